@@ -35,6 +35,7 @@
 #include <atheme/email.h>
 #include <atheme/entity.h>
 #include <atheme/entity-validation.h>
+#include <atheme/expiry.h>
 #include <atheme/flags.h>
 #include <atheme/global.h>
 #include <atheme/hook.h>
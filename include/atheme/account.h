@@ -19,6 +19,10 @@
 /* kline list struct */
 struct kline
 {
+	mowgli_node_t   node;           // klnlist
+	mowgli_node_t   idxnode;        // host index bucket, see node.c
+	mowgli_list_t * idxlist;        // the bucket idxnode is in
+	unsigned int    expiry_idx;     // position in the expiry queue + 1, 0 if not in it
 	char *          user;
 	char *          host;
 	char *          reason;
@@ -32,6 +36,7 @@ struct kline
 /* xline list struct */
 struct xline
 {
+	unsigned int    expiry_idx;     // position in the expiry queue + 1, 0 if not in it
 	char *          realname;
 	char *          reason;
 	char *          setby;
@@ -44,6 +49,7 @@ struct xline
 /* qline list struct */
 struct qline
 {
+	unsigned int    expiry_idx;     // position in the expiry queue + 1, 0 if not in it
 	char *          mask;
 	char *          reason;
 	char *          setby;
@@ -63,11 +69,23 @@ struct svsignore
 	char *                  reason;
 };
 
+/* parts of an account that most accounts never use; allocated by myuser_ext()
+ * the first time one of them is changed
+ */
+struct myuser_ext
+{
+	unsigned int            memo_ratelimit_num;     // memos sent recently
+	time_t                  memo_ratelimit_time;    // last time a memo was sent
+	mowgli_list_t           memo_ignores;
+	mowgli_list_t           access_list;
+	mowgli_list_t           cert_fingerprints;
+};
+
 /* services accounts */
 struct myuser
 {
 	struct myentity         ent;
-	char                    pass[PASSLEN + 1];
+	char *                  pass;                   // at most PASSLEN long; set with myuser_set_pass()
 	stringref               email;
 	stringref               email_canonical;
 	mowgli_list_t           logins;                 // 'struct user's currently logged in to this
@@ -75,15 +93,12 @@ struct myuser
 	time_t                  lastlogin;
 	struct soper *          soper;
 	unsigned int            flags;
-	mowgli_list_t           memos;                  // store memos
 	unsigned int            memoct_new;
-	unsigned int            memo_ratelimit_num;     // memos sent recently
-	time_t                  memo_ratelimit_time;    // last time a memo was sent
-	mowgli_list_t           memo_ignores;
-	mowgli_list_t           access_list;
+	unsigned int            expiry_idx;             // position in the expiry queue + 1, see expire_check()
+	mowgli_list_t           memos;                  // store memos
 	mowgli_list_t           nicks;                  // registered nicks, must include mu->name if nonempty
 	struct language *       language;
-	mowgli_list_t           cert_fingerprints;
+	struct myuser_ext *     ext;                    // NULL until needed; read it with myuser_ext_peek()
 };
 
 /* Keep this synchronized with mu_flags in libathemecore/flags.c */
@@ -116,6 +131,7 @@ struct mynick
 {
 	struct atheme_object    parent;
 	char                    nick[NICKLEN + 1];
+	unsigned int            expiry_idx;     // position in the expiry queue + 1, see expire_check()
 	struct myuser *         owner;
 	time_t                  registered;
 	time_t                  lastseen;
@@ -142,6 +158,13 @@ struct mychan
 	stringref               name;
 	struct channel *        chan;
 	mowgli_list_t           chanacs;
+	mowgli_list_t           chanacs_host;   // hostmask entries, in chanacs order
+	mowgli_list_t           chanacs_ext;    // entries whose entity has its own vtable
+	struct chanacs **       chanacs_hash;   // entity entries, keyed by entity pointer
+	unsigned int            chanacs_hash_size;
+	unsigned int            chanacs_hash_count;
+	unsigned int            num_founders;   // entity entries carrying CA_FOUNDER
+	unsigned int            expiry_idx;     // position in the expiry queue + 1, see expire_check()
 	time_t                  registered;
 	time_t                  used;
 	unsigned int            mlock_on;
@@ -186,6 +209,9 @@ struct chanacs
 	time_t                  tmodified;
 	mowgli_node_t           cnode;
 	mowgli_node_t           unode;
+	mowgli_node_t           lnode;          // in mychan -> chanacs_host or chanacs_ext
+	struct chanacs *        hnext;          // next entry in the mychan -> chanacs_hash bucket
+	unsigned int            match_type;     // CBAN_MATCH_* for hostmask entries
 	char                    setter_uid[IDLEN + 1];
 };
 
@@ -284,10 +310,12 @@ struct groupacs
 /* struct for account memos */
 struct mymemo
 {
-	char            sender[NICKLEN + 1];
-	char            text[MEMOLEN + 1];
-	time_t          sent;
+	stringref       sender;
+	char *          text;           // NULL while the text is in the memo store; use mymemo_text()
+	off_t           textoff;        // where in the memo store the text is
+	unsigned int    textlen;
 	unsigned int    status;
+	time_t          sent;
 };
 
 /* memo status flags */
@@ -325,6 +353,7 @@ void kline_delete(struct kline *k);
 struct kline *kline_find(const char *user, const char *host);
 struct kline *kline_find_num(unsigned long number);
 struct kline *kline_find_user(struct user *u);
+void kline_set_expiry(struct kline *k, time_t settime);
 void kline_expire(void *arg);
 
 extern mowgli_list_t xlnlist;
@@ -334,6 +363,7 @@ void xline_delete(const char *realname);
 struct xline *xline_find(const char *realname);
 struct xline *xline_find_num(unsigned int number);
 struct xline *xline_find_user(struct user *u);
+void xline_set_expiry(struct xline *x, time_t settime);
 void xline_expire(void *arg);
 
 extern mowgli_list_t qlnlist;
@@ -345,6 +375,7 @@ struct qline *qline_find_match(const char *mask);
 struct qline *qline_find_num(unsigned int number);
 struct qline *qline_find_user(struct user *u);
 struct qline *qline_find_channel(struct channel *c);
+void qline_set_expiry(struct qline *q, time_t settime);
 void qline_expire(void *arg);
 
 /* account.c */
@@ -360,6 +391,9 @@ void myuser_delete(struct myuser *mu);
 //inline struct myuser *myuser_find(const char *name);
 void myuser_rename(struct myuser *mu, const char *name);
 void myuser_set_email(struct myuser *mu, const char *newemail);
+void myuser_set_pass(struct myuser *mu, const char *pass);
+struct myuser_ext *myuser_ext(struct myuser *mu);
+const struct myuser_ext *myuser_ext_peek(const struct myuser *mu);
 struct myuser *myuser_find_ext(const char *name);
 void myuser_notice(const char *from, struct myuser *target, const char *fmt, ...) ATHEME_FATTR_PRINTF(3, 4);
 
@@ -379,6 +413,10 @@ struct mycertfp *mycertfp_add(struct myuser *mu, const char *certfp, bool force)
 void mycertfp_delete(struct mycertfp *mcfp);
 struct mycertfp *mycertfp_find(const char *certfp);
 
+struct mymemo *mymemo_add(struct myuser *mu, const char *sender, const char *text, time_t sent, unsigned int status);
+void mymemo_delete(struct myuser *mu, mowgli_node_t *n);
+const char *mymemo_text(const struct mymemo *memo, char *buf);
+
 struct mychan *mychan_add(char *name);
 //inline struct mychan *mychan_find(const char *name);
 bool mychan_isused(struct mychan *mc);
@@ -392,6 +430,8 @@ const char *mychan_get_sts_mlock(struct mychan *mc);
 struct chanacs *chanacs_add(struct mychan *mychan, struct myentity *myuser, unsigned int level, time_t ts, struct myentity *setter);
 struct chanacs *chanacs_add_host(struct mychan *mychan, const char *host, unsigned int level, time_t ts, struct myentity *setter);
 
+void chanacs_set_level(struct chanacs *ca, unsigned int level);
+
 struct chanacs *chanacs_find(struct mychan *mychan, struct myentity *myuser, unsigned int level);
 unsigned int chanacs_entity_flags(struct mychan *mychan, struct myentity *myuser);
 struct chanacs *chanacs_find_literal(struct mychan *mychan, struct myentity *myuser, unsigned int level);
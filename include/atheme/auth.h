@@ -14,8 +14,39 @@
 #include <atheme/stdheaders.h>
 #include <atheme/structures.h>
 
+enum verify_password_result
+{
+	VERIFY_PASSWORD_FAILED  = 0,    // The password is wrong
+	VERIFY_PASSWORD_OK      = 1,    // The password is right
+	VERIFY_PASSWORD_BUSY    = 2,    // Too many verifications are queued (in all, or from this source); try later
+	VERIFY_PASSWORD_PENDING = 3,    // Queued for a worker thread; the callback will get the result
+};
+
+struct verify_password_req;
+
+/* Called on the main thread with VERIFY_PASSWORD_OK or VERIFY_PASSWORD_FAILED; mu is NULL if the account
+ * was dropped in the meantime.
+ */
+typedef void (*verify_password_cb)(struct myuser *mu, enum verify_password_result result, void *priv);
+
+struct authpool_stats
+{
+	unsigned int    threads;        // worker threads running
+	unsigned int    queued;         // verifications queued or running
+	unsigned int    queued_peak;    // most verifications ever queued or running at once
+	unsigned long   completed;      // verifications completed by the pool
+	unsigned long   rejected;       // verifications refused with VERIFY_PASSWORD_BUSY
+	uint64_t        latency_total;  // nanoseconds from queueing to the callback, summed over completed ones
+	uint64_t        latency_max;    // nanoseconds from queueing to the callback, at most
+};
+
 bool set_password(struct myuser *mu, const char *password) ATHEME_FATTR_WUR;
 bool verify_password(struct myuser *mu, const char *password) ATHEME_FATTR_WUR;
+enum verify_password_result verify_password_async(struct myuser *mu, const char *password, const char *source,
+                                                  verify_password_cb cb, void *priv,
+                                                  struct verify_password_req **req) ATHEME_FATTR_WUR;
+void verify_password_cancel(struct verify_password_req *req);
+const struct authpool_stats *authpool_get_stats(void);
 
 extern bool auth_module_loaded;
 extern bool (*auth_user_custom)(struct myuser *mu, const char *password) ATHEME_FATTR_WUR;
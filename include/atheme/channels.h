@@ -33,6 +33,8 @@ struct channel
 	mowgli_list_t   bans;
 	unsigned int    flags;
 	struct mychan * mychan;
+	uint64_t        ban_epoch;      // see chanban_epoch
+	unsigned int    numextbans;     // bans with an extban type
 };
 
 /* struct for channel memberships */
@@ -43,8 +45,20 @@ struct chanuser
 	unsigned int    modes;
 	mowgli_node_t   unode;
 	mowgli_node_t   cnode;
+	uint64_t        ban_stamp;      // chanban_epoch when ban_cached was filled
+	unsigned char   ban_cached;     // CU_BANCACHE_* results that are known
+	unsigned char   ban_matched;    // CU_BANCACHE_* results that are true
+	unsigned char   flags;          // CU_* flags below
+	struct chanuser *hnext;         // next entry in the membership hash bucket
 };
 
+/* for struct chanuser -> ban_cached, ban_matched */
+#define CU_BANCACHE_BAN     0x01U
+#define CU_BANCACHE_QUIET   0x02U
+
+/* for struct chanuser -> flags */
+#define CU_SYNC_DEFERRED    0x01U   /* joined during a burst; channel services have not acted on it yet */
+
 struct chanban
 {
 	struct channel *chan;
@@ -52,6 +66,13 @@ struct chanban
 	int             type;   // 'b', 'e', 'I', etc -- jilles
 	mowgli_node_t   node;   // for struct channel -> bans
 	unsigned int    flags;
+
+	// filled in by chanban_compile() when the ban is added
+	char *          match_mask;     // mask to match users against; may be mask itself
+	unsigned int    match_type;     // CBAN_MATCH_*
+	char            ext_type;       // extban type, or '\0' if not an extban
+	bool            ext_negate;
+	const char *    ext_param;      // points into match_mask, or NULL
 };
 
 /* for struct channel -> modes */
@@ -79,6 +100,11 @@ struct chanban
 /* for struct chanban -> flags */
 #define CBAN_ANTIFLOOD  0x00000001U	/* chanserv/antiflood set this */
 
+/* for struct chanban -> match_type */
+#define CBAN_MATCH_LITERAL	0U	/* no wildcards; a case-insensitive compare will do */
+#define CBAN_MATCH_WILDCARD	1U	/* needs match() */
+#define CBAN_MATCH_CIDR		2U	/* needs match() and match_cidr() */
+
 #define MTYPE_NUL 0U
 #define MTYPE_ADD 1U
 #define MTYPE_DEL 2U
@@ -132,9 +158,17 @@ struct chanuser *chanuser_add(struct channel *chan, const char *user);
 void chanuser_delete(struct channel *chan, struct user *user);
 struct chanuser *chanuser_find(struct channel *chan, struct user *user);
 
+extern uint64_t chanban_epoch;
+extern uint64_t chanban_epoch_all;
+
+/* give `epoch' a value newer than every cached ban match */
+#define CHANBAN_EPOCH_BUMP(epoch)	((epoch) = ++chanban_epoch)
+
 struct chanban *chanban_add(struct channel *chan, const char *mask, int type);
 void chanban_delete(struct chanban *c);
 struct chanban *chanban_find(struct channel *chan, const char *mask, int type);
+unsigned int chanban_match_type(const char *mask);
+bool chanban_match_mask(const struct chanban *cb, const char *name);
 //inline void chanban_clear(struct channel *chan);
 
 #endif /* !ATHEME_INC_CHANNELS_H */
@@ -48,9 +48,18 @@ enum cmd_faultcode
 /* strshare.c - stringref management */
 typedef const char *stringref;
 
+struct strshare_stats
+{
+	size_t  strings;        // distinct strings
+	size_t  refs;           // references to them
+	size_t  bytes;          // bytes taken by the distinct strings
+	size_t  ref_bytes;      // bytes they would take if every reference had its own copy
+};
+
 void strshare_init(void);
 stringref strshare_get(const char *str);
 stringref strshare_ref(stringref str);
 void strshare_unref(stringref str);
+const struct strshare_stats *strshare_get_stats(void);
 
 #endif /* !ATHEME_INC_COMMON_H */
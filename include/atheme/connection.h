@@ -34,6 +34,7 @@
 #define CF_NONEWLINE            0x00000080U
 #define CF_SEND_EOF             0x00000100U /* shutdown(2) write end if sendq empty */
 #define CF_SEND_DEAD            0x00000200U /* write end shut down */
+#define CF_RECVQ_HELD           0x00000400U /* recvq not handed to its handler; see recvq_hold() */
 
 #define CF_IS_UPLINK(cptr)      ((cptr)->flags & CF_UPLINK)
 #define CF_IS_DCCOUT(cptr)      ((cptr)->flags & CF_DCCOUT)
@@ -46,6 +47,7 @@
 #define CF_IS_NONEWLINE(cptr)   ((cptr)->flags & CF_NONEWLINE)
 #define CF_IS_SEND_EOF(cptr)    ((cptr)->flags & CF_SEND_EOF)
 #define CF_IS_SEND_DEAD(cptr)   ((cptr)->flags & CF_SEND_DEAD)
+#define CF_IS_RECVQ_HELD(cptr)  ((cptr)->flags & CF_RECVQ_HELD)
 
 typedef void (*connection_evhandler)(struct connection *);
 
@@ -62,6 +64,15 @@ struct connection
 	connection_evhandler            close_handler;
 	connection_evhandler            recvq_handler;
 	size_t                          sendq_limit;
+	size_t                          sendq_len;      // bytes currently queued for sending
+	size_t                          sendq_peak;     // high-water mark of sendq_len
+	uint64_t                        sendq_bytes;    // total bytes ever queued for sending
+	uint64_t                        sendq_syscalls; // number of send(2)/sendmsg(2) calls
+	size_t                          recvq_len;      // bytes currently waiting in the recvq
+	uint64_t                        recvq_bytes;    // total bytes received
+	uint64_t                        recvq_syscalls; // number of recv(2) calls
+	unsigned int                    recvq_budget;   // max lines handled per event loop iteration (0 = no limit)
+	mowgli_eventloop_timer_t *      recvq_timer;    // resumes handling of lines left over by recvq_budget
 	time_t                          first_recv;
 	time_t                          last_recv;
 	unsigned int                    flags;
@@ -80,6 +91,7 @@ struct connection *connection_accept_tcp(struct connection *, connection_evhandl
 struct connection *connection_find(int);
 
 void connection_setselect_read(struct connection *, connection_evhandler);
+void connection_pause_read(struct connection *, bool);
 void connection_setselect_write(struct connection *, connection_evhandler);
 void connection_close(struct connection *);
 void connection_close_children(struct connection *);
@@ -20,11 +20,30 @@
 typedef const char *(*crypt_crypt_func)(const char *, const char *) ATHEME_FATTR_WUR;
 typedef bool (*crypt_verify_func)(const char *, const char *, unsigned int *) ATHEME_FATTR_WUR;
 
+// One of several passwords given to a provider's verify_batch function at once
+struct crypt_verify_job
+{
+	const char *            password;
+	const char *            parameters;
+	unsigned int            flags;                  // as set by a verify function
+	bool                    result;                 // as returned by a verify function
+	void *                  priv;                   // the caller's; see crypt_verify_job_enter()
+};
+
+typedef bool (*crypt_batch_key_func)(const char *, uint64_t *) ATHEME_FATTR_WUR;
+typedef void (*crypt_verify_batch_func)(struct crypt_verify_job *, size_t);
+
 struct crypt_impl
 {
 	const char *            id;
 	crypt_crypt_func        crypt;
 	crypt_verify_func       verify;
+	bool                    verify_main_thread;     // verify is not reentrant (e.g. crypt(3)); never run it on a worker thread
+	const char *const *     prefixes;               // NULL-terminated "$id$" prefixes of the hashes it handles, if any
+	const void *            params;                 // configured parameters that verify reads; see crypt_verify_params()
+	size_t                  params_size;
+	crypt_batch_key_func    batch_key;              // hashes with equal keys may be verified together; see authpool.c
+	crypt_verify_batch_func verify_batch;           // verifies such hashes (of its own prefixes) together
 };
 
 void crypt_register(const struct crypt_impl *impl);
@@ -36,5 +55,7 @@ const struct crypt_impl *crypt_verify_password(const char *password, const char
     ATHEME_FATTR_WUR;
 
 const char *crypt_password(const char *password);
+const void *crypt_verify_params(const void *params);
+void crypt_verify_job_enter(const struct crypt_verify_job *job);
 
 #endif /* !ATHEME_INC_CRYPTO_H */
@@ -12,6 +12,7 @@
 
 #include <atheme/attributes.h>
 #include <atheme/constants.h>
+#include <atheme/hook.h>
 #include <atheme/stdheaders.h>
 #include <atheme/structures.h>
 
@@ -20,7 +21,8 @@ extern bool strict_mode;
 enum database_transaction
 {
 	DB_READ,
-	DB_WRITE
+	DB_WRITE,
+	DB_APPEND       // add rows to the end of an existing file, e.g. a journal
 };
 
 struct database_vtable
@@ -97,4 +99,14 @@ void db_process(struct database_handle *db, const char *type);
 void db_init(void);
 extern const struct database_module *db_mod;
 
+void db_record_changed(enum db_record_type type, void *object, const char *key);
+void db_record_deleted(enum db_record_type type, void *object);
+void db_record_touched(enum db_record_type type, void *object);
+void db_mark_dirty(void);
+void db_mark_saving(void);
+void db_mark_saved(void);
+
+extern unsigned int db_changes;         // records changed or deleted since services.db was last saved
+extern bool db_dirty;                   // anything (not only such records) may have changed since then
+
 #endif /* !ATHEME_INC_DATABASE_BACKEND_H */
@@ -14,15 +14,19 @@
 #include <atheme/structures.h>
 
 void sendq_add(struct connection *cptr, char *buf, size_t len);
+void sendq_add_line(struct connection *cptr, const char *prefix, size_t prefixlen, const char *text, size_t textlen);
 void sendq_add_eof(struct connection *cptr);
 void sendq_flush(struct connection *cptr);
 bool sendq_nonempty(struct connection *cptr);
 void sendq_set_limit(struct connection *cptr, size_t len);
 
 int recvq_length(struct connection *cptr);
+void recvq_set_budget(struct connection *cptr, unsigned int lines);
+void recvq_hold(struct connection *cptr, bool held);
 void recvq_put(struct connection *cptr);
 int recvq_get(struct connection *cptr, char *buf, size_t len);
 int recvq_getline(struct connection *cptr, char *buf, size_t len);
+char *recvq_getline_inplace(struct connection *cptr, size_t len, size_t *linelen);
 
 void sendqrecvq_free(struct connection *cptr);
 
@@ -57,6 +57,8 @@ bool digest_oneshot_hkdf(enum digest_algorithm, const void *, size_t, const void
 
 bool digest_oneshot_pbkdf2(enum digest_algorithm, const void *, size_t, const void *, size_t, size_t, void *, size_t)
     ATHEME_FATTR_WUR;
+bool digest_oneshot_pbkdf2_batch(enum digest_algorithm, const struct digest_pbkdf2_job *, size_t, size_t)
+    ATHEME_FATTR_WUR;
 
 bool digest_testsuite_run(void) ATHEME_FATTR_WUR;
 const char *digest_get_frontend_info(void);
@@ -32,6 +32,16 @@
 #define DIGEST_BKLEN_MAX        DIGEST_BKLEN_SHA2_512
 #define DIGEST_MDLEN_MAX        DIGEST_MDLEN_SHA2_512
 
+#define DIGEST_LANES_MAX        0x08U
+
+enum digest_lanes_impl
+{
+	DIGEST_LANES_IMPL_AUTO      = 0,
+	DIGEST_LANES_IMPL_SCALAR    = 1,
+	DIGEST_LANES_IMPL_SSE41     = 2,
+	DIGEST_LANES_IMPL_AVX2      = 3,
+};
+
 struct digest_direct_ctx_md5
 {
 	uint32_t        count[0x02U];
@@ -83,4 +93,15 @@ void digest_direct_final_sha1(union digest_direct_ctx *, void *);
 void digest_direct_final_sha2_256(union digest_direct_ctx *, void *);
 void digest_direct_final_sha2_512(union digest_direct_ctx *, void *);
 
+/* Multi-lane SHA2 block transforms; see digest_direct_sha2.c. Only the
+ * requested number of lanes is read and written.
+ */
+bool digest_direct_lanes_supported(enum digest_lanes_impl);
+bool digest_direct_lanes_force(enum digest_lanes_impl);
+enum digest_lanes_impl digest_direct_lanes_impl(void);
+const char *digest_direct_lanes_name(enum digest_lanes_impl);
+
+void digest_direct_transform_lanes_sha2_256(uint32_t [][DIGEST_LANES_MAX], const uint32_t [][DIGEST_LANES_MAX], size_t);
+void digest_direct_transform_lanes_sha2_512(uint64_t [][DIGEST_LANES_MAX], const uint64_t [][DIGEST_LANES_MAX], size_t);
+
 #endif /* !ATHEME_INC_DIGEST_DIRECT_H */
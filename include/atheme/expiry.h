@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Expiry queues (binary min-heaps of objects keyed by a due time)
+ */
+
+#ifndef ATHEME_INC_EXPIRY_H
+#define ATHEME_INC_EXPIRY_H 1
+
+#include <atheme/stdheaders.h>
+
+struct expiry_entry
+{
+	time_t                  when;
+	void *                  obj;
+	unsigned int *          idx;    // the object's position in the queue + 1, 0 if not in it
+};
+
+struct expiry_queue
+{
+	struct expiry_entry *   entries;
+	unsigned int            count;
+	unsigned int            size;
+};
+
+void expiry_queue_set(struct expiry_queue *q, void *obj, unsigned int *idx, time_t when);
+void expiry_queue_delete(struct expiry_queue *q, unsigned int *idx);
+void *expiry_queue_pop(struct expiry_queue *q, time_t now);
+
+#endif /* !ATHEME_INC_EXPIRY_H */
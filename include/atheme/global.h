@@ -33,6 +33,8 @@ struct me
 	struct server * me;                     // pointer to our server struct
 	bool            connected;              // are we connected?
 	bool            bursting;               // are we bursting?
+	bool            burst_defer;            // defer channel services' reactions until handle_burst_end()?
+	unsigned int    burst_time;             // how long the last burst took, in milliseconds
 	bool            recvsvr;                // received server peer
 	unsigned int    maxcertfp;              // maximum fingerprints in certfp list
 	unsigned int    maxlogins;              // maximum logins per username
@@ -72,6 +74,14 @@ struct ConfOption
 	unsigned int    clone_time;             // default expire for clone exemptions
 	unsigned int    commit_interval;        // interval between commits
 	bool            db_save_blocking;       // whether to always use a blocking database commit
+	bool            db_save_sync;           // flush database saves to disk before renaming them into place
+	unsigned int    db_save_slice;          // write background saves in slices of this many ms instead of forking
+	bool            db_save_skip_unchanged; // skip periodic saves when nothing has changed since the last one
+	bool            db_journal;             // append changes to a journal between database saves
+	unsigned int    db_journal_compact;     // save the database once the journal has this many records
+	unsigned int    auth_threads;           // verify passwords on this many worker threads (0 = inline)
+	unsigned int    auth_queue_max;         // password verifications that may be queued at once
+	unsigned int    auth_source_max;        // ... of which from any one client (0 = no limit)
 	bool            silent;                 // stop sending WALLOPS?
 	bool            join_chans;             // join registered channels?
 	bool            leave_chans;            // leave channels when empty?
@@ -91,6 +101,7 @@ struct ConfOption
 	unsigned int    default_clone_warn;     // default clone warn
 	bool            clone_increase;         // If the clone limit will increase based on # of identified clones
 	unsigned int    uplink_sendq_limit;
+	unsigned int    uplink_recvq_budget;    // max lines parsed from the uplink per event loop iteration
 	char *          language;               // default language
 	mowgli_list_t   exempts;                // List of masks never to automatically kline
 	bool            allow_taint;            // allow tainted operation
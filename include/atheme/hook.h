@@ -19,9 +19,16 @@ typedef void (*hook_fn)(void *data);
 struct hook
 {
 	stringref       name;
-	mowgli_list_t   hooks;
+	hook_fn *       handlers;   // in call order; NULL where one was removed during a call
+	unsigned int    count;      // used slots in handlers
+	unsigned int    size;       // allocated slots in handlers
+	unsigned int    live;       // non-NULL slots in handlers
+	unsigned int    running;    // calls of this hook in progress
 };
 
+/* call the handlers of a hook, returning at once if there are none */
+#define HOOK_CALL(ev, x)        ((ev).live != 0 ? hook_call_handlers(&(ev), (x)) : (void) 0)
+
 struct hook_channel_acl_req
 {
 	struct chanacs *    ca;
@@ -100,6 +107,28 @@ struct hook_chanuser_sync
 	const bool         take_prefixes; // Whether temporary prefixes should be removed
 };
 
+enum db_record_type
+{
+	DB_RECORD_MYUSER,
+	DB_RECORD_MYNICK,
+	DB_RECORD_MYCHAN,
+	DB_RECORD_CHANACS,
+	DB_RECORD_METADATA,
+	DB_RECORD_KLINE,
+	DB_RECORD_XLINE,
+	DB_RECORD_QLINE,
+	DB_RECORD_MEMOS,                // An account's memos and memo ignores, as a whole
+};
+
+struct hook_db_change
+{
+	enum db_record_type     type;
+	void *                  object;     // For DB_RECORD_METADATA, the object that owns it
+	const char *            key;        // Metadata name, or the previous name of a renamed account
+	bool                    deleted;    // The object is about to be destroyed
+	bool                    touched;    // Only its last-login, last-seen or last-used time changed
+};
+
 struct hook_expiry_req
 {
 	union {
@@ -265,6 +294,10 @@ void hook_add_hook(const char *, hook_fn);
 void hook_add_hook_first(const char *, hook_fn);
 void hook_call_event(const char *, void *);
 
+void hook_del_handler(struct hook *, hook_fn);
+void hook_add_handler(struct hook *, hook_fn, bool first);
+void hook_call_handlers(struct hook *, void *);
+
 void hook_stop(void);
 void hook_continue(void *newptr);
 
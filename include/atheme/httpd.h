@@ -31,6 +31,8 @@ struct httpddata
 	bool            correct_content_type;
 	bool            expect_100_continue;
 	bool            sent_reply;
+	void *          pending;                        // set by a path handler that will reply later
+	void            (*pending_cancel)(void *);      // called with it if the connection closes first
 };
 
 #endif /* !ATHEME_INC_HTTPD_H */
@@ -36,9 +36,50 @@ struct atheme_regex
 	} un;
 };
 
+/* a set of regexes that is matched as a whole, see regex_set_match() */
+struct atheme_regex_set_entry
+{
+	mowgli_node_t           node;
+	char *                  pattern;
+	struct atheme_regex *   re;
+	void *                  data;
+	int                     combined;       // index into modes[], or -1
+	size_t                  ngroups;        // parenthesised groups in pattern
+	size_t                  index;          // position in modes[combined].members
+};
+
+/* one alternation per range of members, laid out as a pre-order tree */
+struct atheme_regex_set_node
+{
+	regex_t                 re;
+	bool                    compiled;
+};
+
+struct atheme_regex_set_mode
+{
+	struct atheme_regex_set_entry **members;
+	size_t *                groupoff;       // groups before each member
+	struct atheme_regex_set_node *nodes;
+	bool *                  hits;
+	size_t                  count;
+};
+
+struct atheme_regex_set
+{
+	mowgli_list_t           entries;
+	struct atheme_regex_set_mode modes[2];  // case-sensitive, case-insensitive
+	regmatch_t *            pmatch;
+	size_t                  npmatch;
+	bool                    dirty;
+};
+
+typedef void (*regex_set_match_fn)(void *data, void *priv);
+
 /* cidr.c */
 int match_ips(const char *mask, const char *address);
 int match_cidr(const char *mask, const char *address);
+unsigned int cidr_parse_ip(const char *ip, unsigned char *addr);
+unsigned int cidr_parse_mask(const char *mask, unsigned char *addr, unsigned int *bits);
 
 /* match.c */
 #define MATCH_RFC1459   0
@@ -91,4 +132,10 @@ char *regex_extract(char *pattern, char **pend, int *pflags);
 bool regex_match(struct atheme_regex *preg, char *string);
 bool regex_destroy(struct atheme_regex *preg);
 
+struct atheme_regex_set *regex_set_create(void) ATHEME_FATTR_MALLOC ATHEME_FATTR_RETURNS_NONNULL;
+void regex_set_add(struct atheme_regex_set *set, const char *pattern, int flags, struct atheme_regex *re, void *data);
+void regex_set_delete(struct atheme_regex_set *set, void *data);
+unsigned int regex_set_match(struct atheme_regex_set *set, char *string, regex_set_match_fn cb, void *priv);
+void regex_set_destroy(struct atheme_regex_set *set);
+
 #endif /* !ATHEME_INC_MATCH_H */
@@ -30,20 +30,34 @@ while read hook type; do
 		continue
 		;;
 	*:void)
-		echo "#define hook_call_$hook() hook_call_event(\"$hook\", NULL)"
+		echo "extern struct hook hook_ev_$hook;"
+		echo "#define hook_call_$hook() HOOK_CALL(hook_ev_$hook, NULL)"
 		# Still require a dummy void * function parameter here.
-		echo "#define hook_add_$hook(f) hook_add_hook(\"$hook\", f)"
-		echo "#define hook_add_first_$hook(f) hook_add_hook_first(\"$hook\", f)"
-		echo "#define hook_del_$hook(f) hook_del_hook(\"$hook\", f)"
+		echo "#define hook_add_$hook(f) hook_add_handler(&hook_ev_$hook, f, false)"
+		echo "#define hook_add_first_$hook(f) hook_add_handler(&hook_ev_$hook, f, true)"
+		echo "#define hook_del_$hook(f) hook_del_handler(&hook_ev_$hook, f)"
 		;;
 	*)
-		echo "#define hook_call_$hook(x) hook_call_event(\"$hook\", ENSURE_TYPE(x, $type))"
-		echo "#define hook_add_$hook(f) hook_add_hook(\"$hook\", (void (*)(void *))ENSURE_TYPE(f, void (*)($type)))"
-		echo "#define hook_add_first_$hook(f) hook_add_hook_first(\"$hook\", (void (*)(void *))ENSURE_TYPE(f, void (*)($type)))"
-		echo "#define hook_del_$hook(f) hook_del_hook(\"$hook\", (void (*)(void *))ENSURE_TYPE(f, void (*)($type)))"
+		echo "extern struct hook hook_ev_$hook;"
+		echo "#define hook_call_$hook(x) HOOK_CALL(hook_ev_$hook, ENSURE_TYPE(x, $type))"
+		echo "#define hook_add_$hook(f) hook_add_handler(&hook_ev_$hook, (void (*)(void *))ENSURE_TYPE(f, void (*)($type)), false)"
+		echo "#define hook_add_first_$hook(f) hook_add_handler(&hook_ev_$hook, (void (*)(void *))ENSURE_TYPE(f, void (*)($type)), true)"
+		echo "#define hook_del_$hook(f) hook_del_handler(&hook_ev_$hook, (void (*)(void *))ENSURE_TYPE(f, void (*)($type)))"
 		;;
 	esac
 done < "$1"
 
+# hook.c defines and registers one struct hook per hook through this list
+echo
+echo '#define HOOKTYPES_FOREACH(HOOK) \'
+while read hook type; do
+	case $hook:$type in
+	[#]*|:)
+		continue
+		;;
+	esac
+	echo "	HOOK($hook) \\"
+done < "$1"
+echo '	/* end of list */'
 echo
 echo '#endif /* !ATHEME_INC_HOOKTYPES_H */'
@@ -21,9 +21,20 @@ struct metadata
 
 typedef void (*atheme_object_destructor_fn)(void *);
 
+/* objects whose metadata is part of the database */
+enum atheme_object_type
+{
+	ATHEME_OBJECT_OTHER             = 0,
+	ATHEME_OBJECT_MYUSER,
+	ATHEME_OBJECT_MYNICK,
+	ATHEME_OBJECT_MYCHAN,
+	ATHEME_OBJECT_CHANACS,
+};
+
 struct atheme_object
 {
 	int                             refcount;
+	enum atheme_object_type         type;
 	atheme_object_destructor_fn     destructor;
 	mowgli_patricia_t *             metadata;
 	mowgli_patricia_t *             privatedata;
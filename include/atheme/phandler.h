@@ -83,7 +83,8 @@ struct ircd
 
 /* server login, usually sends PASS, CAPAB, SERVER and SVINFO
  * you can still change ircd->uses_uid at this point
- * set me.bursting = true
+ * set me.bursting = true, or call handle_burst_begin() if the protocol module
+ * calls handle_burst_end() when the uplink has finished bursting
  * return 1 if sts() failed (by returning 1), otherwise 0 */
 extern unsigned int (*server_login)(void);
 /* introduce a client on the services server */
@@ -124,6 +125,12 @@ extern void (*msg_global_sts)(struct user *from, const char *mask, const char *t
  * from can be a client on the services server or the services server
  * itself (NULL) */
 extern void (*notice_user_sts)(struct user *from, struct user *target, const char *text);
+/* write what notice_user_sts() sends before the text into buf (of size len)
+ * and return its length (as snprintf() would), or return 0 if notices are
+ * not sent that way; the result may only depend on the CLIENT_NAME() of the
+ * users, as notice_user_lines() reuses it for as long as these stay the same
+ * (a protocol module that replaces notice_user_sts() must replace this too) */
+extern size_t (*notice_user_prefix)(struct user *from, struct user *target, char *buf, size_t len);
 /* send a global notice to all users on servers matching the mask
  * from is a client on the services server
  * mask is either "*" or it has a non-wildcard TLD */
@@ -230,6 +237,8 @@ extern void (*sasl_sts) (const char *target, char mode, const char *data);
 extern void (*sasl_mechlist_sts)(const char *mechlist);
 /* check whether a mask matches a user */
 extern bool (*mask_matches_user)(const char *mask, struct user *u);
+/* fill in the match fields of a newly added channel ban */
+extern void (*chanban_compile)(struct chanban *cb);
 /* find next channel ban (or other ban-like mode) matching user */
 extern mowgli_node_t *(*next_matching_ban)(struct channel *c, struct user *u, int type, mowgli_node_t *first);
 /* find next host channel access matching user */
@@ -275,6 +284,7 @@ void generic_kick(struct user *source, struct channel *c, struct user *u, const
 void generic_msg(const char *from, const char *target, const char *fmt, ...) ATHEME_FATTR_PRINTF(3, 4);
 void generic_msg_global_sts(struct user *from, const char *mask, const char *text);
 void generic_notice_user_sts(struct user *from, struct user *target, const char *text);
+size_t generic_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len);
 void generic_notice_global_sts(struct user *from, const char *mask, const char *text);
 void generic_notice_channel_sts(struct user *from, struct channel *target, const char *text);
 void generic_wallchops(struct user *source, struct channel *target, const char *message);
@@ -300,6 +310,7 @@ void generic_svslogin_sts(const char *target, const char *nick, const char *user
 void generic_sasl_sts(const char *target, char mode, const char *data);
 void generic_sasl_mechlist_sts(const char *mechlist);
 bool generic_mask_matches_user(const char *mask, struct user *u);
+void generic_chanban_compile(struct chanban *cb);
 mowgli_node_t *generic_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_node_t *first);
 mowgli_node_t *generic_next_matching_host_chanacs(struct mychan *mc, struct user *u, mowgli_node_t *first);
 bool generic_is_valid_host(const char *host);
@@ -36,6 +36,7 @@
 #define ASASL_SFLAG_NONE                0x00000000U // Nothing special
 #define ASASL_SFLAG_MARKED_FOR_DELETION 0x00000001U // See sasl_delete_stale() in modules/saslserv/main.c
 #define ASASL_SFLAG_CLIENT_SECURE       0x00000002U // The client is connected to the network securely
+#define ASASL_SFLAG_PENDING             0x00000004U // The mechanism is waiting for a result (ASASL_MRESULT_ASYNC)
 
 // Flags for sasl_input_buf->flags
 #define ASASL_INFLAG_NONE               0x00000000U // Nothing special
@@ -102,6 +103,7 @@ enum sasl_mechanism_result
 	ASASL_MRESULT_FAILURE   = 2,    // Client supplied invalid credentials; run bad_password() on the target
 	ASASL_MRESULT_CONTINUE  = 3,    // Everything looks good so far, but we need more data from the client
 	ASASL_MRESULT_SUCCESS   = 4,    // The client has successfully authenticated
+	ASASL_MRESULT_ASYNC     = 5,    // The result will be passed to mech_complete() later (e.g. password verification)
 };
 
 typedef enum sasl_mechanism_result (*sasl_mech_start_fn)(struct sasl_session *restrict,
@@ -130,6 +132,7 @@ struct sasl_core_functions
 	sasl_authxid_can_login_fn   authcid_can_login;
 	sasl_authxid_can_login_fn   authzid_can_login;
 	void                      (*recalc_mechlist)(const struct sasl_session *, const char **);
+	void                      (*mech_complete)(struct sasl_session *, enum sasl_mechanism_result);
 };
 
 #endif /* !ATHEME_INC_SASL_H */
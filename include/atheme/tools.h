@@ -45,6 +45,7 @@ struct logfile
 
 extern char *log_path; /* contains path to default log. */
 extern int log_force;
+extern unsigned int log_active_mask; /* union of the masks of all log streams */
 
 struct logfile *logfile_new(const char *log_path_, unsigned int log_mask) ATHEME_FATTR_MALLOC_UNCHECKED;
 void logfile_register(struct logfile *lf);
@@ -91,11 +92,27 @@ void log_shutdown(void);
 bool log_debug_enabled(void);
 void log_master_set_mask(unsigned int mask);
 struct logfile *logfile_find_mask(unsigned int log_mask);
-void slog(unsigned int level, const char *fmt, ...) ATHEME_FATTR_PRINTF(2, 3);
+void (slog)(unsigned int level, const char *fmt, ...) ATHEME_FATTR_PRINTF(2, 3);
 void logcommand(struct sourceinfo *si, int level, const char *fmt, ...) ATHEME_FATTR_PRINTF(3, 4);
 void logcommand_user(struct service *svs, struct user *source, int level, const char *fmt, ...) ATHEME_FATTR_PRINTF(4, 5);
 void logcommand_external(struct service *svs, const char *type, struct connection *source, const char *sourcedesc, struct myuser *login, int level, const char *fmt, ...) ATHEME_FATTR_PRINTF(7, 8);
 
+/* Whether anything would be logged at (any of) the given level(s). Password
+ * verification threads may see a stale mask here; vslog_ext() then filters
+ * their messages by the levels enabled when their request was queued.
+ */
+static inline bool
+log_level_enabled(const unsigned int level)
+{
+	return (level & log_active_mask) != 0U || log_force;
+}
+
+/* Skip formatting (and evaluating the arguments of) messages that no log
+ * stream wants. The level may be evaluated twice.
+ */
+#define slog(level, ...) \
+	((void) (log_level_enabled(level) ? (slog)((level), __VA_ARGS__) : (void) 0))
+
 /* function.c */
 
 /* misc string stuff */
@@ -118,6 +135,7 @@ char *combine_path(const char *parent, const char *child);
 
 unsigned long makekey(void);
 int srename(const char *old_fn, const char *new_fn);
+const char *sstrerror(int errnum, char *buf, size_t buflen);
 
 /* time stuff */
 #if HAVE_GETTIMEOFDAY
@@ -47,10 +47,14 @@ extern struct timeval burstime;
 #endif
 
 extern void (*parse)(char *line);
+void parse_set_coreline(const char *line, size_t len);
+const char *parse_coreline(void);
 void irc_handle_connect(struct connection *cptr);
 
 /* send.c */
 int send_line(const char *line);
+int send_prefixed_line(const char *prefix, size_t prefixlen, const char *text, size_t textlen);
+void notice_user_lines(struct user *from, struct user *target, const char *text);
 void io_loop(void);
 
 #endif /* !ATHEME_INC_UPLINK_H */
@@ -36,6 +36,7 @@ struct user
 	time_t                  ts;
 	mowgli_node_t           snode;          // for struct server -> userlist
 	char *                  certfp;         // client certificate fingerprint
+	uint64_t                ban_epoch;      // see chanban_epoch
 };
 
 #define UF_AWAY        0x00000002U
@@ -25,10 +25,22 @@ static mowgli_patricia_t *certfplist;
 static mowgli_heap_t *myuser_heap;   /* HEAP_USER */
 static mowgli_heap_t *mynick_heap;   /* HEAP_USER */
 static mowgli_heap_t *mycertfp_heap; /* HEAP_USER */
+static mowgli_heap_t *mymemo_heap;   /* HEAP_USER */
 static mowgli_heap_t *myuser_name_heap;	/* HEAP_USER / 2 */
 static mowgli_heap_t *mychan_heap;	/* HEAP_CHANNEL */
 static mowgli_heap_t *chanacs_heap;	/* HEAP_CHANACS */
 
+static void mymemo_free(struct myuser *mu, mowgli_node_t *n);
+
+/* accounts, nicks and channels ordered by the earliest time they could
+ * expire, see expire_check() */
+static struct expiry_queue myuser_expiry;
+static struct expiry_queue mynick_expiry;
+static struct expiry_queue mychan_expiry;
+static bool expiry_queued = false;
+static unsigned int expiry_queued_nick;
+static unsigned int expiry_queued_chan;
+
 /*
  * init_accounts()
  *
@@ -52,9 +64,10 @@ init_accounts(void)
 	mychan_heap = sharedheap_get(sizeof(struct mychan));
 	chanacs_heap = sharedheap_get(sizeof(struct chanacs));
 	mycertfp_heap = sharedheap_get(sizeof(struct mycertfp));
+	mymemo_heap = sharedheap_get(sizeof(struct mymemo));
 
 	if (myuser_heap == NULL || mynick_heap == NULL || mychan_heap == NULL
-			|| chanacs_heap == NULL || mycertfp_heap == NULL)
+			|| chanacs_heap == NULL || mycertfp_heap == NULL || mymemo_heap == NULL)
 	{
 		slog(LG_ERROR, "init_accounts(): block allocator failure.");
 		exit(EXIT_FAILURE);
@@ -116,6 +129,7 @@ myuser_add_id(const char *id, const char *name, const char *pass, const char *em
 
 	mu = mowgli_heap_alloc(myuser_heap);
 	atheme_object_init(atheme_object(mu), name, (atheme_object_destructor_fn) myuser_delete);
+	atheme_object(mu)->type = ATHEME_OBJECT_MYUSER;
 
 	entity(mu)->type = ENT_USER;
 	entity(mu)->name = strshare_get(name);
@@ -146,7 +160,7 @@ myuser_add_id(const char *id, const char *name, const char *pass, const char *em
 	 * try to encrypt it, or continue to store it plain if this fails.
 	 */
 	if ((mu->flags & MU_CRYPTPASS) || (! set_password(mu, pass)))
-		(void) mowgli_strlcpy(mu->pass, pass, sizeof mu->pass);
+		(void) myuser_set_pass(mu, pass);
 
 	if ((soper = soper_find_named(entity(mu)->name)) != NULL
 		|| (soper = soper_find_eid(entity(mu)->id)) != NULL)
@@ -158,6 +172,11 @@ myuser_add_id(const char *id, const char *name, const char *pass, const char *em
 
 	myuser_name_restore(entity(mu)->name, mu);
 
+	if (expiry_queued)
+		expiry_queue_set(&myuser_expiry, mu, &mu->expiry_idx, CURRTIME);
+
+	db_record_changed(DB_RECORD_MYUSER, mu, NULL);
+
 	cnt.myuser++;
 
 	return mu;
@@ -185,7 +204,6 @@ myuser_delete(struct myuser *mu)
 	struct mynick *mn;
 	struct user *u;
 	mowgli_node_t *n, *tn;
-	struct mymemo *memo;
 	struct chanacs *ca;
 	char nicks[200];
 
@@ -194,6 +212,8 @@ myuser_delete(struct myuser *mu)
 	if (!(runflags & RF_STARTING))
 		slog(LG_DEBUG, "myuser_delete(): %s", entity(mu)->name);
 
+	db_record_deleted(DB_RECORD_MYUSER, mu);
+
 	myuser_name_remember(entity(mu)->name, mu);
 
 	hook_call_myuser_delete(mu);
@@ -258,6 +278,8 @@ myuser_delete(struct myuser *mu)
 	if (soper_find(mu))
 		soper_delete(mu->soper);
 
+	expiry_queue_delete(&myuser_expiry, &mu->expiry_idx);
+
 	metadata_delete_all(mu);
 
 	/* kill any authcookies */
@@ -265,21 +287,28 @@ myuser_delete(struct myuser *mu)
 
 	/* delete memos */
 	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->memos.head)
+		mymemo_free(mu, n);
+
+	if (mu->ext != NULL)
 	{
-		memo = (struct mymemo *)n->data;
+		/* delete access entries */
+		MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->ext->access_list.head)
+			myuser_access_delete(mu, (char *)n->data);
 
-		mowgli_node_delete(n, &mu->memos);
-		mowgli_node_free(n);
-		sfree(memo);
-	}
+		/* delete certfp entries */
+		MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->ext->cert_fingerprints.head)
+			mycertfp_delete((struct mycertfp *) n->data);
 
-	/* delete access entries */
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->access_list.head)
-		myuser_access_delete(mu, (char *)n->data);
+		/* delete memo ignores */
+		MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->ext->memo_ignores.head)
+		{
+			sfree(n->data);
+			mowgli_node_delete(n, &mu->ext->memo_ignores);
+			mowgli_node_free(n);
+		}
 
-	/* delete certfp entries */
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->cert_fingerprints.head)
-		mycertfp_delete((struct mycertfp *) n->data);
+		sfree(mu->ext);
+	}
 
 	/* delete their nicks and report them */
 	nicks[0] = '\0';
@@ -315,6 +344,12 @@ myuser_delete(struct myuser *mu)
 	strshare_unref(mu->email_canonical);
 	strshare_unref(entity(mu)->name);
 
+	if (mu->pass != NULL)
+	{
+		(void) smemzero(mu->pass, strlen(mu->pass));
+		(void) sfree(mu->pass);
+	}
+
 	mowgli_heap_free(myuser_heap, mu);
 
 	cnt.myuser--;
@@ -376,6 +411,8 @@ myuser_rename(struct myuser *mu, const char *name)
 		}
 	}
 
+	db_record_changed(DB_RECORD_MYUSER, mu, nb);
+
 	data.mu = mu;
 	data.oldname = nb;
 	hook_call_user_rename(&data);
@@ -407,6 +444,74 @@ myuser_set_email(struct myuser *mu, const char *newemail)
 
 	mu->email = strshare_get(newemail);
 	mu->email_canonical = canonicalize_email(newemail);
+
+	db_record_changed(DB_RECORD_MYUSER, mu, NULL);
+}
+
+/*
+ * myuser_set_pass(struct myuser *mu, const char *pass)
+ *
+ * Stores a password (or, usually, a password hash) for an account, in
+ * an allocation of its own size.
+ *
+ * Inputs:
+ *      - account to change
+ *      - password or hash; may be mu->pass itself
+ *
+ * Outputs:
+ *      - nothing
+ *
+ * Side Effects:
+ *      - the previous password is wiped and freed
+ */
+void
+myuser_set_pass(struct myuser *mu, const char *pass)
+{
+	return_if_fail(mu != NULL);
+
+	char *const old = mu->pass;
+
+	mu->pass = sstrndup((pass != NULL) ? pass : "", PASSLEN);
+
+	if (old != NULL)
+	{
+		(void) smemzero(old, strlen(old));
+		(void) sfree(old);
+	}
+}
+
+/*
+ * myuser_ext(struct myuser *mu)
+ *
+ * Returns the rarely used parts of an account, allocating them if this
+ * is the first time they are needed.  Use myuser_ext_peek() to read them.
+ */
+struct myuser_ext *
+myuser_ext(struct myuser *mu)
+{
+	return_val_if_fail(mu != NULL, NULL);
+
+	if (mu->ext == NULL)
+		mu->ext = smalloc(sizeof *mu->ext);
+
+	return mu->ext;
+}
+
+/*
+ * myuser_ext_peek(const struct myuser *mu)
+ *
+ * Like myuser_ext(), but never allocates; an account that has not needed
+ * them yet gets a shared block of empty lists and zeroes, which must not
+ * be changed.
+ */
+const struct myuser_ext *
+myuser_ext_peek(const struct myuser *mu)
+{
+	static const struct myuser_ext empty;
+
+	return_val_if_fail(mu != NULL, &empty);
+
+	return (mu->ext != NULL) ? mu->ext : &empty;
 }
 
 /*
@@ -529,7 +634,7 @@ myuser_access_verify(struct user *u, struct myuser *mu)
 	snprintf(buf3, sizeof buf3, "%s@%s", u->user, u->ip);
 	snprintf(buf4, sizeof buf4, "%s@%s", u->user, u->chost);
 
-	MOWGLI_ITER_FOREACH(n, mu->access_list.head)
+	MOWGLI_ITER_FOREACH(n, myuser_ext_peek(mu)->access_list.head)
 	{
 		char *entry = (char *) n->data;
 
@@ -562,7 +667,7 @@ myuser_access_add(struct myuser *mu, const char *mask)
 	return_val_if_fail(mu != NULL, false);
 	return_val_if_fail(mask != NULL, false);
 
-	if (MOWGLI_LIST_LENGTH(&mu->access_list) > me.mdlimit)
+	if (MOWGLI_LIST_LENGTH(&myuser_ext_peek(mu)->access_list) > me.mdlimit)
 	{
 		slog(LG_DEBUG, "myuser_access_add(): access entry limit reached for %s", entity(mu)->name);
 		return false;
@@ -570,9 +675,10 @@ myuser_access_add(struct myuser *mu, const char *mask)
 
 	msk = sstrdup(mask);
 	n = mowgli_node_create();
-	mowgli_node_add(msk, n, &mu->access_list);
+	mowgli_node_add(msk, n, &myuser_ext(mu)->access_list);
 
 	cnt.myuser_access++;
+	db_mark_dirty();
 
 	return true;
 }
@@ -597,7 +703,7 @@ myuser_access_find(struct myuser *mu, const char *mask)
 	return_val_if_fail(mu != NULL, NULL);
 	return_val_if_fail(mask != NULL, NULL);
 
-	MOWGLI_ITER_FOREACH(n, mu->access_list.head)
+	MOWGLI_ITER_FOREACH(n, myuser_ext_peek(mu)->access_list.head)
 	{
 		char *entry = (char *) n->data;
 
@@ -627,17 +733,18 @@ myuser_access_delete(struct myuser *mu, const char *mask)
 	return_if_fail(mu != NULL);
 	return_if_fail(mask != NULL);
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->access_list.head)
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, myuser_ext_peek(mu)->access_list.head)
 	{
 		char *entry = (char *) n->data;
 
 		if (!strcasecmp(entry, mask))
 		{
-			mowgli_node_delete(n, &mu->access_list);
+			mowgli_node_delete(n, &mu->ext->access_list);
 			mowgli_node_free(n);
 			sfree(entry);
 
 			cnt.myuser_access--;
+			db_mark_dirty();
 
 			return;
 		}
@@ -678,6 +785,7 @@ mynick_add(struct myuser *mu, const char *name)
 
 	mn = mowgli_heap_alloc(mynick_heap);
 	atheme_object_init(atheme_object(mn), name, (atheme_object_destructor_fn) mynick_delete);
+	atheme_object(mn)->type = ATHEME_OBJECT_MYNICK;
 
 	mowgli_strlcpy(mn->nick, name, sizeof mn->nick);
 	mn->owner = mu;
@@ -688,6 +796,11 @@ mynick_add(struct myuser *mu, const char *name)
 
 	myuser_name_restore(mn->nick, mu);
 
+	if (expiry_queued && nicksvs.expiry > 0)
+		expiry_queue_set(&mynick_expiry, mn, &mn->expiry_idx, CURRTIME);
+
+	db_record_changed(DB_RECORD_MYNICK, mn, NULL);
+
 	cnt.mynick++;
 
 	return mn;
@@ -715,10 +828,13 @@ mynick_delete(struct mynick *mn)
 	if (!(runflags & RF_STARTING))
 		slog(LG_DEBUG, "mynick_delete(): %s", mn->nick);
 
+	db_record_deleted(DB_RECORD_MYNICK, mn);
+
 	myuser_name_remember(mn->nick, mn->owner);
 
 	mowgli_patricia_delete(nicklist, mn->nick);
 	mowgli_node_delete(&mn->node, &mn->owner->nicks);
+	expiry_queue_delete(&mynick_expiry, &mn->expiry_idx);
 
 	mowgli_heap_free(mynick_heap, mn);
 
@@ -922,7 +1038,7 @@ mycertfp_add(struct myuser *mu, const char *certfp, const bool force)
 	return_val_if_fail(mu != NULL, NULL);
 	return_val_if_fail(certfp != NULL, NULL);
 
-	if (me.maxcertfp && MOWGLI_LIST_LENGTH(&mu->cert_fingerprints) >= me.maxcertfp && ! force)
+	if (me.maxcertfp && MOWGLI_LIST_LENGTH(&myuser_ext_peek(mu)->cert_fingerprints) >= me.maxcertfp && ! force)
 		return NULL;
 
 	struct mycertfp *const mcfp = mowgli_heap_alloc(mycertfp_heap);
@@ -930,9 +1046,11 @@ mycertfp_add(struct myuser *mu, const char *certfp, const bool force)
 	mcfp->mu = mu;
 	mcfp->certfp = sstrdup(certfp);
 
-	(void) mowgli_node_add(mcfp, &mcfp->node, &mu->cert_fingerprints);
+	(void) mowgli_node_add(mcfp, &mcfp->node, &myuser_ext(mu)->cert_fingerprints);
 	(void) mowgli_patricia_add(certfplist, mcfp->certfp, mcfp);
 
+	db_mark_dirty();
+
 	return mcfp;
 }
 
@@ -943,11 +1061,13 @@ mycertfp_delete(struct mycertfp *mcfp)
 	return_if_fail(mcfp->mu != NULL);
 	return_if_fail(mcfp->certfp != NULL);
 
-	mowgli_node_delete(&mcfp->node, &mcfp->mu->cert_fingerprints);
+	mowgli_node_delete(&mcfp->node, &mcfp->mu->ext->cert_fingerprints);
 	mowgli_patricia_delete(certfplist, mcfp->certfp);
 
 	sfree(mcfp->certfp);
 	mowgli_heap_free(mycertfp_heap, mcfp);
+
+	db_mark_dirty();
 }
 
 struct mycertfp *
@@ -958,6 +1078,114 @@ mycertfp_find(const char *certfp)
 	return mowgli_patricia_retrieve(certfplist, certfp);
 }
 
+/***************
+ * M Y M E M O *
+ ***************/
+
+/*
+ * mymemo_add(struct myuser *mu, const char *sender, const char *text,
+ *            time_t sent, unsigned int status)
+ *
+ * Adds a memo to the end of an account's inbox.  The text (truncated to
+ * MEMOLEN) goes to the memo store, so only the memo's header is kept in
+ * memory; the sender is shared with every other memo from the same sender.
+ *
+ * Inputs:
+ *      - account the memo is for
+ *      - sender, text, time sent and MEMO_* status flags
+ *
+ * Outputs:
+ *      - the new memo
+ *
+ * Side Effects:
+ *      - the account's count of unread memos is updated
+ */
+struct mymemo *
+mymemo_add(struct myuser *mu, const char *sender, const char *text, time_t sent, unsigned int status)
+{
+	struct mymemo *memo;
+	char buf[MEMOLEN + 1];
+
+	return_val_if_fail(mu != NULL, NULL);
+	return_val_if_fail(sender != NULL, NULL);
+	return_val_if_fail(text != NULL, NULL);
+
+	(void) mowgli_strlcpy(buf, text, sizeof buf);
+
+	memo = mowgli_heap_alloc(mymemo_heap);
+	memo->sender = strshare_get(sender);
+	memostore_put(memo, buf);
+	memo->sent = sent;
+	memo->status = status;
+
+	if (!(status & MEMO_READ))
+		mu->memoct_new++;
+
+	mowgli_node_add(memo, mowgli_node_create(), &mu->memos);
+
+	db_record_changed(DB_RECORD_MEMOS, mu, NULL);
+
+	return memo;
+}
+
+static void
+mymemo_free(struct myuser *mu, mowgli_node_t *n)
+{
+	struct mymemo *const memo = n->data;
+
+	if (!(memo->status & MEMO_READ))
+		mu->memoct_new--;
+
+	mowgli_node_delete(n, &mu->memos);
+	mowgli_node_free(n);
+
+	strshare_unref(memo->sender);
+	memostore_release(memo);
+	mowgli_heap_free(mymemo_heap, memo);
+}
+
+/*
+ * mymemo_delete(struct myuser *mu, mowgli_node_t *n)
+ *
+ * Removes a memo (given by its node in mu->memos) from an account's inbox
+ * and frees it.
+ */
+void
+mymemo_delete(struct myuser *mu, mowgli_node_t *n)
+{
+	return_if_fail(mu != NULL);
+	return_if_fail(n != NULL);
+
+	mymemo_free(mu, n);
+
+	db_record_changed(DB_RECORD_MEMOS, mu, NULL);
+}
+
+/*
+ * mymemo_text(const struct mymemo *memo, char *buf)
+ *
+ * Gets the text of a memo, reading it in from the memo store if need be.
+ *
+ * Inputs:
+ *      - the memo
+ *      - a buffer of at least MEMOLEN + 1 bytes to read the text into
+ *
+ * Outputs:
+ *      - the text (in buf, or kept with the memo), or NULL if it could not
+ *        be read; it is only valid until the next call with the same buf
+ *
+ * Side Effects:
+ *      - none
+ */
+const char *
+mymemo_text(const struct mymemo *memo, char *buf)
+{
+	return_val_if_fail(memo != NULL, NULL);
+	return_val_if_fail(buf != NULL, NULL);
+
+	return memostore_get(memo, buf);
+}
+
 /***************
  * M Y C H A N *
  ***************/
@@ -973,6 +1201,8 @@ mychan_delete(struct mychan *mc)
 	if (!(runflags & RF_STARTING))
 		slog(LG_DEBUG, "mychan_delete(): %s", mc->name);
 
+	db_record_deleted(DB_RECORD_MYCHAN, mc);
+
 	if (mc->chan != NULL)
 		mc->chan->mychan = NULL;
 
@@ -980,9 +1210,12 @@ mychan_delete(struct mychan *mc)
 	MOWGLI_ITER_FOREACH_SAFE(n, tn, mc->chanacs.head)
 		atheme_object_unref(n->data);
 
+	sfree(mc->chanacs_hash);
+
 	metadata_delete_all(mc);
 
 	mowgli_patricia_delete(mclist, mc->name);
+	expiry_queue_delete(&mychan_expiry, &mc->expiry_idx);
 
 	strshare_unref(mc->name);
 
@@ -1005,6 +1238,7 @@ mychan_add(char *name)
 	mc = mowgli_heap_alloc(mychan_heap);
 
 	atheme_object_init(atheme_object(mc), name, (atheme_object_destructor_fn) mychan_delete);
+	atheme_object(mc)->type = ATHEME_OBJECT_MYCHAN;
 	mc->name = strshare_get(name);
 	mc->registered = CURRTIME;
 	mc->chan = channel_find(name);
@@ -1014,6 +1248,11 @@ mychan_add(char *name)
 
 	mowgli_patricia_add(mclist, mc->name, mc);
 
+	if (expiry_queued)
+		expiry_queue_set(&mychan_expiry, mc, &mc->expiry_idx, CURRTIME);
+
+	db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
+
 	cnt.mychan++;
 
 	return mc;
@@ -1047,19 +1286,9 @@ mychan_isused(struct mychan *mc)
 unsigned int
 mychan_num_founders(struct mychan *mc)
 {
-	mowgli_node_t *n;
-	struct chanacs *ca;
-	unsigned int count = 0;
-
 	return_val_if_fail(mc != NULL, 0);
 
-	MOWGLI_ITER_FOREACH(n, mc->chanacs.head)
-	{
-		ca = n->data;
-		if (ca->entity != NULL && ca->level & CA_FOUNDER)
-			count++;
-	}
-	return count;
+	return mc->num_founders;
 }
 
 const char *
@@ -1072,6 +1301,9 @@ mychan_founder_names(struct mychan *mc)
 	return_val_if_fail(mc != NULL, NULL);
 
 	names[0] = '\0';
+	if (mc->num_founders == 0)
+		return names;
+
 	MOWGLI_ITER_FOREACH(n, mc->chanacs.head)
 	{
 		ca = n->data;
@@ -1371,6 +1603,131 @@ mychan_get_sts_mlock(struct mychan *mc)
  * C H A N A C S *
  *****************/
 
+/* Each mychan indexes its access list three ways, next to the full list in
+ * mychan -> chanacs that everything else iterates in order:
+ *
+ *   - every entity entry is chained into mychan -> chanacs_hash, keyed by the
+ *     entity pointer, for exact lookups;
+ *   - entity entries whose entity brings its own vtable (groups, exttargets)
+ *     are also on mychan -> chanacs_ext, as they can match other entities;
+ *   - hostmask entries are on mychan -> chanacs_host, with their match type
+ *     worked out once when they are added.
+ *
+ * The hash is allocated on first use and doubles when it holds more entries
+ * than buckets.
+ */
+#define CHANACS_HASH_MINSIZE    8U
+
+static inline unsigned int
+chanacs_hash_slot(const struct myentity *const mt, const unsigned int size)
+{
+	uint64_t h = (uint64_t) (uintptr_t) mt * UINT64_C(0x9E3779B97F4A7C15);
+
+	h ^= h >> 32;
+
+	return (unsigned int) h & (size - 1U);
+}
+
+static void
+chanacs_hash_resize(struct mychan *const mc, const unsigned int size)
+{
+	struct chanacs **const table = smalloc(size * sizeof *table);
+
+	for (unsigned int i = 0; i < mc->chanacs_hash_size; i++)
+	{
+		struct chanacs *ca = mc->chanacs_hash[i];
+
+		while (ca != NULL)
+		{
+			struct chanacs *const next = ca->hnext;
+			struct chanacs **pca = &table[chanacs_hash_slot(ca->entity, size)];
+
+			while (*pca != NULL)
+				pca = &(*pca)->hnext;
+
+			ca->hnext = NULL;
+			*pca = ca;
+			ca = next;
+		}
+	}
+
+	sfree(mc->chanacs_hash);
+	mc->chanacs_hash = table;
+	mc->chanacs_hash_size = size;
+}
+
+static inline bool
+chanacs_is_founder(const struct chanacs *const ca)
+{
+	return ca->entity != NULL && (ca->level & CA_FOUNDER);
+}
+
+static void
+chanacs_index_add(struct chanacs *const ca)
+{
+	struct mychan *const mc = ca->mychan;
+
+	if (chanacs_is_founder(ca))
+		mc->num_founders++;
+
+	if (ca->entity == NULL)
+	{
+		ca->match_type = chanban_match_type(ca->host);
+		mowgli_node_add(ca, &ca->lnode, &mc->chanacs_host);
+		return;
+	}
+
+	if (ca->entity->vtable != NULL)
+		mowgli_node_add(ca, &ca->lnode, &mc->chanacs_ext);
+
+	if (mc->chanacs_hash_count >= mc->chanacs_hash_size)
+		chanacs_hash_resize(mc, mc->chanacs_hash_size ? (mc->chanacs_hash_size * 2U) : CHANACS_HASH_MINSIZE);
+
+	const unsigned int slot = chanacs_hash_slot(ca->entity, mc->chanacs_hash_size);
+	struct chanacs **pca = &mc->chanacs_hash[slot];
+
+	// Keep duplicates of one entity in list order, so lookups return the oldest
+	while (*pca != NULL)
+		pca = &(*pca)->hnext;
+
+	ca->hnext = NULL;
+	*pca = ca;
+	mc->chanacs_hash_count++;
+}
+
+static void
+chanacs_index_delete(struct chanacs *const ca)
+{
+	struct mychan *const mc = ca->mychan;
+
+	if (chanacs_is_founder(ca))
+		mc->num_founders--;
+
+	if (ca->entity == NULL)
+	{
+		mowgli_node_delete(&ca->lnode, &mc->chanacs_host);
+		return;
+	}
+
+	if (ca->entity->vtable != NULL)
+		mowgli_node_delete(&ca->lnode, &mc->chanacs_ext);
+
+	if (mc->chanacs_hash == NULL)
+		return;
+
+	for (struct chanacs **pca = &mc->chanacs_hash[chanacs_hash_slot(ca->entity, mc->chanacs_hash_size)];
+	     *pca != NULL; pca = &(*pca)->hnext)
+	{
+		if (*pca != ca)
+			continue;
+
+		*pca = ca->hnext;
+		ca->hnext = NULL;
+		mc->chanacs_hash_count--;
+		return;
+	}
+}
+
 /* private destructor for struct chanacs */
 static void
 chanacs_delete(struct chanacs *ca)
@@ -1382,7 +1739,11 @@ chanacs_delete(struct chanacs *ca)
 		slog(LG_DEBUG, "chanacs_delete(): %s -> %s [%s]", ca->mychan->name,
 			ca->entity != NULL ? entity(ca->entity)->name : ca->host,
 			ca->entity != NULL ? "entity" : "hostmask");
+
+	db_record_deleted(DB_RECORD_CHANACS, ca);
+
 	mowgli_node_delete(&ca->cnode, &ca->mychan->chanacs);
+	chanacs_index_delete(ca);
 
 	if (ca->entity != NULL)
 	{
@@ -1437,6 +1798,7 @@ chanacs_add(struct mychan *mychan, struct myentity *mt, unsigned int level, time
 	ca = mowgli_heap_alloc(chanacs_heap);
 
 	atheme_object_init(atheme_object(ca), mt->name, (atheme_object_destructor_fn) chanacs_delete);
+	atheme_object(ca)->type = ATHEME_OBJECT_CHANACS;
 	ca->mychan = mychan;
 	ca->entity = isdynamic(mt) ? atheme_object_ref(mt) : mt;
 	ca->host = NULL;
@@ -1450,6 +1812,9 @@ chanacs_add(struct mychan *mychan, struct myentity *mt, unsigned int level, time
 
 	mowgli_node_add(ca, &ca->cnode, &mychan->chanacs);
 	mowgli_node_add(ca, &ca->unode, &mt->chanacs);
+	chanacs_index_add(ca);
+
+	db_record_changed(DB_RECORD_CHANACS, ca, NULL);
 
 	cnt.chanacs++;
 
@@ -1492,6 +1857,7 @@ chanacs_add_host(struct mychan *mychan, const char *host, unsigned int level, ti
 	ca = mowgli_heap_alloc(chanacs_heap);
 
 	atheme_object_init(atheme_object(ca), host, (atheme_object_destructor_fn) chanacs_delete);
+	atheme_object(ca)->type = ATHEME_OBJECT_CHANACS;
 	ca->mychan = mychan;
 	ca->entity = NULL;
 	ca->host = sstrdup(host);
@@ -1504,12 +1870,48 @@ chanacs_add_host(struct mychan *mychan, const char *host, unsigned int level, ti
 		ca->setter_uid[0] = '\0';
 
 	mowgli_node_add(ca, &ca->cnode, &mychan->chanacs);
+	chanacs_index_add(ca);
+
+	db_record_changed(DB_RECORD_CHANACS, ca, NULL);
 
 	cnt.chanacs++;
 
 	return ca;
 }
 
+/*
+ * chanacs_set_level(struct chanacs *ca, unsigned int level)
+ *
+ * Changes the flags of an access entry.
+ *
+ * Inputs:
+ *       - an access entry
+ *       - the new bitmask of privileges
+ *
+ * Outputs:
+ *       - nothing
+ *
+ * Side Effects:
+ *       - the channel's cached founder count is kept up to date; always
+ *         use this rather than writing to ca->level directly.
+ */
+void
+chanacs_set_level(struct chanacs *ca, unsigned int level)
+{
+	return_if_fail(ca != NULL);
+	return_if_fail(ca->mychan != NULL);
+
+	if (chanacs_is_founder(ca))
+		ca->mychan->num_founders--;
+
+	ca->level = level;
+
+	if (chanacs_is_founder(ca))
+		ca->mychan->num_founders++;
+
+	db_record_changed(DB_RECORD_CHANACS, ca, NULL);
+}
+
 struct chanacs *
 chanacs_find(struct mychan *mychan, struct myentity *mt, unsigned int level)
 {
@@ -1521,15 +1923,15 @@ chanacs_find(struct mychan *mychan, struct myentity *mt, unsigned int level)
 	if ((ca = chanacs_find_literal(mychan, mt, level)) != NULL)
 		return ca;
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	/* entities without a vtable of their own only match themselves, so
+	 * only the entries on chanacs_ext are left to try.
+	 */
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_ext.head)
 	{
 		const struct entity_vtable *vt;
 
 		ca = (struct chanacs *)n->data;
 
-		if (ca->entity == NULL)
-			continue;
-
 		vt = myentity_get_vtable(ca->entity);
 		if (level != 0x0)
 		{
@@ -1543,31 +1945,45 @@ chanacs_find(struct mychan *mychan, struct myentity *mt, unsigned int level)
 	return NULL;
 }
 
+static unsigned int
+chanacs_entity_literal_flags(struct mychan *mychan, struct myentity *mt)
+{
+	struct chanacs *ca;
+	unsigned int result = 0;
+
+	if (mychan->chanacs_hash == NULL)
+		return 0;
+
+	for (ca = mychan->chanacs_hash[chanacs_hash_slot(mt, mychan->chanacs_hash_size)]; ca != NULL; ca = ca->hnext)
+		if (ca->entity == mt)
+			result |= ca->level;
+
+	return result;
+}
+
 unsigned int
 chanacs_entity_flags(struct mychan *mychan, struct myentity *mt)
 {
 	mowgli_node_t *n;
 	struct chanacs *ca;
-	unsigned int result = 0;
+	unsigned int result;
 
 	return_val_if_fail(mychan != NULL && mt != NULL, 0);
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	result = chanacs_entity_literal_flags(mychan, mt);
+
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_ext.head)
 	{
 		const struct entity_vtable *vt;
 
 		ca = (struct chanacs *)n->data;
 
-		if (ca->entity == NULL)
-			continue;
 		if (ca->entity == mt)
+			continue;
+
+		vt = myentity_get_vtable(ca->entity);
+		if (vt->match_entity(ca->entity, mt))
 			result |= ca->level;
-		else
-		{
-			vt = myentity_get_vtable(ca->entity);
-			if (vt->match_entity(ca->entity, mt))
-				result |= ca->level;
-		}
 	}
 
 	slog(LG_DEBUG, "chanacs_entity_flags(%s, %s): return %s", mychan->name, mt->name, bitmask_to_flags(result));
@@ -1578,21 +1994,19 @@ chanacs_entity_flags(struct mychan *mychan, struct myentity *mt)
 struct chanacs *
 chanacs_find_literal(struct mychan *mychan, struct myentity *mt, unsigned int level)
 {
-	mowgli_node_t *n;
 	struct chanacs *ca;
 
 	return_val_if_fail(mychan != NULL && mt != NULL, NULL);
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	if (mychan->chanacs_hash == NULL)
+		return NULL;
+
+	for (ca = mychan->chanacs_hash[chanacs_hash_slot(mt, mychan->chanacs_hash_size)]; ca != NULL; ca = ca->hnext)
 	{
-		ca = (struct chanacs *)n->data;
+		if (ca->entity != mt)
+			continue;
 
-		if (level != 0x0)
-		{
-			if (ca->entity == mt && ((ca->level & level) == level))
-				return ca;
-		}
-		else if (ca->entity == mt)
+		if (level == 0x0 || (ca->level & level) == level)
 			return ca;
 	}
 
@@ -1607,16 +2021,16 @@ chanacs_find_host(struct mychan *mychan, const char *host, unsigned int level)
 
 	return_val_if_fail(mychan != NULL && host != NULL, NULL);
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_host.head)
 	{
 		ca = (struct chanacs *)n->data;
 
 		if (level != 0x0)
 		{
-			if ((ca->entity == NULL) && (!match(ca->host, host)) && ((ca->level & level) == level))
+			if (!match(ca->host, host) && (ca->level & level) == level)
 				return ca;
 		}
-		else if ((ca->entity == NULL) && (!match(ca->host, host)))
+		else if (!match(ca->host, host))
 			return ca;
 	}
 
@@ -1632,11 +2046,11 @@ chanacs_host_flags(struct mychan *mychan, const char *host)
 
 	return_val_if_fail(mychan != NULL && host != NULL, 0);
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_host.head)
 	{
 		ca = (struct chanacs *)n->data;
 
-		if (ca->entity == NULL && !match(ca->host, host))
+		if (!match(ca->host, host))
 			result |= ca->level;
 	}
 
@@ -1652,16 +2066,16 @@ chanacs_find_host_literal(struct mychan *mychan, const char *host, unsigned int
 	if ((!mychan) || (!host))
 		return NULL;
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_host.head)
 	{
 		ca = (struct chanacs *)n->data;
 
 		if (level != 0x0)
 		{
-			if ((ca->entity == NULL) && (!strcasecmp(ca->host, host)) && ((ca->level & level) == level))
+			if (!strcasecmp(ca->host, host) && (ca->level & level) == level)
 				return ca;
 		}
-		else if ((ca->entity == NULL) && (!strcasecmp(ca->host, host)))
+		else if (!strcasecmp(ca->host, host))
 			return ca;
 	}
 
@@ -1676,7 +2090,7 @@ chanacs_find_host_by_user(struct mychan *mychan, struct user *u, unsigned int le
 
 	return_val_if_fail(mychan != NULL && u != NULL, NULL);
 
-	for (n = next_matching_host_chanacs(mychan, u, mychan->chanacs.head); n != NULL; n = next_matching_host_chanacs(mychan, u, n->next))
+	for (n = next_matching_host_chanacs(mychan, u, mychan->chanacs_host.head); n != NULL; n = next_matching_host_chanacs(mychan, u, n->next))
 	{
 		ca = n->data;
 		if ((ca->level & level) == level)
@@ -1695,7 +2109,7 @@ chanacs_host_flags_by_user(struct mychan *mychan, struct user *u)
 
 	return_val_if_fail(mychan != NULL && u != NULL, 0);
 
-	for (n = next_matching_host_chanacs(mychan, u, mychan->chanacs.head); n != NULL; n = next_matching_host_chanacs(mychan, u, n->next))
+	for (n = next_matching_host_chanacs(mychan, u, mychan->chanacs_host.head); n != NULL; n = next_matching_host_chanacs(mychan, u, n->next))
 	{
 		ca = n->data;
 		result |= ca->level;
@@ -1755,15 +2169,18 @@ chanacs_entity_flags_by_user(struct mychan *mychan, struct user *u)
 	return_val_if_fail(mychan != NULL, 0);
 	return_val_if_fail(u != NULL, 0);
 
-	MOWGLI_ITER_FOREACH(n, mychan->chanacs.head)
+	/* an entity without a vtable of its own matches exactly the user's
+	 * account, which the hash answers directly.
+	 */
+	if (u->myuser != NULL)
+		result |= chanacs_entity_literal_flags(mychan, entity(u->myuser));
+
+	MOWGLI_ITER_FOREACH(n, mychan->chanacs_ext.head)
 	{
 		struct chanacs *ca = n->data;
 		struct myentity *mt;
 		const struct entity_vtable *vt;
 
-		if (ca->entity == NULL)
-			continue;
-
 		mt = ca->entity;
 		vt = myentity_get_vtable(mt);
 
@@ -1878,7 +2295,7 @@ chanacs_modify(struct chanacs *ca, unsigned int *addflags, unsigned int *removef
 	/* attempting to manipulate user with more privs? */
 	if (~restrictflags & ca->level)
 		return false;
-	ca->level = (ca->level | *addflags) & ~*removeflags;
+	chanacs_set_level(ca, (ca->level | *addflags) & ~*removeflags);
 	ca->tmodified = CURRTIME;
 	if (setter != NULL)
 		mowgli_strlcpy(ca->setter_uid, entity(setter)->id, sizeof ca->setter_uid);
@@ -1947,7 +2364,7 @@ chanacs_change(struct mychan *mychan, struct myentity *mt, const char *hostmask,
 			/* attempting to manipulate user with more privs? */
 			if (~restrictflags & ca->level)
 				return false;
-			ca->level = (ca->level | *addflags) & ~*removeflags;
+			chanacs_set_level(ca, (ca->level | *addflags) & ~*removeflags);
 			ca->tmodified = CURRTIME;
 			if (setter != NULL)
 				mowgli_strlcpy(ca->setter_uid, setter->id, sizeof ca->setter_uid);
@@ -1988,7 +2405,7 @@ chanacs_change(struct mychan *mychan, struct myentity *mt, const char *hostmask,
 			/* attempting to manipulate user with more privs? */
 			if (~restrictflags & ca->level)
 				return false;
-			ca->level = (ca->level | *addflags) & ~*removeflags;
+			chanacs_set_level(ca, (ca->level | *addflags) & ~*removeflags);
 			ca->tmodified = CURRTIME;
 			if (setter != NULL)
 				mowgli_strlcpy(ca->setter_uid, setter->id, sizeof ca->setter_uid);
@@ -2013,26 +2430,109 @@ chanacs_change_simple(struct mychan *mychan, struct myentity *mt, const char *ho
 	return chanacs_change(mychan, mt, hostmask, &a, &r, ca_all, setter);
 }
 
+static void
+myuser_expiry_requeue(struct myuser *const restrict mu, const time_t floor)
+{
+	time_t when;
+
+	if (mu->flags & MU_WAITAUTH)
+	{
+		when = mu->registered + SECONDS_PER_DAY;
+
+		if (nicksvs.expiry > 0 && mu->lastlogin + nicksvs.expiry < when)
+			when = mu->lastlogin + nicksvs.expiry;
+	}
+	else if (nicksvs.expiry > 0)
+		when = mu->lastlogin + nicksvs.expiry;
+	else
+	{
+		expiry_queue_delete(&myuser_expiry, &mu->expiry_idx);
+		return;
+	}
+
+	expiry_queue_set(&myuser_expiry, mu, &mu->expiry_idx, when > floor ? when : floor);
+}
+
+static void
+mynick_expiry_requeue(struct mynick *const restrict mn, const time_t floor)
+{
+	if (nicksvs.expiry == 0)
+	{
+		expiry_queue_delete(&mynick_expiry, &mn->expiry_idx);
+		return;
+	}
+
+	const time_t when = mn->lastseen + nicksvs.expiry;
+
+	expiry_queue_set(&mynick_expiry, mn, &mn->expiry_idx, when > floor ? when : floor);
+}
+
+static void
+mychan_expiry_requeue(struct mychan *const restrict mc, const time_t floor)
+{
+	// The last used time is refreshed about daily even if channels do not expire
+	unsigned int period = SECONDS_PER_DAY - SECONDS_PER_HOUR - SECONDS_PER_MINUTE;
+
+	if (chansvs.expiry > 0 && chansvs.expiry < period)
+		period = chansvs.expiry;
+
+	const time_t when = mc->used + period;
+
+	expiry_queue_set(&mychan_expiry, mc, &mc->expiry_idx, when > floor ? when : floor);
+}
+
 static int
-expire_myuser_cb(struct myentity *const restrict mt, void ATHEME_VATTR_UNUSED *const restrict unused)
+expiry_queue_myuser_cb(struct myentity *const restrict mt, void ATHEME_VATTR_UNUSED *const restrict unused)
 {
 	return_val_if_fail(isuser(mt), 0);
 
-	struct myuser *const mu = user(mt);
+	myuser_expiry_requeue(user(mt), 0);
+
+	return 0;
+}
+
+/* (Re)computes the time each account, nick and channel could first expire at,
+ * from their timestamps and the configured expiry periods.
+ */
+static void
+expiry_queue_all(void)
+{
+	struct mynick *mn;
+	struct mychan *mc;
+	mowgli_patricia_iteration_state_t state;
 
+	myentity_foreach_t(ENT_USER, &expiry_queue_myuser_cb, NULL);
+
+	MOWGLI_PATRICIA_FOREACH(mn, &state, nicklist)
+		mynick_expiry_requeue(mn, 0);
+
+	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
+		mychan_expiry_requeue(mc, 0);
+
+	expiry_queued = true;
+	expiry_queued_nick = nicksvs.expiry;
+	expiry_queued_chan = chansvs.expiry;
+}
+
+static bool
+expire_myuser(struct myuser *const restrict mu)
+{
 	if (mu->flags & MU_HOLD)
-		return 0;
+		return false;
 
 	/* Don't expire accounts with privs on them in atheme.conf,
 	 * otherwise someone can reregister them and take the privs.
 	 *   -- jilles
 	 */
 	if (is_conf_soper(mu))
-		return 0;
+		return false;
 
 	// If they're logged in, update lastlogin time.  -- jilles
 	if (MOWGLI_LIST_LENGTH(&mu->logins))
+	{
 		mu->lastlogin = CURRTIME;
+		db_record_touched(DB_RECORD_MYUSER, mu);
+	}
 
 	/* If they're unverified, expire them after a day. Otherwise, expire them
 	 * if expiration is enabled, and they have not logged in for that long.
@@ -2050,123 +2550,157 @@ expire_myuser_cb(struct myentity *const restrict mt, void ATHEME_VATTR_UNUSED *c
 	(void) hook_call_user_check_expire(&req);
 
 	// Don't let a hook prevent expiry of unverified accounts
-	if (uexpired || req.do_expire)
-	{
-		(void) slog(LG_REGISTER, "EXPIRE:%s: \2%s\2 from \2%s\2",
-		                         expired ? "CORE" : "HOOK", entity(mu)->name, mu->email);
+	if (!(uexpired || req.do_expire))
+		return false;
 
-		(void) slog(LG_VERBOSE, "expire_check(): %s expiring account %s (unused %us, email %s, logins %zu, "
-		                        "nicks %zu, chanacs %zu)", expired ? "core" : "hook", entity(mu)->name,
-		                        (unsigned int)(CURRTIME - mu->lastlogin), mu->email,
-		                        MOWGLI_LIST_LENGTH(&mu->logins), MOWGLI_LIST_LENGTH(&mu->nicks),
-		                        MOWGLI_LIST_LENGTH(&entity(mu)->chanacs));
+	(void) slog(LG_REGISTER, "EXPIRE:%s: \2%s\2 from \2%s\2",
+	                         expired ? "CORE" : "HOOK", entity(mu)->name, mu->email);
 
-		/* If they are logged in during expiration, the destructor
-		 * for this object will take care of logging them out.
-		 *   -- amdj
-		 */
-		(void) atheme_object_dispose(mu);
-	}
+	(void) slog(LG_VERBOSE, "expire_check(): %s expiring account %s (unused %us, email %s, logins %zu, "
+	                        "nicks %zu, chanacs %zu)", expired ? "core" : "hook", entity(mu)->name,
+	                        (unsigned int)(CURRTIME - mu->lastlogin), mu->email,
+	                        MOWGLI_LIST_LENGTH(&mu->logins), MOWGLI_LIST_LENGTH(&mu->nicks),
+	                        MOWGLI_LIST_LENGTH(&entity(mu)->chanacs));
 
-	return 0;
+	/* If they are logged in during expiration, the destructor
+	 * for this object will take care of logging them out.
+	 *   -- amdj
+	 */
+	(void) atheme_object_dispose(mu);
+
+	return true;
 }
 
-void
-expire_check(void *arg)
+static bool
+expire_mynick(struct mynick *const restrict mn)
 {
-	struct mynick *mn;
-	struct mychan *mc;
-	struct user *u;
-	mowgli_patricia_iteration_state_t state;
 	struct hook_expiry_req req;
+	struct user *u;
 
-	/* Let them know about this and the likely subsequent db_save()
-	 * right away -- jilles */
-	if (curr_uplink != NULL && curr_uplink->conn != NULL)
-		sendq_flush(curr_uplink->conn);
+	req.do_expire = 1;
+	req.data.mn = mn;
 
-	myentity_foreach_t(ENT_USER, &expire_myuser_cb, NULL);
+	hook_call_nick_check_expire(&req);
 
-	MOWGLI_PATRICIA_FOREACH(mn, &state, nicklist)
-	{
-		req.do_expire = 1;
-		req.data.mn = mn;
+	if (!req.do_expire)
+		return false;
 
-		hook_call_nick_check_expire(&req);
+	if (nicksvs.expiry > 0 && mn->lastseen < CURRTIME &&
+			(unsigned int)(CURRTIME - mn->lastseen) >= nicksvs.expiry)
+	{
+		if (MU_HOLD & mn->owner->flags)
+			return false;
 
-		if (!req.do_expire)
-			continue;
+		/* do not drop main nick like this */
+		if (!irccasecmp(mn->nick, entity(mn->owner)->name))
+			return false;
 
-		if (nicksvs.expiry > 0 && mn->lastseen < CURRTIME &&
-				(unsigned int)(CURRTIME - mn->lastseen) >= nicksvs.expiry)
+		u = user_find_named(mn->nick);
+		if (u != NULL && u->myuser == mn->owner)
 		{
-			if (MU_HOLD & mn->owner->flags)
-				continue;
+			/* still logged in, bleh */
+			mn->lastseen = CURRTIME;
+			mn->owner->lastlogin = CURRTIME;
+			db_record_touched(DB_RECORD_MYNICK, mn);
+			db_record_touched(DB_RECORD_MYUSER, mn->owner);
+			return false;
+		}
 
-			/* do not drop main nick like this */
-			if (!irccasecmp(mn->nick, entity(mn->owner)->name))
-				continue;
+		slog(LG_REGISTER, "EXPIRE: \2%s\2 from \2%s\2", mn->nick, entity(mn->owner)->name);
+		slog(LG_VERBOSE, "expire_check(): expiring nick %s (unused %lds, account %s)",
+				mn->nick, (long)(CURRTIME - mn->lastseen),
+				entity(mn->owner)->name);
+		atheme_object_unref(mn);
+		return true;
+	}
 
-			u = user_find_named(mn->nick);
-			if (u != NULL && u->myuser == mn->owner)
-			{
-				/* still logged in, bleh */
-				mn->lastseen = CURRTIME;
-				mn->owner->lastlogin = CURRTIME;
-				continue;
-			}
+	return false;
+}
 
-			slog(LG_REGISTER, "EXPIRE: \2%s\2 from \2%s\2", mn->nick, entity(mn->owner)->name);
-			slog(LG_VERBOSE, "expire_check(): expiring nick %s (unused %lds, account %s)",
-					mn->nick, (long)(CURRTIME - mn->lastseen),
-					entity(mn->owner)->name);
-			atheme_object_unref(mn);
-		}
-	}
+static bool
+expire_mychan(struct mychan *const restrict mc)
+{
+	struct hook_expiry_req req;
 
-	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
-	{
-		req.do_expire = 1;
-		req.data.mc = mc;
+	req.do_expire = 1;
+	req.data.mc = mc;
 
-		hook_call_channel_check_expire(&req);
+	hook_call_channel_check_expire(&req);
 
-		if (!req.do_expire)
-			continue;
+	if (!req.do_expire)
+		return false;
 
-		if ((unsigned int) (CURRTIME - mc->used) >= (SECONDS_PER_DAY - SECONDS_PER_HOUR - SECONDS_PER_MINUTE))
+	if ((unsigned int) (CURRTIME - mc->used) >= (SECONDS_PER_DAY - SECONDS_PER_HOUR - SECONDS_PER_MINUTE))
+	{
+		/* keep last used time accurate to
+		 * within a day, making sure an active
+		 * channel will never get "Last used"
+		 * in /cs info -- jilles */
+		if (mychan_isused(mc))
 		{
-			/* keep last used time accurate to
-			 * within a day, making sure an active
-			 * channel will never get "Last used"
-			 * in /cs info -- jilles */
-			if (mychan_isused(mc))
-			{
-				mc->used = CURRTIME;
-				slog(LG_DEBUG, "expire_check(): updating last used time on %s because it appears to be still in use", mc->name);
-				continue;
-			}
+			mc->used = CURRTIME;
+			db_record_touched(DB_RECORD_MYCHAN, mc);
+			slog(LG_DEBUG, "expire_check(): updating last used time on %s because it appears to be still in use", mc->name);
+			return false;
 		}
+	}
 
-		if (chansvs.expiry > 0 && mc->used < CURRTIME &&
-				(unsigned int)(CURRTIME - mc->used) >= chansvs.expiry)
-		{
-			if (MC_HOLD & mc->flags)
-				continue;
+	if (chansvs.expiry > 0 && mc->used < CURRTIME &&
+			(unsigned int)(CURRTIME - mc->used) >= chansvs.expiry)
+	{
+		if (MC_HOLD & mc->flags)
+			return false;
 
-			slog(LG_REGISTER, "EXPIRE: \2%s\2 from \2%s\2", mc->name, mychan_founder_names(mc));
-			slog(LG_VERBOSE, "expire_check(): expiring channel %s (unused %lds, founder %s, chanacs %zu)",
-					mc->name, (long)(CURRTIME - mc->used),
-					mychan_founder_names(mc),
-					MOWGLI_LIST_LENGTH(&mc->chanacs));
+		slog(LG_REGISTER, "EXPIRE: \2%s\2 from \2%s\2", mc->name, mychan_founder_names(mc));
+		slog(LG_VERBOSE, "expire_check(): expiring channel %s (unused %lds, founder %s, chanacs %zu)",
+				mc->name, (long)(CURRTIME - mc->used),
+				mychan_founder_names(mc),
+				MOWGLI_LIST_LENGTH(&mc->chanacs));
 
-			hook_call_channel_drop(mc);
-			if (mc->chan != NULL && !(mc->chan->flags & CHAN_LOG))
-				part(mc->name, chansvs.nick);
+		hook_call_channel_drop(mc);
+		if (mc->chan != NULL && !(mc->chan->flags & CHAN_LOG))
+			part(mc->name, chansvs.nick);
 
-			atheme_object_unref(mc);
-		}
+		atheme_object_unref(mc);
+		return true;
 	}
+
+	return false;
+}
+
+/* Accounts, nicks and channels are kept in expiry queues keyed by the
+ * earliest time they could expire (or need their last used time refreshed);
+ * these only move later as they are used, so only the entries that have come
+ * due are looked at here.  Whatever survives is queued again at its new time,
+ * but at least an hour from now, so that held ones and ones kept by a hook are
+ * looked at about as often as before.
+ */
+void
+expire_check(void *arg)
+{
+	struct myuser *mu;
+	struct mynick *mn;
+	struct mychan *mc;
+
+	/* Let them know about this and the likely subsequent db_save()
+	 * right away -- jilles */
+	if (curr_uplink != NULL && curr_uplink->conn != NULL)
+		sendq_flush(curr_uplink->conn);
+
+	if (!expiry_queued || expiry_queued_nick != nicksvs.expiry || expiry_queued_chan != chansvs.expiry)
+		expiry_queue_all();
+
+	while ((mu = expiry_queue_pop(&myuser_expiry, CURRTIME)) != NULL)
+		if (!expire_myuser(mu))
+			myuser_expiry_requeue(mu, CURRTIME + SECONDS_PER_HOUR);
+
+	while ((mn = expiry_queue_pop(&mynick_expiry, CURRTIME)) != NULL)
+		if (!expire_mynick(mn))
+			mynick_expiry_requeue(mn, CURRTIME + SECONDS_PER_HOUR);
+
+	while ((mc = expiry_queue_pop(&mychan_expiry, CURRTIME)) != NULL)
+		if (!expire_mychan(mc))
+			mychan_expiry_requeue(mc, CURRTIME + SECONDS_PER_HOUR);
 }
 
 static int
@@ -355,6 +355,7 @@ void
 atheme_setup(void)
 {
 	base_eventloop = mowgli_eventloop_create();
+	init_socket_queues();
         hooks_init();
 	db_init();
 
@@ -379,7 +380,13 @@ atheme_setup(void)
 void
 db_save_periodic(void *unused)
 {
-	slog(LG_DEBUG, "db_save_periodic(): initiating periodic database write");
+	if (config_options.db_save_skip_unchanged && ! db_dirty)
+	{
+		slog(LG_DEBUG, "db_save_periodic(): nothing has changed since the last database write, skipping it");
+		return;
+	}
+
+	slog(LG_DEBUG, "db_save_periodic(): initiating periodic database write (%u records changed)", db_changes);
 
 	db_save(unused, DB_SAVE_BG_REGULAR);
 }
@@ -489,6 +496,9 @@ atheme_main(int argc, char *argv[])
 #endif
 
 	(void) slog(LG_INFO, "Using Digest API frontend: %s", digest_get_frontend_info());
+#if (ATHEME_API_DIGEST_FRONTEND == ATHEME_API_DIGEST_FRONTEND_INTERNAL)
+	(void) slog(LG_INFO, "Using SHA2 multi-lane kernel: %s", digest_direct_lanes_name(digest_direct_lanes_impl()));
+#endif
 	(void) slog(LG_INFO, "Using Random API frontend: %s", random_get_frontend_info());
 
 	(void) slog(LG_INFO, "running digest testsuite...");
@@ -608,6 +618,7 @@ atheme_main(int argc, char *argv[])
 	io_loop();
 
 	/* we're shutting down */
+	authpool_shutdown();
 	hook_call_shutdown();
 
 	if (db_save && !readonly)
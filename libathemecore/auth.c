@@ -37,8 +37,8 @@ set_password(struct myuser *const restrict mu, const char *const restrict passwo
 
 	mu->flags |= MU_CRYPTPASS;
 
-	(void) smemzero(mu->pass, sizeof mu->pass);
-	(void) mowgli_strlcpy(mu->pass, hash, sizeof mu->pass);
+	(void) myuser_set_pass(mu, hash);
+	(void) db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 	(void) hook_call_myuser_changed_password_or_hash(mu);
 
 	return true;
@@ -79,17 +79,31 @@ verify_password(struct myuser *const restrict mu, const char *const restrict pas
 		 */
 		return (strcmp(mu->pass, password) == 0);
 
-	const char *new_hash;
-	const struct crypt_impl *ci, *ci_default;
+	const struct crypt_impl *ci;
 	unsigned int verify_flags = PWVERIFY_FLAG_NONE;
 
 	if (! (ci = crypt_verify_password(password, mu->pass, &verify_flags)))
 		// Verification failure
 		return false;
 
+	(void) verify_password_recrypt(mu, password, ci, verify_flags);
+
+	return true;
+}
+
+/* Called after a password was verified against the user's password hash by the given crypto provider, to
+ * re-encrypt it with the default provider if the hash came from a different one or is otherwise out of date.
+ */
+void
+verify_password_recrypt(struct myuser *const restrict mu, const char *const restrict password,
+                        const struct crypt_impl *const restrict ci, const unsigned int verify_flags)
+{
+	const char *new_hash;
+	const struct crypt_impl *ci_default;
+
 	if (! (ci_default = crypt_get_default_provider()))
 		// Verification succeeded but we don't have a module that can create new password hashes
-		return true;
+		return;
 
 	if (ci != ci_default)
 		(void) slog(LG_INFO, "%s: transitioning from crypt scheme '%s' to '%s' for account '%s'",
@@ -98,22 +112,16 @@ verify_password(struct myuser *const restrict mu, const char *const restrict pas
 		(void) slog(LG_INFO, "%s: re-encrypting password for account '%s'",
 		                     MOWGLI_FUNC_NAME, entity(mu)->name);
 	else
-		// Verification succeeded and re-encrypting not required, nothing more to do
-		return true;
+		// Re-encrypting not required, nothing more to do
+		return;
 
 	if (! (new_hash = ci_default->crypt(password, NULL)))
 	{
 		(void) slog(LG_DEBUG, "%s: failed to re-encrypt password for account '%s'",
 		                      MOWGLI_FUNC_NAME, entity(mu)->name);
-
-		// Verification succeeded and re-encrypting password failed
-		return true;
+		return;
 	}
 
-	(void) smemzero(mu->pass, sizeof mu->pass);
-	(void) mowgli_strlcpy(mu->pass, new_hash, sizeof mu->pass);
+	(void) myuser_set_pass(mu, new_hash);
 	(void) hook_call_myuser_changed_password_or_hash(mu);
-
-	// Verification succeeded and user's password re-encrypted
-	return true;
 }
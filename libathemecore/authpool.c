@@ -0,0 +1,714 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * atheme-services: A collection of minimalist IRC services
+ * authpool.c: Password verification on worker threads.
+ *
+ * Memory-hard password hashes take long enough to verify that a burst of
+ * logins (e.g. SASL after a netsplit) can stall the whole process. With
+ * general::auth_threads set, verify_password_async() hands the expensive part,
+ * the crypto providers' verify functions, to a bounded pool of threads, and
+ * the result is passed back to the main loop through a pipe.
+ *
+ * The worker threads run nothing but crypt_verify_password_by() on copies of
+ * the password and hash. They do not read the configuration: the providers'
+ * parameters (see crypt_verify_params()) and the enabled log levels are copied
+ * into each request when it is queued. Whatever the providers log there is
+ * kept with the request and logged on the main thread when it completes, and
+ * crypto providers are only (un)registered while no worker is using the list.
+ *
+ * While every worker is busy, a worker that takes a request also takes up to
+ * DIGEST_LANES_MAX - 1 more queued ones that its provider can verify together
+ * with it (e.g. PBKDF2v2 hashes with the same PRF and iteration count, whose
+ * derivations then run in the lanes of one SHA2 kernel); see crypt_batch_key().
+ */
+
+#include <atheme.h>
+#include "internal.h"
+
+#ifdef HAVE_LIBPTHREAD
+#  include <pthread.h>
+#  define AUTHPOOL_USE_THREADS 1
+#endif
+
+#define AUTHPOOL_MAX_THREADS    64U
+#define AUTHPOOL_BATCH_MAX      DIGEST_LANES_MAX        // requests verified together at most
+
+struct authpool_log
+{
+	struct authpool_log *           next;
+	unsigned int                    level;
+	char                            text[];
+};
+
+struct authpool_source
+{
+	char *                          name;
+	unsigned int                    count;          // requests from this source queued or running
+};
+
+struct verify_password_req
+{
+	struct verify_password_req *    next;           // in the queue or the completed list
+	verify_password_cb              cb;             // NULL once cancelled
+	void *                          priv;
+	struct authpool_source *        source;
+	char                            eid[IDLEN + 1];
+	char *                          password;
+	char *                          hash;           // the hash being verified, to check that it is still current
+	struct crypt_params *           params;         // the crypto providers' parameters when this was queued
+	unsigned int                    log_mask;       // the log levels enabled when this was queued
+	const struct crypt_impl *       batch_impl;     // only compared; see crypt_batch_key()
+	uint64_t                        batch_key;
+	const struct crypt_impl *       ci;             // filled in by the worker
+	unsigned int                    flags;          // filled in by the worker
+	struct authpool_log *           log;            // messages logged by the worker
+	struct authpool_log **          logtail;
+	struct timespec                 queued;
+};
+
+static struct authpool_stats authpool_stats;
+
+#ifdef AUTHPOOL_USE_THREADS
+
+static mowgli_patricia_t *authpool_sources = NULL;
+
+static pthread_mutex_t authpool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t authpool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_rwlock_t authpool_crypt_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_key_t authpool_current;
+static bool authpool_initialised = false;
+
+static pthread_t authpool_threads[AUTHPOOL_MAX_THREADS];
+static unsigned int authpool_nthreads = 0;      // threads started
+static unsigned int authpool_want = 0;          // threads that should keep running, protected by authpool_lock
+static unsigned int authpool_idle = 0;          // threads waiting for a request, protected by authpool_lock
+
+// both protected by authpool_lock
+static struct verify_password_req *authpool_queue = NULL;
+static struct verify_password_req **authpool_queue_tail = &authpool_queue;
+static struct verify_password_req *authpool_done = NULL;
+
+static int authpool_pipe[2] = { -1, -1 };
+static mowgli_eventloop_pollable_t *authpool_pollable = NULL;
+
+static void
+authpool_req_free(struct verify_password_req *const restrict req)
+{
+	struct authpool_log *log, *next;
+
+	for (log = req->log; log != NULL; log = next)
+	{
+		next = log->next;
+		(void) sfree(log);
+	}
+
+	(void) smemzerofree(req->password, strlen(req->password));
+	(void) crypt_params_free(req->params);
+	(void) sfree(req->hash);
+	(void) sfree(req);
+}
+
+static void
+authpool_source_release(struct authpool_source *const restrict src)
+{
+	if (src == NULL || --src->count != 0)
+		return;
+
+	(void) mowgli_patricia_delete(authpool_sources, src->name);
+	(void) sfree(src->name);
+	(void) sfree(src);
+}
+
+static void
+authpool_run(struct verify_password_req *const restrict req)
+{
+	(void) pthread_setspecific(authpool_current, req);
+	(void) pthread_rwlock_rdlock(&authpool_crypt_rwlock);
+
+	req->ci = crypt_verify_password_by(req->password, req->hash, &req->flags, true, req->params);
+
+	(void) pthread_rwlock_unlock(&authpool_crypt_rwlock);
+	(void) pthread_setspecific(authpool_current, NULL);
+}
+
+static void
+authpool_run_batch(struct verify_password_req *const *const restrict batch, const size_t n)
+{
+	struct crypt_verify_job jobs[AUTHPOOL_BATCH_MAX];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		jobs[i].password = batch[i]->password;
+		jobs[i].parameters = batch[i]->hash;
+		jobs[i].priv = batch[i];
+	}
+
+	(void) pthread_rwlock_rdlock(&authpool_crypt_rwlock);
+
+	const struct crypt_impl *const ci = crypt_verify_batch_by(jobs, n);
+
+	(void) pthread_rwlock_unlock(&authpool_crypt_rwlock);
+	(void) pthread_setspecific(authpool_current, NULL);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		// The provider has been unloaded or replaced since they were queued
+		if (ci == NULL)
+		{
+			(void) authpool_run(batch[i]);
+			continue;
+		}
+
+		batch[i]->ci = jobs[i].result ? ci : NULL;
+		batch[i]->flags = jobs[i].flags;
+	}
+}
+
+/* Takes the request at the head of the queue and, if no other worker is idle
+ * to take them instead, the queued requests that can be verified along with
+ * it. Returns how many were taken. Called with authpool_lock held.
+ */
+static size_t
+authpool_take(struct verify_password_req **const restrict batch)
+{
+	struct verify_password_req *const head = authpool_queue;
+	size_t n = 0;
+
+	batch[n++] = head;
+
+	if (! (authpool_queue = head->next))
+		authpool_queue_tail = &authpool_queue;
+
+	if (head->batch_impl == NULL || authpool_idle != 0)
+		return n;
+
+	struct verify_password_req **reqp = &authpool_queue;
+
+	while (*reqp != NULL && n < AUTHPOOL_BATCH_MAX)
+	{
+		struct verify_password_req *const req = *reqp;
+
+		if (req->batch_impl == head->batch_impl && req->batch_key == head->batch_key)
+		{
+			*reqp = req->next;
+			batch[n++] = req;
+		}
+		else
+			reqp = &req->next;
+	}
+
+	if (*reqp == NULL)
+		authpool_queue_tail = reqp;
+
+	return n;
+}
+
+// Runs on the main thread once the worker is done with a request
+static void
+authpool_complete(struct verify_password_req *const restrict req)
+{
+	struct timespec now;
+	struct authpool_log *log;
+
+	for (log = req->log; log != NULL; log = log->next)
+		(void) slog(log->level, "%s", log->text);
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+	const uint64_t latency = ((uint64_t) (now.tv_sec - req->queued.tv_sec) * UINT64_C(1000000000)) +
+	                         (uint64_t) now.tv_nsec - (uint64_t) req->queued.tv_nsec;
+
+	authpool_stats.queued--;
+	authpool_stats.completed++;
+	authpool_stats.latency_total += latency;
+
+	if (latency > authpool_stats.latency_max)
+		authpool_stats.latency_max = latency;
+
+	(void) authpool_source_release(req->source);
+
+	if (req->cb == NULL)
+	{
+		(void) authpool_req_free(req);
+		return;
+	}
+
+	struct myuser *const mu = myuser_find_uid(req->eid);
+	enum verify_password_result result = VERIFY_PASSWORD_FAILED;
+
+	// If the password was changed in the meantime, the old one must not work
+	if (mu != NULL && mu->pass != NULL && strcmp(mu->pass, req->hash) == 0)
+	{
+		const struct crypt_impl *ci = req->ci;
+		unsigned int flags = req->flags;
+
+		// Hashes that the worker did not recognise are left to the providers that must run here
+		if (ci == NULL && ! (flags & PWVERIFY_FLAG_MYMODULE))
+			ci = crypt_verify_password_by(req->password, req->hash, &flags, false, req->params);
+
+		if (ci != NULL)
+		{
+			(void) verify_password_recrypt(mu, req->password, ci, flags);
+			result = VERIFY_PASSWORD_OK;
+		}
+	}
+
+	(void) req->cb(mu, result, req->priv);
+	(void) authpool_req_free(req);
+}
+
+static void *
+authpool_worker(void *const restrict arg)
+{
+	const unsigned int index = (unsigned int) (uintptr_t) arg;
+
+	(void) pthread_mutex_lock(&authpool_lock);
+
+	for (;;)
+	{
+		while (index < authpool_want && authpool_queue == NULL)
+		{
+			authpool_idle++;
+			(void) pthread_cond_wait(&authpool_cond, &authpool_lock);
+			authpool_idle--;
+		}
+
+		if (index >= authpool_want)
+			break;
+
+		struct verify_password_req *batch[AUTHPOOL_BATCH_MAX];
+		const size_t n = authpool_take(batch);
+
+		(void) pthread_mutex_unlock(&authpool_lock);
+
+		if (n == 1)
+			(void) authpool_run(batch[0]);
+		else
+			(void) authpool_run_batch(batch, n);
+
+		(void) pthread_mutex_lock(&authpool_lock);
+
+		// Only the first completion since the main thread last looked needs to wake it up
+		if (authpool_done == NULL)
+		{
+			const ssize_t ATHEME_VATTR_UNUSED ret = write(authpool_pipe[1], "", 1);
+		}
+
+		for (size_t i = 0; i < n; i++)
+		{
+			batch[i]->next = authpool_done;
+			authpool_done = batch[i];
+		}
+	}
+
+	(void) pthread_mutex_unlock(&authpool_lock);
+
+	return NULL;
+}
+
+static void
+authpool_wakeup(mowgli_eventloop_t ATHEME_VATTR_UNUSED *const restrict eventloop,
+                mowgli_eventloop_io_t ATHEME_VATTR_UNUSED *const restrict io,
+                const mowgli_eventloop_io_dir_t ATHEME_VATTR_UNUSED dir,
+                void ATHEME_VATTR_UNUSED *const restrict userdata)
+{
+	char buf[64];
+
+	while (read(authpool_pipe[0], buf, sizeof buf) > 0)
+		;
+
+	(void) pthread_mutex_lock(&authpool_lock);
+	struct verify_password_req *req = authpool_done;
+	authpool_done = NULL;
+	(void) pthread_mutex_unlock(&authpool_lock);
+
+	// They were pushed onto the front of the list; complete them in the order they finished
+	struct verify_password_req *ordered = NULL;
+
+	while (req != NULL)
+	{
+		struct verify_password_req *const next = req->next;
+
+		req->next = ordered;
+		ordered = req;
+		req = next;
+	}
+
+	while (ordered != NULL)
+	{
+		struct verify_password_req *const next = ordered->next;
+
+		(void) authpool_complete(ordered);
+		ordered = next;
+	}
+}
+
+static bool
+authpool_init(void)
+{
+	if (authpool_initialised)
+		return true;
+
+	char errbuf[BUFSIZE];
+	int ret;
+
+	if ((ret = pthread_key_create(&authpool_current, NULL)) != 0)
+	{
+		(void) slog(LG_ERROR, "%s: pthread_key_create(3): %s", MOWGLI_FUNC_NAME,
+		                      sstrerror(ret, errbuf, sizeof errbuf));
+		return false;
+	}
+
+	if (pipe(authpool_pipe) != 0)
+	{
+		(void) slog(LG_ERROR, "%s: pipe(2): %s", MOWGLI_FUNC_NAME, sstrerror(errno, errbuf, sizeof errbuf));
+		(void) pthread_key_delete(authpool_current);
+		return false;
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		const int flags = fcntl(authpool_pipe[i], F_GETFL, 0);
+
+		(void) fcntl(authpool_pipe[i], F_SETFL, flags | O_NONBLOCK);
+		(void) fcntl(authpool_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+
+	authpool_pollable = mowgli_pollable_create(base_eventloop, authpool_pipe[0], NULL);
+	(void) mowgli_pollable_setselect(base_eventloop, authpool_pollable, MOWGLI_EVENTLOOP_IO_READ, &authpool_wakeup);
+
+	authpool_initialised = true;
+	return true;
+}
+
+// Stops the threads beyond the first want, waiting for them to finish what they are doing
+static void
+authpool_stop_threads(const unsigned int want)
+{
+	(void) pthread_mutex_lock(&authpool_lock);
+	authpool_want = want;
+	(void) pthread_cond_broadcast(&authpool_cond);
+	(void) pthread_mutex_unlock(&authpool_lock);
+
+	while (authpool_nthreads > want)
+		(void) pthread_join(authpool_threads[--authpool_nthreads], NULL);
+}
+
+#endif /* AUTHPOOL_USE_THREADS */
+
+// Starts or stops worker threads to match general::auth_threads
+void
+authpool_configure(void)
+{
+	unsigned int want = config_options.auth_threads;
+
+#ifdef AUTHPOOL_USE_THREADS
+	if (want > AUTHPOOL_MAX_THREADS)
+		want = AUTHPOOL_MAX_THREADS;
+
+	if (want > authpool_nthreads && ! authpool_init())
+		want = 0;
+
+	if (want < authpool_nthreads)
+	{
+		(void) authpool_stop_threads(want);
+
+		if (want == 0)
+		{
+			// Nobody is left to run what is still queued, so finish it here
+			(void) authpool_wakeup(base_eventloop, NULL, 0, NULL);
+
+			while (authpool_queue != NULL)
+			{
+				struct verify_password_req *const req = authpool_queue;
+
+				authpool_queue = req->next;
+				(void) authpool_run(req);
+				(void) authpool_complete(req);
+			}
+
+			authpool_queue_tail = &authpool_queue;
+		}
+	}
+	else if (want > authpool_nthreads)
+	{
+		sigset_t newset, oldset;
+		char errbuf[BUFSIZE];
+		int ret;
+
+		(void) pthread_mutex_lock(&authpool_lock);
+		authpool_want = want;
+		(void) pthread_mutex_unlock(&authpool_lock);
+
+		// Signals are handled on the main thread only
+		(void) sigfillset(&newset);
+		(void) pthread_sigmask(SIG_BLOCK, &newset, &oldset);
+
+		for (; authpool_nthreads < want; authpool_nthreads++)
+		{
+			void *const arg = (void *) (uintptr_t) authpool_nthreads;
+
+			if ((ret = pthread_create(&authpool_threads[authpool_nthreads], NULL, &authpool_worker, arg)) != 0)
+			{
+				(void) slog(LG_ERROR, "%s: pthread_create(3): %s", MOWGLI_FUNC_NAME,
+				                      sstrerror(ret, errbuf, sizeof errbuf));
+				break;
+			}
+		}
+
+		(void) pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+
+		(void) pthread_mutex_lock(&authpool_lock);
+		authpool_want = authpool_nthreads;
+		(void) pthread_mutex_unlock(&authpool_lock);
+	}
+
+	authpool_stats.threads = authpool_nthreads;
+#else
+	if (want != 0)
+		(void) slog(LG_INFO, "%s: this system has no POSIX threads; passwords are verified inline",
+		                     MOWGLI_FUNC_NAME);
+#endif
+}
+
+// Stops the worker threads at shutdown, dropping whatever is still queued
+void
+authpool_shutdown(void)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	if (! authpool_initialised)
+		return;
+
+	(void) authpool_stop_threads(0);
+
+	struct verify_password_req *const lists[] = { authpool_queue, authpool_done };
+
+	for (size_t i = 0; i < ARRAY_SIZE(lists); i++)
+	{
+		struct verify_password_req *req, *next;
+
+		for (req = lists[i]; req != NULL; req = next)
+		{
+			next = req->next;
+			(void) authpool_req_free(req);
+		}
+	}
+
+	authpool_queue = authpool_done = NULL;
+	authpool_queue_tail = &authpool_queue;
+
+	(void) mowgli_pollable_destroy(base_eventloop, authpool_pollable);
+	(void) close(authpool_pipe[0]);
+	(void) close(authpool_pipe[1]);
+	(void) pthread_key_delete(authpool_current);
+
+	authpool_initialised = false;
+	authpool_stats.threads = 0;
+#endif
+}
+
+void
+authpool_crypt_lock(void)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	(void) pthread_rwlock_wrlock(&authpool_crypt_rwlock);
+#endif
+}
+
+void
+authpool_crypt_unlock(void)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	(void) pthread_rwlock_unlock(&authpool_crypt_rwlock);
+#endif
+}
+
+/* Called by the logger for every message; keeps the ones logged by a worker
+ * thread with its request, to be logged when the request completes. Those at
+ * levels that were not enabled when the request was queued are dropped.
+ */
+bool
+authpool_log_deferred(const unsigned int level, const char *const restrict buf)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	if (! authpool_initialised)
+		return false;
+
+	struct verify_password_req *const req = pthread_getspecific(authpool_current);
+
+	if (req == NULL)
+		return false;
+
+	if (! (level & req->log_mask))
+		return true;
+
+	const size_t len = strlen(buf);
+	struct authpool_log *const log = smalloc(sizeof *log + len + 1);
+
+	log->level = level;
+	(void) memcpy(log->text, buf, len + 1);
+
+	*req->logtail = log;
+	req->logtail = &log->next;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/* Called by crypt_verify_params(); gives the copy of the crypto providers'
+ * parameters made for the request being verified, if any.
+ */
+const struct crypt_params *
+authpool_current_params(void)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	if (! authpool_initialised)
+		return NULL;
+
+	const struct verify_password_req *const req = pthread_getspecific(authpool_current);
+
+	return (req != NULL) ? req->params : NULL;
+#else
+	return NULL;
+#endif
+}
+
+/* Called by crypt_verify_job_enter(); makes the request of one job in a batch
+ * the one that log messages and crypt_verify_params() apply to.
+ */
+void
+authpool_set_current(void *const restrict req)
+{
+#ifdef AUTHPOOL_USE_THREADS
+	if (authpool_initialised)
+		(void) pthread_setspecific(authpool_current, req);
+#else
+	(void) req;
+#endif
+}
+
+/* Verifies a password like verify_password(), on a worker thread if there are
+ * any. The source (e.g. an IP address, may be NULL) is used to limit how many
+ * verifications one client can have queued at once.
+ *
+ * Returns VERIFY_PASSWORD_PENDING and sets *req if the verification was
+ * queued; the callback is then called later on the main thread, unless the
+ * request is cancelled with verify_password_cancel() first. Otherwise the
+ * verification was done (or refused) right away and the callback is not used.
+ */
+enum verify_password_result ATHEME_FATTR_WUR
+verify_password_async(struct myuser *const restrict mu, const char *const restrict password,
+                      const char *const restrict source, const verify_password_cb cb, void *const restrict priv,
+                      struct verify_password_req **const restrict reqp)
+{
+	return_val_if_fail(mu != NULL, VERIFY_PASSWORD_FAILED);
+	return_val_if_fail(password != NULL, VERIFY_PASSWORD_FAILED);
+	return_val_if_fail(*password != 0x00, VERIFY_PASSWORD_FAILED);
+	return_val_if_fail(cb != NULL, VERIFY_PASSWORD_FAILED);
+	return_val_if_fail(reqp != NULL, VERIFY_PASSWORD_FAILED);
+
+	*reqp = NULL;
+
+#ifdef AUTHPOOL_USE_THREADS
+	// Custom authentication modules and unencrypted passwords are handled inline, as before
+	if (authpool_nthreads == 0 || (auth_module_loaded && auth_user_custom) || ! (mu->flags & MU_CRYPTPASS))
+		return verify_password(mu, password) ? VERIFY_PASSWORD_OK : VERIFY_PASSWORD_FAILED;
+
+	if (authpool_stats.queued >= config_options.auth_queue_max)
+	{
+		(void) slog(LG_DEBUG, "%s: refusing to queue a verification for '%s' (%u queued)",
+		                      MOWGLI_FUNC_NAME, entity(mu)->name, authpool_stats.queued);
+
+		authpool_stats.rejected++;
+		return VERIFY_PASSWORD_BUSY;
+	}
+
+	struct authpool_source *src = NULL;
+
+	if (source != NULL && config_options.auth_source_max != 0)
+	{
+		if (authpool_sources == NULL)
+			authpool_sources = mowgli_patricia_create(NULL);
+
+		if ((src = mowgli_patricia_retrieve(authpool_sources, source)) == NULL)
+		{
+			src = smalloc(sizeof *src);
+			src->name = sstrdup(source);
+			(void) mowgli_patricia_add(authpool_sources, src->name, src);
+		}
+
+		if (src->count >= config_options.auth_source_max)
+		{
+			(void) slog(LG_DEBUG, "%s: refusing to queue a verification for '%s' from %s (%u queued)",
+			                      MOWGLI_FUNC_NAME, entity(mu)->name, source, src->count);
+
+			authpool_stats.rejected++;
+			return VERIFY_PASSWORD_BUSY;
+		}
+	}
+
+	struct verify_password_req *const req = smalloc(sizeof *req);
+
+	req->cb = cb;
+	req->priv = priv;
+	req->source = src;
+	req->password = sstrdup(password);
+	req->hash = sstrdup(mu->pass);
+	req->params = crypt_params_snapshot();
+	req->log_mask = log_enabled_levels();
+	req->logtail = &req->log;
+	(void) mowgli_strlcpy(req->eid, entity(mu)->id, sizeof req->eid);
+	(void) clock_gettime(CLOCK_MONOTONIC, &req->queued);
+
+	if (! crypt_batch_key(req->hash, &req->batch_impl, &req->batch_key))
+		req->batch_impl = NULL;
+
+	if (src != NULL)
+		src->count++;
+
+	if (++authpool_stats.queued > authpool_stats.queued_peak)
+		authpool_stats.queued_peak = authpool_stats.queued;
+
+	(void) pthread_mutex_lock(&authpool_lock);
+	*authpool_queue_tail = req;
+	authpool_queue_tail = &req->next;
+	(void) pthread_cond_signal(&authpool_cond);
+	(void) pthread_mutex_unlock(&authpool_lock);
+
+	*reqp = req;
+	return VERIFY_PASSWORD_PENDING;
+#else
+	(void) source;
+	(void) priv;
+
+	return verify_password(mu, password) ? VERIFY_PASSWORD_OK : VERIFY_PASSWORD_FAILED;
+#endif
+}
+
+/* Makes sure the callback of a pending verification will not be called, e.g.
+ * because its priv is about to go away. The verification itself still runs.
+ */
+void
+verify_password_cancel(struct verify_password_req *const restrict req)
+{
+	return_if_fail(req != NULL);
+
+	req->cb = NULL;
+	req->priv = NULL;
+}
+
+const struct authpool_stats *
+authpool_get_stats(void)
+{
+	return &authpool_stats;
+}
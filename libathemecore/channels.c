@@ -18,10 +18,103 @@
 
 mowgli_patricia_t *chanlist;
 
+/* Cached ban matches (struct chanuser -> ban_stamp) stay valid until the
+ * user's, the channel's or the global ban epoch moves past the stamp. All
+ * of them are drawn from this counter.
+ */
+uint64_t chanban_epoch = 0;
+uint64_t chanban_epoch_all = 0;
+
 static mowgli_heap_t *chan_heap = NULL;
 static mowgli_heap_t *chanuser_heap = NULL;
 static mowgli_heap_t *chanban_heap = NULL;
 
+/* Membership index: every struct chanuser is chained (through cu->hnext)
+ * into a bucket chosen by its (channel, user) pointer pair. The table is a
+ * power of two in size and doubles when it holds more entries than buckets,
+ * so lookups stay O(1) at the cost of one pointer per bucket and per entry.
+ */
+#define CHANUSER_HASH_MINSIZE   1024U
+
+static struct chanuser **chanuser_hash = NULL;
+static size_t chanuser_hash_size = 0;
+static size_t chanuser_hash_count = 0;
+
+static inline size_t
+chanuser_hash_slot(const struct channel *const chan, const struct user *const user, const size_t size)
+{
+	uint64_t h = (uint64_t) (uintptr_t) chan * UINT64_C(0x9E3779B97F4A7C15);
+
+	h ^= (uint64_t) (uintptr_t) user + UINT64_C(0x7F4A7C159E3779B9) + (h << 6) + (h >> 2);
+	h ^= h >> 29;
+	h *= UINT64_C(0xBF58476D1CE4E5B9);
+	h ^= h >> 32;
+
+	return (size_t) h & (size - 1U);
+}
+
+static void
+chanuser_hash_resize(const size_t size)
+{
+	struct chanuser **const table = smalloc(size * sizeof *table);
+
+	for (size_t i = 0; i < chanuser_hash_size; i++)
+	{
+		struct chanuser *cu = chanuser_hash[i];
+
+		while (cu != NULL)
+		{
+			struct chanuser *const next = cu->hnext;
+			const size_t slot = chanuser_hash_slot(cu->chan, cu->user, size);
+
+			cu->hnext = table[slot];
+			table[slot] = cu;
+			cu = next;
+		}
+	}
+
+	sfree(chanuser_hash);
+	chanuser_hash = table;
+	chanuser_hash_size = size;
+}
+
+static void
+chanuser_hash_add(struct chanuser *const cu)
+{
+	if (chanuser_hash_count >= chanuser_hash_size)
+		chanuser_hash_resize(chanuser_hash_size ? (chanuser_hash_size * 2U) : CHANUSER_HASH_MINSIZE);
+
+	const size_t slot = chanuser_hash_slot(cu->chan, cu->user, chanuser_hash_size);
+
+	cu->hnext = chanuser_hash[slot];
+	chanuser_hash[slot] = cu;
+	chanuser_hash_count++;
+}
+
+static void
+chanuser_hash_delete(struct chanuser *const cu)
+{
+	struct chanuser **pcu = &chanuser_hash[chanuser_hash_slot(cu->chan, cu->user, chanuser_hash_size)];
+
+	for (; *pcu != NULL; pcu = &(*pcu)->hnext)
+	{
+		if (*pcu != cu)
+			continue;
+
+		*pcu = cu->hnext;
+		cu->hnext = NULL;
+		chanuser_hash_count--;
+
+		// Give memory back after a large netsplit, but don't thrash around the threshold
+		if (chanuser_hash_size > CHANUSER_HASH_MINSIZE && chanuser_hash_count < (chanuser_hash_size / 8U))
+			chanuser_hash_resize(chanuser_hash_size / 2U);
+
+		return;
+	}
+
+	slog(LG_DEBUG, "chanuser_hash_delete(): %s -> %s was not indexed", cu->chan->name, cu->user->nick);
+}
+
 /*
  * init_channels()
  *
@@ -50,6 +143,8 @@ init_channels(void)
 	}
 
 	chanlist = mowgli_patricia_create(irccasecanon);
+
+	chanuser_hash_resize(CHANUSER_HASH_MINSIZE);
 }
 
 /*
@@ -166,6 +261,7 @@ channel_delete(struct channel *c)
 		soft_assert(is_internal_client(cu->user) && !me.connected);
 		mowgli_node_delete(&cu->cnode, &c->members);
 		mowgli_node_delete(&cu->unode, &cu->user->channels);
+		chanuser_hash_delete(cu);
 		mowgli_heap_free(chanuser_heap, cu);
 		cnt.chanuser--;
 	}
@@ -240,7 +336,12 @@ chanban_add(struct channel *chan, const char *mask, int type)
 	c->mask = sstrdup(mask);
 	c->type = type;
 
+	chanban_compile(c);
+	if (c->ext_type != '\0')
+		chan->numextbans++;
+
 	mowgli_node_add(c, &c->node, &chan->bans);
+	CHANBAN_EPOCH_BUMP(chan->ban_epoch);
 
 	return c;
 }
@@ -265,7 +366,13 @@ chanban_delete(struct chanban * c)
 	return_if_fail(c != NULL);
 
 	mowgli_node_delete(&c->node, &c->chan->bans);
+	CHANBAN_EPOCH_BUMP(c->chan->ban_epoch);
 
+	if (c->ext_type != '\0')
+		c->chan->numextbans--;
+
+	if (c->match_mask != c->mask)
+		sfree(c->match_mask);
 	sfree(c->mask);
 	mowgli_heap_free(chanban_heap, c);
 }
@@ -307,6 +414,62 @@ chanban_find(struct channel *chan, const char *mask, int type)
 	return NULL;
 }
 
+/*
+ * chanban_match_type(const char *mask)
+ *
+ * Classifies a ban mask by how it has to be matched.
+ *
+ * Inputs:
+ *     - mask to classify
+ *
+ * Outputs:
+ *     - CBAN_MATCH_CIDR if the host part could be a CIDR mask,
+ *       CBAN_MATCH_WILDCARD if the mask has match() wildcards or escapes,
+ *       CBAN_MATCH_LITERAL otherwise
+ *
+ * Side Effects:
+ *     - none
+ */
+unsigned int
+chanban_match_type(const char *mask)
+{
+	const char *p;
+
+	return_val_if_fail(mask != NULL, CBAN_MATCH_WILDCARD);
+
+	if ((p = strrchr(mask, '@')) != NULL && strchr(p, '/') != NULL)
+		return CBAN_MATCH_CIDR;
+
+	if (strpbrk(mask, "*?&#%\\") != NULL)
+		return CBAN_MATCH_WILDCARD;
+
+	return CBAN_MATCH_LITERAL;
+}
+
+/*
+ * chanban_match_mask(const struct chanban *cb, const char *name)
+ *
+ * Matches a nick!user@host string against a compiled ban's mask.
+ *
+ * Inputs:
+ *     - compiled channel ban
+ *     - nick!user@host to match
+ *
+ * Outputs:
+ *     - true if !match(cb->match_mask, name) would be
+ *
+ * Side Effects:
+ *     - none
+ */
+bool
+chanban_match_mask(const struct chanban *cb, const char *name)
+{
+	if (cb->match_type == CBAN_MATCH_LITERAL)
+		return irccasecmp(cb->match_mask, name) == 0;
+
+	return match(cb->match_mask, name) == 0;
+}
+
 /*
  * chanuser_add(struct channel *chan, const char *nick)
  *
@@ -402,6 +565,7 @@ chanuser_add(struct channel *chan, const char *nick)
 
 	mowgli_node_add(cu, &cu->cnode, &chan->members);
 	mowgli_node_add(cu, &cu->unode, &u->channels);
+	chanuser_hash_add(cu);
 
 	cnt.chanuser++;
 
@@ -453,6 +617,7 @@ chanuser_delete(struct channel *chan, struct user *user)
 
 	mowgli_node_delete(&cu->cnode, &chan->members);
 	mowgli_node_delete(&cu->unode, &user->channels);
+	chanuser_hash_delete(cu);
 
 	mowgli_heap_free(chanuser_heap, cu);
 
@@ -490,33 +655,17 @@ chanuser_delete(struct channel *chan, struct user *user)
 struct chanuser *
 chanuser_find(struct channel *chan, struct user *user)
 {
-	mowgli_node_t *n;
 	struct chanuser *cu;
 
 	return_val_if_fail(chan != NULL, NULL);
 	return_val_if_fail(user != NULL, NULL);
 
-	/* choose shortest list to search -- jilles */
-	if (MOWGLI_LIST_LENGTH(&user->channels) < MOWGLI_LIST_LENGTH(&chan->members))
-	{
-		MOWGLI_ITER_FOREACH(n, user->channels.head)
-		{
-			cu = (struct chanuser *)n->data;
-
-			if (cu->chan == chan)
-				return cu;
-		}
-	}
-	else
-	{
-		MOWGLI_ITER_FOREACH(n, chan->members.head)
-		{
-			cu = (struct chanuser *)n->data;
+	if (chanuser_hash_count == 0)
+		return NULL;
 
-			if (cu->user == user)
-				return cu;
-		}
-	}
+	for (cu = chanuser_hash[chanuser_hash_slot(chan, user, chanuser_hash_size)]; cu != NULL; cu = cu->hnext)
+		if (cu->chan == chan && cu->user == user)
+			return cu;
 
 	return NULL;
 }
@@ -360,6 +360,63 @@ match_cidr(const char *s1, const char *s2)
 		return 1;
 }
 
+/* cidr_parse_ip()
+ *
+ * Input - address, buffer of at least 16 bytes
+ * Output - the address length in bits (32 or 128) with the address stored
+ *          in addr, or 0 if the address is invalid
+ * Parses an address the way match_ips() does.
+ */
+unsigned int
+cidr_parse_ip(const char *ip, unsigned char *addr)
+{
+	if (ip == NULL)
+		return 0;
+
+	if (strchr(ip, ':'))
+		return inet_pton6(ip, addr) ? 128 : 0;
+
+	return inet_pton4(ip, addr) ? 32 : 0;
+}
+
+/* cidr_parse_mask()
+ *
+ * Input - cidr ip mask, buffer of at least 16 bytes
+ * Output - the address length in bits (32 or 128) with the address stored
+ *          in addr and the prefix length in *bits, or 0 if match_ips()
+ *          would never match anything against this mask
+ */
+unsigned int
+cidr_parse_mask(const char *s1, unsigned char *addr, unsigned int *bits)
+{
+	char ipmask[BUFSIZE];
+	char *len;
+	unsigned int maxbits;
+	int cidrlen;
+
+	if (s1 == NULL)
+		return 0;
+
+	mowgli_strlcpy(ipmask, s1, sizeof ipmask);
+
+	len = strrchr(ipmask, '/');
+	if (len == NULL)
+		return 0;
+
+	*len++ = '\0';
+
+	cidrlen = atoi(len);
+	maxbits = strchr(ipmask, ':') ? 128 : 32;
+	if (cidrlen <= 0 || (unsigned int) cidrlen > maxbits)
+		return 0;
+
+	if (cidr_parse_ip(ipmask, addr) != maxbits)
+		return 0;
+
+	*bits = cidrlen;
+	return maxbits;
+}
+
 int
 valid_ip_or_mask(const char *src)
 {
@@ -307,6 +307,14 @@ init_newconf(void)
 	add_duration_conf_item("CLONE_TIME", &conf_gi_table, 0, &config_options.clone_time, "m", 0);
 	add_duration_conf_item("COMMIT_INTERVAL", &conf_gi_table, 0, &config_options.commit_interval, "m", 300);
 	add_bool_conf_item("DB_SAVE_BLOCKING", &conf_gi_table, 0, &config_options.db_save_blocking, false);
+	add_bool_conf_item("DB_SAVE_SYNC", &conf_gi_table, 0, &config_options.db_save_sync, false);
+	add_uint_conf_item("DB_SAVE_SLICE", &conf_gi_table, 0, &config_options.db_save_slice, 0, 1000, 0);
+	add_bool_conf_item("DB_SAVE_SKIP_UNCHANGED", &conf_gi_table, 0, &config_options.db_save_skip_unchanged, false);
+	add_bool_conf_item("DB_JOURNAL", &conf_gi_table, 0, &config_options.db_journal, false);
+	add_uint_conf_item("DB_JOURNAL_COMPACT", &conf_gi_table, 0, &config_options.db_journal_compact, 0, INT_MAX, 10000);
+	add_uint_conf_item("AUTH_THREADS", &conf_gi_table, 0, &config_options.auth_threads, 0, 64, 0);
+	add_uint_conf_item("AUTH_QUEUE_MAX", &conf_gi_table, 0, &config_options.auth_queue_max, 1, INT_MAX, 1024);
+	add_uint_conf_item("AUTH_SOURCE_MAX", &conf_gi_table, 0, &config_options.auth_source_max, 0, 1000, 4);
 	add_dupstr_conf_item("OPERSTRING", &conf_gi_table, 0, &config_options.operstring, "is an IRC Operator");
 	add_dupstr_conf_item("SERVICESTRING", &conf_gi_table, 0, &config_options.servicestring, "is a Network Service");
 	add_bool_conf_item("MATCH_MASKS_THROUGH_VHOST", &conf_gi_table, 0, &config_options.masks_through_vhost, true);
@@ -318,6 +326,7 @@ init_newconf(void)
 	add_bool_conf_item("CLONE_IDENTIFIED_INCREASE_LIMIT", &conf_gi_table, 0, &config_options.clone_increase, false);
 
 	add_uint_conf_item("UPLINK_SENDQ_LIMIT", &conf_gi_table, 0, &config_options.uplink_sendq_limit, 10240, INT_MAX, 1048576);
+	add_uint_conf_item("UPLINK_RECVQ_BUDGET", &conf_gi_table, 0, &config_options.uplink_recvq_budget, 0, INT_MAX, 1000);
 	add_dupstr_conf_item("LANGUAGE", &conf_gi_table, 0, &config_options.language, "en");
 	add_conf_item("EXEMPTS", &conf_gi_table, c_gi_exempts);
 	add_bool_conf_item("ALLOW_TAINT", &conf_gi_table, 0, &config_options.allow_taint, false);
@@ -1006,6 +1015,9 @@ conf_rehash(void)
 	conf_process(cfp);
 	mowgli_config_file_free(cfp);
 
+	/* cached ban matches may depend on masks_through_vhost */
+	CHANBAN_EPOCH_BUMP(chanban_epoch_all);
+
 	/* now recheck */
 	if (!conf_check())
 	{
@@ -1030,7 +1042,10 @@ conf_rehash(void)
 	hook_call_config_ready();
 
 	if (curr_uplink && curr_uplink->conn)
+	{
 		sendq_set_limit(curr_uplink->conn, config_options.uplink_sendq_limit);
+		recvq_set_budget(curr_uplink->conn, config_options.uplink_recvq_budget);
+	}
 
 	remove_illegals();
 
@@ -1135,6 +1150,8 @@ conf_check(void)
 		commit_interval_timer = mowgli_timer_add(base_eventloop, "db_save_periodic", &db_save_periodic, NULL,
 		                                         config_options.commit_interval);
 
+	(void) authpool_configure();
+
 	return true;
 }
 
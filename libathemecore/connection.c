@@ -618,6 +618,15 @@ connection_setselect_read(struct connection *const restrict cptr, const connecti
 	                                 read_handler ? &connection_trampoline : NULL);
 }
 
+/* stop watching for readability without forgetting the read handler,
+ * or start again; lets the recvq stop reading while it has a backlog */
+void
+connection_pause_read(struct connection *const restrict cptr, const bool paused)
+{
+	(void) mowgli_pollable_setselect(base_eventloop, cptr->pollable, MOWGLI_EVENTLOOP_IO_READ,
+	                                 (cptr->read_handler && ! paused) ? &connection_trampoline : NULL);
+}
+
 void
 connection_setselect_write(struct connection *const restrict cptr, const connection_evhandler write_handler)
 {
@@ -671,6 +680,13 @@ connection_stats(void (*const stats_cb)(const char *, void *), void *const restr
 				(void) mowgli_strlcat(buf, " send_eof", sizeof buf);
 		}
 
+		char qbuf[BUFSIZE];
+
+		(void) snprintf(qbuf, sizeof qbuf, " sendq %zu peak %zu out %" PRIu64 "/%" PRIu64 " in %" PRIu64
+		                "/%" PRIu64, cptr->sendq_len, cptr->sendq_peak, cptr->sendq_bytes, cptr->sendq_syscalls,
+		                cptr->recvq_bytes, cptr->recvq_syscalls);
+		(void) mowgli_strlcat(buf, qbuf, sizeof buf);
+
 		(void) stats_cb(buf, privdata);
 	}
 }
@@ -16,8 +16,24 @@
 #include <atheme.h>
 #include "internal.h"
 
+// Longest "$id$" hash prefix a provider may declare
+#define CRYPT_PREFIX_MAXLEN     32U
+
 static mowgli_list_t crypt_impl_list = { NULL, NULL, 0 };
 
+// Hash prefix ("$id$") => the provider that declared it
+static mowgli_patricia_t *crypt_prefix_index = NULL;
+
+// A copy of one provider's parameters, made for a request to a password verification thread (see authpool.c)
+struct crypt_params
+{
+	struct crypt_params *           next;
+	const struct crypt_impl *       impl;
+	const void *                    live;           // the provider's own parameters, which this is a copy of
+	size_t                          size;
+	unsigned char                   data[];
+};
+
 static inline void
 crypt_log_modchg(const char *const restrict caller, const char *const restrict which,
                  const struct crypt_impl *const restrict impl)
@@ -33,10 +49,185 @@ crypt_log_modchg(const char *const restrict caller, const char *const restrict w
 		(void) slog(LG_ERROR, "%s: no encryption-capable crypto provider is available!", caller);
 }
 
+static inline bool
+crypt_prefix_valid(const char *const restrict prefix)
+{
+	const size_t len = strlen(prefix);
+
+	if (len < 3 || len > CRYPT_PREFIX_MAXLEN || prefix[0] != '$' || prefix[len - 1] != '$')
+		return false;
+
+	return (strchr(prefix + 1, '$') == prefix + len - 1);
+}
+
+static void
+crypt_prefix_index_add(const struct crypt_impl *const restrict impl)
+{
+	if (! impl->prefixes)
+		return;
+
+	if (! crypt_prefix_index)
+		crypt_prefix_index = mowgli_patricia_create(NULL);
+
+	for (const char *const *prefix = impl->prefixes; *prefix; prefix++)
+	{
+		const struct crypt_impl *owner;
+
+		if (! crypt_prefix_valid(*prefix))
+			(void) slog(LG_ERROR, "%s: crypto provider '%s' declares invalid prefix '%s' (BUG)",
+			                      MOWGLI_FUNC_NAME, impl->id, *prefix);
+		else if ((owner = mowgli_patricia_retrieve(crypt_prefix_index, *prefix)))
+			(void) slog(LG_ERROR, "%s: prefix '%s' of crypto provider '%s' already belongs to '%s'",
+			                      MOWGLI_FUNC_NAME, *prefix, impl->id, owner->id);
+		else
+			(void) mowgli_patricia_add(crypt_prefix_index, *prefix, (void *) ((uintptr_t) impl));
+	}
+}
+
+static void
+crypt_prefix_index_del(const struct crypt_impl *const restrict impl)
+{
+	if (! impl->prefixes || ! crypt_prefix_index)
+		return;
+
+	for (const char *const *prefix = impl->prefixes; *prefix; prefix++)
+		if (mowgli_patricia_retrieve(crypt_prefix_index, *prefix) == impl)
+			(void) mowgli_patricia_delete(crypt_prefix_index, *prefix);
+}
+
+/* Returns the provider that declared the "$id$" prefix of the given password hash, if any. Hashes with such an
+ * owner are only ever given to that provider; the others are tried against every provider without prefixes.
+ */
+static const struct crypt_impl *
+crypt_prefix_owner(const char *const restrict parameters)
+{
+	char prefix[CRYPT_PREFIX_MAXLEN + 1];
+
+	if (! crypt_prefix_index || parameters[0] != '$')
+		return NULL;
+
+	const char *const end = strchr(parameters + 1, '$');
+
+	if (! end || (size_t) (end - parameters) >= CRYPT_PREFIX_MAXLEN)
+		return NULL;
+
+	const size_t len = (size_t) (end - parameters) + 1;
+
+	(void) memcpy(prefix, parameters, len);
+	prefix[len] = 0x00;
+
+	return mowgli_patricia_retrieve(crypt_prefix_index, prefix);
+}
+
+// Tries one provider; on failure, *flags says whether the hash was its own
+static bool
+crypt_verify_with(const struct crypt_impl *const restrict ci, const char *const restrict password,
+                  const char *const restrict parameters, unsigned int *const restrict flags)
+{
+	*flags = PWVERIFY_FLAG_NONE;
+
+	if (ci->verify)
+		return ci->verify(password, parameters, flags);
+
+	if (ci->crypt)
+	{
+		const char *const result = ci->crypt(password, parameters);
+
+		if (result && strcmp(result, parameters) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// Which providers crypt_verify_common() may use
+#define CRYPT_VERIFY_ALL        0U
+#define CRYPT_VERIFY_THREADED   1U      // those whose verify function may run on a worker thread
+#define CRYPT_VERIFY_MAIN       2U      // the others
+
+static const struct crypt_params *
+crypt_params_find(const struct crypt_params *cp, const struct crypt_impl *const restrict ci)
+{
+	for (; cp; cp = cp->next)
+		if (cp->impl == ci && cp->live == ci->params && cp->size == ci->params_size)
+			return cp;
+
+	return NULL;
+}
+
+static inline bool
+crypt_verify_allowed(const struct crypt_impl *const restrict ci, const unsigned int which,
+                     const struct crypt_params *const restrict params)
+{
+	if (which == CRYPT_VERIFY_ALL)
+		return true;
+
+	// A provider registered after the request was queued has no copy of its parameters to use on the thread
+	const bool threaded = ci->verify && ! ci->verify_main_thread &&
+	                      (! ci->params_size || crypt_params_find(params, ci));
+
+	return ((which == CRYPT_VERIFY_THREADED) == threaded);
+}
+
+static const struct crypt_impl *
+crypt_verify_common(const char *const restrict password, const char *const restrict parameters,
+                    unsigned int *const restrict flags, const unsigned int which,
+                    const struct crypt_params *const restrict params)
+{
+	const struct crypt_impl *const owner = crypt_prefix_owner(parameters);
+	unsigned int myflags;
+	mowgli_node_t *n;
+
+	*flags = PWVERIFY_FLAG_NONE;
+
+	if (owner)
+	{
+		if (! crypt_verify_allowed(owner, which, params))
+			return NULL;
+
+		if (crypt_verify_with(owner, password, parameters, &myflags))
+		{
+			*flags = myflags;
+			return owner;
+		}
+
+		// The hash cannot belong to anyone else
+		*flags = PWVERIFY_FLAG_MYMODULE;
+		return NULL;
+	}
+
+	MOWGLI_ITER_FOREACH(n, crypt_impl_list.head)
+	{
+		const struct crypt_impl *const ci = n->data;
+
+		if (ci->prefixes || ! crypt_verify_allowed(ci, which, params))
+			continue;
+
+		if (crypt_verify_with(ci, password, parameters, &myflags))
+		{
+			*flags = myflags;
+			return ci;
+		}
+
+		/* If password verification failed and the password hash was produced
+		 * by the module we just tried, there's no point continuing to test it
+		 * against the other modules. This saves some CPU time.
+		 */
+		if (myflags & PWVERIFY_FLAG_MYMODULE)
+		{
+			*flags = PWVERIFY_FLAG_MYMODULE;
+			return NULL;
+		}
+	}
+
+	return NULL;
+}
+
 void
 crypt_register(const struct crypt_impl *const restrict impl)
 {
-	if (! impl || ! impl->id || ! *impl->id || ! (impl->crypt || impl->verify))
+	if (! impl || ! impl->id || ! *impl->id || ! (impl->crypt || impl->verify) || (impl->params_size && ! impl->params) ||
+	    (! impl->batch_key != ! impl->verify_batch) || (impl->verify_batch && ! (impl->verify && impl->prefixes)))
 	{
 		(void) slog(LG_ERROR, "%s: invalid parameters (BUG)", MOWGLI_FUNC_NAME);
 		return;
@@ -57,7 +248,10 @@ crypt_register(const struct crypt_impl *const restrict impl)
 	 * To avoid the cast generating a diagnostic due to dropping a const qualifier, we first cast to uintptr_t.
 	 * This is not unprecedented in this codebase; libathemecore/strshare.c does the same thing.
 	 */
+	(void) authpool_crypt_lock();
 	(void) mowgli_node_add((void *) ((uintptr_t) impl), n, &crypt_impl_list);
+	(void) crypt_prefix_index_add(impl);
+	(void) authpool_crypt_unlock();
 	(void) crypt_log_modchg(MOWGLI_FUNC_NAME, "registered", impl);
 }
 
@@ -76,7 +270,10 @@ crypt_unregister(const struct crypt_impl *const restrict impl)
 	{
 		if (n->data == impl)
 		{
+			(void) authpool_crypt_lock();
 			(void) mowgli_node_delete(n, &crypt_impl_list);
+			(void) crypt_prefix_index_del(impl);
+			(void) authpool_crypt_unlock();
 			(void) mowgli_node_free(n);
 
 			(void) crypt_log_modchg(MOWGLI_FUNC_NAME, "unregistered", impl);
@@ -123,49 +320,145 @@ const struct crypt_impl * ATHEME_FATTR_WUR
 crypt_verify_password(const char *const restrict password, const char *const restrict parameters,
                       unsigned int *const restrict flags)
 {
-	mowgli_node_t *n;
+	unsigned int myflags;
+
+	const struct crypt_impl *const ci = crypt_verify_common(password, parameters, &myflags, CRYPT_VERIFY_ALL, NULL);
 
 	if (flags)
-		*flags = PWVERIFY_FLAG_NONE;
+		*flags = (ci ? myflags : PWVERIFY_FLAG_NONE);
+
+	return ci;
+}
+
+/* Like crypt_verify_password(), but only tries the providers whose verify function may run on a password
+ * verification worker thread (see authpool.c), or only the others (crypt-only providers, those with
+ * verify_main_thread set, and those without a copy of their parameters in the request's snapshot), which the
+ * main thread tries afterwards if none of the former recognised the hash.
+ */
+const struct crypt_impl * ATHEME_FATTR_WUR
+crypt_verify_password_by(const char *const restrict password, const char *const restrict parameters,
+                         unsigned int *const restrict flags, const bool threaded,
+                         const struct crypt_params *const restrict params)
+{
+	const unsigned int which = threaded ? CRYPT_VERIFY_THREADED : CRYPT_VERIFY_MAIN;
+
+	return crypt_verify_common(password, parameters, flags, which, params);
+}
+
+/* Gives the provider that a password hash would be verified by on a password verification thread, and the key
+ * that it computes from the hash, if it can verify several hashes with equal keys at once (see authpool.c).
+ */
+bool ATHEME_FATTR_WUR
+crypt_batch_key(const char *const restrict parameters, const struct crypt_impl **const restrict impl,
+                uint64_t *const restrict key)
+{
+	const struct crypt_impl *const owner = crypt_prefix_owner(parameters);
+
+	if (! owner || ! owner->verify_batch || owner->verify_main_thread || ! owner->batch_key(parameters, key))
+		return false;
+
+	*impl = owner;
+	return true;
+}
+
+/* Like crypt_verify_password_by() with threaded set, for the password hashes of several jobs at once, if they all
+ * belong to one provider with a verify_batch function that may still run on this thread. The results are left in
+ * the jobs and that provider is returned; otherwise nothing is verified and NULL is returned.
+ */
+const struct crypt_impl * ATHEME_FATTR_WUR
+crypt_verify_batch_by(struct crypt_verify_job *const restrict jobs, const size_t n)
+{
+	const struct crypt_impl *const owner = crypt_prefix_owner(jobs[0].parameters);
+
+	if (! owner || ! owner->verify_batch)
+		return NULL;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		(void) crypt_verify_job_enter(&jobs[i]);
+
+		if (crypt_prefix_owner(jobs[i].parameters) != owner ||
+		    ! crypt_verify_allowed(owner, CRYPT_VERIFY_THREADED, authpool_current_params()))
+			return NULL;
+
+		jobs[i].flags = PWVERIFY_FLAG_NONE;
+		jobs[i].result = false;
+	}
+
+	(void) owner->verify_batch(jobs, n);
+
+	// The hashes cannot belong to anyone else
+	for (size_t i = 0; i < n; i++)
+		if (! jobs[i].result)
+			jobs[i].flags = PWVERIFY_FLAG_MYMODULE;
+
+	return owner;
+}
+
+/* Copies the parameters of every provider that has any, when a request is queued for a password verification
+ * thread; the thread then compares hashes against these copies, while the originals may be changed by a rehash.
+ */
+struct crypt_params *
+crypt_params_snapshot(void)
+{
+	struct crypt_params *head = NULL;
+	mowgli_node_t *n;
 
 	MOWGLI_ITER_FOREACH(n, crypt_impl_list.head)
 	{
 		const struct crypt_impl *const ci = n->data;
 
-		if (ci->verify)
-		{
-			unsigned int myflags = PWVERIFY_FLAG_NONE;
+		if (! ci->params_size)
+			continue;
 
-			if (ci->verify(password, parameters, &myflags))
-			{
-				if (flags)
-					*flags = myflags;
+		struct crypt_params *const cp = smalloc(sizeof *cp + ci->params_size);
 
-				return ci;
-			}
+		cp->next = head;
+		cp->impl = ci;
+		cp->live = ci->params;
+		cp->size = ci->params_size;
 
-			/* If password verification failed and the password hash was produced
-			 * by the module we just tried, there's no point continuing to test it
-			 * against the other modules. This saves some CPU time.
-			 */
-			if (myflags & PWVERIFY_FLAG_MYMODULE)
-				return NULL;
+		(void) memcpy(cp->data, ci->params, ci->params_size);
 
-			continue;
-		}
+		head = cp;
+	}
 
-		if (ci->crypt)
-		{
-			const char *const result = ci->crypt(password, parameters);
+	return head;
+}
 
-			if (result && strcmp(result, parameters) == 0)
-				return ci;
+void
+crypt_params_free(struct crypt_params *cp)
+{
+	while (cp)
+	{
+		struct crypt_params *const next = cp->next;
 
-			continue;
-		}
+		(void) sfree(cp);
+		cp = next;
 	}
+}
 
-	return NULL;
+/* Returns the parameters that a provider's verify function should compare a hash against, given the address of
+ * the ones that it has registered (crypt_impl::params): on a password verification thread, the copy made when the
+ * request was queued, and otherwise those themselves.
+ */
+const void *
+crypt_verify_params(const void *const restrict params)
+{
+	for (const struct crypt_params *cp = authpool_current_params(); cp; cp = cp->next)
+		if (cp->live == params)
+			return cp->data;
+
+	return params;
+}
+
+/* Called by a provider's verify_batch function before it works on (or logs about) one of the jobs; the parameters
+ * that crypt_verify_params() gives and the request that log messages are kept with are then that job's.
+ */
+void
+crypt_verify_job_enter(const struct crypt_verify_job *const restrict job)
+{
+	(void) authpool_set_current(job->priv);
 }
 
 const char *
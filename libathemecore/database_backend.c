@@ -13,6 +13,28 @@
 
 static mowgli_patricia_t *db_types = NULL;
 
+/* Row types seen while loading, in an open-addressed table probed from a
+ * hash of the first two bytes and the length of the type. Each slot caches
+ * the handler found in db_types (revalidated when handlers are registered
+ * or unregistered) and accumulates how long rows of that type took to load.
+ */
+#define DB_TYPE_SLOTS           256U
+#define DB_TYPE_MAXLEN          15U
+
+struct db_type_slot
+{
+	char                    type[DB_TYPE_MAXLEN + 1];
+	database_handler_fn     fun;
+	unsigned int            generation;
+	unsigned int            rows;
+	uint64_t                nsec;
+};
+
+static struct db_type_slot db_type_slots[DB_TYPE_SLOTS];
+static unsigned int db_types_generation = 1;
+static struct db_type_slot *db_stats_last = NULL;
+static struct timespec db_stats_stamp;
+
 const struct database_module *db_mod = NULL;
 
 struct database_handle *
@@ -33,13 +55,92 @@ db_close(struct database_handle *db)
 	return db_mod->db_close(db);
 }
 
+static uint64_t
+db_stats_elapsed(const struct timespec *const begin, const struct timespec *const end)
+{
+	return ((uint64_t) (end->tv_sec - begin->tv_sec) * UINT64_C(1000000000)) +
+	       (uint64_t) end->tv_nsec - (uint64_t) begin->tv_nsec;
+}
+
+// Charge the time since the previous row started to that row's type
+static void
+db_stats_charge(void)
+{
+	struct timespec now;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if (db_stats_last != NULL)
+	{
+		db_stats_last->rows++;
+		db_stats_last->nsec += db_stats_elapsed(&db_stats_stamp, &now);
+	}
+
+	db_stats_stamp = now;
+}
+
+static int
+db_stats_compare(const void *const a, const void *const b)
+{
+	const struct db_type_slot *const sa = *(const struct db_type_slot *const *) a;
+	const struct db_type_slot *const sb = *(const struct db_type_slot *const *) b;
+
+	return (sa->nsec < sb->nsec) - (sa->nsec > sb->nsec);
+}
+
+static void
+db_stats_report(const struct database_handle *const db, const struct timespec *const begin)
+{
+	const struct db_type_slot *sorted[DB_TYPE_SLOTS];
+	struct timespec end;
+	unsigned int count = 0;
+	unsigned int rows = 0;
+
+	db_stats_charge();
+	db_stats_last = NULL;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (unsigned int i = 0; i < DB_TYPE_SLOTS; i++)
+	{
+		if (! db_type_slots[i].rows)
+			continue;
+
+		sorted[count++] = &db_type_slots[i];
+		rows += db_type_slots[i].rows;
+	}
+
+	qsort(sorted, count, sizeof sorted[0], &db_stats_compare);
+
+	slog(LG_INFO, "db_parse(): loaded %u rows from %s in %.3fs", rows, db->file,
+	     (double) db_stats_elapsed(begin, &end) / 1000000000.0);
+
+	for (unsigned int i = 0; i < count; i++)
+		slog(LG_VERBOSE, "db_parse():   %-*s %10u rows %10.3fms", (int) DB_TYPE_MAXLEN, sorted[i]->type,
+		     sorted[i]->rows, (double) sorted[i]->nsec / 1000000.0);
+}
+
 void
 db_parse(struct database_handle *db)
 {
+	struct timespec begin;
+
 	return_if_fail(db_mod != NULL);
 	return_if_fail(db_mod->db_parse != NULL);
 
-	return db_mod->db_parse(db);
+	for (unsigned int i = 0; i < DB_TYPE_SLOTS; i++)
+	{
+		db_type_slots[i].rows = 0;
+		db_type_slots[i].nsec = 0;
+	}
+
+	db_stats_last = NULL;
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+	db_stats_stamp = begin;
+
+	db_mod->db_parse(db);
+
+	db_stats_report(db, &begin);
 }
 
 bool
@@ -251,6 +352,7 @@ db_register_type_handler(const char *type, database_handler_fn fun)
 	return_if_fail(fun != NULL);
 
 	mowgli_patricia_add(db_types, type, fun);
+	db_types_generation++;
 }
 
 void
@@ -260,22 +362,80 @@ db_unregister_type_handler(const char *type)
 	return_if_fail(type != NULL);
 
 	mowgli_patricia_delete(db_types, type);
+	db_types_generation++;
+}
+
+static database_handler_fn
+db_lookup_handler(const char *type)
+{
+	database_handler_fn fun = mowgli_patricia_retrieve(db_types, type);
+
+	if (!fun)
+		fun = mowgli_patricia_retrieve(db_types, "???");
+
+	return fun;
+}
+
+/* Find or claim the slot for a row type; NULL if the type is too long or
+ * the table is full, in which case the row is dispatched uncached.
+ */
+static struct db_type_slot *
+db_type_slot_find(const char *const type)
+{
+	const size_t len = strlen(type);
+
+	if (! len || len > DB_TYPE_MAXLEN)
+		return NULL;
+
+	const unsigned int c0 = (unsigned char) ToUpper(type[0]);
+	const unsigned int c1 = (unsigned char) ToUpper(type[1]);
+	unsigned int i = ((c0 << 8) ^ (c1 * 33U) ^ ((unsigned int) len * 131U)) % DB_TYPE_SLOTS;
+
+	for (unsigned int probes = 0; probes < DB_TYPE_SLOTS; probes++, i = (i + 1U) % DB_TYPE_SLOTS)
+	{
+		struct db_type_slot *const slot = &db_type_slots[i];
+
+		if (slot->type[0] == '\0')
+		{
+			(void) memcpy(slot->type, type, len + 1);
+			slot->generation = 0;
+			return slot;
+		}
+
+		if (! strcasecmp(slot->type, type))
+			return slot;
+	}
+
+	return NULL;
 }
 
 void
 db_process(struct database_handle *db, const char *type)
 {
+	struct db_type_slot *slot;
 	database_handler_fn fun;
 
 	return_if_fail(db_types != NULL);
 	return_if_fail(db != NULL);
 	return_if_fail(type != NULL);
 
-	fun = mowgli_patricia_retrieve(db_types, type);
+	db_stats_charge();
 
-	if (!fun)
+	if ((slot = db_type_slot_find(type)) == NULL)
 	{
-		fun = mowgli_patricia_retrieve(db_types, "???");
+		db_stats_last = NULL;
+		fun = db_lookup_handler(type);
+	}
+	else
+	{
+		if (slot->generation != db_types_generation)
+		{
+			slot->fun = db_lookup_handler(type);
+			slot->generation = db_types_generation;
+		}
+
+		db_stats_last = slot;
+		fun = slot->fun;
 	}
 
 	fun(db, type);
@@ -305,3 +465,99 @@ db_init(void)
 		exit(EXIT_FAILURE);
 	}
 }
+
+unsigned int db_changes = 0;
+bool db_dirty = false;
+
+// what had changed when the save being written began, see db_mark_saving()
+static unsigned int db_changes_saving;
+static unsigned int db_dirty_gen;
+static unsigned int db_dirty_gen_saving;
+
+/* Tell the storage backend that a record has been created or changed, so
+ * that a journalling backend can log it before the next full save.  Changes
+ * made while the database is being loaded are not reported.
+ */
+void
+db_record_changed(enum db_record_type type, void *object, const char *key)
+{
+	return_if_fail(object != NULL);
+
+	if (runflags & RF_STARTING)
+		return;
+
+	db_changes++;
+	db_dirty = true;
+	db_dirty_gen++;
+
+	hook_call_db_change((&(struct hook_db_change){ .type = type, .object = object, .key = key }));
+}
+
+// Likewise for a record that is about to be destroyed
+void
+db_record_deleted(enum db_record_type type, void *object)
+{
+	return_if_fail(object != NULL);
+
+	if (runflags & RF_STARTING)
+		return;
+
+	db_changes++;
+	db_dirty = true;
+	db_dirty_gen++;
+
+	hook_call_db_change((&(struct hook_db_change){ .type = type, .object = object, .deleted = true }));
+}
+
+/* Only the last-login, last-seen or last-used time of a record has changed.
+ * That makes the database dirty, but is neither counted in db_changes nor
+ * worth journalling every time it happens.
+ */
+void
+db_record_touched(enum db_record_type type, void *object)
+{
+	return_if_fail(object != NULL);
+
+	if (runflags & RF_STARTING)
+		return;
+
+	db_dirty = true;
+	db_dirty_gen++;
+
+	hook_call_db_change((&(struct hook_db_change){ .type = type, .object = object, .touched = true }));
+}
+
+/* Something that is saved but not reported as a record (e.g. a group, or the
+ * access list of an account) has changed, so the next periodic save must not
+ * be skipped.
+ */
+void
+db_mark_dirty(void)
+{
+	if (runflags & RF_STARTING)
+		return;
+
+	db_dirty = true;
+	db_dirty_gen++;
+}
+
+// Called by the backend when it starts writing services.db
+void
+db_mark_saving(void)
+{
+	db_changes_saving = db_changes;
+	db_dirty_gen_saving = db_dirty_gen;
+}
+
+/* Called by the backend once the save begun by the last db_mark_saving() is
+ * on disk; what has changed since that save began is still unsaved.
+ */
+void
+db_mark_saved(void)
+{
+	db_changes -= (db_changes_saving < db_changes) ? db_changes_saving : db_changes;
+	db_changes_saving = 0;
+
+	if (db_dirty_gen == db_dirty_gen_saving)
+		db_dirty = false;
+}
@@ -18,6 +18,12 @@
 
 #define SENDQSIZE (4096 - 40)
 
+/* maximum number of blocks handed to the kernel in one sendmsg() call */
+#define SENDQ_IOVMAX 64
+
+/* maximum number of bytes read from the uplink per readiness event */
+#define RECVQ_DRAINMAX (64 * SENDQSIZE)
+
 #ifdef MOWGLI_OS_WIN
 # define EWOULDBLOCK	WSAEWOULDBLOCK
 # define EALREADY	WSAEALREADY
@@ -32,37 +38,114 @@ struct sendq {
 	char buf[SENDQSIZE];
 };
 
+static mowgli_heap_t *sendq_heap = NULL;
+
 void
-sendq_add(struct connection * cptr, char *buf, size_t len)
+init_socket_queues(void)
 {
-	mowgli_node_t *n;
+	sendq_heap = sharedheap_get(sizeof(struct sendq));
+
+	if (sendq_heap == NULL)
+	{
+		slog(LG_INFO, "init_socket_queues(): block allocator failure.");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static struct sendq *
+sendq_block_add(mowgli_list_t *q)
+{
+	struct sendq *sq;
+
+	sq = mowgli_heap_alloc(sendq_heap);
+	sq->firstused = sq->firstfree = 0;
+	mowgli_node_add(sq, &sq->node, q);
+
+	return sq;
+}
+
+static void
+sendq_block_delete(struct sendq *sq, mowgli_list_t *q)
+{
+	mowgli_node_delete(&sq->node, q);
+	mowgli_heap_free(sendq_heap, sq);
+}
+
+/* drop the first len bytes of a queue, keeping one (empty) block around */
+static void
+sendq_block_consume(mowgli_list_t *q, size_t len)
+{
+	mowgli_node_t *n, *tn;
 	struct sendq *sq;
 	size_t l;
-	int pos = 0;
 
-	return_if_fail(cptr != NULL);
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, q->head)
+	{
+		sq = n->data;
+
+		l = sq->firstfree - sq->firstused;
+		if (l > len)
+			l = len;
+		sq->firstused += l;
+		len -= l;
+
+		if (sq->firstused != sq->firstfree)
+			return;
+
+		if (MOWGLI_LIST_LENGTH(q) > 1)
+			sendq_block_delete(sq, q);
+		else
+			/* keep one struct sendq */
+			sq->firstused = sq->firstfree = 0;
+
+		if (len == 0)
+			return;
+	}
+}
+
+/* account for len more bytes on the sendq; returns false if they must not be added */
+static bool
+sendq_reserve(struct connection *cptr, size_t len)
+{
+	return_val_if_fail(cptr != NULL, false);
 
 	if (CF_IS_DEAD(cptr) || CF_IS_SEND_EOF(cptr))
 	{
 		slog(LG_DEBUG, "sendq_add(): attempted to send to fd %d which is already dead", cptr->fd);
-		return;
+		return false;
 	}
 
 	if (len == 0)
-		return;
+		return false;
 
-	if (cptr->sendq_limit != 0 &&
-			MOWGLI_LIST_LENGTH(&cptr->sendq) * SENDQSIZE + len > cptr->sendq_limit)
+	if (cptr->sendq_limit != 0 && cptr->sendq_len + len > cptr->sendq_limit)
 	{
 		slog(LG_INFO, "sendq_add(): sendq limit exceeded on connection %s[%d]",
 				cptr->name, cptr->fd);
 		cptr->flags |= CF_DEAD;
-		return;
+		return false;
 	}
 
 	if (!sendq_nonempty(cptr))
 		connection_setselect_write(cptr, sendq_flush);
 
+	cptr->sendq_len += len;
+	cptr->sendq_bytes += len;
+	if (cptr->sendq_len > cptr->sendq_peak)
+		cptr->sendq_peak = cptr->sendq_len;
+
+	return true;
+}
+
+/* copy bytes accounted for by sendq_reserve() to the end of the sendq */
+static void
+sendq_append(struct connection *cptr, const char *buf, size_t len)
+{
+	mowgli_node_t *n;
+	struct sendq *sq;
+	size_t l;
+	size_t pos = 0;
+
 	n = cptr->sendq.tail;
 	if (n != NULL)
 	{
@@ -78,8 +161,7 @@ sendq_add(struct connection * cptr, char *buf, size_t len)
 
 	while (len > 0)
 	{
-		sq = smalloc(sizeof *sq);
-		mowgli_node_add(sq, &sq->node, &cptr->sendq);
+		sq = sendq_block_add(&cptr->sendq);
 		l = SENDQSIZE;
 		if (l > len)
 			l = len;
@@ -90,6 +172,28 @@ sendq_add(struct connection * cptr, char *buf, size_t len)
 	}
 }
 
+void
+sendq_add(struct connection * cptr, char *buf, size_t len)
+{
+	if (!sendq_reserve(cptr, len))
+		return;
+
+	sendq_append(cptr, buf, len);
+}
+
+/* add a line made of a prefix and a text, and terminate it with \r\n,
+ * without assembling it in a buffer first */
+void
+sendq_add_line(struct connection *cptr, const char *prefix, size_t prefixlen, const char *text, size_t textlen)
+{
+	if (!sendq_reserve(cptr, prefixlen + textlen + 2))
+		return;
+
+	sendq_append(cptr, prefix, prefixlen);
+	sendq_append(cptr, text, textlen);
+	sendq_append(cptr, "\r\n", 2);
+}
+
 void
 sendq_add_eof(struct connection * cptr)
 {
@@ -105,27 +209,66 @@ sendq_add_eof(struct connection * cptr)
 	cptr->flags |= CF_SEND_EOF;
 }
 
+/* hand as much of the sendq as possible to the kernel in one call */
+static ssize_t
+sendq_write(struct connection *cptr, size_t *wanted)
+{
+	mowgli_node_t *n;
+	struct sendq *sq;
+
+#ifndef MOWGLI_OS_WIN
+	struct iovec iov[SENDQ_IOVMAX];
+	struct msghdr msg;
+	size_t iovcnt = 0;
+
+	*wanted = 0;
+
+	MOWGLI_ITER_FOREACH(n, cptr->sendq.head)
+	{
+		sq = n->data;
+
+		if (sq->firstused == sq->firstfree || iovcnt == SENDQ_IOVMAX)
+			break;
+
+		iov[iovcnt].iov_base = sq->buf + sq->firstused;
+		iov[iovcnt].iov_len = sq->firstfree - sq->firstused;
+		*wanted += iov[iovcnt].iov_len;
+		iovcnt++;
+	}
+
+	memset(&msg, 0, sizeof msg);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
+	cptr->sendq_syscalls++;
+
+	return sendmsg(cptr->fd, &msg, 0);
+#else
+	n = cptr->sendq.head;
+	sq = n->data;
+	*wanted = sq->firstfree - sq->firstused;
+
+	cptr->sendq_syscalls++;
+
+	return send(cptr->fd, sq->buf + sq->firstused, *wanted, 0);
+#endif
+}
+
 void
 sendq_flush(struct connection * cptr)
 {
-        mowgli_node_t *n, *tn;
-        struct sendq *sq;
-        int l;
+	ssize_t l;
+	size_t wanted;
 
 	return_if_fail(cptr != NULL);
 
-        MOWGLI_ITER_FOREACH_SAFE(n, tn, cptr->sendq.head)
-        {
-                sq = (struct sendq *)n->data;
-
-                if (sq->firstused == sq->firstfree)
-                        break;
-
-                if ((l = send(cptr->fd, sq->buf + sq->firstused, sq->firstfree - sq->firstused, 0)) == -1)
-                {
-                        int err = ioerrno();
+	while (cptr->sendq_len > 0)
+	{
+		if ((l = sendq_write(cptr, &wanted)) == -1)
+		{
+			int err = ioerrno();
 
-                        if (!mowgli_eventloop_ignore_errno(err))
+			if (!mowgli_eventloop_ignore_errno(err))
 			{
 				slog(LG_DEBUG, "sendq_flush(): write error %d (%s) on connection %s[%d]",
 						err, strerror(err),
@@ -133,24 +276,16 @@ sendq_flush(struct connection * cptr)
 				cptr->flags |= CF_DEAD;
 			}
 
-                        return;
-                }
+			return;
+		}
 
-                sq->firstused += l;
-                if (sq->firstused == sq->firstfree)
-                {
-			if (MOWGLI_LIST_LENGTH(&cptr->sendq) > 1)
-			{
-                        	mowgli_node_delete(&sq->node, &cptr->sendq);
-				sfree(sq);
-			}
-			else
-				/* keep one struct sendq */
-				sq->firstused = sq->firstfree = 0;
-                }
-                else
-                        return;
-        }
+		sendq_block_consume(&cptr->sendq, l);
+		cptr->sendq_len -= l;
+
+		/* short write, the socket buffer is full */
+		if ((size_t) l < wanted)
+			return;
+	}
 	if (CF_IS_SEND_EOF(cptr))
 	{
 		/* shut down write end, kill entire connection
@@ -168,18 +303,11 @@ sendq_flush(struct connection * cptr)
 bool
 sendq_nonempty(struct connection *cptr)
 {
-	mowgli_node_t *n;
-	struct sendq *sq;
-
 	if (CF_IS_SEND_DEAD(cptr))
 		return false;
 	if (CF_IS_SEND_EOF(cptr))
 		return true;
-	n = cptr->sendq.head;
-	if (n == NULL)
-		return false;
-	sq = n->data;
-	return sq->firstfree > sq->firstused;
+	return cptr->sendq_len > 0;
 }
 
 void
@@ -188,27 +316,119 @@ sendq_set_limit(struct connection *cptr, size_t len)
 	cptr->sendq_limit = len;
 }
 
-int
-recvq_length(struct connection *cptr)
+/* drop an empty head block, e.g. one left behind by recvq_getline_inplace() */
+static void
+recvq_trim(struct connection *cptr)
 {
-	int l = 0;
 	mowgli_node_t *n;
 	struct sendq *sq;
 
-	MOWGLI_ITER_FOREACH(n, cptr->recvq.head)
+	n = cptr->recvq.head;
+	if (n == NULL)
+		return;
+	sq = n->data;
+	if (sq->firstused != sq->firstfree)
+		return;
+
+	if (MOWGLI_LIST_LENGTH(&cptr->recvq) > 1)
+		sendq_block_delete(sq, &cptr->recvq);
+	else
+		/* keep one struct sendq */
+		sq->firstused = sq->firstfree = 0;
+}
+
+int
+recvq_length(struct connection *cptr)
+{
+	return cptr->recvq_len;
+}
+
+void
+recvq_set_budget(struct connection *cptr, unsigned int lines)
+{
+	cptr->recvq_budget = lines;
+}
+
+static void recvq_resume(void *arg);
+
+/* call the handler until it consumes nothing or the line budget runs out */
+static void
+recvq_process(struct connection *cptr)
+{
+	unsigned int lines = 0;
+	size_t l, ll;
+
+	l = cptr->recvq_len;
+	while (l != 0 && cptr->recvq_handler != NULL && !CF_IS_RECVQ_HELD(cptr))
 	{
-		sq = n->data;
-		l += sq->firstfree - sq->firstused;
+		if (cptr->recvq_budget != 0 && lines++ == cptr->recvq_budget)
+		{
+			/* let timers and other connections run, then carry on;
+			 * stop reading until the backlog is gone, so that the
+			 * recvq does not grow without bound and the uplink
+			 * feels TCP backpressure instead */
+			if (cptr->recvq_timer == NULL)
+				cptr->recvq_timer = mowgli_timer_add_once(base_eventloop, "recvq_resume",
+						recvq_resume, cptr, 0);
+			connection_pause_read(cptr, true);
+			return;
+		}
+
+		cptr->recvq_handler(cptr);
+		ll = l;
+		l = cptr->recvq_len;
+		if (ll == l)
+			break;
 	}
-	return l;
+}
+
+static void
+recvq_resume(void *arg)
+{
+	struct connection *cptr = arg;
+
+	cptr->recvq_timer = NULL;
+
+	if (!CF_IS_DEAD(cptr))
+		recvq_process(cptr);
+
+	/* the backlog is gone (or only a partial line is left, or the
+	 * connection is going away); watch for readability again */
+	if (cptr->recvq_timer == NULL && !CF_IS_RECVQ_HELD(cptr))
+		connection_pause_read(cptr, false);
+}
+
+/* stop handing the recvq to its handler and reading more into it, e.g.
+ * while the handler waits for a password to be verified before it can
+ * take the next request; or carry on with what is already there, and
+ * read again once that is done */
+void
+recvq_hold(struct connection *cptr, bool held)
+{
+	return_if_fail(cptr != NULL);
+
+	if (held)
+	{
+		cptr->flags |= CF_RECVQ_HELD;
+		connection_pause_read(cptr, true);
+		return;
+	}
+
+	cptr->flags &= ~CF_RECVQ_HELD;
+
+	if (cptr->recvq_timer == NULL)
+		cptr->recvq_timer = mowgli_timer_add_once(base_eventloop, "recvq_resume",
+				recvq_resume, cptr, 0);
 }
 
 void
 recvq_put(struct connection *cptr)
 {
 	mowgli_node_t *n;
-	struct sendq *sq = NULL;
-	int l = 0, ll = 0;
+	struct sendq *sq;
+	size_t got = 0;
+	ssize_t l;
+	size_t want;
 
 	return_if_fail(cptr != NULL);
 
@@ -226,46 +446,58 @@ recvq_put(struct connection *cptr)
 		return;
 	}
 
-	n = cptr->recvq.tail;
-	if (n != NULL)
-	{
-		sq = n->data;
-		l = SENDQSIZE - sq->firstfree;
-		if (l == 0)
-			sq = NULL;
-	}
-	if (sq == NULL)
-	{
-		sq = smalloc(sizeof *sq);
-		mowgli_node_add(sq, &sq->node, &cptr->recvq);
-		l = SENDQSIZE;
-	}
-	errno = 0;
+	recvq_trim(cptr);
 
-	l = recv(cptr->fd, sq->buf + sq->firstfree, l, 0);
-	if (l == 0 || (l < 0 && !mowgli_eventloop_ignore_errno(ioerrno())))
+	/* The uplink is drained until the socket would block (up to
+	 * RECVQ_DRAINMAX bytes), so that a burst is parsed in as few
+	 * event loop iterations as possible; everything else gets one
+	 * read per readiness event.
+	 */
+	do
 	{
-		if (l == 0)
-			slog(LG_DEBUG, "recvq_put(): fd %d closed the connection", cptr->fd);
-		else
-			slog(LG_DEBUG, "recvq_put(): lost connection on fd %d", cptr->fd);
-		connection_close(cptr);
-		return;
-	}
-	else if (l > 0)
-		sq->firstfree += l;
+		sq = NULL;
+		want = 0;
+		n = cptr->recvq.tail;
+		if (n != NULL)
+		{
+			sq = n->data;
+			want = SENDQSIZE - sq->firstfree;
+			if (want == 0)
+				sq = NULL;
+		}
+		if (sq == NULL)
+		{
+			sq = sendq_block_add(&cptr->recvq);
+			want = SENDQSIZE;
+		}
+		errno = 0;
 
-	if (cptr->recvq_handler)
-	{
-		l = recvq_length(cptr);
-		do /* call handler until it consumes nothing */
+		cptr->recvq_syscalls++;
+		l = recv(cptr->fd, sq->buf + sq->firstfree, want, 0);
+		if (l == 0 || (l < 0 && !mowgli_eventloop_ignore_errno(ioerrno())))
 		{
-			cptr->recvq_handler(cptr);
-			ll = l;
-			l = recvq_length(cptr);
-		} while (ll != l && l != 0);
-	}
-	return;
+			/* process what we already have; the next
+			 * readiness event will find the EOF again */
+			if (got > 0)
+				break;
+
+			if (l == 0)
+				slog(LG_DEBUG, "recvq_put(): fd %d closed the connection", cptr->fd);
+			else
+				slog(LG_DEBUG, "recvq_put(): lost connection on fd %d", cptr->fd);
+			connection_close(cptr);
+			return;
+		}
+		else if (l < 0)
+			break;
+
+		sq->firstfree += l;
+		got += l;
+		cptr->recvq_len += l;
+		cptr->recvq_bytes += l;
+	} while (CF_IS_UPLINK(cptr) && (size_t) l == want && got < RECVQ_DRAINMAX);
+
+	recvq_process(cptr);
 }
 
 int
@@ -278,6 +510,8 @@ recvq_get(struct connection *cptr, char *buf, size_t len)
 
 	return_val_if_fail(cptr != NULL, 0);
 
+	recvq_trim(cptr);
+
 	MOWGLI_ITER_FOREACH_SAFE(n, tn, cptr->recvq.head)
 	{
 		sq = (struct sendq *)n->data;
@@ -296,17 +530,15 @@ recvq_get(struct connection *cptr, char *buf, size_t len)
 		if (sq->firstused == sq->firstfree)
 		{
 			if (MOWGLI_LIST_LENGTH(&cptr->recvq) > 1)
-			{
-				mowgli_node_delete(&sq->node, &cptr->recvq);
-				sfree(sq);
-			}
+				sendq_block_delete(sq, &cptr->recvq);
 			else
 				/* keep one struct sendq */
 				sq->firstused = sq->firstfree = 0;
 		}
 		else
-			return p - buf;
+			break;
 	}
+	cptr->recvq_len -= p - buf;
 	return p - buf;
 }
 
@@ -321,6 +553,8 @@ recvq_getline(struct connection *cptr, char *buf, size_t len)
 
 	return_val_if_fail(cptr != NULL, 0);
 
+	recvq_trim(cptr);
+
 	MOWGLI_ITER_FOREACH(n, cptr->recvq.head)
 	{
 		sq2 = n->data;
@@ -356,20 +590,59 @@ recvq_getline(struct connection *cptr, char *buf, size_t len)
 		if (sq->firstused == sq->firstfree)
 		{
 			if (MOWGLI_LIST_LENGTH(&cptr->recvq) > 1)
-			{
-				mowgli_node_delete(&sq->node, &cptr->recvq);
-				sfree(sq);
-			}
+				sendq_block_delete(sq, &cptr->recvq);
 			else
 				/* keep one struct sendq */
 				sq->firstused = sq->firstfree = 0;
 		}
 		else
-			return p - buf;
+			break;
 	}
+	cptr->recvq_len -= p - buf;
 	return p - buf;
 }
 
+/*
+ * Like recvq_getline(), but if the next line (of at most len bytes) lies
+ * entirely within one block of the receive queue, it is consumed and a
+ * pointer to it inside the queue is returned instead of copying it out.
+ * The caller may modify the line in place; it stays valid until the next
+ * recvq operation on this connection. Returns NULL if the line has to be
+ * fetched with recvq_getline() instead.
+ */
+char *
+recvq_getline_inplace(struct connection *cptr, size_t len, size_t *linelen)
+{
+	struct sendq *sq;
+	char *line, *newline;
+	size_t l;
+
+	return_val_if_fail(cptr != NULL, NULL);
+
+	recvq_trim(cptr);
+
+	if (cptr->recvq.head == NULL)
+		return NULL;
+
+	sq = cptr->recvq.head->data;
+	line = sq->buf + sq->firstused;
+	l = sq->firstfree - sq->firstused;
+	if (l > len)
+		l = len;
+
+	newline = memchr(line, '\n', l);
+	if (newline == NULL)
+		return NULL;
+
+	/* the block is released by the next recvq_trim() */
+	l = newline - line + 1;
+	sq->firstused += l;
+	cptr->recvq_len -= l;
+	cptr->flags &= ~CF_NONEWLINE;
+	*linelen = l;
+	return line;
+}
+
 void
 sendqrecvq_free(struct connection *cptr)
 {
@@ -380,17 +653,22 @@ sendqrecvq_free(struct connection *cptr)
 	{
 		sq = nptr->data;
 
-		mowgli_node_delete(&sq->node, &cptr->recvq);
-		sfree(sq);
+		sendq_block_delete(sq, &cptr->recvq);
 	}
 
 	MOWGLI_ITER_FOREACH_SAFE(nptr, nptr2, cptr->sendq.head)
 	{
 		sq = nptr->data;
 
-		mowgli_node_delete(&sq->node, &cptr->sendq);
-		sfree(sq);
+		sendq_block_delete(sq, &cptr->sendq);
 	}
+
+	if (cptr->recvq_timer != NULL)
+		mowgli_timer_destroy(base_eventloop, cptr->recvq_timer);
+
+	cptr->recvq_timer = NULL;
+	cptr->recvq_len = 0;
+	cptr->sendq_len = 0;
 }
 
 /* vim:cinoptions=>s,e0,n0,f0,{0,}0,^0,=s,ps,t0,c3,+s,(2s,us,)20,*30,gs,hs
@@ -142,6 +142,70 @@
         j++;                                                                                                        \
     } while (0)
 
+static const uint32_t digest_sha2_256_K[] = {
+
+	UINT32_C(0x428A2F98), UINT32_C(0x71374491), UINT32_C(0xB5C0FBCF), UINT32_C(0xE9B5DBA5),
+	UINT32_C(0x3956C25B), UINT32_C(0x59F111F1), UINT32_C(0x923F82A4), UINT32_C(0xAB1C5ED5),
+	UINT32_C(0xD807AA98), UINT32_C(0x12835B01), UINT32_C(0x243185BE), UINT32_C(0x550C7DC3),
+	UINT32_C(0x72BE5D74), UINT32_C(0x80DEB1FE), UINT32_C(0x9BDC06A7), UINT32_C(0xC19BF174),
+	UINT32_C(0xE49B69C1), UINT32_C(0xEFBE4786), UINT32_C(0x0FC19DC6), UINT32_C(0x240CA1CC),
+	UINT32_C(0x2DE92C6F), UINT32_C(0x4A7484AA), UINT32_C(0x5CB0A9DC), UINT32_C(0x76F988DA),
+	UINT32_C(0x983E5152), UINT32_C(0xA831C66D), UINT32_C(0xB00327C8), UINT32_C(0xBF597FC7),
+	UINT32_C(0xC6E00BF3), UINT32_C(0xD5A79147), UINT32_C(0x06CA6351), UINT32_C(0x14292967),
+	UINT32_C(0x27B70A85), UINT32_C(0x2E1B2138), UINT32_C(0x4D2C6DFC), UINT32_C(0x53380D13),
+	UINT32_C(0x650A7354), UINT32_C(0x766A0ABB), UINT32_C(0x81C2C92E), UINT32_C(0x92722C85),
+	UINT32_C(0xA2BFE8A1), UINT32_C(0xA81A664B), UINT32_C(0xC24B8B70), UINT32_C(0xC76C51A3),
+	UINT32_C(0xD192E819), UINT32_C(0xD6990624), UINT32_C(0xF40E3585), UINT32_C(0x106AA070),
+	UINT32_C(0x19A4C116), UINT32_C(0x1E376C08), UINT32_C(0x2748774C), UINT32_C(0x34B0BCB5),
+	UINT32_C(0x391C0CB3), UINT32_C(0x4ED8AA4A), UINT32_C(0x5B9CCA4F), UINT32_C(0x682E6FF3),
+	UINT32_C(0x748F82EE), UINT32_C(0x78A5636F), UINT32_C(0x84C87814), UINT32_C(0x8CC70208),
+	UINT32_C(0x90BEFFFA), UINT32_C(0xA4506CEB), UINT32_C(0xBEF9A3F7), UINT32_C(0xC67178F2),
+};
+
+static const uint64_t digest_sha2_512_K[] = {
+
+	UINT64_C(0x428A2F98D728AE22), UINT64_C(0x7137449123EF65CD),
+	UINT64_C(0xB5C0FBCFEC4D3B2F), UINT64_C(0xE9B5DBA58189DBBC),
+	UINT64_C(0x3956C25BF348B538), UINT64_C(0x59F111F1B605D019),
+	UINT64_C(0x923F82A4AF194F9B), UINT64_C(0xAB1C5ED5DA6D8118),
+	UINT64_C(0xD807AA98A3030242), UINT64_C(0x12835B0145706FBE),
+	UINT64_C(0x243185BE4EE4B28C), UINT64_C(0x550C7DC3D5FFB4E2),
+	UINT64_C(0x72BE5D74F27B896F), UINT64_C(0x80DEB1FE3B1696B1),
+	UINT64_C(0x9BDC06A725C71235), UINT64_C(0xC19BF174CF692694),
+	UINT64_C(0xE49B69C19EF14AD2), UINT64_C(0xEFBE4786384F25E3),
+	UINT64_C(0x0FC19DC68B8CD5B5), UINT64_C(0x240CA1CC77AC9C65),
+	UINT64_C(0x2DE92C6F592B0275), UINT64_C(0x4A7484AA6EA6E483),
+	UINT64_C(0x5CB0A9DCBD41FBD4), UINT64_C(0x76F988DA831153B5),
+	UINT64_C(0x983E5152EE66DFAB), UINT64_C(0xA831C66D2DB43210),
+	UINT64_C(0xB00327C898FB213F), UINT64_C(0xBF597FC7BEEF0EE4),
+	UINT64_C(0xC6E00BF33DA88FC2), UINT64_C(0xD5A79147930AA725),
+	UINT64_C(0x06CA6351E003826F), UINT64_C(0x142929670A0E6E70),
+	UINT64_C(0x27B70A8546D22FFC), UINT64_C(0x2E1B21385C26C926),
+	UINT64_C(0x4D2C6DFC5AC42AED), UINT64_C(0x53380D139D95B3DF),
+	UINT64_C(0x650A73548BAF63DE), UINT64_C(0x766A0ABB3C77B2A8),
+	UINT64_C(0x81C2C92E47EDAEE6), UINT64_C(0x92722C851482353B),
+	UINT64_C(0xA2BFE8A14CF10364), UINT64_C(0xA81A664BBC423001),
+	UINT64_C(0xC24B8B70D0F89791), UINT64_C(0xC76C51A30654BE30),
+	UINT64_C(0xD192E819D6EF5218), UINT64_C(0xD69906245565A910),
+	UINT64_C(0xF40E35855771202A), UINT64_C(0x106AA07032BBD1B8),
+	UINT64_C(0x19A4C116B8D2D0C8), UINT64_C(0x1E376C085141AB53),
+	UINT64_C(0x2748774CDF8EEB99), UINT64_C(0x34B0BCB5E19B48A8),
+	UINT64_C(0x391C0CB3C5C95A63), UINT64_C(0x4ED8AA4AE3418ACB),
+	UINT64_C(0x5B9CCA4F7763E373), UINT64_C(0x682E6FF3D6B2B8A3),
+	UINT64_C(0x748F82EE5DEFB2FC), UINT64_C(0x78A5636F43172F60),
+	UINT64_C(0x84C87814A1F0AB72), UINT64_C(0x8CC702081A6439EC),
+	UINT64_C(0x90BEFFFA23631E28), UINT64_C(0xA4506CEBDE82BDE9),
+	UINT64_C(0xBEF9A3F7B2C67915), UINT64_C(0xC67178F2E372532B),
+	UINT64_C(0xCA273ECEEA26619C), UINT64_C(0xD186B8C721C0C207),
+	UINT64_C(0xEADA7DD6CDE0EB1E), UINT64_C(0xF57D4F7FEE6ED178),
+	UINT64_C(0x06F067AA72176FBA), UINT64_C(0x0A637DC5A2C898A6),
+	UINT64_C(0x113F9804BEF90DAE), UINT64_C(0x1B710B35131C471B),
+	UINT64_C(0x28DB77F523047D84), UINT64_C(0x32CAAB7B40C72493),
+	UINT64_C(0x3C9EBE0A15C9BEBC), UINT64_C(0x431D67C49C100D4C),
+	UINT64_C(0x4CC5D4BECB3E42B6), UINT64_C(0x597F299CFC657E2A),
+	UINT64_C(0x5FCB6FAB3AD6FAEC), UINT64_C(0x6C44198C4A475817),
+};
+
 static inline bool
 digest_is_big_endian_sha2(void)
 {
@@ -151,25 +215,8 @@ digest_is_big_endian_sha2(void)
 static void
 digest_transform_block_sha2_256(union digest_direct_ctx *const state, const uint32_t *data)
 {
-	static const uint32_t K[] = {
-
-		UINT32_C(0x428A2F98), UINT32_C(0x71374491), UINT32_C(0xB5C0FBCF), UINT32_C(0xE9B5DBA5),
-		UINT32_C(0x3956C25B), UINT32_C(0x59F111F1), UINT32_C(0x923F82A4), UINT32_C(0xAB1C5ED5),
-		UINT32_C(0xD807AA98), UINT32_C(0x12835B01), UINT32_C(0x243185BE), UINT32_C(0x550C7DC3),
-		UINT32_C(0x72BE5D74), UINT32_C(0x80DEB1FE), UINT32_C(0x9BDC06A7), UINT32_C(0xC19BF174),
-		UINT32_C(0xE49B69C1), UINT32_C(0xEFBE4786), UINT32_C(0x0FC19DC6), UINT32_C(0x240CA1CC),
-		UINT32_C(0x2DE92C6F), UINT32_C(0x4A7484AA), UINT32_C(0x5CB0A9DC), UINT32_C(0x76F988DA),
-		UINT32_C(0x983E5152), UINT32_C(0xA831C66D), UINT32_C(0xB00327C8), UINT32_C(0xBF597FC7),
-		UINT32_C(0xC6E00BF3), UINT32_C(0xD5A79147), UINT32_C(0x06CA6351), UINT32_C(0x14292967),
-		UINT32_C(0x27B70A85), UINT32_C(0x2E1B2138), UINT32_C(0x4D2C6DFC), UINT32_C(0x53380D13),
-		UINT32_C(0x650A7354), UINT32_C(0x766A0ABB), UINT32_C(0x81C2C92E), UINT32_C(0x92722C85),
-		UINT32_C(0xA2BFE8A1), UINT32_C(0xA81A664B), UINT32_C(0xC24B8B70), UINT32_C(0xC76C51A3),
-		UINT32_C(0xD192E819), UINT32_C(0xD6990624), UINT32_C(0xF40E3585), UINT32_C(0x106AA070),
-		UINT32_C(0x19A4C116), UINT32_C(0x1E376C08), UINT32_C(0x2748774C), UINT32_C(0x34B0BCB5),
-		UINT32_C(0x391C0CB3), UINT32_C(0x4ED8AA4A), UINT32_C(0x5B9CCA4F), UINT32_C(0x682E6FF3),
-		UINT32_C(0x748F82EE), UINT32_C(0x78A5636F), UINT32_C(0x84C87814), UINT32_C(0x8CC70208),
-		UINT32_C(0x90BEFFFA), UINT32_C(0xA4506CEB), UINT32_C(0xBEF9A3F7), UINT32_C(0xC67178F2),
-	};
+	const uint32_t *const K = digest_sha2_256_K;
+
 
 	uint32_t *const W = (uint32_t *) state->sha2_256.buf;
 	uint32_t j = 0x00U;
@@ -211,49 +258,8 @@ digest_transform_block_sha2_256(union digest_direct_ctx *const state, const uint
 static void
 digest_transform_block_sha2_512(union digest_direct_ctx *const state, const uint64_t *data)
 {
-	static const uint64_t K[] = {
-
-		UINT64_C(0x428A2F98D728AE22), UINT64_C(0x7137449123EF65CD),
-		UINT64_C(0xB5C0FBCFEC4D3B2F), UINT64_C(0xE9B5DBA58189DBBC),
-		UINT64_C(0x3956C25BF348B538), UINT64_C(0x59F111F1B605D019),
-		UINT64_C(0x923F82A4AF194F9B), UINT64_C(0xAB1C5ED5DA6D8118),
-		UINT64_C(0xD807AA98A3030242), UINT64_C(0x12835B0145706FBE),
-		UINT64_C(0x243185BE4EE4B28C), UINT64_C(0x550C7DC3D5FFB4E2),
-		UINT64_C(0x72BE5D74F27B896F), UINT64_C(0x80DEB1FE3B1696B1),
-		UINT64_C(0x9BDC06A725C71235), UINT64_C(0xC19BF174CF692694),
-		UINT64_C(0xE49B69C19EF14AD2), UINT64_C(0xEFBE4786384F25E3),
-		UINT64_C(0x0FC19DC68B8CD5B5), UINT64_C(0x240CA1CC77AC9C65),
-		UINT64_C(0x2DE92C6F592B0275), UINT64_C(0x4A7484AA6EA6E483),
-		UINT64_C(0x5CB0A9DCBD41FBD4), UINT64_C(0x76F988DA831153B5),
-		UINT64_C(0x983E5152EE66DFAB), UINT64_C(0xA831C66D2DB43210),
-		UINT64_C(0xB00327C898FB213F), UINT64_C(0xBF597FC7BEEF0EE4),
-		UINT64_C(0xC6E00BF33DA88FC2), UINT64_C(0xD5A79147930AA725),
-		UINT64_C(0x06CA6351E003826F), UINT64_C(0x142929670A0E6E70),
-		UINT64_C(0x27B70A8546D22FFC), UINT64_C(0x2E1B21385C26C926),
-		UINT64_C(0x4D2C6DFC5AC42AED), UINT64_C(0x53380D139D95B3DF),
-		UINT64_C(0x650A73548BAF63DE), UINT64_C(0x766A0ABB3C77B2A8),
-		UINT64_C(0x81C2C92E47EDAEE6), UINT64_C(0x92722C851482353B),
-		UINT64_C(0xA2BFE8A14CF10364), UINT64_C(0xA81A664BBC423001),
-		UINT64_C(0xC24B8B70D0F89791), UINT64_C(0xC76C51A30654BE30),
-		UINT64_C(0xD192E819D6EF5218), UINT64_C(0xD69906245565A910),
-		UINT64_C(0xF40E35855771202A), UINT64_C(0x106AA07032BBD1B8),
-		UINT64_C(0x19A4C116B8D2D0C8), UINT64_C(0x1E376C085141AB53),
-		UINT64_C(0x2748774CDF8EEB99), UINT64_C(0x34B0BCB5E19B48A8),
-		UINT64_C(0x391C0CB3C5C95A63), UINT64_C(0x4ED8AA4AE3418ACB),
-		UINT64_C(0x5B9CCA4F7763E373), UINT64_C(0x682E6FF3D6B2B8A3),
-		UINT64_C(0x748F82EE5DEFB2FC), UINT64_C(0x78A5636F43172F60),
-		UINT64_C(0x84C87814A1F0AB72), UINT64_C(0x8CC702081A6439EC),
-		UINT64_C(0x90BEFFFA23631E28), UINT64_C(0xA4506CEBDE82BDE9),
-		UINT64_C(0xBEF9A3F7B2C67915), UINT64_C(0xC67178F2E372532B),
-		UINT64_C(0xCA273ECEEA26619C), UINT64_C(0xD186B8C721C0C207),
-		UINT64_C(0xEADA7DD6CDE0EB1E), UINT64_C(0xF57D4F7FEE6ED178),
-		UINT64_C(0x06F067AA72176FBA), UINT64_C(0x0A637DC5A2C898A6),
-		UINT64_C(0x113F9804BEF90DAE), UINT64_C(0x1B710B35131C471B),
-		UINT64_C(0x28DB77F523047D84), UINT64_C(0x32CAAB7B40C72493),
-		UINT64_C(0x3C9EBE0A15C9BEBC), UINT64_C(0x431D67C49C100D4C),
-		UINT64_C(0x4CC5D4BECB3E42B6), UINT64_C(0x597F299CFC657E2A),
-		UINT64_C(0x5FCB6FAB3AD6FAEC), UINT64_C(0x6C44198C4A475817),
-	};
+	const uint64_t *const K = digest_sha2_512_K;
+
 
 	uint64_t *const W = (uint64_t *) state->sha2_512.buf;
 	uint64_t j = 0x00U;
@@ -527,3 +533,248 @@ digest_direct_final_sha2_512(union digest_direct_ctx *const restrict state, void
 
 	(void) smemzero(state, sizeof *state);
 }
+
+/*
+ * Multi-lane SHA2 block transforms.
+ *
+ * These compress one block for each of up to DIGEST_LANES_MAX independent
+ * digest states at once. The states and blocks are stored transposed, as
+ * state[word][lane] and block[word][lane], with the words in host byte order,
+ * so that a SIMD kernel can load the same word of every lane with a single
+ * instruction. The SIMD kernels are compiled with GCC vector extensions and a
+ * target attribute, and the best one the CPU supports is chosen at runtime.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#  define DIGEST_LANES_HAVE_X86_64          1
+#  define DIGEST_LANES_TARGET(isa)          __attribute__((__target__(isa)))
+
+typedef uint32_t digest_lanes_v4u32 __attribute__((__vector_size__(16)));
+typedef uint32_t digest_lanes_v8u32 __attribute__((__vector_size__(32)));
+typedef uint64_t digest_lanes_v2u64 __attribute__((__vector_size__(16)));
+typedef uint64_t digest_lanes_v4u64 __attribute__((__vector_size__(32)));
+#endif /* __GNUC__ && __x86_64__ */
+
+#define DIGEST_ROUNDS_SHA2_256              0x40U
+#define DIGEST_ROUNDS_SHA2_512              0x50U
+
+#define SHA2_LANES_COMPRESS(type, bits, S, W)                                                                       \
+    do {                                                                                                            \
+        type a = S[0x00U], b = S[0x01U], c = S[0x02U], d = S[0x03U];                                                \
+        type e = S[0x04U], f = S[0x05U], g = S[0x06U], h = S[0x07U];                                                \
+                                                                                                                    \
+        for (size_t j = 0x00U; j < DIGEST_ROUNDS_SHA2_##bits; j++)                                                  \
+        {                                                                                                           \
+            if (j >= 0x10U)                                                                                         \
+                W[j & 0x0FU] += SHA2_##bits##_sigma1(W[(j + 0x0EU) & 0x0FU]) + W[(j + 0x09U) & 0x0FU] +             \
+                                SHA2_##bits##_sigma0(W[(j + 0x01U) & 0x0FU]);                                       \
+                                                                                                                    \
+            const type t1 = h + SHA2_##bits##_Sigma1(e) + SHA2_Ch(e, f, g) + digest_sha2_##bits##_K[j] +            \
+                            W[j & 0x0FU];                                                                           \
+            const type t2 = SHA2_##bits##_Sigma0(a) + SHA2_Maj(a, b, c);                                            \
+                                                                                                                    \
+            h = g; g = f; f = e; e = d + t1;                                                                        \
+            d = c; c = b; b = a; a = t1 + t2;                                                                       \
+        }                                                                                                           \
+                                                                                                                    \
+        S[0x00U] += a; S[0x01U] += b; S[0x02U] += c; S[0x03U] += d;                                                 \
+        S[0x04U] += e; S[0x05U] += f; S[0x06U] += g; S[0x07U] += h;                                                 \
+    } while (0)
+
+/* The lanes of the last vector that are past the requested ones are filled
+ * with copies of its first lane, and are not stored back, so that the kernel
+ * never computes on (or overwrites) lanes that the caller did not give it.
+ */
+#define SHA2_LANES_LOAD(type, word, dst, src, l, valid)                                                             \
+    do {                                                                                                            \
+        if ((valid) == (sizeof(type) / sizeof(word)))                                                               \
+            (void) memcpy(&(dst), &(src)[(l)], sizeof(type));                                                       \
+        else                                                                                                        \
+            for (size_t w = 0x00U; w < (sizeof(type) / sizeof(word)); w++)                                          \
+                (void) memcpy(((unsigned char *) &(dst)) + (w * sizeof(word)),                                      \
+                              &(src)[(l) + ((w < (valid)) ? w : 0x00U)], sizeof(word));                             \
+    } while (0)
+
+#define SHA2_LANES_KERNEL(name, attrs, bits, word, type)                                                            \
+    static void attrs                                                                                               \
+    name(word state[][DIGEST_LANES_MAX], const word block[][DIGEST_LANES_MAX], const size_t lanes)                  \
+    {                                                                                                               \
+        for (size_t l = 0x00U; l < lanes; l += (sizeof(type) / sizeof(word)))                                       \
+        {                                                                                                           \
+            const size_t valid = ((lanes - l) < (sizeof(type) / sizeof(word))) ?                                    \
+                                 (lanes - l) : (sizeof(type) / sizeof(word));                                       \
+            type S[DIGEST_IVLEN_SHA2_##bits];                                                                       \
+            type W[0x10U];                                                                                          \
+                                                                                                                    \
+            for (size_t x = 0x00U; x < DIGEST_IVLEN_SHA2_##bits; x++)                                               \
+                SHA2_LANES_LOAD(type, word, S[x], state[x], l, valid);                                              \
+                                                                                                                    \
+            for (size_t x = 0x00U; x < 0x10U; x++)                                                                  \
+                SHA2_LANES_LOAD(type, word, W[x], block[x], l, valid);                                              \
+                                                                                                                    \
+            SHA2_LANES_COMPRESS(type, bits, S, W);                                                                  \
+                                                                                                                    \
+            for (size_t x = 0x00U; x < DIGEST_IVLEN_SHA2_##bits; x++)                                               \
+                (void) memcpy(&state[x][l], &S[x], valid * sizeof(word));                                           \
+        }                                                                                                           \
+    }
+
+SHA2_LANES_KERNEL(digest_lanes_scalar_sha2_256, /* No attributes */, 256, uint32_t, uint32_t)
+SHA2_LANES_KERNEL(digest_lanes_scalar_sha2_512, /* No attributes */, 512, uint64_t, uint64_t)
+
+#ifdef DIGEST_LANES_HAVE_X86_64
+SHA2_LANES_KERNEL(digest_lanes_sse41_sha2_256, DIGEST_LANES_TARGET("sse4.1"), 256, uint32_t, digest_lanes_v4u32)
+SHA2_LANES_KERNEL(digest_lanes_sse41_sha2_512, DIGEST_LANES_TARGET("sse4.1"), 512, uint64_t, digest_lanes_v2u64)
+SHA2_LANES_KERNEL(digest_lanes_avx2_sha2_256, DIGEST_LANES_TARGET("avx2"), 256, uint32_t, digest_lanes_v8u32)
+SHA2_LANES_KERNEL(digest_lanes_avx2_sha2_512, DIGEST_LANES_TARGET("avx2"), 512, uint64_t, digest_lanes_v4u64)
+#endif /* DIGEST_LANES_HAVE_X86_64 */
+
+/* The kernel the transforms below dispatch to, picked from what the CPU
+ * supports the first time it is needed; the transforms are called for every
+ * block, so the CPU is only asked once. The services start this (through the
+ * digest testsuite) before any authpool worker thread exists.
+ */
+static enum digest_lanes_impl digest_lanes_active = DIGEST_LANES_IMPL_AUTO;
+
+#ifdef DIGEST_LANES_HAVE_X86_64
+static bool digest_lanes_probed = false;
+static bool digest_lanes_have_sse41 = false;
+static bool digest_lanes_have_avx2 = false;
+
+static void
+digest_lanes_probe(void)
+{
+	if (digest_lanes_probed)
+		return;
+
+	digest_lanes_have_sse41 = (bool) __builtin_cpu_supports("sse4.1");
+	digest_lanes_have_avx2 = (bool) __builtin_cpu_supports("avx2");
+	digest_lanes_probed = true;
+}
+#endif /* DIGEST_LANES_HAVE_X86_64 */
+
+bool
+digest_direct_lanes_supported(const enum digest_lanes_impl impl)
+{
+	switch (impl)
+	{
+		case DIGEST_LANES_IMPL_AUTO:
+		case DIGEST_LANES_IMPL_SCALAR:
+			return true;
+
+#ifdef DIGEST_LANES_HAVE_X86_64
+		case DIGEST_LANES_IMPL_SSE41:
+			digest_lanes_probe();
+			return digest_lanes_have_sse41;
+
+		case DIGEST_LANES_IMPL_AVX2:
+			digest_lanes_probe();
+			return digest_lanes_have_avx2;
+#else /* DIGEST_LANES_HAVE_X86_64 */
+		case DIGEST_LANES_IMPL_SSE41:
+		case DIGEST_LANES_IMPL_AVX2:
+			return false;
+#endif /* !DIGEST_LANES_HAVE_X86_64 */
+	}
+
+	return false;
+}
+
+static enum digest_lanes_impl
+digest_lanes_best(void)
+{
+	if (digest_direct_lanes_supported(DIGEST_LANES_IMPL_AVX2))
+		return DIGEST_LANES_IMPL_AVX2;
+
+	if (digest_direct_lanes_supported(DIGEST_LANES_IMPL_SSE41))
+		return DIGEST_LANES_IMPL_SSE41;
+
+	return DIGEST_LANES_IMPL_SCALAR;
+}
+
+bool
+digest_direct_lanes_force(const enum digest_lanes_impl impl)
+{
+	if (! digest_direct_lanes_supported(impl))
+		return false;
+
+	digest_lanes_active = (impl == DIGEST_LANES_IMPL_AUTO) ? digest_lanes_best() : impl;
+	return true;
+}
+
+enum digest_lanes_impl
+digest_direct_lanes_impl(void)
+{
+	if (digest_lanes_active == DIGEST_LANES_IMPL_AUTO)
+		digest_lanes_active = digest_lanes_best();
+
+	return digest_lanes_active;
+}
+
+const char *
+digest_direct_lanes_name(const enum digest_lanes_impl impl)
+{
+	switch (impl)
+	{
+		case DIGEST_LANES_IMPL_AUTO:
+			return "Automatic";
+		case DIGEST_LANES_IMPL_SCALAR:
+			return "Scalar";
+		case DIGEST_LANES_IMPL_SSE41:
+			return "SSE4.1";
+		case DIGEST_LANES_IMPL_AVX2:
+			return "AVX2";
+	}
+
+	return NULL;
+}
+
+void
+digest_direct_transform_lanes_sha2_256(uint32_t state[][DIGEST_LANES_MAX], const uint32_t block[][DIGEST_LANES_MAX],
+                                       const size_t lanes)
+{
+	// A SIMD kernel would compute all of its lanes for nothing
+	const enum digest_lanes_impl impl = (lanes > 1) ? digest_direct_lanes_impl() : DIGEST_LANES_IMPL_SCALAR;
+
+	switch (impl)
+	{
+#ifdef DIGEST_LANES_HAVE_X86_64
+		case DIGEST_LANES_IMPL_AVX2:
+			(void) digest_lanes_avx2_sha2_256(state, block, lanes);
+			return;
+
+		case DIGEST_LANES_IMPL_SSE41:
+			(void) digest_lanes_sse41_sha2_256(state, block, lanes);
+			return;
+#endif /* DIGEST_LANES_HAVE_X86_64 */
+
+		default:
+			(void) digest_lanes_scalar_sha2_256(state, block, lanes);
+			return;
+	}
+}
+
+void
+digest_direct_transform_lanes_sha2_512(uint64_t state[][DIGEST_LANES_MAX], const uint64_t block[][DIGEST_LANES_MAX],
+                                       const size_t lanes)
+{
+	// A SIMD kernel would compute all of its lanes for nothing
+	const enum digest_lanes_impl impl = (lanes > 1) ? digest_direct_lanes_impl() : DIGEST_LANES_IMPL_SCALAR;
+
+	switch (impl)
+	{
+#ifdef DIGEST_LANES_HAVE_X86_64
+		case DIGEST_LANES_IMPL_AVX2:
+			(void) digest_lanes_avx2_sha2_512(state, block, lanes);
+			return;
+
+		case DIGEST_LANES_IMPL_SSE41:
+			(void) digest_lanes_sse41_sha2_512(state, block, lanes);
+			return;
+#endif /* DIGEST_LANES_HAVE_X86_64 */
+
+		default:
+			(void) digest_lanes_scalar_sha2_512(state, block, lanes);
+			return;
+	}
+}
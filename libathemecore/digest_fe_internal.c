@@ -14,7 +14,10 @@
 #define DIGEST_HMAC_INNER_XORVAL    0x36U
 #define DIGEST_HMAC_OUTER_XORVAL    0x5CU
 
+#define ATHEME_LAC_DIGEST_FE_HAVE_PBKDF2_BATCH 1
+
 static bool _digest_oneshot(enum digest_algorithm, const void *, size_t, void *, size_t *);
+static bool _digest_oneshot_pbkdf2_batch(enum digest_algorithm, const struct digest_pbkdf2_job *, size_t, size_t);
 
 const char *
 digest_get_frontend_info(void)
@@ -130,6 +133,285 @@ _digest_final(struct digest_context *const restrict ctx, void *const restrict ou
 	return true;
 }
 
+/*
+ * PBKDF2-HMAC-SHA2 on the multi-lane block transforms.
+ *
+ * Each iteration of PBKDF2 is an HMAC of the previous U, which is 2 blocks
+ * (ikey || U, then okey || inner digest) for each of the inner and outer
+ * digests. The first block of each never changes, so the digest states after
+ * them (the "midstates") are computed once, and every iteration is then just
+ * 2 block transforms of a fixed-size, pre-padded block, with U kept as words.
+ *
+ * The iterations of one U chain depend on each other, but separate chains do
+ * not; every block T(i) of every derivation given here is a chain, and these
+ * are run DIGEST_LANES_MAX at a time in the lanes of the transform. This lets
+ * a derivation with dkLen > hLen, or a batch of derivations with the same
+ * iteration count, use the whole width of a SIMD kernel.
+ */
+
+#define DIGEST_LANES_SHA2_256_MSGBITS   ((DIGEST_BKLEN_SHA2_256 + DIGEST_MDLEN_SHA2_256) * 0x08U)
+#define DIGEST_LANES_SHA2_512_MSGBITS   ((DIGEST_BKLEN_SHA2_512 + DIGEST_MDLEN_SHA2_512) * 0x08U)
+
+struct digest_lanes_output
+{
+	unsigned char * ptr;
+	size_t          len;
+};
+
+static void
+_digest_pbkdf2_lanes_run_sha2_256(uint32_t ist[][DIGEST_LANES_MAX], uint32_t ost[][DIGEST_LANES_MAX],
+                                  uint32_t blk[][DIGEST_LANES_MAX], uint32_t t[][DIGEST_LANES_MAX],
+                                  const struct digest_lanes_output *const restrict out, const size_t lanes,
+                                  const size_t c)
+{
+	uint32_t st[DIGEST_IVLEN_SHA2_256][DIGEST_LANES_MAX];
+
+	for (size_t j = 1; j < c; j++)
+	{
+		(void) memcpy(st, ist, sizeof st);
+		(void) digest_direct_transform_lanes_sha2_256(st, (const void *) blk, lanes);
+		(void) memcpy(blk, st, sizeof st);
+		(void) memcpy(st, ost, sizeof st);
+		(void) digest_direct_transform_lanes_sha2_256(st, (const void *) blk, lanes);
+		(void) memcpy(blk, st, sizeof st);
+
+		for (size_t x = 0; x < DIGEST_IVLEN_SHA2_256; x++)
+			for (size_t l = 0; l < lanes; l++)
+				t[x][l] ^= st[x][l];
+	}
+
+	for (size_t l = 0; l < lanes; l++)
+	{
+		unsigned char tmp[DIGEST_MDLEN_SHA2_256];
+
+		for (size_t x = 0; x < DIGEST_IVLEN_SHA2_256; x++)
+		{
+			const uint32_t be = htonl(t[x][l]);
+
+			(void) memcpy(tmp + (x * sizeof be), &be, sizeof be);
+		}
+
+		(void) memcpy(out[l].ptr, tmp, out[l].len);
+		(void) smemzero(tmp, sizeof tmp);
+	}
+
+	(void) smemzero(st, sizeof st);
+}
+
+static void
+_digest_pbkdf2_lanes_sha2_256(const struct digest_pbkdf2_job *const restrict jobs, const size_t jobsLen,
+                              const size_t c)
+{
+	uint32_t ist[DIGEST_IVLEN_SHA2_256][DIGEST_LANES_MAX];
+	uint32_t ost[DIGEST_IVLEN_SHA2_256][DIGEST_LANES_MAX];
+	uint32_t blk[0x10U][DIGEST_LANES_MAX];
+	uint32_t t[DIGEST_IVLEN_SHA2_256][DIGEST_LANES_MAX];
+	struct digest_lanes_output out[DIGEST_LANES_MAX];
+	size_t lanes = 0;
+
+	(void) memset(ist, 0x00, sizeof ist);
+	(void) memset(ost, 0x00, sizeof ost);
+	(void) memset(blk, 0x00, sizeof blk);
+	(void) memset(t, 0x00, sizeof t);
+
+	for (size_t l = 0; l < DIGEST_LANES_MAX; l++)
+	{
+		blk[DIGEST_IVLEN_SHA2_256][l] = UINT32_C(0x80000000);
+		blk[0x0FU][l] = DIGEST_LANES_SHA2_256_MSGBITS;
+	}
+
+	for (size_t n = 0; n < jobsLen; n++)
+	{
+		const struct digest_pbkdf2_job *const job = &jobs[n];
+		union digest_direct_ctx outer;
+		struct digest_context ctx;
+
+		(void) _digest_init_hmac(&ctx, DIGALG_SHA2_256, job->pass, job->passLen);
+		(void) digest_direct_init_sha2_256(&outer);
+		(void) digest_direct_update_sha2_256(&outer, ctx.okey, ctx.blksz);
+
+		unsigned char *dk = job->dk;
+		size_t rem = job->dkLen;
+
+		for (uint32_t i = 1; rem; i++)
+		{
+			unsigned char tmp[DIGEST_MDLEN_SHA2_256];
+			struct digest_context u1 = ctx;
+			const uint32_t ibe = htonl(i);
+
+			(void) u1.update(&u1.state, job->salt, job->saltLen);
+			(void) u1.update(&u1.state, &ibe, sizeof ibe);
+			(void) _digest_final(&u1, tmp, NULL);
+
+			for (size_t x = 0; x < DIGEST_IVLEN_SHA2_256; x++)
+			{
+				uint32_t be;
+
+				(void) memcpy(&be, tmp + (x * sizeof be), sizeof be);
+
+				ist[x][lanes] = ctx.state.sha2_256.state[x];
+				ost[x][lanes] = outer.sha2_256.state[x];
+				blk[x][lanes] = t[x][lanes] = ntohl(be);
+			}
+
+			out[lanes].ptr = dk;
+			out[lanes].len = (rem > sizeof tmp) ? sizeof tmp : rem;
+
+			dk += out[lanes].len;
+			rem -= out[lanes].len;
+
+			(void) smemzero(&u1, sizeof u1);
+			(void) smemzero(tmp, sizeof tmp);
+
+			if (++lanes == DIGEST_LANES_MAX)
+			{
+				(void) _digest_pbkdf2_lanes_run_sha2_256(ist, ost, blk, t, out, lanes, c);
+				lanes = 0;
+			}
+		}
+
+		(void) smemzero(&outer, sizeof outer);
+		(void) smemzero(&ctx, sizeof ctx);
+	}
+
+	if (lanes)
+		(void) _digest_pbkdf2_lanes_run_sha2_256(ist, ost, blk, t, out, lanes, c);
+
+	(void) smemzero(ist, sizeof ist);
+	(void) smemzero(ost, sizeof ost);
+	(void) smemzero(blk, sizeof blk);
+	(void) smemzero(t, sizeof t);
+}
+
+static void
+_digest_pbkdf2_lanes_run_sha2_512(uint64_t ist[][DIGEST_LANES_MAX], uint64_t ost[][DIGEST_LANES_MAX],
+                                  uint64_t blk[][DIGEST_LANES_MAX], uint64_t t[][DIGEST_LANES_MAX],
+                                  const struct digest_lanes_output *const restrict out, const size_t lanes,
+                                  const size_t c)
+{
+	uint64_t st[DIGEST_IVLEN_SHA2_512][DIGEST_LANES_MAX];
+
+	for (size_t j = 1; j < c; j++)
+	{
+		(void) memcpy(st, ist, sizeof st);
+		(void) digest_direct_transform_lanes_sha2_512(st, (const void *) blk, lanes);
+		(void) memcpy(blk, st, sizeof st);
+		(void) memcpy(st, ost, sizeof st);
+		(void) digest_direct_transform_lanes_sha2_512(st, (const void *) blk, lanes);
+		(void) memcpy(blk, st, sizeof st);
+
+		for (size_t x = 0; x < DIGEST_IVLEN_SHA2_512; x++)
+			for (size_t l = 0; l < lanes; l++)
+				t[x][l] ^= st[x][l];
+	}
+
+	for (size_t l = 0; l < lanes; l++)
+	{
+		unsigned char tmp[DIGEST_MDLEN_SHA2_512];
+
+		for (size_t x = 0; x < DIGEST_IVLEN_SHA2_512; x++)
+		{
+			const uint32_t hibe = htonl((uint32_t) (t[x][l] >> 0x20U));
+			const uint32_t lobe = htonl((uint32_t) t[x][l]);
+
+			(void) memcpy(tmp + (x * 0x08U), &hibe, sizeof hibe);
+			(void) memcpy(tmp + (x * 0x08U) + sizeof hibe, &lobe, sizeof lobe);
+		}
+
+		(void) memcpy(out[l].ptr, tmp, out[l].len);
+		(void) smemzero(tmp, sizeof tmp);
+	}
+
+	(void) smemzero(st, sizeof st);
+}
+
+static void
+_digest_pbkdf2_lanes_sha2_512(const struct digest_pbkdf2_job *const restrict jobs, const size_t jobsLen,
+                              const size_t c)
+{
+	uint64_t ist[DIGEST_IVLEN_SHA2_512][DIGEST_LANES_MAX];
+	uint64_t ost[DIGEST_IVLEN_SHA2_512][DIGEST_LANES_MAX];
+	uint64_t blk[0x10U][DIGEST_LANES_MAX];
+	uint64_t t[DIGEST_IVLEN_SHA2_512][DIGEST_LANES_MAX];
+	struct digest_lanes_output out[DIGEST_LANES_MAX];
+	size_t lanes = 0;
+
+	(void) memset(ist, 0x00, sizeof ist);
+	(void) memset(ost, 0x00, sizeof ost);
+	(void) memset(blk, 0x00, sizeof blk);
+	(void) memset(t, 0x00, sizeof t);
+
+	for (size_t l = 0; l < DIGEST_LANES_MAX; l++)
+	{
+		blk[DIGEST_IVLEN_SHA2_512][l] = UINT64_C(0x8000000000000000);
+		blk[0x0FU][l] = DIGEST_LANES_SHA2_512_MSGBITS;
+	}
+
+	for (size_t n = 0; n < jobsLen; n++)
+	{
+		const struct digest_pbkdf2_job *const job = &jobs[n];
+		union digest_direct_ctx outer;
+		struct digest_context ctx;
+
+		(void) _digest_init_hmac(&ctx, DIGALG_SHA2_512, job->pass, job->passLen);
+		(void) digest_direct_init_sha2_512(&outer);
+		(void) digest_direct_update_sha2_512(&outer, ctx.okey, ctx.blksz);
+
+		unsigned char *dk = job->dk;
+		size_t rem = job->dkLen;
+
+		for (uint32_t i = 1; rem; i++)
+		{
+			unsigned char tmp[DIGEST_MDLEN_SHA2_512];
+			struct digest_context u1 = ctx;
+			const uint32_t ibe = htonl(i);
+
+			(void) u1.update(&u1.state, job->salt, job->saltLen);
+			(void) u1.update(&u1.state, &ibe, sizeof ibe);
+			(void) _digest_final(&u1, tmp, NULL);
+
+			for (size_t x = 0; x < DIGEST_IVLEN_SHA2_512; x++)
+			{
+				uint32_t hibe;
+				uint32_t lobe;
+
+				(void) memcpy(&hibe, tmp + (x * 0x08U), sizeof hibe);
+				(void) memcpy(&lobe, tmp + (x * 0x08U) + sizeof hibe, sizeof lobe);
+
+				ist[x][lanes] = ctx.state.sha2_512.state[x];
+				ost[x][lanes] = outer.sha2_512.state[x];
+				blk[x][lanes] = t[x][lanes] = (((uint64_t) ntohl(hibe)) << 0x20U) | ntohl(lobe);
+			}
+
+			out[lanes].ptr = dk;
+			out[lanes].len = (rem > sizeof tmp) ? sizeof tmp : rem;
+
+			dk += out[lanes].len;
+			rem -= out[lanes].len;
+
+			(void) smemzero(&u1, sizeof u1);
+			(void) smemzero(tmp, sizeof tmp);
+
+			if (++lanes == DIGEST_LANES_MAX)
+			{
+				(void) _digest_pbkdf2_lanes_run_sha2_512(ist, ost, blk, t, out, lanes, c);
+				lanes = 0;
+			}
+		}
+
+		(void) smemzero(&outer, sizeof outer);
+		(void) smemzero(&ctx, sizeof ctx);
+	}
+
+	if (lanes)
+		(void) _digest_pbkdf2_lanes_run_sha2_512(ist, ost, blk, t, out, lanes, c);
+
+	(void) smemzero(ist, sizeof ist);
+	(void) smemzero(ost, sizeof ost);
+	(void) smemzero(blk, sizeof blk);
+	(void) smemzero(t, sizeof t);
+}
+
 static bool
 _digest_oneshot_pbkdf2(const enum digest_algorithm alg, const void *const restrict pass, const size_t passLen,
                        const void *const restrict salt, const size_t saltLen, const size_t c,
@@ -193,6 +475,20 @@ _digest_oneshot_pbkdf2(const enum digest_algorithm alg, const void *const restri
 	 * case when dkLen <= hLen.
 	 */
 
+	if (alg == DIGALG_SHA2_256 || alg == DIGALG_SHA2_512)
+	{
+		const struct digest_pbkdf2_job job = {
+			.pass       = pass,
+			.passLen    = passLen,
+			.salt       = salt,
+			.saltLen    = saltLen,
+			.dk         = dk,
+			.dkLen      = dkLen,
+		};
+
+		return _digest_oneshot_pbkdf2_batch(alg, &job, 1, c);
+	}
+
 	unsigned char tmp[DIGEST_MDLEN_MAX];
 	struct digest_context ctx;
 
@@ -237,3 +533,29 @@ _digest_oneshot_pbkdf2(const enum digest_algorithm alg, const void *const restri
 	(void) smemzero(tmp, sizeof tmp);
 	return true;
 }
+
+static bool
+_digest_oneshot_pbkdf2_batch(const enum digest_algorithm alg, const struct digest_pbkdf2_job *const restrict jobs,
+                             const size_t jobsLen, const size_t c)
+{
+	switch (alg)
+	{
+		case DIGALG_SHA2_256:
+			(void) _digest_pbkdf2_lanes_sha2_256(jobs, jobsLen, c);
+			return true;
+
+		case DIGALG_SHA2_512:
+			(void) _digest_pbkdf2_lanes_sha2_512(jobs, jobsLen, c);
+			return true;
+
+		default:
+			break;
+	}
+
+	for (size_t n = 0; n < jobsLen; n++)
+		if (! _digest_oneshot_pbkdf2(alg, jobs[n].pass, jobs[n].passLen, jobs[n].salt, jobs[n].saltLen, c,
+		                             jobs[n].dk, jobs[n].dkLen))
+			return false;
+
+	return true;
+}
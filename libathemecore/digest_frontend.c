@@ -117,6 +117,22 @@ _digest_oneshot_hmac_vector(const enum digest_algorithm alg, const void *const k
 	return true;
 }
 
+#ifndef ATHEME_LAC_DIGEST_FE_HAVE_PBKDF2_BATCH
+
+static bool ATHEME_FATTR_WUR
+_digest_oneshot_pbkdf2_batch(const enum digest_algorithm alg, const struct digest_pbkdf2_job *const restrict jobs,
+                             const size_t jobsLen, const size_t c)
+{
+	for (size_t n = 0; n < jobsLen; n++)
+		if (! _digest_oneshot_pbkdf2(alg, jobs[n].pass, jobs[n].passLen, jobs[n].salt, jobs[n].saltLen, c,
+		                             jobs[n].dk, jobs[n].dkLen))
+			return false;
+
+	return true;
+}
+
+#endif /* !ATHEME_LAC_DIGEST_FE_HAVE_PBKDF2_BATCH */
+
 size_t
 digest_size_alg(const enum digest_algorithm alg)
 {
@@ -616,3 +632,45 @@ digest_oneshot_pbkdf2(const enum digest_algorithm alg, const void *const restric
 
 	return _digest_oneshot_pbkdf2(alg, pass, passLen, salt, saltLen, c, dk, dkLen);
 }
+
+bool ATHEME_FATTR_WUR
+digest_oneshot_pbkdf2_batch(const enum digest_algorithm alg, const struct digest_pbkdf2_job *const restrict jobs,
+                            const size_t jobsLen, const size_t c)
+{
+	if (! digest_size_alg(alg))
+	{
+		(void) slog(LG_ERROR, "%s: called with malformed/uninitialised 'alg' (BUG)", MOWGLI_FUNC_NAME);
+		return false;
+	}
+	if (! (jobs && jobsLen))
+	{
+		(void) slog(LG_ERROR, "%s: called with no jobs (BUG)", MOWGLI_FUNC_NAME);
+		return false;
+	}
+	if (! c)
+	{
+		(void) slog(LG_ERROR, "%s: called with zero 'c' (BUG)", MOWGLI_FUNC_NAME);
+		return false;
+	}
+
+	for (size_t n = 0; n < jobsLen; n++)
+	{
+		if (! (jobs[n].pass && jobs[n].passLen))
+		{
+			(void) slog(LG_ERROR, "%s: job %zu has no password (BUG)", MOWGLI_FUNC_NAME, n);
+			return false;
+		}
+		if (! (jobs[n].salt && jobs[n].saltLen))
+		{
+			(void) slog(LG_ERROR, "%s: job %zu has no salt (BUG)", MOWGLI_FUNC_NAME, n);
+			return false;
+		}
+		if (! (jobs[n].dk && jobs[n].dkLen))
+		{
+			(void) slog(LG_ERROR, "%s: job %zu has no output buffer (BUG)", MOWGLI_FUNC_NAME, n);
+			return false;
+		}
+	}
+
+	return _digest_oneshot_pbkdf2_batch(alg, jobs, jobsLen, c);
+}
@@ -69,6 +69,16 @@
  * by the PKCS5_PBKDF2_HMAC() function in OpenSSL:
  *   <https://www.openssl.org/>
  *   <https://github.com/openssl/openssl/blob/8d049ed24b06ada5/crypto/evp/p5_crpt2.c#L25-L34>
+ *
+ * The second PBKDF2-HMAC-SHA2-256 vector is taken from RFC 7914 Section 11:
+ *   <https://tools.ietf.org/html/rfc7914#section-11>
+ *
+ * The second PBKDF2-HMAC-SHA2-512 vector (same inputs) was generated by the
+ * hashlib.pbkdf2_hmac() function in Python.
+ *
+ * The PBKDF2-HMAC-SHA2 vectors are run once with each multi-lane SHA2 kernel
+ * that the CPU supports, and then a batch of more derivations than there are
+ * lanes is checked against the same derivations done one at a time.
  */
 
 static bool
@@ -4845,6 +4855,32 @@ digest_testsuite_run_pbkdf2_sha2_256(void)
 	if (memcmp(result, vector, sizeof vector) != 0)
 		return false;
 
+	static const char key2[] = "passwd";
+	static const char salt2[] = "salt";
+	static const uint32_t iter2 = 1;
+
+	static const unsigned char vector2[] = {
+		0x55U, 0xACU, 0x04U, 0x6EU, 0x56U, 0xE3U, 0x08U, 0x9FU,
+		0xECU, 0x16U, 0x91U, 0xC2U, 0x25U, 0x44U, 0xB6U, 0x05U,
+		0xF9U, 0x41U, 0x85U, 0x21U, 0x6DU, 0xDEU, 0x04U, 0x65U,
+		0xE6U, 0x8BU, 0x9DU, 0x57U, 0xC2U, 0x0DU, 0xACU, 0xBCU,
+		0x49U, 0xCAU, 0x9CU, 0xCCU, 0xF1U, 0x79U, 0xB6U, 0x45U,
+		0x99U, 0x16U, 0x64U, 0xB3U, 0x9DU, 0x77U, 0xEFU, 0x31U,
+		0x7CU, 0x71U, 0xB8U, 0x45U, 0xB1U, 0xE3U, 0x0BU, 0xD5U,
+		0x09U, 0x11U, 0x20U, 0x41U, 0xD3U, 0xA1U, 0x97U, 0x83U,
+	};
+
+	unsigned char result2[sizeof vector2];
+
+	(void) slog(LG_DEBUG, "%s: vector 2", MOWGLI_FUNC_NAME);
+
+	if (! digest_oneshot_pbkdf2(DIGALG_SHA2_256, key2, strlen(key2), salt2, strlen(salt2), iter2, result2,
+	                            sizeof result2))
+		return false;
+
+	if (memcmp(result2, vector2, sizeof vector2) != 0)
+		return false;
+
 	return true;
 }
 
@@ -4951,9 +4987,105 @@ digest_testsuite_run_pbkdf2_sha2_512(void)
 	if (memcmp(result, vector, sizeof vector) != 0)
 		return false;
 
+	static const char key2[] = "passwd";
+	static const char salt2[] = "salt";
+	static const uint32_t iter2 = 1;
+
+	static const unsigned char vector2[] = {
+		0xC7U, 0x43U, 0x19U, 0xD9U, 0x94U, 0x99U, 0xFCU, 0x3EU,
+		0x90U, 0x13U, 0xACU, 0xFFU, 0x59U, 0x7CU, 0x23U, 0xC5U,
+		0xBAU, 0xF0U, 0xA0U, 0xBEU, 0xC5U, 0x63U, 0x4CU, 0x46U,
+		0xB8U, 0x35U, 0x2BU, 0x79U, 0x3EU, 0x32U, 0x47U, 0x23U,
+		0xD5U, 0x5CU, 0xAAU, 0x76U, 0xB2U, 0xB2U, 0x5CU, 0x43U,
+		0x40U, 0x2DU, 0xCFU, 0xDCU, 0x06U, 0xCDU, 0xCFU, 0x66U,
+		0xF9U, 0x5BU, 0x7DU, 0x04U, 0x29U, 0x42U, 0x0BU, 0x39U,
+		0x52U, 0x00U, 0x06U, 0x74U, 0x9CU, 0x51U, 0xA0U, 0x4EU,
+	};
+
+	unsigned char result2[sizeof vector2];
+
+	(void) slog(LG_DEBUG, "%s: vector 2", MOWGLI_FUNC_NAME);
+
+	if (! digest_oneshot_pbkdf2(DIGALG_SHA2_512, key2, strlen(key2), salt2, strlen(salt2), iter2, result2,
+	                            sizeof result2))
+		return false;
+
+	if (memcmp(result2, vector2, sizeof vector2) != 0)
+		return false;
+
 	return true;
 }
 
+static bool
+digest_testsuite_run_pbkdf2_batch(const enum digest_algorithm alg)
+{
+	unsigned char pass[DIGEST_LANES_MAX + 1][0x10U];
+	unsigned char salt[DIGEST_LANES_MAX + 1][0x10U];
+	unsigned char batch[DIGEST_LANES_MAX + 1][DIGEST_MDLEN_MAX * 2];
+	unsigned char single[DIGEST_MDLEN_MAX * 2];
+	struct digest_pbkdf2_job jobs[DIGEST_LANES_MAX + 1];
+
+	static const uint32_t iter = 8;
+
+	for (size_t i = 0; i < (DIGEST_LANES_MAX + 1); i++)
+	{
+		for (size_t x = 0; x < 0x10U; x++)
+		{
+			pass[i][x] = (unsigned char) ((i << 0x04U) | x);
+			salt[i][x] = (unsigned char) (0xFFU - pass[i][x]);
+		}
+
+		jobs[i].pass = pass[i];
+		jobs[i].passLen = sizeof pass[i];
+		jobs[i].salt = salt[i];
+		jobs[i].saltLen = sizeof salt[i];
+		jobs[i].dk = batch[i];
+		jobs[i].dkLen = 0x14U + (i * 0x0BU);
+	}
+
+	(void) slog(LG_DEBUG, "%s: batch of %u", MOWGLI_FUNC_NAME, DIGEST_LANES_MAX + 1);
+
+	if (! digest_oneshot_pbkdf2_batch(alg, jobs, DIGEST_LANES_MAX + 1, iter))
+		return false;
+
+	for (size_t i = 0; i < (DIGEST_LANES_MAX + 1); i++)
+	{
+		if (! digest_oneshot_pbkdf2(alg, pass[i], sizeof pass[i], salt[i], sizeof salt[i], iter, single,
+		                            jobs[i].dkLen))
+			return false;
+
+		if (memcmp(batch[i], single, jobs[i].dkLen) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static bool
+digest_testsuite_run_pbkdf2_lanes(void)
+{
+	static const enum digest_lanes_impl impls[] = {
+		DIGEST_LANES_IMPL_SCALAR, DIGEST_LANES_IMPL_SSE41, DIGEST_LANES_IMPL_AVX2,
+	};
+
+	bool result = true;
+
+	for (size_t i = 0; result && i < (sizeof impls / sizeof impls[0]); i++)
+	{
+		if (! digest_direct_lanes_force(impls[i]))
+			continue;
+
+		(void) slog(LG_DEBUG, "%s: %s", MOWGLI_FUNC_NAME, digest_direct_lanes_name(impls[i]));
+
+		result = digest_testsuite_run_pbkdf2_sha2_256() && digest_testsuite_run_pbkdf2_sha2_512() &&
+		         digest_testsuite_run_pbkdf2_batch(DIGALG_SHA2_256) &&
+		         digest_testsuite_run_pbkdf2_batch(DIGALG_SHA2_512);
+	}
+
+	(void) digest_direct_lanes_force(DIGEST_LANES_IMPL_AUTO);
+	return result;
+}
+
 bool
 digest_testsuite_run(void)
 {
@@ -5009,5 +5141,9 @@ digest_testsuite_run(void)
 		return false;
 
 
+	if (! digest_testsuite_run_pbkdf2_lanes())
+		return false;
+
+
 	return true;
 }
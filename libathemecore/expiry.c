@@ -0,0 +1,123 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * atheme-services: A collection of minimalist IRC services
+ * expiry.c: Expiry queues.
+ *
+ * Objects that expire at some time (K/X/Q-lines, and accounts, nicks and
+ * channels, see expire_check()) are kept in a binary min-heap ordered by
+ * that time, so that the periodic tasks only look at the ones that are due
+ * instead of walking all of them.  Each object holds its position in the
+ * heap, so that it can be moved or removed when it changes or is deleted.
+ */
+
+#include <atheme.h>
+#include "internal.h"
+
+static inline void
+expiry_queue_place(struct expiry_queue *const restrict q, const unsigned int i, const struct expiry_entry e)
+{
+	q->entries[i] = e;
+	*e.idx = i + 1;
+}
+
+static void
+expiry_queue_sift(struct expiry_queue *const restrict q, unsigned int i)
+{
+	const struct expiry_entry e = q->entries[i];
+	unsigned int parent, child;
+
+	while (i > 0)
+	{
+		parent = (i - 1) / 2;
+		if (q->entries[parent].when <= e.when)
+			break;
+		expiry_queue_place(q, i, q->entries[parent]);
+		i = parent;
+	}
+
+	for (;;)
+	{
+		child = 2 * i + 1;
+		if (child >= q->count)
+			break;
+		if (child + 1 < q->count && q->entries[child + 1].when < q->entries[child].when)
+			child++;
+		if (e.when <= q->entries[child].when)
+			break;
+		expiry_queue_place(q, i, q->entries[child]);
+		i = child;
+	}
+
+	expiry_queue_place(q, i, e);
+}
+
+// Queues an object to be due at when, or moves it there if it is already queued
+void
+expiry_queue_set(struct expiry_queue *const restrict q, void *const restrict obj, unsigned int *const restrict idx,
+                 const time_t when)
+{
+	return_if_fail(q != NULL);
+	return_if_fail(obj != NULL);
+	return_if_fail(idx != NULL);
+
+	if (*idx != 0)
+	{
+		q->entries[*idx - 1].when = when;
+		expiry_queue_sift(q, *idx - 1);
+		return;
+	}
+
+	if (q->count == q->size)
+	{
+		q->size = q->size ? q->size * 2 : 64;
+		q->entries = sreallocarray(q->entries, q->size, sizeof *q->entries);
+	}
+
+	q->entries[q->count] = (struct expiry_entry) { .when = when, .obj = obj, .idx = idx };
+	*idx = ++q->count;
+	expiry_queue_sift(q, q->count - 1);
+}
+
+void
+expiry_queue_delete(struct expiry_queue *const restrict q, unsigned int *const restrict idx)
+{
+	return_if_fail(q != NULL);
+	return_if_fail(idx != NULL);
+
+	if (*idx == 0)
+		return;
+
+	const unsigned int i = *idx - 1;
+
+	*idx = 0;
+
+	if (i != --q->count)
+	{
+		q->entries[i] = q->entries[q->count];
+		expiry_queue_sift(q, i);
+	}
+}
+
+// Removes and returns an object that is due at or before now, or NULL if there are none
+void *
+expiry_queue_pop(struct expiry_queue *const restrict q, const time_t now)
+{
+	return_val_if_fail(q != NULL, NULL);
+
+	if (q->count == 0 || q->entries[0].when > now)
+		return NULL;
+
+	void *const obj = q->entries[0].obj;
+
+	expiry_queue_delete(q, q->entries[0].idx);
+
+	return obj;
+}
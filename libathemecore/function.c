@@ -568,6 +568,26 @@ srename(const char *old_fn, const char *new_fn)
 	return rename(old_fn, new_fn);
 }
 
+/* Like strerror(), but safe to call from a thread other than the main one
+ * (e.g. a password verification thread); the message may be put in buf.
+ */
+const char *
+sstrerror(const int errnum, char *const restrict buf, const size_t buflen)
+{
+#if defined(HAVE_STRERROR_R) && defined(STRERROR_R_CHAR_P)
+	return strerror_r(errnum, buf, buflen);
+#elif defined(HAVE_STRERROR_R)
+	if (strerror_r(errnum, buf, buflen) != 0)
+		(void) snprintf(buf, buflen, "Unknown error %d", errnum);
+
+	return buf;
+#else
+	(void) mowgli_strlcpy(buf, strerror(errnum), buflen);
+
+	return buf;
+#endif
+}
+
 char *
 combine_path(const char *parent, const char *child)
 {
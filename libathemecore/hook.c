@@ -19,37 +19,42 @@
 
 static mowgli_patricia_t *hooks = NULL;
 static mowgli_heap_t *hook_heap = NULL;
-static mowgli_heap_t *hook_privfn_heap = NULL;
 
 typedef struct {
 	struct hook *hook;
 	void *dptr;
 	mowgli_node_t node;
 	unsigned int flags;
+	unsigned int pos;	/* next slot in hook->handlers to run */
 } hook_run_ctx_t;
 
-typedef struct {
-	hook_fn hookfn;
-	mowgli_node_t node;
-} hook_privfn_ctx_t;
-
 #define HF_RUN		0x1
 #define HF_STOP		0x2
 
 static mowgli_list_t hook_run_stack = { NULL, NULL, 0 };
 
+/* every hook in hooktypes.in has a static descriptor, so that hook_call_*()
+ * can go straight to its handlers; hooks only known by name at runtime are
+ * allocated by hook_add_event() */
+#define HOOK_DEFINE(hookname)	struct hook hook_ev_##hookname = { .name = #hookname };
+HOOKTYPES_FOREACH(HOOK_DEFINE)
+#undef HOOK_DEFINE
+
 void
 hooks_init(void)
 {
 	hooks = mowgli_patricia_create(strcasecanon);
 	hook_heap = sharedheap_get(sizeof(struct hook));
-	hook_privfn_heap = sharedheap_get(sizeof(hook_privfn_ctx_t));
 
-	if (hook_heap == NULL || hook_privfn_heap == NULL || hooks == NULL)
+	if (hook_heap == NULL || hooks == NULL)
 	{
 		slog(LG_INFO, "hooks_init(): block allocator failed.");
 		exit(EXIT_SUCCESS);
 	}
+
+#define HOOK_REGISTER(hookname)	mowgli_patricia_add(hooks, hook_ev_##hookname.name, &hook_ev_##hookname);
+	HOOKTYPES_FOREACH(HOOK_REGISTER)
+#undef HOOK_REGISTER
 }
 
 static inline struct hook *
@@ -74,58 +79,94 @@ hook_add_event(const char *name)
 	return nh;
 }
 
-static inline void
-hook_destroy(struct hook *hook, hook_privfn_ctx_t *priv)
+/* squeeze out the slots of handlers removed while the hook was running */
+static void
+hook_compact(struct hook *h)
 {
-	mowgli_node_delete(&priv->node, &hook->hooks);
-	mowgli_heap_free(hook_privfn_heap, priv);
+	unsigned int i, j;
+
+	for (i = j = 0; i < h->count; i++)
+		if (h->handlers[i] != NULL)
+			h->handlers[j++] = h->handlers[i];
+
+	h->count = j;
 }
 
 void
-hook_del_hook(const char *event, hook_fn handler)
+hook_del_handler(struct hook *h, hook_fn handler)
 {
-	mowgli_node_t *n, *n2;
-	struct hook *h;
+	unsigned int i;
 
-	return_if_fail(event != NULL);
+	return_if_fail(h != NULL);
 	return_if_fail(handler != NULL);
 
-	h = hook_find(event);
-	if (h == NULL)
-		return;
+	for (i = 0; i < h->count; i++)
+	{
+		if (h->handlers[i] == handler)
+		{
+			h->handlers[i] = NULL;
+			h->live--;
+		}
+	}
+
+	if (h->running == 0)
+		hook_compact(h);
+}
+
+void
+hook_add_handler(struct hook *h, hook_fn handler, bool first)
+{
+	return_if_fail(h != NULL);
+	return_if_fail(handler != NULL);
 
-	MOWGLI_ITER_FOREACH_SAFE(n, n2, h->hooks.head)
+	if (h->count == h->size)
 	{
-		hook_privfn_ctx_t *priv = n->data;
+		h->size = h->size ? h->size * 2 : 4;
+		h->handlers = sreallocarray(h->handlers, h->size, sizeof *h->handlers);
+	}
+
+	if (first)
+	{
+		mowgli_node_t *n;
 
-		if (handler == priv->hookfn)
-			hook_destroy(h, n->data);
+		memmove(h->handlers + 1, h->handlers, h->count * sizeof *h->handlers);
+		h->handlers[0] = handler;
+
+		// calls in progress carry on with the handler they were about to run
+		MOWGLI_ITER_FOREACH(n, hook_run_stack.head)
+		{
+			hook_run_ctx_t *ctx = n->data;
+
+			if (ctx->hook == h)
+				ctx->pos++;
+		}
 	}
+	else
+		h->handlers[h->count] = handler;
+
+	h->count++;
+	h->live++;
 }
 
-static inline hook_privfn_ctx_t *
-hook_create_and_add(struct hook *hook, hook_fn handler,
-	void (*addfn)(void *data, mowgli_node_t *node, mowgli_list_t *list))
+void
+hook_del_hook(const char *event, hook_fn handler)
 {
-	hook_privfn_ctx_t *priv;
-
-	return_val_if_fail(hook != NULL, NULL);
-	return_val_if_fail(handler != NULL, NULL);
-	return_val_if_fail(addfn != NULL, NULL);
+	struct hook *h;
 
-	priv = mowgli_heap_alloc(hook_privfn_heap);
-	priv->hookfn = handler;
+	return_if_fail(event != NULL);
+	return_if_fail(handler != NULL);
 
-	addfn(priv, &priv->node, &hook->hooks);
+	h = hook_find(event);
+	if (h == NULL)
+		return;
 
-	return priv;
+	hook_del_handler(h, handler);
 }
 
 void
 hook_add_hook(const char *event, hook_fn handler)
 {
 	struct hook *h;
-	hook_privfn_ctx_t *priv;
 
 	return_if_fail(event != NULL);
 	return_if_fail(handler != NULL);
@@ -134,7 +175,7 @@ hook_add_hook(const char *event, hook_fn handler)
 	if (h == NULL)
 		h = hook_add_event(event);
 
-	hook_create_and_add(h, handler, mowgli_node_add);
+	hook_add_handler(h, handler, false);
 }
 
 void
@@ -149,40 +190,59 @@ hook_add_hook_first(const char *event, hook_fn handler)
 	if (h == NULL)
 		h = hook_add_event(event);
 
-	hook_create_and_add(h, handler, mowgli_node_add_head);
+	hook_add_handler(h, handler, true);
 }
 
 void
-hook_call_event(const char *event, void *dptr)
+hook_call_handlers(struct hook *h, void *dptr)
 {
 	hook_run_ctx_t ctx;
-	mowgli_node_t *n, *tn;
-	void (*func)(void *data);
 
-	return_if_fail(event != NULL);
-
-	ctx.hook = hook_find(event);
-	if (ctx.hook == NULL)
-		return;
+	return_if_fail(h != NULL);
 
+	ctx.hook = h;
 	ctx.dptr = dptr;
 	ctx.flags = HF_RUN;
+	ctx.pos = 0;
 
 	mowgli_node_add_head(&ctx, &ctx.node, &hook_run_stack);
+	h->running++;
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, ctx.hook->hooks.head)
+	/* handlers may be added or removed by the handlers themselves, so
+	 * re-read the array on every step */
+	while (ctx.pos < h->count)
 	{
-		hook_privfn_ctx_t *priv = n->data;
+		hook_fn func = h->handlers[ctx.pos++];
+
+		if (func == NULL)
+			continue;
 
-		priv->hookfn(ctx.dptr);
+		func(ctx.dptr);
 		if (ctx.flags & HF_STOP)
-			goto out;
+			break;
 	}
 
-out:
+	h->running--;
+	if (h->running == 0 && h->live != h->count)
+		hook_compact(h);
+
 	mowgli_node_delete(&ctx.node, &hook_run_stack);
 }
 
+void
+hook_call_event(const char *event, void *dptr)
+{
+	struct hook *h;
+
+	return_if_fail(event != NULL);
+
+	h = hook_find(event);
+	if (h == NULL || h->live == 0)
+		return;
+
+	hook_call_handlers(h, dptr);
+}
+
 static inline hook_run_ctx_t *
 hook_run_stack_highest(void)
 {
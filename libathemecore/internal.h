@@ -23,4 +23,34 @@ void init_signal_handlers(void);
 
 void language_init(void);
 
+/* auth.c */
+void verify_password_recrypt(struct myuser *mu, const char *password, const struct crypt_impl *ci,
+                             unsigned int verify_flags);
+
+/* authpool.c */
+void authpool_configure(void);
+void authpool_shutdown(void);
+void authpool_crypt_lock(void);
+void authpool_crypt_unlock(void);
+bool authpool_log_deferred(unsigned int level, const char *buf);
+const struct crypt_params *authpool_current_params(void);
+void authpool_set_current(void *req);
+
+/* crypto.c */
+struct crypt_params;
+struct crypt_params *crypt_params_snapshot(void);
+void crypt_params_free(struct crypt_params *params);
+const struct crypt_impl *crypt_verify_password_by(const char *password, const char *parameters, unsigned int *flags,
+                                                  bool threaded, const struct crypt_params *params) ATHEME_FATTR_WUR;
+bool crypt_batch_key(const char *parameters, const struct crypt_impl **impl, uint64_t *key) ATHEME_FATTR_WUR;
+const struct crypt_impl *crypt_verify_batch_by(struct crypt_verify_job *jobs, size_t n) ATHEME_FATTR_WUR;
+
+/* logger.c */
+unsigned int log_enabled_levels(void);
+
+/* memostore.c */
+void memostore_put(struct mymemo *memo, const char *text);
+const char *memostore_get(const struct mymemo *memo, char *buf);
+void memostore_release(struct mymemo *memo);
+
 #endif /* !ATHEME_LAC_INTERNAL_H */
@@ -18,9 +18,40 @@
 
 static struct logfile *log_file;
 int log_force;
+unsigned int log_active_mask = LG_ERROR | LG_INFO;
 
 static mowgli_list_t log_files = { NULL, NULL, 0 };
 
+/* Recompute log_active_mask from the registered log streams. Called
+ * whenever a stream comes or goes or its mask changes.
+ */
+static void
+log_update_active_mask(void)
+{
+	const mowgli_node_t *n;
+
+	/* vslog_ext() echoes these to the terminal while there is no
+	 * master log file.
+	 */
+	unsigned int mask = (log_file != NULL) ? 0U : (LG_ERROR | LG_INFO);
+
+	MOWGLI_ITER_FOREACH(n, log_files.head)
+	{
+		const struct logfile *const lf = n->data;
+
+		mask |= lf->log_mask;
+	}
+
+	log_active_mask = mask;
+}
+
+/* The levels that log_level_enabled() accepts right now. */
+unsigned int
+log_enabled_levels(void)
+{
+	return log_force ? ~0U : log_active_mask;
+}
+
 /* private destructor function for struct logfile. */
 static void
 logfile_delete_file(void *vdata)
@@ -330,6 +361,7 @@ void
 logfile_register(struct logfile *lf)
 {
 	mowgli_node_add(lf, &lf->node, &log_files);
+	log_update_active_mask();
 }
 
 /*
@@ -350,6 +382,7 @@ void
 logfile_unregister(struct logfile *lf)
 {
 	mowgli_node_delete(&lf->node, &log_files);
+	log_update_active_mask();
 }
 
 /*
@@ -482,6 +515,7 @@ void
 log_open(void)
 {
 	log_file = logfile_new(log_path, LG_ERROR | LG_INFO | LG_CMD_ADMIN);
+	log_update_active_mask();
 }
 
 /*
@@ -524,18 +558,7 @@ log_shutdown(void)
 bool
 log_debug_enabled(void)
 {
-	mowgli_node_t *n;
-	struct logfile *lf;
-
-	if (log_force)
-		return true;
-	MOWGLI_ITER_FOREACH(n, log_files.head)
-	{
-		lf = n->data;
-		if (lf->log_mask & (LG_DEBUG | LG_RAWDATA))
-			return true;
-	}
-	return false;
+	return log_level_enabled(LG_DEBUG | LG_RAWDATA);
 }
 
 /*
@@ -559,6 +582,7 @@ log_master_set_mask(unsigned int mask)
 	if (log_file == NULL)
 		return;
 	log_file->log_mask = mask;
+	log_update_active_mask();
 }
 
 /*
@@ -607,15 +631,22 @@ vslog_ext(enum log_type type, unsigned int level, const char *fmt, va_list args)
 {
 	static bool in_vslog_ext = false;
 
+	if (! log_level_enabled(level))
+		return;
+
+	char buf[BUFSIZE];
+	(void) vsnprintf(buf, sizeof buf, fmt, args);
+
+	// Password verification threads must not touch the log files; this is logged later (or dropped)
+	if (authpool_log_deferred(level, buf))
+		return;
+
 	// Detect infinite logging recursion
 	if (in_vslog_ext)
 		return;
 
 	in_vslog_ext = true;
 
-	char buf[BUFSIZE];
-	(void) vsnprintf(buf, sizeof buf, fmt, args);
-
 	const mowgli_node_t *n;
 	MOWGLI_ITER_FOREACH(n, log_files.head)
 	{
@@ -679,7 +710,7 @@ slog_ext(enum log_type type, unsigned int level, const char *fmt, ...)
  *       - logfiles are updated depending on how they are configured.
  */
 void ATHEME_FATTR_PRINTF(2, 3)
-slog(unsigned int level, const char *fmt, ...)
+(slog)(unsigned int level, const char *fmt, ...)
 {
 	va_list args;
 
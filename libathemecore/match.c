@@ -734,6 +734,414 @@ regex_destroy(struct atheme_regex *preg)
 	return true;
 }
 
+/*
+ * regex_set_combinable()
+ *  Whether a POSIX extended `pattern' can be wrapped in a group and joined
+ *  to others with `|' without changing what it matches. Patterns using
+ *  back-references, or with parentheses we cannot account for, are not.
+ *  The number of groups the pattern opens is stored in `ngroups'.
+ */
+static bool
+regex_set_combinable(const char *p, size_t *ngroups)
+{
+	int depth = 0;
+
+	*ngroups = 0;
+
+	for (; *p != '\0'; p++)
+	{
+		if (*p == '\\')
+		{
+			p++;
+			if (*p == '\0' || isdigit((unsigned char)*p))
+				return false;
+		}
+		else if (*p == '[')
+		{
+			p++;
+			if (*p == '^')
+				p++;
+			if (*p == ']')
+				p++;
+			for (; *p != ']'; p++)
+			{
+				if (*p == '\0')
+					return false;
+				if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+				{
+					const char c = p[1];
+
+					for (p += 2; *p != c || p[1] != ']'; p++)
+						if (*p == '\0')
+							return false;
+					p++;
+				}
+			}
+		}
+		else if (*p == '(')
+		{
+			depth++;
+			(*ngroups)++;
+		}
+		else if (*p == ')' && --depth < 0)
+			return false;
+	}
+
+	return depth == 0;
+}
+
+/*
+ * regex_set_compile_node()
+ *  Compile the alternation of members [lo, hi) of `mode' into node `k',
+ *  then its children. The left child of a node sits right after it and the
+ *  right child after the whole left subtree. Single members are not
+ *  compiled again; their own regex is used.
+ */
+static void
+regex_set_compile_node(struct atheme_regex_set_mode *mode, size_t k, size_t lo, size_t hi, int cflags)
+{
+	struct atheme_regex_set_node *const node = &mode->nodes[k];
+	const size_t mid = lo + (hi - lo) / 2;
+	char *buf, *p;
+	size_t len = 0;
+	int errnum;
+
+	if (hi - lo < 2)
+		return;
+
+	// each member is written as "|(" pattern ")"
+	for (size_t i = lo; i < hi; i++)
+		len += strlen(mode->members[i]->pattern) + 3;
+
+	p = buf = smalloc(len);
+
+	for (size_t i = lo; i < hi; i++)
+	{
+		const char *const pattern = mode->members[i]->pattern;
+		const size_t plen = strlen(pattern);
+
+		if (p != buf)
+			*p++ = '|';
+		*p++ = '(';
+		memcpy(p, pattern, plen);
+		p += plen;
+		*p++ = ')';
+	}
+	*p = '\0';
+
+	errnum = regcomp(&node->re, buf, cflags);
+	if (errnum != 0)
+	{
+		char errmsg[BUFSIZE];
+
+		regerror(errnum, &node->re, errmsg, sizeof errmsg);
+		slog(LG_DEBUG, "regex_set_compile_node(): %s; splitting %zu patterns", errmsg, hi - lo);
+		regfree(&node->re);
+	}
+	else
+		node->compiled = true;
+
+	sfree(buf);
+
+	regex_set_compile_node(mode, k + 1, lo, mid, cflags);
+	regex_set_compile_node(mode, k + 2 * (mid - lo), mid, hi, cflags);
+}
+
+/*
+ * regex_set_free_mode()
+ *  Release everything regex_set_rebuild() built for one case mode.
+ */
+static void
+regex_set_free_mode(struct atheme_regex_set_mode *mode)
+{
+	if (mode->nodes != NULL)
+		for (size_t k = 0; k < 2 * mode->count - 1; k++)
+			if (mode->nodes[k].compiled)
+				regfree(&mode->nodes[k].re);
+
+	sfree(mode->members);
+	sfree(mode->groupoff);
+	sfree(mode->nodes);
+	sfree(mode->hits);
+
+	(void) memset(mode, 0x00, sizeof *mode);
+}
+
+/*
+ * regex_set_rebuild()
+ *  For each case mode, build a tree of alternations over the combinable
+ *  entries: the root joins all of them, and every node below joins half of
+ *  its parent's. A string matching none of them costs one regexec().
+ */
+static void
+regex_set_rebuild(struct atheme_regex_set *set)
+{
+	mowgli_node_t *n;
+
+	set->npmatch = 0;
+	sfree(set->pmatch);
+	set->pmatch = NULL;
+
+	for (int i = 0; i < 2; i++)
+	{
+		struct atheme_regex_set_mode *const mode = &set->modes[i];
+		size_t count = 0;
+
+		regex_set_free_mode(mode);
+
+		MOWGLI_ITER_FOREACH(n, set->entries.head)
+		{
+			const struct atheme_regex_set_entry *const e = n->data;
+
+			if (e->combined == i)
+				count++;
+		}
+
+		if (count == 0)
+			continue;
+
+		mode->count = count;
+		mode->members = smalloc(count * sizeof *mode->members);
+		mode->groupoff = smalloc((count + 1) * sizeof *mode->groupoff);
+		mode->nodes = smalloc((2 * count - 1) * sizeof *mode->nodes);
+		mode->hits = smalloc(count * sizeof *mode->hits);
+
+		count = 0;
+
+		MOWGLI_ITER_FOREACH(n, set->entries.head)
+		{
+			struct atheme_regex_set_entry *const e = n->data;
+
+			if (e->combined != i)
+				continue;
+
+			e->index = count;
+			mode->members[count] = e;
+
+			// a member's own group, then the ones inside its pattern
+			mode->groupoff[count + 1] = mode->groupoff[count] + 1 + e->ngroups;
+			count++;
+		}
+
+		if (mode->groupoff[count] + 1 > set->npmatch)
+			set->npmatch = mode->groupoff[count] + 1;
+
+		regex_set_compile_node(mode, 0, 0, count, (i ? REG_ICASE : 0) | REG_EXTENDED);
+	}
+
+	if (set->npmatch != 0)
+		set->pmatch = smalloc(set->npmatch * sizeof *set->pmatch);
+
+	set->dirty = false;
+}
+
+/*
+ * regex_set_query()
+ *  Mark in mode->hits every member in [qlo, qhi) that matches `string',
+ *  descending from node `k', which covers members [lo, hi).
+ *
+ *  When a node's alternation matches, the group that took part in the
+ *  match names the member that hit, so that one is marked without being
+ *  run again, and only the members on either side of it are looked at
+ *  further. Each regexec() either rules out a whole range or finds a hit.
+ */
+static void
+regex_set_query(struct atheme_regex_set *set, struct atheme_regex_set_mode *mode, size_t k, size_t lo, size_t hi,
+                size_t qlo, size_t qhi, const char *string)
+{
+	const size_t mid = lo + (hi - lo) / 2;
+
+	if (qlo < lo)
+		qlo = lo;
+	if (qhi > hi)
+		qhi = hi;
+	if (qlo >= qhi)
+		return;
+
+	if (hi - lo == 1)
+	{
+		if (regex_match(mode->members[lo]->re, (char *) string))
+			mode->hits[lo] = true;
+
+		return;
+	}
+
+	if (qlo == lo && qhi == hi && mode->nodes[k].compiled)
+	{
+		const size_t nsub = mode->groupoff[hi] - mode->groupoff[lo];
+
+		if (regexec(&mode->nodes[k].re, string, nsub + 1, set->pmatch, 0) != 0)
+			return;
+
+		for (size_t m = lo; m < hi; m++)
+		{
+			if (set->pmatch[1 + mode->groupoff[m] - mode->groupoff[lo]].rm_so == -1)
+				continue;
+
+			mode->hits[m] = true;
+			regex_set_query(set, mode, k, lo, hi, lo, m, string);
+			regex_set_query(set, mode, k, lo, hi, m + 1, hi, string);
+			return;
+		}
+	}
+
+	regex_set_query(set, mode, k + 1, lo, mid, qlo, qhi, string);
+	regex_set_query(set, mode, k + 2 * (mid - lo), mid, hi, qlo, qhi, string);
+}
+
+/*
+ * regex_set_create()
+ *  Create an empty regex set.
+ */
+struct atheme_regex_set * ATHEME_FATTR_MALLOC ATHEME_FATTR_RETURNS_NONNULL
+regex_set_create(void)
+{
+	return smalloc(sizeof(struct atheme_regex_set));
+}
+
+/*
+ * regex_set_add()
+ *  Add the compiled regex `re' of `pattern' (created with `flags') to the
+ *  set, identified by `data'. The regex remains owned by the caller.
+ */
+void
+regex_set_add(struct atheme_regex_set *set, const char *pattern, int flags, struct atheme_regex *re, void *data)
+{
+	return_if_fail(set != NULL);
+	return_if_fail(pattern != NULL);
+	return_if_fail(re != NULL);
+
+	struct atheme_regex_set_entry *const e = smalloc(sizeof *e);
+
+	e->pattern = sstrdup(pattern);
+	e->re = re;
+	e->data = data;
+
+	if (re->type == at_posix && regex_set_combinable(pattern, &e->ngroups))
+		e->combined = (flags & AREGEX_ICASE) ? 1 : 0;
+	else
+		e->combined = -1;
+
+	mowgli_node_add(e, &e->node, &set->entries);
+
+	if (e->combined != -1)
+		set->dirty = true;
+}
+
+/*
+ * regex_set_delete()
+ *  Remove the entry identified by `data' from the set.
+ */
+void
+regex_set_delete(struct atheme_regex_set *set, void *data)
+{
+	mowgli_node_t *n;
+
+	return_if_fail(set != NULL);
+
+	MOWGLI_ITER_FOREACH(n, set->entries.head)
+	{
+		struct atheme_regex_set_entry *const e = n->data;
+
+		if (e->data != data)
+			continue;
+
+		if (e->combined != -1)
+		{
+			// the member table points at it until the next rebuild
+			if (! set->dirty)
+				set->modes[e->combined].members[e->index] = NULL;
+
+			set->dirty = true;
+		}
+
+		mowgli_node_delete(&e->node, &set->entries);
+		sfree(e->pattern);
+		sfree(e);
+		return;
+	}
+}
+
+/*
+ * regex_set_match()
+ *  Match `string' against every regex in the set, calling `cb' with the
+ *  entry's data and `priv' for each one that matches, in the order they
+ *  were added. Returns the number of matches.
+ */
+unsigned int
+regex_set_match(struct atheme_regex_set *set, char *string, regex_set_match_fn cb, void *priv)
+{
+	mowgli_node_t *n, *tn;
+	unsigned int matches = 0;
+
+	return_val_if_fail(set != NULL, 0);
+	return_val_if_fail(string != NULL, 0);
+
+	if (set->dirty)
+		regex_set_rebuild(set);
+
+	for (int i = 0; i < 2; i++)
+	{
+		struct atheme_regex_set_mode *const mode = &set->modes[i];
+
+		if (mode->count == 0)
+			continue;
+
+		(void) memset(mode->hits, 0x00, mode->count * sizeof *mode->hits);
+		regex_set_query(set, mode, 0, 0, mode->count, 0, mode->count, string);
+	}
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, set->entries.head)
+	{
+		struct atheme_regex_set_entry *const e = n->data;
+
+		if (e->combined != -1)
+		{
+			// added by an earlier callback, after the tree was built
+			if (set->dirty && (e->index >= set->modes[e->combined].count ||
+			                   set->modes[e->combined].members[e->index] != e))
+				continue;
+
+			if (!set->modes[e->combined].hits[e->index])
+				continue;
+		}
+		else if (!regex_match(e->re, string))
+			continue;
+
+		matches++;
+		cb(e->data, priv);
+	}
+
+	return matches;
+}
+
+/*
+ * regex_set_destroy()
+ *  Free the set. The regexes added to it are left alone.
+ */
+void
+regex_set_destroy(struct atheme_regex_set *set)
+{
+	mowgli_node_t *n, *tn;
+
+	return_if_fail(set != NULL);
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, set->entries.head)
+	{
+		struct atheme_regex_set_entry *const e = n->data;
+
+		mowgli_node_delete(&e->node, &set->entries);
+		sfree(e->pattern);
+		sfree(e);
+	}
+
+	for (int i = 0; i < 2; i++)
+		regex_set_free_mode(&set->modes[i]);
+
+	sfree(set->pmatch);
+	sfree(set);
+}
+
 /* vim:cinoptions=>s,e0,n0,f0,{0,}0,^0,=s,ps,t0,c3,+s,(2s,us,)20,*30,gs,hs
  * vim:ts=8
  * vim:sw=8
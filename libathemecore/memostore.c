@@ -0,0 +1,345 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * atheme-services: A collection of minimalist IRC services
+ * memostore.c: Memo texts, kept out of memory.
+ *
+ * Only the headers of memos (sender, time sent, status and where the text
+ * is) stay in memory. The texts are appended to a scratch file in the data
+ * directory and read back when MemoServ shows a memo or the database is
+ * saved. The file is unlinked as soon as it is created: the database stays
+ * the only copy of a memo that persists, and the store is filled from it on
+ * every start. A forked database save goes on reading the file it inherited.
+ *
+ * Writes go through a buffer, and texts that are still in it are read from
+ * there. The texts of deleted memos stay in the file until they make up most
+ * of it; the live ones are then copied to a new file from the event loop.
+ * If the file cannot be created or written to, texts are kept in memory.
+ */
+
+#include <atheme.h>
+#include "internal.h"
+
+#define MEMOSTORE_BUFSIZE       65536U
+#define MEMOSTORE_COMPACT_MIN   (1024 * 1024)   // less garbage than this is not worth a copy
+
+static int memostore_fd = -1;
+static bool memostore_disabled;                 // keep texts in memory from now on
+static off_t memostore_flushed;                 // bytes written to the file
+static off_t memostore_garbage;                 // bytes of texts of deleted memos
+static off_t memostore_compact_min = MEMOSTORE_COMPACT_MIN;
+static size_t memostore_buflen;
+static char memostore_buf[MEMOSTORE_BUFSIZE];
+static mowgli_eventloop_timer_t *memostore_compact_timer;
+
+#define MEMOSTORE_FOREACH(mt, state, n) \
+	MYENTITY_FOREACH_T((mt), (state), ENT_USER) MOWGLI_ITER_FOREACH((n), user(mt)->memos.head)
+
+static int
+memostore_create(void)
+{
+	char path[BUFSIZE];
+	int fd;
+
+	(void) snprintf(path, sizeof path, "%s/memos.XXXXXX", datadir);
+
+	if ((fd = mkstemp(path)) < 0)
+	{
+		(void) slog(LG_ERROR, "%s: cannot create '%s': %s", MOWGLI_FUNC_NAME, path, strerror(errno));
+		return -1;
+	}
+
+	(void) unlink(path);
+	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	return fd;
+}
+
+static bool
+memostore_pwrite(const int fd, const char *buf, size_t len, off_t off)
+{
+	while (len)
+	{
+		const ssize_t ret = pwrite(fd, buf, len, off);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+			return false;
+
+		buf += ret;
+		len -= (size_t) ret;
+		off += ret;
+	}
+
+	return true;
+}
+
+static bool
+memostore_pread(const int fd, char *buf, size_t len, off_t off)
+{
+	while (len)
+	{
+		const ssize_t ret = pread(fd, buf, len, off);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+			return false;
+
+		buf += ret;
+		len -= (size_t) ret;
+		off += ret;
+	}
+
+	return true;
+}
+
+// copy a text that is in the store into buf (at least MEMOLEN + 1 bytes)
+static bool
+memostore_read(const struct mymemo *const restrict memo, char *const restrict buf)
+{
+	if (memo->textoff >= memostore_flushed)
+		(void) memcpy(buf, memostore_buf + (memo->textoff - memostore_flushed), memo->textlen);
+	else if (! memostore_pread(memostore_fd, buf, memo->textlen, memo->textoff))
+		return false;
+
+	buf[memo->textlen] = 0x00;
+	return true;
+}
+
+/* Brings every text back into memory and closes the file; for when it can no
+ * longer be written to.
+ */
+static void
+memostore_disable(void)
+{
+	struct myentity_iteration_state state;
+	struct myentity *mt;
+	mowgli_node_t *n;
+	char buf[MEMOLEN + 1];
+
+	MEMOSTORE_FOREACH(mt, &state, n)
+	{
+		struct mymemo *const memo = n->data;
+
+		if (memo->text != NULL)
+			continue;
+
+		if (! memostore_read(memo, buf))
+		{
+			(void) slog(LG_ERROR, "%s: cannot read a memo to %s back: %s", MOWGLI_FUNC_NAME, mt->name,
+			                      strerror(errno));
+			buf[0] = 0x00;
+		}
+
+		memo->text = sstrdup(buf);
+	}
+
+	(void) close(memostore_fd);
+
+	memostore_fd = -1;
+	memostore_disabled = true;
+	memostore_flushed = 0;
+	memostore_garbage = 0;
+	memostore_buflen = 0;
+
+	(void) slog(LG_ERROR, "%s: memo texts are now kept in memory", MOWGLI_FUNC_NAME);
+}
+
+static bool
+memostore_flush(void)
+{
+	if (! memostore_buflen)
+		return true;
+
+	if (! memostore_pwrite(memostore_fd, memostore_buf, memostore_buflen, memostore_flushed))
+	{
+		(void) slog(LG_ERROR, "%s: cannot write memo texts to the memo store: %s", MOWGLI_FUNC_NAME,
+		                      strerror(errno));
+		return false;
+	}
+
+	memostore_flushed += (off_t) memostore_buflen;
+	memostore_buflen = 0;
+	return true;
+}
+
+/* Copies the texts of all memos to a new file, in two passes over the same
+ * (unchanged) memos: the first writes the texts, and only once all of them
+ * are written does the second point the memos at the new file.
+ */
+static void
+memostore_compact(void *const ATHEME_VATTR_UNUSED unused)
+{
+	struct myentity_iteration_state state;
+	struct myentity *mt;
+	mowgli_node_t *n;
+	char text[MEMOLEN + 1];
+	off_t off = 0;
+	size_t outlen = 0;
+	int fd;
+
+	memostore_compact_timer = NULL;
+
+	if (memostore_fd == -1 || memostore_garbage < memostore_compact_min)
+		return;
+
+	if (! memostore_flush())
+	{
+		memostore_disable();
+		return;
+	}
+
+	if ((fd = memostore_create()) == -1)
+	{
+		memostore_compact_min *= 2;
+		return;
+	}
+
+	char *const out = smalloc(MEMOSTORE_BUFSIZE);
+
+	MEMOSTORE_FOREACH(mt, &state, n)
+	{
+		const struct mymemo *const memo = n->data;
+
+		if (memo->text != NULL)
+			continue;
+
+		if (! memostore_read(memo, text))
+			goto fail;
+
+		if (outlen + memo->textlen > MEMOSTORE_BUFSIZE)
+		{
+			if (! memostore_pwrite(fd, out, outlen, off))
+				goto fail;
+
+			off += (off_t) outlen;
+			outlen = 0;
+		}
+
+		(void) memcpy(out + outlen, text, memo->textlen);
+		outlen += memo->textlen;
+	}
+
+	if (! memostore_pwrite(fd, out, outlen, off))
+		goto fail;
+
+	(void) slog(LG_DEBUG, "%s: %lld bytes of memo texts kept, %lld dropped", MOWGLI_FUNC_NAME,
+	                      (long long) (off + (off_t) outlen), (long long) memostore_garbage);
+
+	off = 0;
+
+	MEMOSTORE_FOREACH(mt, &state, n)
+	{
+		struct mymemo *const memo = n->data;
+
+		if (memo->text != NULL)
+			continue;
+
+		memo->textoff = off;
+		off += memo->textlen;
+	}
+
+	(void) close(memostore_fd);
+
+	memostore_fd = fd;
+	memostore_flushed = off;
+	memostore_garbage = 0;
+	memostore_compact_min = MEMOSTORE_COMPACT_MIN;
+
+	sfree(out);
+	return;
+
+fail:
+	(void) slog(LG_ERROR, "%s: cannot copy memo texts to a new memo store: %s", MOWGLI_FUNC_NAME, strerror(errno));
+	(void) close(fd);
+
+	memostore_compact_min *= 2;
+
+	sfree(out);
+}
+
+/* Stores the text of a new memo (already cut to MEMOLEN) in the memo store,
+ * or in memory if that is not in use.
+ */
+void
+memostore_put(struct mymemo *const restrict memo, const char *const restrict text)
+{
+	const size_t len = strlen(text);
+
+	if (memostore_fd == -1 && ! memostore_disabled && (memostore_fd = memostore_create()) == -1)
+		memostore_disabled = true;
+
+	if (memostore_disabled)
+	{
+		memo->text = sstrdup(text);
+		return;
+	}
+
+	if (memostore_buflen + len > MEMOSTORE_BUFSIZE && ! memostore_flush())
+	{
+		memostore_disable();
+		memo->text = sstrdup(text);
+		return;
+	}
+
+	memo->text = NULL;
+	memo->textoff = memostore_flushed + (off_t) memostore_buflen;
+	memo->textlen = (unsigned int) len;
+
+	(void) memcpy(memostore_buf + memostore_buflen, text, len);
+	memostore_buflen += len;
+}
+
+/* Returns the text of a memo: either the copy in memory, or the one in the
+ * memo store, read into buf (at least MEMOLEN + 1 bytes). Returns NULL if it
+ * cannot be read.
+ */
+const char *
+memostore_get(const struct mymemo *const restrict memo, char *const restrict buf)
+{
+	if (memo->text != NULL)
+		return memo->text;
+
+	if (! memostore_read(memo, buf))
+	{
+		(void) slog(LG_ERROR, "%s: cannot read a memo text from the memo store: %s", MOWGLI_FUNC_NAME,
+		                      strerror(errno));
+		return NULL;
+	}
+
+	return buf;
+}
+
+// The memo is being deleted; its text is no longer needed
+void
+memostore_release(struct mymemo *const restrict memo)
+{
+	if (memo->text != NULL)
+	{
+		sfree(memo->text);
+		return;
+	}
+
+	memostore_garbage += memo->textlen;
+
+	const off_t live = memostore_flushed + (off_t) memostore_buflen - memostore_garbage;
+
+	/* Not from here: the caller may be part-way through deleting an account,
+	 * whose remaining memos the copy would not see.
+	 */
+	if (memostore_garbage >= memostore_compact_min && memostore_garbage > live && ! memostore_compact_timer &&
+	    base_eventloop != NULL)
+		memostore_compact_timer = mowgli_timer_add_once(base_eventloop, "memostore_compact", &memostore_compact,
+		                                                NULL, 0);
+}
@@ -24,6 +24,33 @@ static mowgli_heap_t *kline_heap = NULL;	/* 16 */
 static mowgli_heap_t *xline_heap = NULL;	/* 16 */
 static mowgli_heap_t *qline_heap = NULL;	/* 16 */
 
+/* K-lines are indexed by their host part, which falls in one of three
+ * classes:
+ *   - literal hosts and IP addresses, kept in a hash keyed on the host;
+ *   - CIDR masks, kept in a binary radix tree per address family, so that
+ *     every mask covering an address is found on the path to it;
+ *   - masks with wildcards, which still have to be matched one by one.
+ * K-lines are also hashed by number.  Temporary K-lines, X-lines and
+ * Q-lines sit in expiry queues, so the expire timers only visit the ones
+ * that are due.
+ */
+
+struct kline_radix
+{
+	struct kline_radix *    child[2];
+	mowgli_list_t           klines;
+};
+
+static mowgli_patricia_t *kline_hosts = NULL;
+static mowgli_patricia_t *kline_numbers = NULL;
+static mowgli_list_t kline_wildcards;
+static struct kline_radix *kline_radix4 = NULL;
+static struct kline_radix *kline_radix6 = NULL;
+
+static struct expiry_queue kline_expiry;
+static struct expiry_queue xline_expiry;
+static struct expiry_queue qline_expiry;
+
 /*************
  * L I S T S *
  *************/
@@ -41,6 +68,9 @@ init_nodes(void)
 		exit(EXIT_FAILURE);
 	}
 
+	kline_hosts = mowgli_patricia_create(irccasecanon);
+	kline_numbers = mowgli_patricia_create(noopcanon);
+
 	init_uplinks();
 	init_servers();
 	init_metadata();
@@ -114,17 +144,151 @@ remove_illegals()
  * K L I N E *
  *************/
 
+static bool
+kline_host_is_literal(const char *host)
+{
+	return *host != '\0' && strpbrk(host, "*?&#%\\") == NULL;
+}
+
+static mowgli_list_t *
+kline_host_find(const char *host)
+{
+	if (host == NULL || *host == '\0')
+		return NULL;
+
+	return mowgli_patricia_retrieve(kline_hosts, host);
+}
+
+static void
+kline_number_key(unsigned long number, char *buf, size_t len)
+{
+	snprintf(buf, len, "%lu", number);
+}
+
+static struct kline_radix **
+kline_radix_root(unsigned int maxbits)
+{
+	return maxbits == 128 ? &kline_radix6 : &kline_radix4;
+}
+
+static inline unsigned int
+kline_radix_bit(const unsigned char *addr, unsigned int bit)
+{
+	return (addr[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+/* returns the list of K-lines for the given prefix, creating it if requested */
+static mowgli_list_t *
+kline_radix_find(const unsigned char *addr, unsigned int maxbits, unsigned int bits, bool create)
+{
+	struct kline_radix **rn = kline_radix_root(maxbits);
+	unsigned int i;
+
+	for (i = 0; ; i++)
+	{
+		if (*rn == NULL)
+		{
+			if (!create)
+				return NULL;
+			*rn = smalloc(sizeof **rn);
+		}
+		if (i == bits)
+			return &(*rn)->klines;
+		rn = &(*rn)->child[kline_radix_bit(addr, i)];
+	}
+}
+
+/* frees the nodes on the path to the given prefix that have become empty */
+static void
+kline_radix_prune(const unsigned char *addr, unsigned int maxbits, unsigned int bits)
+{
+	struct kline_radix **path[129];
+	struct kline_radix **rn = kline_radix_root(maxbits);
+	unsigned int i;
+
+	for (i = 0; *rn != NULL; i++)
+	{
+		path[i] = rn;
+		if (i == bits)
+		{
+			i++;
+			break;
+		}
+		rn = &(*rn)->child[kline_radix_bit(addr, i)];
+	}
+
+	while (i-- > 0)
+	{
+		struct kline_radix *r = *path[i];
+
+		if (r->child[0] != NULL || r->child[1] != NULL || MOWGLI_LIST_LENGTH(&r->klines) != 0)
+			break;
+
+		sfree(r);
+		*path[i] = NULL;
+	}
+}
+
+static void
+kline_index_add(struct kline *k)
+{
+	unsigned char addr[16];
+	unsigned int maxbits, bits;
+	char key[32];
+
+	if (!kline_host_is_literal(k->host))
+		k->idxlist = &kline_wildcards;
+	else if ((maxbits = cidr_parse_mask(k->host, addr, &bits)) != 0)
+		k->idxlist = kline_radix_find(addr, maxbits, bits, true);
+	else if ((k->idxlist = kline_host_find(k->host)) == NULL)
+	{
+		k->idxlist = mowgli_list_create();
+		mowgli_patricia_add(kline_hosts, k->host, k->idxlist);
+	}
+
+	mowgli_node_add(k, &k->idxnode, k->idxlist);
+
+	kline_number_key(k->number, key, sizeof key);
+	mowgli_patricia_add(kline_numbers, key, k);
+}
+
+static void
+kline_index_delete(struct kline *k)
+{
+	unsigned char addr[16];
+	unsigned int maxbits, bits;
+	char key[32];
+
+	mowgli_node_delete(&k->idxnode, k->idxlist);
+
+	if (k->idxlist != &kline_wildcards && MOWGLI_LIST_LENGTH(k->idxlist) == 0)
+	{
+		if ((maxbits = cidr_parse_mask(k->host, addr, &bits)) != 0)
+			kline_radix_prune(addr, maxbits, bits);
+		else
+		{
+			mowgli_patricia_delete(kline_hosts, k->host);
+			mowgli_list_free(k->idxlist);
+		}
+	}
+
+	k->idxlist = NULL;
+
+	kline_number_key(k->number, key, sizeof key);
+	if (mowgli_patricia_retrieve(kline_numbers, key) == k)
+		mowgli_patricia_delete(kline_numbers, key);
+}
+
 struct kline *
 kline_add_with_id(const char *user, const char *host, const char *reason, long duration, const char *setby, unsigned long id)
 {
 	struct kline *k;
-	mowgli_node_t *n = mowgli_node_create();
 
 	slog(LG_DEBUG, "kline_add(): %s@%s -> %s (%ld)", user, host, reason, duration);
 
 	k = mowgli_heap_alloc(kline_heap);
 
-	mowgli_node_add(k, n, &klnlist);
+	mowgli_node_add(k, &k->node, &klnlist);
 
 	k->user = sstrdup(user);
 	k->host = sstrdup(host);
@@ -135,6 +299,12 @@ kline_add_with_id(const char *user, const char *host, const char *reason, long d
 	k->expires = CURRTIME + duration;
 	k->number = id;
 
+	kline_index_add(k);
+	if (k->duration != 0)
+		expiry_queue_set(&kline_expiry, k, &k->expiry_idx, k->expires);
+
+	db_record_changed(DB_RECORD_KLINE, k, NULL);
+
 	cnt.kline++;
 
 
@@ -164,19 +334,19 @@ kline_add_user(struct user *u, const char *reason, long duration, const char *se
 void
 kline_delete(struct kline *k)
 {
-	mowgli_node_t *n;
-
 	return_if_fail(k != NULL);
 
 	slog(LG_DEBUG, "kline_delete(): %s@%s -> %s", k->user, k->host, k->reason);
 
+	db_record_deleted(DB_RECORD_KLINE, k);
+
 	/* only unkline if ircd has not already removed this -- jilles */
 	if (me.connected && (k->duration == 0 || k->expires > CURRTIME))
 		unkline_sts("*", k->user, k->host);
 
-	n = mowgli_node_find(k, &klnlist);
-	mowgli_node_delete(n, &klnlist);
-	mowgli_node_free(n);
+	mowgli_node_delete(&k->node, &klnlist);
+	kline_index_delete(k);
+	expiry_queue_delete(&kline_expiry, &k->expiry_idx);
 
 	sfree(k->user);
 	sfree(k->host);
@@ -188,13 +358,29 @@ kline_delete(struct kline *k)
 	cnt.kline--;
 }
 
-struct kline *
-kline_find(const char *user, const char *host)
+/* for K-lines loaded from a database, which were set some time ago */
+void
+kline_set_expiry(struct kline *k, time_t settime)
+{
+	return_if_fail(k != NULL);
+
+	k->settime = settime;
+	k->expires = k->settime + k->duration;
+
+	if (k->expiry_idx != 0)
+		expiry_queue_set(&kline_expiry, k, &k->expiry_idx, k->expires);
+}
+
+static struct kline *
+kline_find_in(mowgli_list_t *l, const char *user, const char *host)
 {
 	struct kline *k;
 	mowgli_node_t *n;
 
-	MOWGLI_ITER_FOREACH(n, klnlist.head)
+	if (l == NULL)
+		return NULL;
+
+	MOWGLI_ITER_FOREACH(n, l->head)
 	{
 		k = (struct kline *)n->data;
 
@@ -205,17 +391,53 @@ kline_find(const char *user, const char *host)
 	return NULL;
 }
 
+struct kline *
+kline_find(const char *user, const char *host)
+{
+	struct kline *k;
+	unsigned char addr[16];
+	unsigned int maxbits, bits;
+
+	if ((k = kline_find_in(kline_host_find(host), user, host)) != NULL)
+		return k;
+
+	if ((maxbits = cidr_parse_mask(host, addr, &bits)) != 0 &&
+			(k = kline_find_in(kline_radix_find(addr, maxbits, bits, false), user, host)) != NULL)
+		return k;
+
+	return kline_find_in(&kline_wildcards, user, host);
+}
+
 struct kline *
 kline_find_num(unsigned long number)
+{
+	char key[32];
+
+	kline_number_key(number, key, sizeof key);
+
+	return mowgli_patricia_retrieve(kline_numbers, key);
+}
+
+static inline bool
+kline_active(const struct kline *k)
+{
+	return k->duration == 0 || k->expires > CURRTIME;
+}
+
+static struct kline *
+kline_find_user_in(mowgli_list_t *l, struct user *u)
 {
 	struct kline *k;
 	mowgli_node_t *n;
 
-	MOWGLI_ITER_FOREACH(n, klnlist.head)
+	if (l == NULL)
+		return NULL;
+
+	MOWGLI_ITER_FOREACH(n, l->head)
 	{
 		k = (struct kline *)n->data;
 
-		if (k->number == number)
+		if (kline_active(k) && !match(k->user, u->user))
 			return k;
 	}
 
@@ -226,13 +448,36 @@ struct kline *
 kline_find_user(struct user *u)
 {
 	struct kline *k;
+	struct kline_radix *r;
 	mowgli_node_t *n;
+	unsigned char addr[16];
+	unsigned int maxbits, i;
+
+	/* literal hosts and addresses */
+	if ((k = kline_find_user_in(kline_host_find(u->host), u)) != NULL)
+		return k;
+	if ((k = kline_find_user_in(kline_host_find(u->ip), u)) != NULL)
+		return k;
+
+	/* every CIDR mask covering the address lies on the path to it */
+	if ((maxbits = cidr_parse_ip(u->ip, addr)) != 0)
+	{
+		r = *kline_radix_root(maxbits);
+		for (i = 0; r != NULL; i++)
+		{
+			if ((k = kline_find_user_in(&r->klines, u)) != NULL)
+				return k;
+			if (i == maxbits)
+				break;
+			r = r->child[kline_radix_bit(addr, i)];
+		}
+	}
 
-	MOWGLI_ITER_FOREACH(n, klnlist.head)
+	MOWGLI_ITER_FOREACH(n, kline_wildcards.head)
 	{
 		k = (struct kline *)n->data;
 
-		if (k->duration != 0 && k->expires <= CURRTIME)
+		if (!kline_active(k))
 			continue;
 		if (!match(k->user, u->user) && (!match(k->host, u->host) || !match(k->host, u->ip) || !match_ips(k->host, u->ip)))
 			return k;
@@ -246,28 +491,19 @@ kline_expire(void *arg)
 {
 	struct kline *k;
 	char *reason;
-	mowgli_node_t *n, *tn;
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, klnlist.head)
+	while ((k = expiry_queue_pop(&kline_expiry, CURRTIME)) != NULL)
 	{
-		k = (struct kline *)n->data;
+		/* TODO: determine validity of k->reason */
+		reason = k->reason ? k->reason : "(none)";
 
-		if (k->duration == 0)
-			continue;
-
-		if (k->expires <= CURRTIME)
-		{
-			/* TODO: determine validity of k->reason */
-			reason = k->reason ? k->reason : "(none)";
+		slog(LG_INFO, "KLINE:EXPIRE: \2%s@%s\2 set \2%s\2 ago by \2%s\2 (reason: %s)",
+			k->user, k->host, time_ago(k->settime), k->setby, reason);
 
-			slog(LG_INFO, "KLINE:EXPIRE: \2%s@%s\2 set \2%s\2 ago by \2%s\2 (reason: %s)",
-				k->user, k->host, time_ago(k->settime), k->setby, reason);
+		verbose_wallops("AKILL expired on \2%s@%s\2, set by \2%s\2 (reason: %s)",
+			k->user, k->host, k->setby, reason);
 
-			verbose_wallops("AKILL expired on \2%s@%s\2, set by \2%s\2 (reason: %s)",
-				k->user, k->host, k->setby, reason);
-
-			kline_delete(k);
-		}
+		kline_delete(k);
 	}
 }
 
@@ -296,6 +532,11 @@ xline_add(const char *realname, const char *reason, long duration, const char *s
 	x->expires = CURRTIME + duration;
 	x->number = ++xcnt;
 
+	if (x->duration != 0)
+		expiry_queue_set(&xline_expiry, x, &x->expiry_idx, x->expires);
+
+	db_record_changed(DB_RECORD_XLINE, x, NULL);
+
 	cnt.xline++;
 
 	if (me.connected)
@@ -304,20 +545,15 @@ xline_add(const char *realname, const char *reason, long duration, const char *s
 	return x;
 }
 
-void
-xline_delete(const char *realname)
+static void
+xline_delete_one(struct xline *x)
 {
-	struct xline *x = xline_find(realname);
 	mowgli_node_t *n;
 
-	if (!x)
-	{
-		slog(LG_DEBUG, "xline_delete(): called for nonexistent xline: %s", realname);
-		return;
-	}
-
 	slog(LG_DEBUG, "xline_delete(): %s -> %s", x->realname, x->reason);
 
+	db_record_deleted(DB_RECORD_XLINE, x);
+
 	/* only unxline if ircd has not already removed this -- jilles */
 	if (me.connected && (x->duration == 0 || x->expires > CURRTIME))
 		unxline_sts("*", x->realname);
@@ -325,6 +561,7 @@ xline_delete(const char *realname)
 	n = mowgli_node_find(x, &xlnlist);
 	mowgli_node_delete(n, &xlnlist);
 	mowgli_node_free(n);
+	expiry_queue_delete(&xline_expiry, &x->expiry_idx);
 
 	sfree(x->realname);
 	sfree(x->reason);
@@ -335,6 +572,33 @@ xline_delete(const char *realname)
 	cnt.xline--;
 }
 
+void
+xline_delete(const char *realname)
+{
+	struct xline *x = xline_find(realname);
+
+	if (!x)
+	{
+		slog(LG_DEBUG, "xline_delete(): called for nonexistent xline: %s", realname);
+		return;
+	}
+
+	xline_delete_one(x);
+}
+
+/* for X-lines loaded from a database, which were set some time ago */
+void
+xline_set_expiry(struct xline *x, time_t settime)
+{
+	return_if_fail(x != NULL);
+
+	x->settime = settime;
+	x->expires = x->settime + x->duration;
+
+	if (x->expiry_idx != 0)
+		expiry_queue_set(&xline_expiry, x, &x->expiry_idx, x->expires);
+}
+
 struct xline *
 xline_find(const char *realname)
 {
@@ -393,25 +657,16 @@ void
 xline_expire(void *arg)
 {
 	struct xline *x;
-	mowgli_node_t *n, *tn;
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, xlnlist.head)
+	while ((x = expiry_queue_pop(&xline_expiry, CURRTIME)) != NULL)
 	{
-		x = (struct xline *)n->data;
-
-		if (x->duration == 0)
-			continue;
-
-		if (x->expires <= CURRTIME)
-		{
-			slog(LG_INFO, "XLINE:EXPIRE: \2%s\2 set \2%s\2 ago by \2%s\2",
-				x->realname, time_ago(x->settime), x->setby);
+		slog(LG_INFO, "XLINE:EXPIRE: \2%s\2 set \2%s\2 ago by \2%s\2",
+			x->realname, time_ago(x->settime), x->setby);
 
-			verbose_wallops("XLINE expired on \2%s\2, set by \2%s\2",
-				x->realname, x->setby);
+		verbose_wallops("XLINE expired on \2%s\2, set by \2%s\2",
+			x->realname, x->setby);
 
-			xline_delete(x->realname);
-		}
+		xline_delete_one(x);
 	}
 }
 
@@ -439,6 +694,11 @@ qline_add(const char *mask, const char *reason, long duration, const char *setby
 	q->expires = CURRTIME + duration;
 	q->number = ++qcnt;
 
+	if (q->duration != 0)
+		expiry_queue_set(&qline_expiry, q, &q->expiry_idx, q->expires);
+
+	db_record_changed(DB_RECORD_QLINE, q, NULL);
+
 	cnt.qline++;
 
 	if (me.connected)
@@ -447,20 +707,15 @@ qline_add(const char *mask, const char *reason, long duration, const char *setby
 	return q;
 }
 
-void
-qline_delete(const char *mask)
+static void
+qline_delete_one(struct qline *q)
 {
-	struct qline *q = qline_find(mask);
 	mowgli_node_t *n;
 
-	if (!q)
-	{
-		slog(LG_DEBUG, "qline_delete(): called for nonexistent qline: %s", mask);
-		return;
-	}
-
 	slog(LG_DEBUG, "qline_delete(): %s -> %s", q->mask, q->reason);
 
+	db_record_deleted(DB_RECORD_QLINE, q);
+
 	/* only unqline if ircd has not already removed this -- jilles */
 	if (me.connected && (q->duration == 0 || q->expires > CURRTIME))
 		unqline_sts("*", q->mask);
@@ -468,6 +723,7 @@ qline_delete(const char *mask)
 	n = mowgli_node_find(q, &qlnlist);
 	mowgli_node_delete(n, &qlnlist);
 	mowgli_node_free(n);
+	expiry_queue_delete(&qline_expiry, &q->expiry_idx);
 
 	sfree(q->mask);
 	sfree(q->reason);
@@ -478,6 +734,33 @@ qline_delete(const char *mask)
 	cnt.qline--;
 }
 
+void
+qline_delete(const char *mask)
+{
+	struct qline *q = qline_find(mask);
+
+	if (!q)
+	{
+		slog(LG_DEBUG, "qline_delete(): called for nonexistent qline: %s", mask);
+		return;
+	}
+
+	qline_delete_one(q);
+}
+
+/* for Q-lines loaded from a database, which were set some time ago */
+void
+qline_set_expiry(struct qline *q, time_t settime)
+{
+	return_if_fail(q != NULL);
+
+	q->settime = settime;
+	q->expires = q->settime + q->duration;
+
+	if (q->expiry_idx != 0)
+		expiry_queue_set(&qline_expiry, q, &q->expiry_idx, q->expires);
+}
+
 struct qline *
 qline_find(const char *mask)
 {
@@ -575,25 +858,16 @@ void
 qline_expire(void *arg)
 {
 	struct qline *q;
-	mowgli_node_t *n, *tn;
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, qlnlist.head)
+	while ((q = expiry_queue_pop(&qline_expiry, CURRTIME)) != NULL)
 	{
-		q = (struct qline *)n->data;
+		slog(LG_INFO, "QLINE:EXPIRE: \2%s\2 set \2%s\2 ago by \2%s\2",
+			q->mask, time_ago(q->settime), q->setby);
 
-		if (q->duration == 0)
-			continue;
-
-		if (q->expires <= CURRTIME)
-		{
-			slog(LG_INFO, "QLINE:EXPIRE: \2%s\2 set \2%s\2 ago by \2%s\2",
-				q->mask, time_ago(q->settime), q->setby);
+		verbose_wallops("QLINE expired on \2%s\2, set by \2%s\2",
+			q->mask, q->setby);
 
-			verbose_wallops("QLINE expired on \2%s\2, set by \2%s\2",
-				q->mask, q->setby);
-
-			qline_delete(q->mask);
-		}
+		qline_delete_one(q);
 	}
 }
 
@@ -58,6 +58,7 @@ atheme_object_init(struct atheme_object *obj, const char *name, atheme_object_de
 
 	obj->destructor = des;
 	obj->refcount = 1;
+	obj->type = ATHEME_OBJECT_OTHER;
 
 #ifdef OBJECT_DEBUG
 	mowgli_node_add(obj, &obj->dnode, &object_list);
@@ -215,6 +216,17 @@ atheme_object_dispose(void *object)
 		mowgli_patricia_destroy(metadata, NULL, NULL);
 }
 
+static void
+metadata_free(struct atheme_object *obj, struct metadata *md)
+{
+	mowgli_patricia_delete(obj->metadata, md->name);
+
+	strshare_unref(md->name);
+	sfree(md->value);
+
+	mowgli_heap_free(metadata_heap, md);
+}
+
 struct metadata *
 metadata_add(void *target, const char *name, const char *value)
 {
@@ -228,8 +240,8 @@ metadata_add(void *target, const char *name, const char *value)
 
 	if (obj->metadata == NULL)
 		obj->metadata = mowgli_patricia_create(strcasecanon);
-	else if (metadata_find(target, name))
-		metadata_delete(target, name);
+	else if ((md = metadata_find(target, name)) != NULL)
+		metadata_free(obj, md);
 
 	md = mowgli_heap_alloc(metadata_heap);
 
@@ -238,6 +250,9 @@ metadata_add(void *target, const char *name, const char *value)
 
 	mowgli_patricia_add(obj->metadata, md->name, md);
 
+	if (obj->type != ATHEME_OBJECT_OTHER)
+		db_record_changed(DB_RECORD_METADATA, target, md->name);
+
 	return md;
 }
 
@@ -254,12 +269,10 @@ metadata_delete(void *target, const char *name)
 
 	return_if_fail(obj->metadata != NULL);
 
-	mowgli_patricia_delete(obj->metadata, name);
-
-	strshare_unref(md->name);
-	sfree(md->value);
+	if (obj->type != ATHEME_OBJECT_OTHER)
+		db_record_changed(DB_RECORD_METADATA, target, md->name);
 
-	mowgli_heap_free(metadata_heap, md);
+	metadata_free(obj, md);
 }
 
 struct metadata *
@@ -290,9 +303,10 @@ metadata_delete_all(void *target)
 	if (obj->metadata == NULL)
 		return;
 
+	// only called by destructors, which report the deletion of the whole object
 	MOWGLI_PATRICIA_FOREACH(md, &state, obj->metadata)
 	{
-		metadata_delete(obj, md->name);
+		metadata_free(obj, md);
 	}
 }
 
@@ -22,28 +22,68 @@ struct timeval burstime;
 
 static mowgli_eventloop_timer_t *ping_uplink_timer = NULL;
 
+/* The line the protocol module is parsing. It is tokenized in place, so
+ * parse_coreline() puts the separators back for logging.
+ */
+static const char *coreLine = NULL;
+static size_t coreLineLen = 0;
+
+void
+parse_set_coreline(const char *line, size_t len)
+{
+	coreLine = line;
+	coreLineLen = len;
+}
+
+const char *
+parse_coreline(void)
+{
+	static char buf[BUFSIZE];
+	size_t i, len;
+
+	if (coreLine == NULL)
+		return "";
+
+	len = coreLineLen < sizeof buf - 1 ? coreLineLen : sizeof buf - 1;
+	for (i = 0; i < len; i++)
+		buf[i] = coreLine[i] != '\0' ? coreLine[i] : ' ';
+	buf[len] = '\0';
+
+	return buf;
+}
+
 static void
 irc_recvq_handler(struct connection *cptr)
 {
 	bool wasnonl;
 	char parsebuf[BUFSIZE + 1];
-	int count;
+	char *line;
+	size_t count;
+	int ret;
 
 	wasnonl = CF_IS_NONEWLINE(cptr) ? true : false;
-	count = recvq_getline(cptr, parsebuf, sizeof parsebuf - 1);
-	if (count <= 0)
-		return;
+
+	/* parse the line where it sits in the recvq if we can */
+	line = recvq_getline_inplace(cptr, sizeof parsebuf - 1, &count);
+	if (line == NULL)
+	{
+		ret = recvq_getline(cptr, parsebuf, sizeof parsebuf - 1);
+		if (ret <= 0)
+			return;
+		line = parsebuf;
+		count = ret;
+	}
 	cnt.bin += count;
 	/* ignore the excessive part of a too long line */
 	if (wasnonl)
 		return;
 	me.uplinkpong = CURRTIME;
-	if (parsebuf[count - 1] == '\n')
+	if (line[count - 1] == '\n')
 		count--;
-	if (count > 0 && parsebuf[count - 1] == '\r')
+	if (count > 0 && line[count - 1] == '\r')
 		count--;
-	parsebuf[count] = '\0';
-	parse(parsebuf);
+	line[count] = '\0';
+	parse(line);
 }
 
 static void
@@ -81,6 +121,7 @@ irc_handle_connect(struct connection *cptr)
 	{
 		cptr->flags = CF_UPLINK;
 		cptr->recvq_handler = irc_recvq_handler;
+		recvq_set_budget(cptr, config_options.uplink_recvq_budget);
 		connection_setselect_read(cptr, recvq_put);
 		slog(LG_INFO, "irc_handle_connect(): connection to uplink established");
 		me.connected = true;
@@ -25,6 +25,7 @@ void (*kick) (struct user *source, struct channel *c, struct user *u, const char
 void (*msg) (const char *from, const char *target, const char *fmt, ...) = generic_msg;
 void (*msg_global_sts) (struct user *from, const char *mask, const char *text) = generic_msg_global_sts;
 void (*notice_user_sts) (struct user *from, struct user *target, const char *text) = generic_notice_user_sts;
+size_t (*notice_user_prefix) (struct user *from, struct user *target, char *buf, size_t len) = generic_notice_user_prefix;
 void (*notice_global_sts) (struct user *from, const char *mask, const char *text) = generic_notice_global_sts;
 void (*notice_channel_sts) (struct user *from, struct channel *target, const char *text) = generic_notice_channel_sts;
 void (*wallchops) (struct user *source, struct channel *target, const char *message) = generic_wallchops;
@@ -52,6 +53,7 @@ void (*svslogin_sts) (const char *target, const char *nick, const char *user, co
 void (*sasl_sts) (const char *target, char mode, const char *data) = generic_sasl_sts;
 void (*sasl_mechlist_sts) (const char *mechlist) = generic_sasl_mechlist_sts;
 bool (*mask_matches_user)(const char *mask, struct user *u) = generic_mask_matches_user;
+void (*chanban_compile)(struct chanban *cb) = generic_chanban_compile;
 mowgli_node_t *(*next_matching_ban)(struct channel *c, struct user *u, int type, mowgli_node_t *first) = generic_next_matching_ban;
 mowgli_node_t *(*next_matching_host_chanacs)(struct mychan *mc, struct user *u, mowgli_node_t *first) = generic_next_matching_host_chanacs;
 bool (*is_valid_nick)(const char *nick) = generic_is_valid_nick;
@@ -146,6 +148,12 @@ generic_notice_user_sts(struct user *from, struct user *target, const char *text
 	slog(LG_INFO, "Cannot send notice to %s (%s): don't know how. Load a protocol module perhaps?", target->nick, text);
 }
 
+size_t
+generic_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return 0;
+}
+
 void
 generic_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -336,29 +344,66 @@ generic_sasl_mechlist_sts(const char *mechlist)
 	/* nothing to do here. */
 }
 
-bool
-generic_mask_matches_user(const char *mask, struct user *u)
+/* The forms of a user's nick!user@host that masks are matched against. The
+ * last two are only considered if masks may look through a vhost.
+ */
+struct user_mask_forms
 {
-	char hostbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char cloakbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char realbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char ipbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-
-	snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
-	snprintf(cloakbuf, sizeof cloakbuf, "%s!%s@%s", u->nick, u->user, u->chost);
+	char    host[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
+	char    cloak[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
+	char    real[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
+	char    ip[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
+	bool    through_vhost;
+};
 
-	bool result = !match(mask, hostbuf) || !match(mask, cloakbuf);
+static void
+user_mask_forms_build(struct user_mask_forms *const f, const struct user *const u)
+{
+	snprintf(f->host, sizeof f->host, "%s!%s@%s", u->nick, u->user, u->vhost);
+	snprintf(f->cloak, sizeof f->cloak, "%s!%s@%s", u->nick, u->user, u->chost);
 
-	// return if configured not to check further, or if we already have a match
-	if ((!config_options.masks_through_vhost && u->host != u->vhost) || result)
-		return result;
+	f->through_vhost = config_options.masks_through_vhost || u->host == u->vhost;
+	if (!f->through_vhost)
+		return;
 
-	snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
+	snprintf(f->real, sizeof f->real, "%s!%s@%s", u->nick, u->user, u->host);
 	/* will be nick!user@ if ip unknown, doesn't matter */
-	snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
+	snprintf(f->ip, sizeof f->ip, "%s!%s@%s", u->nick, u->user, u->ip);
+}
 
-	return !match(mask, realbuf) || !match(mask, ipbuf) || (ircd->flags & IRCD_CIDR_BANS && !match_cidr(mask, ipbuf));
+// match_type is chanban_match_type(mask)
+static bool
+user_mask_forms_match(const struct user_mask_forms *const f, const char *const mask, const unsigned int match_type)
+{
+	if (match_type == CBAN_MATCH_LITERAL)
+		return !irccasecmp(mask, f->host) || !irccasecmp(mask, f->cloak) ||
+			(f->through_vhost && (!irccasecmp(mask, f->real) || !irccasecmp(mask, f->ip)));
 
+	if (!match(mask, f->host) || !match(mask, f->cloak))
+		return true;
+
+	if (!f->through_vhost)
+		return false;
+
+	return !match(mask, f->real) || !match(mask, f->ip) ||
+		(match_type == CBAN_MATCH_CIDR && ircd->flags & IRCD_CIDR_BANS && !match_cidr(mask, f->ip));
+}
+
+bool
+generic_mask_matches_user(const char *mask, struct user *u)
+{
+	struct user_mask_forms forms;
+
+	user_mask_forms_build(&forms, u);
+
+	return user_mask_forms_match(&forms, mask, chanban_match_type(mask));
+}
+
+void
+generic_chanban_compile(struct chanban *cb)
+{
+	cb->match_mask = cb->mask;
+	cb->match_type = chanban_match_type(cb->mask);
 }
 
 mowgli_node_t *
@@ -380,6 +425,13 @@ mowgli_node_t *
 generic_next_matching_host_chanacs(struct mychan *mc, struct user *u, mowgli_node_t *first)
 {
 	mowgli_node_t *n;
+	struct user_mask_forms forms;
+
+	if (first == NULL)
+		return NULL;
+
+	// format the user's masks once for the whole walk, not once per entry
+	user_mask_forms_build(&forms, u);
 
 	MOWGLI_ITER_FOREACH(n, first)
 	{
@@ -387,7 +439,12 @@ generic_next_matching_host_chanacs(struct mychan *mc, struct user *u, mowgli_nod
 
 		if (ca->entity != NULL)
 		       continue;
-		if (mask_matches_user(ca->host, u))
+		if (mask_matches_user != &generic_mask_matches_user)
+		{
+			if (mask_matches_user(ca->host, u))
+				return n;
+		}
+		else if (user_mask_forms_match(&forms, ca->host, ca->match_type))
 			return n;
 	}
 	return NULL;
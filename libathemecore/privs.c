@@ -198,6 +198,7 @@ soper_add(const char *name, const char *classname, int flags, const char *passwo
 	soper->password = sstrdup(password);
 
 	cnt.soper++;
+	db_mark_dirty();
 
 	return soper;
 }
@@ -230,6 +231,7 @@ soper_delete(struct soper *soper)
 	mowgli_heap_free(soper_heap, soper);
 
 	cnt.soper--;
+	db_mark_dirty();
 }
 
 struct soper *
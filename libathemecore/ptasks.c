@@ -116,6 +116,8 @@ handle_stats(struct user *u, char req)
 	mowgli_node_t *n;
 	struct uplink *uplink;
 	struct soper *soper;
+	const struct strshare_stats *ss;
+	const struct authpool_stats *as;
 	int j;
 	char fl[10];
 
@@ -271,6 +273,23 @@ handle_stats(struct user *u, char req)
 		  numeric_sts(me.me, 249, u, "T :myuser_acc %7u", cnt.myuser_access);
 		  numeric_sts(me.me, 249, u, "T :myuser_nam %7u", cnt.myuser_name);
 		  numeric_sts(me.me, 249, u, "T :chanacs    %7u", cnt.chanacs);
+		  numeric_sts(me.me, 249, u, "T :db_changes %7u", db_changes);
+
+		  ss = strshare_get_stats();
+		  numeric_sts(me.me, 249, u, "T :strshare   %7zu", ss->strings);
+		  numeric_sts(me.me, 249, u, "T :strsh_refs %7zu (%.2f per string)", ss->refs,
+				  ss->strings ? (double) ss->refs / (double) ss->strings : 0.0);
+		  numeric_sts(me.me, 249, u, "T :strsh_save %7.2f%s", (double) bytes(ss->ref_bytes - ss->bytes),
+				  sbytes(ss->ref_bytes - ss->bytes));
+
+		  as = authpool_get_stats();
+		  numeric_sts(me.me, 249, u, "T :auth_thrd  %7u", as->threads);
+		  numeric_sts(me.me, 249, u, "T :auth_queue %7u (peak %u)", as->queued, as->queued_peak);
+		  numeric_sts(me.me, 249, u, "T :auth_done  %7lu (%lu refused)", as->completed, as->rejected);
+		  numeric_sts(me.me, 249, u, "T :auth_lat   %7.2f ms (max %.2f ms)",
+				  as->completed ? (double) as->latency_total / (double) as->completed / 1e6 : 0.0,
+				  (double) as->latency_max / 1e6);
+		  numeric_sts(me.me, 249, u, "T :burst_time %7u ms", me.burst_time);
 
 #ifdef OBJECT_DEBUG
 		  numeric_sts(me.me, 249, u, "T :objects    %7zu", MOWGLI_LIST_LENGTH(&object_list));
@@ -875,6 +894,49 @@ handle_eob(struct server *s)
 	}
 }
 
+/* Called by protocol modules from server_login() instead of setting
+ * me.bursting themselves, if they call handle_burst_end() when the uplink
+ * has finished bursting. Until then, channel services may defer acting on
+ * the users and channels that the burst introduces.
+ */
+void
+handle_burst_begin(void)
+{
+	me.bursting = true;
+	me.burst_defer = true;
+}
+
+/* Called by protocol modules when the uplink has finished bursting. */
+void
+handle_burst_end(void)
+{
+	if (!me.bursting)
+		return;
+
+	/* Still bursting as far as the deferred work is concerned, so that
+	 * it sees the same state it would have if it had not been deferred.
+	 */
+	if (me.burst_defer)
+	{
+		hook_call_burst_end();
+		me.burst_defer = false;
+	}
+
+#ifdef HAVE_GETTIMEOFDAY
+	e_time(burstime, &burstime);
+	me.burst_time = tv2ms(&burstime);
+
+	slog(LG_INFO, "handle_burst_end(): finished synching with uplink (%u %s)", (me.burst_time > 1000) ? (me.burst_time / 1000) : me.burst_time, (me.burst_time > 1000) ? "s" : "ms");
+
+	wallops("Finished synchronizing with network in %u %s.", (me.burst_time > 1000) ? (me.burst_time / 1000) : me.burst_time, (me.burst_time > 1000) ? "s" : "ms");
+#else
+	slog(LG_INFO, "handle_burst_end(): finished synching with uplink");
+	wallops("Finished synchronizing with network.");
+#endif
+
+	me.bursting = false;
+}
+
 /* Received a message from a user, check if they are flooding
  * Returns true if the message should be ignored.
  * u - user sending the message
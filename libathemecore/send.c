@@ -66,6 +66,141 @@ send_line(const char *line)
 	return 0;
 }
 
+/* send a line made of a prefix and a text to the server, as send_line()
+ * would send the two concatenated, without copying them together first;
+ * the prefix may not start with message tags */
+int
+send_prefixed_line(const char *prefix, size_t prefixlen, const char *text, size_t textlen)
+{
+	if (!me.connected)
+		return 0;
+
+	return_val_if_fail(curr_uplink != NULL, 0);
+	return_val_if_fail(curr_uplink->conn != NULL, 0);
+	return_val_if_fail(prefix != NULL, 0);
+	return_val_if_fail(text != NULL, 0);
+	return_val_if_fail(prefixlen <= 510, 0);
+
+	// same limit as send_line(): 510 bytes, then the \r\n
+	if (textlen > 510 - prefixlen)
+		textlen = 510 - prefixlen;
+
+	cnt.bout += prefixlen + textlen + 2;
+
+	sendq_add_line(curr_uplink->conn, prefix, prefixlen, text, textlen);
+
+	slog(LG_RAWDATA, "<- %.*s%.*s\r\n", (int) prefixlen, prefix, (int) textlen, text);
+
+	return 0;
+}
+
+/* the prefixes of the notices we last sent, see notice_user_lines();
+ * an entry is only reused for the same pair of users while they still
+ * have the names (CLIENT_NAME) it was made with, so it does not matter
+ * if a user went away and its struct user was reused since */
+#define NOTICE_PREFIX_CACHE 8U
+
+struct notice_prefix
+{
+	size_t          (*fn)(struct user *, struct user *, char *, size_t);
+	const struct user *from;
+	const struct user *target;
+	char            from_name[NICKLEN + 1];
+	char            target_name[NICKLEN + 1];
+	size_t          len;
+	char            buf[BUFSIZE];
+};
+
+static struct notice_prefix notice_prefix_cache[NOTICE_PREFIX_CACHE];
+
+static const struct notice_prefix *
+notice_prefix_get(struct user *from, struct user *target)
+{
+	const char *const from_name = (from != NULL) ? CLIENT_NAME(from) : "";
+	const char *const target_name = CLIENT_NAME(target);
+	const uintptr_t key = ((uintptr_t) from ^ (uintptr_t) target) >> 4;
+	struct notice_prefix *const np = &notice_prefix_cache[key % NOTICE_PREFIX_CACHE];
+	size_t len;
+
+	if (np->len != 0 && np->fn == notice_user_prefix && np->from == from && np->target == target &&
+	    strcmp(np->from_name, from_name) == 0 && strcmp(np->target_name, target_name) == 0)
+		return np;
+
+	np->len = 0;
+
+	if (strlen(from_name) >= sizeof np->from_name || strlen(target_name) >= sizeof np->target_name)
+		return NULL;
+
+	// 0 if the protocol module does not build notices this way
+	len = notice_user_prefix(from, target, np->buf, sizeof np->buf);
+	if (len == 0 || len >= sizeof np->buf || len > 510)
+		return NULL;
+
+	np->fn = notice_user_prefix;
+	np->from = from;
+	np->target = target;
+	(void) mowgli_strlcpy(np->from_name, from_name, sizeof np->from_name);
+	(void) mowgli_strlcpy(np->target_name, target_name, sizeof np->target_name);
+	np->len = len;
+
+	return np;
+}
+
+/*
+ * notice_user_lines()
+ *
+ * Sends a notice to a user for each line of a text, as notice_user_sts()
+ * would. The protocol module formats the beginning of the lines (with
+ * notice_user_prefix()) only once for a given source and target, and the
+ * lines are then written to the uplink's sendq as they are.
+ *
+ * Inputs:
+ *       - the source, as for notice_user_sts()
+ *       - the user to send the notices to
+ *       - the text, with lines separated by \n; empty lines are sent as a
+ *         single space, and a final \n is ignored
+ *
+ * Outputs:
+ *       - nothing
+ */
+void
+notice_user_lines(struct user *from, struct user *target, const char *text)
+{
+	const struct notice_prefix *np;
+	const char *end;
+	const char *line;
+	size_t len;
+	char buf[BUFSIZE];
+
+	return_if_fail(target != NULL);
+	return_if_fail(text != NULL);
+
+	np = notice_prefix_get(from, target);
+
+	do
+	{
+		end = strchr(text, '\n');
+		len = (end != NULL) ? (size_t) (end - text) : strlen(text);
+		line = text;
+
+		if (len == 0)
+		{
+			line = " ";
+			len = 1;
+		}
+
+		if (np != NULL)
+			(void) send_prefixed_line(np->buf, np->len, line, len);
+		else
+		{
+			(void) mowgli_strlcpy(buf, line, (len < sizeof buf) ? len + 1 : sizeof buf);
+			notice_user_sts(from, target, buf);
+		}
+
+		text = (end != NULL && end[1] != '\0') ? end + 1 : NULL;
+	} while (text != NULL);
+}
+
 /*
  * io_loop()
  *
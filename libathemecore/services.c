@@ -753,9 +753,13 @@ myuser_login(struct service *svs, struct user *u, struct myuser *mu, bool sendac
 		notice(svs->me->nick, u->nick, "Warning: Your password is not encrypted.");
 
 	mu->lastlogin = CURRTIME;
+	db_record_touched(DB_RECORD_MYUSER, mu);
 	mn = mynick_find(u->nick);
 	if (mn != NULL && mn->owner == mu)
+	{
 		mn->lastseen = CURRTIME;
+		db_record_touched(DB_RECORD_MYNICK, mn);
+	}
 
 	/* XXX: ircd_on_login supports hostmasking, we just dont have it yet. */
 	/* don't allow them to join regonly chans until their
@@ -955,7 +959,7 @@ command_fail(struct sourceinfo *si, enum cmd_faultcode code, const char *fmt, ..
 	if (use_privmsg && si->smu != NULL && si->smu->flags & MU_USE_PRIVMSG)
 		msg(si->service->nick, si->su->nick, "%s", buf);
 	else
-		notice_user_sts(si->service->me, si->su, buf);
+		notice_user_lines(si->service->me, si->su, buf);
 }
 
 void ATHEME_FATTR_PRINTF(2, 3)
@@ -988,6 +992,12 @@ command_success_nodata(struct sourceinfo *si, const char *fmt, ...)
 		return;
 	}
 
+	if (!(use_privmsg && si->smu != NULL && si->smu->flags & MU_USE_PRIVMSG))
+	{
+		notice_user_lines(si->service->me, si->su, buf);
+		return;
+	}
+
 	p = buf;
 	do
 	{
@@ -996,14 +1006,11 @@ command_success_nodata(struct sourceinfo *si, const char *fmt, ...)
 		{
 			*q++ = '\0';
 			if (*q == '\0')
-				return; /* ending with \n */
+				q = NULL; /* ending with \n */
 		}
 		if (*p == '\0')
 			p = space; /* replace empty lines with a space */
-		if (use_privmsg && si->smu != NULL && si->smu->flags & MU_USE_PRIVMSG)
-			msg(si->service->nick, si->su->nick, "%s", p);
-		else
-			notice_user_sts(si->service->me, si->su, p);
+		msg(si->service->nick, si->su->nick, "%s", p);
 		p = q;
 	} while (p != NULL);
 }
@@ -1029,7 +1036,7 @@ command_success_string(struct sourceinfo *si, const char *result, const char *fm
 	if (use_privmsg && si->smu != NULL && si->smu->flags & MU_USE_PRIVMSG)
 		msg(si->service->nick, si->su->nick, "%s", buf);
 	else
-		notice_user_sts(si->service->me, si->su, buf);
+		notice_user_lines(si->service->me, si->su, buf);
 }
 
 static void
@@ -483,6 +483,7 @@ servtree_update(void *dummy)
 			sptr->me->vhost = strshare_ref(sptr->me->host);
 			strshare_unref(sptr->me->gecos);
 			sptr->me->gecos = strshare_get(sptr->real);
+			CHANBAN_EPOCH_BUMP(sptr->me->ban_epoch);
 			if (me.connected)
 				reintroduce_user(sptr->me);
 		}
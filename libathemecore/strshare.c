@@ -16,38 +16,214 @@
 #include <atheme.h>
 #include "internal.h"
 
-static mowgli_patricia_t *strshare_dict = NULL;
-
+/* Each shared string is stored once, after a header, in a slab of its size
+ * class (or with smalloc() if it is long); the stringref handed out is the
+ * string itself.  The strings are found through an open-addressed table of
+ * header pointers, keyed by a hash that is kept in the header so that
+ * neither growing the table nor dropping the last reference hashes the
+ * string again.
+ *
+ * Most of these strings come from the network (hostnames, gecos, ...), so
+ * the hash is SipHash-2-4 under a key picked at random on startup; nobody
+ * can choose strings that all land in one run of the table.
+ */
 struct strshare
 {
-	int refcount;
+	unsigned int            refcount;
+	unsigned int            hash;
+	unsigned int            len;
 };
 
+#define STRSHARE_CLASS_SIZE     16U
+#define STRSHARE_CLASSES        8U
+#define STRSHARE_TABLE_MIN      1024U
+
+static mowgli_heap_t *strshare_heaps[STRSHARE_CLASSES];
+static struct strshare **strshare_table = NULL;
+static size_t strshare_table_size = 0;
+static struct strshare_stats strshare_stats;
+static uint64_t strshare_key[2];
+
+#define STRSHARE_ROTL(x, b)     (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define STRSHARE_SIPROUND(v0, v1, v2, v3)                                                           \
+    do {                                                                                            \
+        (v0) += (v1); (v1) = STRSHARE_ROTL((v1), 13); (v1) ^= (v0); (v0) = STRSHARE_ROTL((v0), 32); \
+        (v2) += (v3); (v3) = STRSHARE_ROTL((v3), 16); (v3) ^= (v2);                                 \
+        (v0) += (v3); (v3) = STRSHARE_ROTL((v3), 21); (v3) ^= (v0);                                 \
+        (v2) += (v1); (v1) = STRSHARE_ROTL((v1), 17); (v1) ^= (v2); (v2) = STRSHARE_ROTL((v2), 32); \
+    } while (0)
+
+static inline uint64_t
+strshare_load64(const unsigned char *const restrict p, const size_t len)
+{
+	uint64_t word = 0;
+
+	for (size_t i = 0; i < len; i++)
+		word |= ((uint64_t) p[i]) << (8U * i);
+
+	return word;
+}
+
+// SipHash-2-4 of the string under strshare_key, folded to the width of the header's hash
+static inline unsigned int
+strshare_hash(const char *const restrict str, size_t *const restrict len)
+{
+	const unsigned char *p = (const unsigned char *) str;
+	const size_t slen = strlen(str);
+	const unsigned char *const end = p + (slen & ~((size_t) 7U));
+
+	uint64_t v0 = strshare_key[0] ^ UINT64_C(0x736F6D6570736575);
+	uint64_t v1 = strshare_key[1] ^ UINT64_C(0x646F72616E646F6D);
+	uint64_t v2 = strshare_key[0] ^ UINT64_C(0x6C7967656E657261);
+	uint64_t v3 = strshare_key[1] ^ UINT64_C(0x7465646279746573);
+	uint64_t m;
+
+	for (; p != end; p += 8)
+	{
+		m = strshare_load64(p, 8);
+
+		v3 ^= m;
+		STRSHARE_SIPROUND(v0, v1, v2, v3);
+		STRSHARE_SIPROUND(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	m = strshare_load64(p, slen & 7U) | (((uint64_t) slen) << 56);
+
+	v3 ^= m;
+	STRSHARE_SIPROUND(v0, v1, v2, v3);
+	STRSHARE_SIPROUND(v0, v1, v2, v3);
+	v0 ^= m;
+
+	v2 ^= 0xFFU;
+
+	for (size_t i = 0; i < 4; i++)
+		STRSHARE_SIPROUND(v0, v1, v2, v3);
+
+	const uint64_t hash = v0 ^ v1 ^ v2 ^ v3;
+
+	*len = slen;
+
+	return (unsigned int) (hash ^ (hash >> 32));
+}
+
+// The slab a string of this length lives in, or STRSHARE_CLASSES if it is too long for one
+static inline size_t
+strshare_class(const size_t len)
+{
+	return (sizeof(struct strshare) + len) / STRSHARE_CLASS_SIZE;
+}
+
+static void
+strshare_table_insert(struct strshare *const restrict ss)
+{
+	const size_t mask = strshare_table_size - 1;
+	size_t i;
+
+	for (i = ss->hash & mask; strshare_table[i] != NULL; i = (i + 1) & mask)
+		;
+
+	strshare_table[i] = ss;
+}
+
+static void
+strshare_table_grow(void)
+{
+	struct strshare **const old = strshare_table;
+	const size_t old_size = strshare_table_size;
+
+	strshare_table_size = old_size * 2;
+	strshare_table = scalloc(strshare_table_size, sizeof *strshare_table);
+
+	for (size_t i = 0; i < old_size; i++)
+		if (old[i] != NULL)
+			strshare_table_insert(old[i]);
+
+	sfree(old);
+}
+
+// Linear probing without tombstones: pull later entries of the run back into the hole
+static void
+strshare_table_delete(const struct strshare *const restrict ss)
+{
+	const size_t mask = strshare_table_size - 1;
+	size_t hole, i;
+
+	for (hole = ss->hash & mask; strshare_table[hole] != ss; hole = (hole + 1) & mask)
+		;
+
+	for (i = (hole + 1) & mask; strshare_table[i] != NULL; i = (i + 1) & mask)
+	{
+		const size_t home = strshare_table[i]->hash & mask;
+
+		// can the entry at i move back to the hole without passing its home slot?
+		if (((i - home) & mask) >= ((i - hole) & mask))
+		{
+			strshare_table[hole] = strshare_table[i];
+			hole = i;
+		}
+	}
+
+	strshare_table[hole] = NULL;
+}
+
 void
 strshare_init(void)
 {
-	strshare_dict = mowgli_patricia_create(noopcanon);
+	(void) atheme_random_buf(strshare_key, sizeof strshare_key);
+
+	for (size_t i = 0; i < STRSHARE_CLASSES; i++)
+		strshare_heaps[i] = sharedheap_get((i + 1) * STRSHARE_CLASS_SIZE);
+
+	strshare_table_size = STRSHARE_TABLE_MIN;
+	strshare_table = scalloc(strshare_table_size, sizeof *strshare_table);
 }
 
 stringref
 strshare_get(const char *str)
 {
 	struct strshare *ss;
+	size_t len, i, class;
+	unsigned int hash;
 
 	if (str == NULL)
 		return NULL;
 
-	ss = mowgli_patricia_retrieve(strshare_dict, str);
-	if (ss != NULL)
-		ss->refcount++;
-	else
+	hash = strshare_hash(str, &len);
+
+	for (i = hash & (strshare_table_size - 1); (ss = strshare_table[i]) != NULL; i = (i + 1) & (strshare_table_size - 1))
 	{
-		ss = smalloc((sizeof *ss) + strlen(str) + 1);
-		ss->refcount = 1;
-		strcpy((char *)(ss + 1), str);
-		mowgli_patricia_add(strshare_dict, (char *)(ss + 1), ss);
+		if (ss->hash == hash && ss->len == len && memcmp(ss + 1, str, len) == 0)
+		{
+			ss->refcount++;
+			strshare_stats.refs++;
+			strshare_stats.ref_bytes += len + 1;
+
+			return (char *)(ss + 1);
+		}
 	}
 
+	if ((class = strshare_class(len)) < STRSHARE_CLASSES && strshare_heaps[class] != NULL)
+		ss = mowgli_heap_alloc(strshare_heaps[class]);
+	else
+		ss = smalloc((sizeof *ss) + len + 1);
+
+	ss->refcount = 1;
+	ss->hash = hash;
+	ss->len = len;
+	memcpy(ss + 1, str, len + 1);
+
+	strshare_stats.strings++;
+	strshare_stats.refs++;
+	strshare_stats.bytes += len + 1;
+	strshare_stats.ref_bytes += len + 1;
+
+	if (strshare_stats.strings >= strshare_table_size / 2)
+		strshare_table_grow();
+
+	strshare_table_insert(ss);
+
 	return (char *)(ss + 1);
 }
 
@@ -63,6 +239,9 @@ strshare_ref(stringref str)
 	ss = (struct strshare *)(uintptr_t)str - 1;
 	ss->refcount++;
 
+	strshare_stats.refs++;
+	strshare_stats.ref_bytes += ss->len + 1;
+
 	return str;
 }
 
@@ -70,6 +249,7 @@ void
 strshare_unref(stringref str)
 {
 	struct strshare *ss;
+	size_t class;
 
 	if (str == NULL)
 		return;
@@ -77,13 +257,30 @@ strshare_unref(stringref str)
 	/* intermediate cast to suppress gcc -Wcast-qual */
 	ss = (struct strshare *)(uintptr_t)str - 1;
 	ss->refcount--;
+
+	strshare_stats.refs--;
+	strshare_stats.ref_bytes -= ss->len + 1;
+
 	if (ss->refcount == 0)
 	{
-		mowgli_patricia_delete(strshare_dict, str);
-		sfree(ss);
+		strshare_table_delete(ss);
+
+		strshare_stats.strings--;
+		strshare_stats.bytes -= ss->len + 1;
+
+		if ((class = strshare_class(ss->len)) < STRSHARE_CLASSES && strshare_heaps[class] != NULL)
+			mowgli_heap_free(strshare_heaps[class], ss);
+		else
+			sfree(ss);
 	}
 }
 
+const struct strshare_stats *
+strshare_get_stats(void)
+{
+	return &strshare_stats;
+}
+
 /* vim:cinoptions=>s,e0,n0,f0,{0,}0,^0,=s,ps,t0,c3,+s,(2s,us,)20,*30,gs,hs
  * vim:ts=8
  * vim:sw=8
@@ -49,6 +49,7 @@ svsignore_add(const char *mask, const char *reason)
         mowgli_node_add(svsignore, n, &svs_ignore_list);
 
         cnt.svsignore++;
+        db_mark_dirty();
         return svsignore;
 }
 
@@ -122,6 +123,8 @@ svsignore_delete(struct svsignore *svsignore)
 	sfree(svsignore->setby);
 	sfree(svsignore->reason);
 	sfree(svsignore);
+
+	db_mark_dirty();
 }
 
 /* vim:cinoptions=>s,e0,n0,f0,{0,}0,^0,=s,ps,t0,c3,+s,(2s,us,)20,*30,gs,hs
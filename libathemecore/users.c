@@ -263,9 +263,13 @@ user_delete(struct user *u, const char *comment)
 			}
 		}
 		u->myuser->lastlogin = CURRTIME;
+		db_record_touched(DB_RECORD_MYUSER, u->myuser);
 		if ((mn = mynick_find(u->nick)) != NULL &&
 				mn->owner == u->myuser)
+		{
 			mn->lastseen = CURRTIME;
+			db_record_touched(DB_RECORD_MYNICK, mn);
+		}
 		u->myuser = NULL;
 	}
 
@@ -492,11 +496,15 @@ user_changenick(struct user *u, const char *nick, time_t ts)
 	}
 	if (u->myuser != NULL && (mn = mynick_find(u->nick)) != NULL &&
 			mn->owner == u->myuser)
+	{
 		mn->lastseen = CURRTIME;
+		db_record_touched(DB_RECORD_MYNICK, mn);
+	}
 	mowgli_patricia_delete(userlist, u->nick);
 
 	strshare_unref(u->nick);
 	u->nick = strshare_get(nick);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	u->ts = ts;
 
@@ -622,6 +630,7 @@ user_sethost(struct user *source, struct user *target, stringref host)
 
 	strshare_unref(target->vhost);
 	target->vhost = strshare_get(host);
+	CHANBAN_EPOCH_BUMP(target->ban_epoch);
 
 	sethost_sts(source, target, target->vhost);
 	hook_call_user_sethost(target);
@@ -645,6 +654,57 @@ user_get_umodestr(struct user *u)
 	return result;
 }
 
+/*
+ * chanuser_is_banned(struct chanuser *cu, const char ban_type)
+ *
+ * Checks whether a channel member matches a ban of the given type and no
+ * exception. The result is cached on the membership until the user's
+ * identity or the channel's ban list changes (see chanban_epoch). Channels
+ * with extbans are never cached, as those depend on more than the user's
+ * nick!user@host.
+ */
+static bool
+chanuser_is_banned(struct chanuser *const restrict cu, const char ban_type)
+{
+	struct channel *const c = cu->chan;
+	struct user *const u = cu->user;
+	unsigned char bit = 0;
+	bool banned;
+
+	if (ban_type == 'b')
+		bit = CU_BANCACHE_BAN;
+	else if (ban_type == 'q')
+		bit = CU_BANCACHE_QUIET;
+
+	if (c->numextbans != 0)
+		bit = 0;
+
+	if (bit != 0)
+	{
+		if (cu->ban_stamp < u->ban_epoch || cu->ban_stamp < c->ban_epoch || cu->ban_stamp < chanban_epoch_all)
+		{
+			cu->ban_cached = 0;
+			cu->ban_stamp = chanban_epoch;
+		}
+		else if (cu->ban_cached & bit)
+			return (cu->ban_matched & bit) != 0;
+	}
+
+	banned = next_matching_ban(c, u, ban_type, c->bans.head) != NULL &&
+		(ircd->except_mchar == '\0' || next_matching_ban(c, u, ircd->except_mchar, c->bans.head) == NULL);
+
+	if (bit != 0)
+	{
+		cu->ban_cached |= bit;
+		if (banned)
+			cu->ban_matched |= bit;
+		else
+			cu->ban_matched &= ~bit;
+	}
+
+	return banned;
+}
+
 struct chanuser *
 find_user_banned_channel(struct user *const restrict u, const char ban_type)
 {
@@ -661,13 +721,8 @@ find_user_banned_channel(struct user *const restrict u, const char ban_type)
 		if (cu->modes != 0)
 			continue;
 
-		if (next_matching_ban(cu->chan, u, ban_type, cu->chan->bans.head) != NULL)
-		{
-			if (ircd->except_mchar == '\0' || next_matching_ban(cu->chan, u, ircd->except_mchar, cu->chan->bans.head) == NULL)
-				return cu;
-			else
-				continue;
-		}
+		if (chanuser_is_banned(cu, ban_type))
+			return cu;
 	}
 
 	return NULL;
@@ -99,6 +99,8 @@ AC_DEFUN([ATHEME_CHECK_BUILD_REQUIREMENTS], [
     AC_CHECK_FUNCS([timingsafe_memcmp], [], [])
     AC_CHECK_FUNCS([vsnprintf], [], [ATHEME_REQUIRED_FUNC_MISSING])
 
+    AC_FUNC_STRERROR_R
+
     AC_C_BIGENDIAN
     AC_C_CONST
     AC_C_INLINE
@@ -0,0 +1,62 @@
+# SPDX-License-Identifier: ISC
+# SPDX-URL: https://spdx.org/licenses/ISC.html
+#
+# Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+#
+# -*- Atheme IRC Services -*-
+# Atheme Build System Component
+
+AC_DEFUN([ATHEME_LIBTEST_PTHREAD], [
+
+    LIBS_SAVED="${LIBS}"
+
+    LIBPTHREAD_LIBS=""
+    LIBPTHREAD_USABLE="No"
+
+    AC_CHECK_HEADERS([pthread.h], [
+
+        AC_SEARCH_LIBS([pthread_create], [pthread], [
+            AS_IF([test "x${ac_cv_search_pthread_create}" != "xnone required"], [
+                LIBPTHREAD_LIBS="${ac_cv_search_pthread_create}"
+            ])
+            LIBPTHREAD_USABLE="Yes"
+        ], [])
+    ], [], [])
+
+    AS_IF([test "${LIBPTHREAD_USABLE}" = "Yes"], [
+
+        LIBS="${LIBPTHREAD_LIBS} ${LIBS_SAVED}"
+
+        AC_MSG_CHECKING([if POSIX threads are usable])
+        AC_LINK_IFELSE([
+            AC_LANG_PROGRAM([[
+                #include <stddef.h>
+                #include <pthread.h>
+                static void *fn(void *arg) { return arg; }
+            ]], [[
+                pthread_t thread;
+                pthread_mutex_t lock;
+                (void) pthread_mutex_init(&lock, NULL);
+                (void) pthread_create(&thread, NULL, &fn, NULL);
+                (void) pthread_join(thread, NULL);
+            ]])
+        ], [
+            AC_MSG_RESULT([yes])
+            AC_DEFINE([HAVE_LIBPTHREAD], [1], [Define to 1 if POSIX threads appear to be usable])
+        ], [
+            AC_MSG_RESULT([no])
+            LIBPTHREAD_LIBS=""
+            LIBPTHREAD_USABLE="No"
+        ])
+    ])
+
+    AS_IF([test "${LIBPTHREAD_USABLE}" = "No"], [
+        AC_MSG_WARN([POSIX threads appear to be unusable; work that could use them will be done on the main thread])
+    ])
+
+    AC_SUBST([LIBPTHREAD_LIBS])
+
+    LIBS="${LIBS_SAVED}"
+
+    unset LIBS_SAVED
+])
@@ -0,0 +1,1477 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * This file contains the binary snapshot database backend for Atheme. It
+ * stores the same rows as OpenSEX, in checksummed blocks of tagged cells with
+ * every distinct string stored once, so that a database is loaded without any
+ * text parsing and its blocks can be checked on several threads. The rows are
+ * still handed to their handlers one at a time on the main thread.
+ */
+
+#include <atheme.h>
+
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#  include <sys/mman.h>
+#  define BINARY_USE_MMAP 1
+#endif
+
+#ifdef HAVE_LIBPTHREAD
+#  include <pthread.h>
+#  define BINARY_USE_THREADS 1
+#endif
+
+/* File layout (all integers are little-endian):
+ *
+ *   8 bytes of magic, u32 format version, u32 reserved
+ *   blocks, each a 16 byte header and a payload:
+ *     u8 kind, u8 flags, u16 reserved,
+ *     u32 count, u32 payload length, u32 CRC-32 of the payload
+ *
+ * An S block holds <count> strings, each a varint length, the bytes and a NUL
+ * so that the reader can hand out pointers into the file; an S block flagged
+ * NEWTABLE starts a new string table, and the first one of a batch always is.
+ * An R block holds <count> rows, each the index of its type in the current
+ * string table followed by a series of tagged cells ended by a zero tag;
+ * string cells are indexes into the current table too. An E block ends a
+ * batch. A snapshot is one batch and every append (e.g. to a journal) adds
+ * another; a batch without its E block was cut short and is ignored.
+ *
+ * Rows are kept in the order in which they were written, and are written out
+ * a block at a time, each after the strings that it refers to. A string table
+ * is kept in memory while it is written, and a new one is started when it has
+ * grown past BINARY_TABLE_SIZE.
+ */
+#define BINARY_MAGIC            "ATHMBIN\n"
+#define BINARY_VERSION          2U
+#define BINARY_FILE_HDRLEN      16U
+#define BINARY_BLOCK_HDRLEN     16U
+
+#define BINARY_BLOCK_STRINGS    'S'
+#define BINARY_BLOCK_ROWS       'R'
+#define BINARY_BLOCK_END        'E'
+
+#define BINARY_FLAG_NEWTABLE    0x01U
+
+#define BINARY_CELL_END         0x00U
+#define BINARY_CELL_STR         0x01U
+#define BINARY_CELL_UINT        0x02U
+#define BINARY_CELL_INT         0x03U
+#define BINARY_CELL_TIME        0x04U
+
+#define BINARY_BLOCK_SIZE       262144U // rows at which a block is written out
+#define BINARY_TABLE_SIZE       4194304U // strings at which a new table is started
+#define BINARY_MAX_THREADS      8U
+#define BINARY_SCRATCH_SIZE     1024U
+
+struct binary_buf
+{
+	uint8_t *               data;
+	size_t                  len;
+	size_t                  cap;
+};
+
+struct binary_block
+{
+	uint8_t                 kind;
+	uint8_t                 flags;
+	uint32_t                count;
+	uint32_t                crc;
+	const uint8_t *         data;
+	size_t                  len;
+	size_t                  table;
+	size_t                  base;           // S: index of the first string; R: strings available
+	const char *            error;          // set by binary_check_block()
+};
+
+struct binary_table
+{
+	const char **           strs;
+	size_t                  count;
+};
+
+struct binary
+{
+	// Binary reading state
+	uint8_t *               file;
+	size_t                  filesize;
+	bool                    mapped;
+	struct binary_block *   blocks;
+	size_t                  nblocks;
+	size_t                  curblock;
+	struct binary_table *   tables;
+	size_t                  ntables;
+	const struct binary_table *table;
+	const uint8_t *         pos;
+	const uint8_t *         end;
+	uint32_t                rowsleft;
+	bool                    rowdone;
+	const char *            type;
+
+	// Strings made up for the current row (numbers read as words, etc.)
+	char                    scratch[BINARY_SCRATCH_SIZE];
+	size_t                  scratchlen;
+	char **                 spill;
+	size_t                  nspill;
+	size_t                  spillcap;
+
+	// A database that is not in this format yet is read as OpenSEX text
+	char *                  text;
+	char *                  textpos;
+	char *                  textend;
+	char *                  token;
+	char *                  rowend;
+
+	// Writing state
+	int                     fd;
+	bool                    werror;
+	bool                    newfile;
+	bool                    newtable;       // the next strings written start a new table
+	struct binary_buf       rows;           // rows not written out yet
+	uint32_t                nrows;
+	uint32_t                batchrows;
+	struct binary_buf       strings;        // the current table
+	size_t                  strwritten;     // bytes of it written out already
+	uint32_t                nstrwritten;
+	uint32_t *              slots;
+	size_t                  nslots;
+	size_t *                stroffs;
+	uint32_t *              strlens;
+	uint32_t *              strhashes;
+	uint32_t                nstrings;
+	uint32_t                strcap;
+};
+
+#ifdef HAVE_FLOCK
+static int lockfd;
+#endif
+
+// CRC-32 (as in zlib), eight bytes at a time
+static uint32_t binary_crc_table[8][256];
+
+static void
+binary_crc32_init(void)
+{
+	for (uint32_t i = 0; i < 256U; i++)
+	{
+		uint32_t c = i;
+
+		for (unsigned int k = 0; k < 8U; k++)
+			c = (c & 1U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+
+		binary_crc_table[0][i] = c;
+	}
+
+	for (uint32_t i = 0; i < 256U; i++)
+		for (unsigned int k = 1; k < 8U; k++)
+			binary_crc_table[k][i] = binary_crc_table[0][binary_crc_table[k - 1][i] & 0xFFU] ^
+			                         (binary_crc_table[k - 1][i] >> 8);
+}
+
+static uint32_t
+binary_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+	crc = ~crc;
+
+	for (; len >= 8U; data += 8, len -= 8U)
+	{
+		const uint32_t lo = crc ^ ((uint32_t) data[0] | ((uint32_t) data[1] << 8) |
+		                           ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+
+		crc = binary_crc_table[7][lo & 0xFFU] ^ binary_crc_table[6][(lo >> 8) & 0xFFU] ^
+		      binary_crc_table[5][(lo >> 16) & 0xFFU] ^ binary_crc_table[4][lo >> 24] ^
+		      binary_crc_table[3][data[4]] ^ binary_crc_table[2][data[5]] ^
+		      binary_crc_table[1][data[6]] ^ binary_crc_table[0][data[7]];
+	}
+
+	while (len--)
+		crc = binary_crc_table[0][(crc ^ *data++) & 0xFFU] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static inline uint32_t
+binary_get32(const uint8_t *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void
+binary_put32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+	p[2] = (uint8_t) (v >> 16);
+	p[3] = (uint8_t) (v >> 24);
+}
+
+static bool
+binary_get_varint(const uint8_t **pp, const uint8_t *end, uint64_t *res)
+{
+	uint64_t v = 0;
+
+	for (unsigned int shift = 0; *pp < end && shift < 64U; shift += 7U)
+	{
+		const uint8_t b = *(*pp)++;
+
+		v |= (uint64_t) (b & 0x7FU) << shift;
+
+		if (! (b & 0x80U))
+		{
+			*res = v;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static inline uint64_t
+binary_zigzag(int64_t v)
+{
+	return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline int64_t
+binary_unzigzag(uint64_t v)
+{
+	return (int64_t) ((v >> 1) ^ (0U - (v & 1U)));
+}
+
+/* Checks one block, and fills in the pointers of a string table block. This
+ * runs on the worker threads, so it must not touch anything but the block and
+ * its slice of the table: no logging, and no mowgli heaps or patricias.
+ */
+static void
+binary_check_block(struct binary_block *const restrict blk, struct binary_table *const restrict tables)
+{
+	const uint8_t *p = blk->data;
+	const uint8_t *const end = blk->data + blk->len;
+	uint64_t v;
+
+	if (binary_crc32(0, blk->data, blk->len) != blk->crc)
+	{
+		blk->error = "checksum mismatch";
+		return;
+	}
+
+	if (blk->kind == BINARY_BLOCK_STRINGS)
+	{
+		const char **const strs = tables[blk->table].strs + blk->base;
+
+		for (uint32_t i = 0; i < blk->count; i++)
+		{
+			if (! binary_get_varint(&p, end, &v) || v >= (uint64_t) (end - p) || p[v] != '\0')
+			{
+				blk->error = "bad string";
+				return;
+			}
+
+			strs[i] = (const char *) p;
+			p += v + 1;
+		}
+	}
+	else if (blk->kind == BINARY_BLOCK_ROWS)
+	{
+		for (uint32_t i = 0; i < blk->count; i++)
+		{
+			if (! binary_get_varint(&p, end, &v) || v >= blk->base)
+			{
+				blk->error = "bad row type";
+				return;
+			}
+
+			for (;;)
+			{
+				if (p >= end)
+				{
+					blk->error = "truncated row";
+					return;
+				}
+
+				const uint8_t tag = *p++;
+
+				if (tag == BINARY_CELL_END)
+					break;
+
+				if (tag > BINARY_CELL_TIME || ! binary_get_varint(&p, end, &v))
+				{
+					blk->error = "bad cell";
+					return;
+				}
+
+				if (tag == BINARY_CELL_STR && v >= blk->base)
+				{
+					blk->error = "string index out of range";
+					return;
+				}
+			}
+		}
+	}
+
+	if (p != end)
+		blk->error = "trailing data";
+}
+
+#ifdef BINARY_USE_THREADS
+struct binary_pool
+{
+	pthread_mutex_t         lock;
+	struct binary_block *   blocks;
+	struct binary_table *   tables;
+	size_t                  nblocks;
+	size_t                  next;
+};
+
+static void *
+binary_worker(void *const restrict arg)
+{
+	struct binary_pool *const pool = arg;
+
+	for (;;)
+	{
+		(void) pthread_mutex_lock(&pool->lock);
+		const size_t i = pool->next++;
+		(void) pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->nblocks)
+			break;
+
+		binary_check_block(&pool->blocks[i], pool->tables);
+	}
+
+	return NULL;
+}
+#endif
+
+static void
+binary_check_blocks(struct binary *const restrict rs)
+{
+#ifdef BINARY_USE_THREADS
+	pthread_t threads[BINARY_MAX_THREADS - 1];
+	struct binary_pool pool = {
+		.blocks = rs->blocks,
+		.tables = rs->tables,
+		.nblocks = rs->nblocks,
+	};
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	const long ncpu = 1;
+#endif
+	size_t nthreads = 0;
+	size_t want = (ncpu > 1) ? (size_t) ncpu - 1 : 0;
+
+	if (want > BINARY_MAX_THREADS - 1)
+		want = BINARY_MAX_THREADS - 1;
+	if (want >= rs->nblocks)
+		want = rs->nblocks ? rs->nblocks - 1 : 0;
+
+	(void) pthread_mutex_init(&pool.lock, NULL);
+
+	for (; nthreads < want; nthreads++)
+		if (pthread_create(&threads[nthreads], NULL, &binary_worker, &pool) != 0)
+			break;
+
+	// this thread does its share too, or all of it if no threads could be started
+	(void) binary_worker(&pool);
+
+	for (size_t i = 0; i < nthreads; i++)
+		(void) pthread_join(threads[i], NULL);
+
+	(void) pthread_mutex_destroy(&pool.lock);
+
+	slog(LG_DEBUG, "db-open-read: checked %zu blocks on %zu threads", rs->nblocks, nthreads + 1);
+#else
+	for (size_t i = 0; i < rs->nblocks; i++)
+		binary_check_block(&rs->blocks[i], rs->tables);
+#endif
+}
+
+// Indexes the blocks of a binary database and returns false if it is unusable
+static bool
+binary_index(struct database_handle *const restrict db, struct binary *const restrict rs)
+{
+	const uint8_t *p = rs->file + BINARY_FILE_HDRLEN;
+	const uint8_t *const end = rs->file + rs->filesize;
+	size_t complete = 0, cap = 0, tablecap = 0;
+
+	if (rs->filesize < BINARY_FILE_HDRLEN || binary_get32(rs->file + 8) != BINARY_VERSION)
+	{
+		slog(LG_ERROR, "db-open-read: '%s' has an unsupported format version", db->file);
+		return false;
+	}
+
+	while ((size_t) (end - p) >= BINARY_BLOCK_HDRLEN)
+	{
+		struct binary_block blk = {
+			.kind = p[0],
+			.flags = p[1],
+			.count = binary_get32(p + 4),
+			.len = binary_get32(p + 8),
+			.crc = binary_get32(p + 12),
+		};
+
+		p += BINARY_BLOCK_HDRLEN;
+
+		if ((size_t) (end - p) < blk.len)
+			break;
+
+		blk.data = p;
+		p += blk.len;
+
+		switch (blk.kind)
+		{
+			case BINARY_BLOCK_STRINGS:
+				if (blk.flags & BINARY_FLAG_NEWTABLE)
+				{
+					if (rs->ntables == tablecap)
+					{
+						tablecap = tablecap ? tablecap * 2 : 4;
+						rs->tables = sreallocarray(rs->tables, tablecap, sizeof *rs->tables);
+					}
+
+					rs->tables[rs->ntables++] = (struct binary_table) { .strs = NULL, .count = 0 };
+				}
+				else if (! rs->ntables)
+				{
+					slog(LG_ERROR, "db-open-read: '%s' has strings outside of a table", db->file);
+					return false;
+				}
+
+				blk.table = rs->ntables - 1;
+				blk.base = rs->tables[blk.table].count;
+				rs->tables[blk.table].count += blk.count;
+				break;
+
+			case BINARY_BLOCK_ROWS:
+				if (! rs->ntables)
+				{
+					slog(LG_ERROR, "db-open-read: '%s' has rows without a string table", db->file);
+					return false;
+				}
+
+				blk.table = rs->ntables - 1;
+				blk.base = rs->tables[blk.table].count;
+				break;
+
+			case BINARY_BLOCK_END:
+				break;
+
+			default:
+				slog(LG_ERROR, "db-open-read: '%s' has a block of unknown kind 0x%02X", db->file,
+				               (unsigned int) blk.kind);
+				return false;
+		}
+
+		if (rs->nblocks == cap)
+		{
+			cap = cap ? cap * 2 : 64;
+			rs->blocks = sreallocarray(rs->blocks, cap, sizeof *rs->blocks);
+		}
+
+		rs->blocks[rs->nblocks++] = blk;
+
+		if (blk.kind == BINARY_BLOCK_END)
+			complete = rs->nblocks;
+	}
+
+	// only an append can be cut short; a snapshot is renamed into place once it is complete
+	if ((p != end || rs->nblocks != complete) && ! complete)
+	{
+		slog(LG_ERROR, "db-open-read: '%s' is truncated", db->file);
+		return false;
+	}
+
+	if (p != end || rs->nblocks != complete)
+	{
+		slog(LG_ERROR, "db-open-read: '%s' ends with an incomplete batch of changes; ignoring it", db->file);
+		rs->nblocks = complete;
+	}
+
+	for (size_t i = 0; i < rs->ntables; i++)
+		rs->tables[i].strs = sreallocarray(NULL, rs->tables[i].count ? rs->tables[i].count : 1, sizeof(char *));
+
+	binary_check_blocks(rs);
+
+	for (size_t i = 0; i < rs->nblocks; i++)
+	{
+		if (rs->blocks[i].error)
+		{
+			slog(LG_ERROR, "db-open-read: '%s' is corrupt: block %zu: %s", db->file, i, rs->blocks[i].error);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static char *
+binary_scratch(struct binary *const restrict rs, const size_t len)
+{
+	if (len <= sizeof rs->scratch - rs->scratchlen)
+	{
+		char *const res = rs->scratch + rs->scratchlen;
+
+		rs->scratchlen += len;
+		return res;
+	}
+
+	if (rs->nspill == rs->spillcap)
+	{
+		rs->spillcap = rs->spillcap ? rs->spillcap * 2 : 8;
+		rs->spill = sreallocarray(rs->spill, rs->spillcap, sizeof *rs->spill);
+	}
+
+	return rs->spill[rs->nspill++] = smalloc(len);
+}
+
+static void
+binary_scratch_reset(struct binary *const restrict rs)
+{
+	for (size_t i = 0; i < rs->nspill; i++)
+		sfree(rs->spill[i]);
+
+	rs->nspill = 0;
+	rs->scratchlen = 0;
+}
+
+static bool
+binary_next_cell(struct binary *const restrict rs, uint8_t *const restrict tag, uint64_t *const restrict val)
+{
+	if (rs->rowdone)
+		return false;
+
+	// the block was checked when it was opened, so this cannot run off the end
+	*tag = *rs->pos++;
+
+	if (*tag == BINARY_CELL_END)
+	{
+		rs->rowdone = true;
+		return false;
+	}
+
+	return binary_get_varint(&rs->pos, rs->end, val);
+}
+
+static const char *
+binary_cell_word(struct binary *const restrict rs, const uint8_t tag, const uint64_t val)
+{
+	char buf[BUFSIZE];
+
+	switch (tag)
+	{
+		case BINARY_CELL_STR:
+			return rs->table->strs[val];
+		case BINARY_CELL_UINT:
+			(void) snprintf(buf, sizeof buf, "%ju", (uintmax_t) val);
+			break;
+		case BINARY_CELL_INT:
+			(void) snprintf(buf, sizeof buf, "%jd", (intmax_t) binary_unzigzag(val));
+			break;
+		default:
+			// as OpenSEX writes times
+			(void) snprintf(buf, sizeof buf, "%lu", (unsigned long) binary_unzigzag(val));
+			break;
+	}
+
+	const size_t len = strlen(buf) + 1;
+
+	return memcpy(binary_scratch(rs, len), buf, len);
+}
+
+static bool
+binary_read_next_row_text(struct database_handle *hdl, struct binary *rs)
+{
+	char *const row = rs->textpos;
+	char *nl;
+
+	if (row >= rs->textend)
+		return false;
+
+	if ((nl = memchr(row, '\n', (size_t) (rs->textend - row))) != NULL)
+	{
+		*nl = '\0';
+		rs->textpos = nl + 1;
+	}
+	else
+	{
+		// the buffer has a NUL after the end of the file
+		nl = rs->textend;
+		rs->textpos = rs->textend;
+	}
+
+	rs->token = row;
+	rs->rowend = nl;
+
+	hdl->line++;
+	hdl->token = 0;
+	return true;
+}
+
+static bool
+binary_read_next_row(struct database_handle *hdl)
+{
+	struct binary *rs = (struct binary *)hdl->priv;
+	uint8_t tag;
+	uint64_t val;
+
+	if (rs->text != NULL)
+		return binary_read_next_row_text(hdl, rs);
+
+	// skip whatever the handler of the last row did not read
+	while (binary_next_cell(rs, &tag, &val))
+		;
+
+	while (! rs->rowsleft)
+	{
+		const struct binary_block *blk;
+
+		if (rs->curblock >= rs->nblocks)
+			return false;
+
+		blk = &rs->blocks[rs->curblock++];
+
+		if (blk->kind != BINARY_BLOCK_ROWS)
+			continue;
+
+		rs->table = &rs->tables[blk->table];
+		rs->pos = blk->data;
+		rs->end = blk->data + blk->len;
+		rs->rowsleft = blk->count;
+	}
+
+	// checked along with the block
+	(void) binary_get_varint(&rs->pos, rs->end, &val);
+
+	rs->type = rs->table->strs[val];
+	rs->rowsleft--;
+	rs->rowdone = false;
+	binary_scratch_reset(rs);
+
+	hdl->line++;
+	hdl->token = 0;
+	return true;
+}
+
+static const char *
+binary_read_word(struct database_handle *db)
+{
+	struct binary *rs = (struct binary *)db->priv;
+	uint8_t tag;
+	uint64_t val;
+
+	if (rs->text != NULL)
+	{
+		char *const res = rs->token;
+		char *ptr;
+
+		if (res == NULL)
+			return NULL;
+
+		if ((ptr = memchr(res, ' ', (size_t) (rs->rowend - res))) != NULL)
+		{
+			*ptr++ = '\0';
+			rs->token = ptr;
+		}
+		else
+			rs->token = NULL;
+
+		db->token++;
+		return res;
+	}
+
+	if (! binary_next_cell(rs, &tag, &val))
+		return NULL;
+
+	db->token++;
+	return binary_cell_word(rs, tag, val);
+}
+
+// Like OpenSEX, a string is the rest of the row, even if it was written as several cells
+static const char *
+binary_read_str(struct database_handle *db)
+{
+	struct binary *rs = (struct binary *)db->priv;
+	const char *res;
+	uint8_t tag;
+	uint64_t val;
+
+	if (rs->text != NULL)
+	{
+		db->token++;
+		return rs->token;
+	}
+
+	if (! binary_next_cell(rs, &tag, &val))
+		res = "";
+	else
+		res = binary_cell_word(rs, tag, val);
+
+	while (binary_next_cell(rs, &tag, &val))
+	{
+		const char *const next = binary_cell_word(rs, tag, val);
+		const size_t len1 = strlen(res);
+		const size_t len2 = strlen(next);
+		char *const joined = binary_scratch(rs, len1 + len2 + 2);
+
+		(void) memcpy(joined, res, len1);
+		joined[len1] = ' ';
+		(void) memcpy(joined + len1 + 1, next, len2 + 1);
+		res = joined;
+	}
+
+	db->token++;
+	return res;
+}
+
+static bool
+binary_read_number(struct database_handle *db, bool sign, intmax_t *res)
+{
+	struct binary *rs = (struct binary *)db->priv;
+	const char *s;
+	char *rp;
+	uint8_t tag;
+	uint64_t val;
+
+	if (rs->text == NULL)
+	{
+		if (! binary_next_cell(rs, &tag, &val))
+			return false;
+
+		db->token++;
+
+		if (tag == BINARY_CELL_UINT)
+		{
+			*res = (intmax_t) val;
+			return true;
+		}
+		if (tag != BINARY_CELL_STR)
+		{
+			*res = binary_unzigzag(val);
+			return true;
+		}
+
+		s = rs->table->strs[val];
+	}
+	else if (! (s = db_read_word(db)))
+		return false;
+
+	if (sign)
+		*res = strtol(s, &rp, 0);
+	else
+		*res = (intmax_t) strtoul(s, &rp, 0);
+
+	return *s && !*rp;
+}
+
+static bool
+binary_read_int(struct database_handle *db, int *res)
+{
+	intmax_t num;
+
+	if (! binary_read_number(db, true, &num))
+		return false;
+
+	*res = (int) num;
+	return true;
+}
+
+static bool
+binary_read_uint(struct database_handle *db, unsigned int *res)
+{
+	intmax_t num;
+
+	if (! binary_read_number(db, false, &num))
+		return false;
+
+	*res = (unsigned int) num;
+	return true;
+}
+
+static bool
+binary_read_time(struct database_handle *db, time_t *res)
+{
+	intmax_t num;
+
+	if (! binary_read_number(db, false, &num))
+		return false;
+
+	*res = (time_t) num;
+	return true;
+}
+
+static void
+binary_buf_put(struct binary_buf *const restrict buf, const void *const restrict data, const size_t len)
+{
+	if (len > buf->cap - buf->len)
+	{
+		size_t cap = buf->cap ? buf->cap : 4096U;
+
+		while (len > cap - buf->len)
+			cap *= 2;
+
+		buf->data = srealloc(buf->data, cap);
+		buf->cap = cap;
+	}
+
+	(void) memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+static size_t
+binary_put_varint(uint8_t *const restrict p, uint64_t val)
+{
+	size_t n = 0;
+
+	while (val >= 0x80U)
+	{
+		p[n++] = (uint8_t) (val | 0x80U);
+		val >>= 7;
+	}
+
+	p[n++] = (uint8_t) val;
+	return n;
+}
+
+static void
+binary_buf_put_cell(struct binary_buf *const restrict buf, const uint8_t tag, const uint64_t val)
+{
+	uint8_t tmp[11];
+
+	tmp[0] = tag;
+	binary_buf_put(buf, tmp, 1 + binary_put_varint(tmp + 1, val));
+}
+
+static void
+binary_buf_free(struct binary_buf *const restrict buf)
+{
+	sfree(buf->data);
+}
+
+static void
+binary_intern_grow(struct binary *const restrict rs)
+{
+	const size_t nslots = rs->nslots ? rs->nslots * 2 : 4096U;
+	uint32_t *const slots = sreallocarray(NULL, nslots, sizeof *slots);
+
+	(void) memset(slots, 0x00, nslots * sizeof *slots);
+
+	for (uint32_t i = 0; i < rs->nstrings; i++)
+	{
+		size_t s = rs->strhashes[i] & (nslots - 1);
+
+		while (slots[s])
+			s = (s + 1) & (nslots - 1);
+
+		slots[s] = i + 1;
+	}
+
+	sfree(rs->slots);
+	rs->slots = slots;
+	rs->nslots = nslots;
+}
+
+static uint32_t
+binary_intern(struct binary *const restrict rs, const char *const restrict str)
+{
+	const size_t len = strlen(str);
+	uint32_t hash = 0x811C9DC5U;
+	size_t s;
+
+	for (size_t i = 0; i < len; i++)
+		hash = (hash ^ (uint8_t) str[i]) * 0x01000193U;
+
+	if (rs->nstrings >= rs->nslots / 2)
+		binary_intern_grow(rs);
+
+	for (s = hash & (rs->nslots - 1); rs->slots[s]; s = (s + 1) & (rs->nslots - 1))
+	{
+		const uint32_t i = rs->slots[s] - 1;
+
+		if (rs->strhashes[i] == hash && rs->strlens[i] == len && ! memcmp(rs->strings.data + rs->stroffs[i], str, len))
+			return i;
+	}
+
+	if (rs->nstrings == rs->strcap)
+	{
+		rs->strcap = rs->strcap ? rs->strcap * 2 : 4096U;
+		rs->stroffs = sreallocarray(rs->stroffs, rs->strcap, sizeof *rs->stroffs);
+		rs->strlens = sreallocarray(rs->strlens, rs->strcap, sizeof *rs->strlens);
+		rs->strhashes = sreallocarray(rs->strhashes, rs->strcap, sizeof *rs->strhashes);
+	}
+
+	const uint32_t i = rs->nstrings++;
+	uint8_t tmp[10];
+
+	binary_buf_put(&rs->strings, tmp, binary_put_varint(tmp, len));
+
+	rs->stroffs[i] = rs->strings.len;
+	rs->strlens[i] = (uint32_t) len;
+	rs->strhashes[i] = hash;
+	binary_buf_put(&rs->strings, str, len + 1);
+
+	rs->slots[s] = i + 1;
+	return i;
+}
+
+static void
+binary_write(struct database_handle *db, struct binary *rs, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len != 0 && ! rs->werror)
+	{
+		const ssize_t ret = write(rs->fd, p, len);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+		{
+			slog(LG_ERROR, "db-write: cannot write to '%s%s': %s", db->file, (db->txn == DB_WRITE) ? ".new" : "",
+			               ret < 0 ? strerror(errno) : "short write");
+			rs->werror = true;
+			break;
+		}
+
+		p += ret;
+		len -= (size_t) ret;
+	}
+}
+
+static void
+binary_write_block(struct database_handle *db, struct binary *rs, uint8_t kind, uint8_t flags, uint32_t count,
+                   const uint8_t *data, size_t len)
+{
+	uint8_t hdr[BINARY_BLOCK_HDRLEN];
+
+	hdr[0] = kind;
+	hdr[1] = flags;
+	hdr[2] = 0;
+	hdr[3] = 0;
+	binary_put32(hdr + 4, count);
+	binary_put32(hdr + 8, (uint32_t) len);
+	binary_put32(hdr + 12, binary_crc32(0, data, len));
+
+	binary_write(db, rs, hdr, sizeof hdr);
+	binary_write(db, rs, data, len);
+}
+
+static void
+binary_write_header(struct database_handle *db, struct binary *rs)
+{
+	uint8_t hdr[BINARY_FILE_HDRLEN] = { 0 };
+
+	(void) memcpy(hdr, BINARY_MAGIC, 8);
+	binary_put32(hdr + 8, BINARY_VERSION);
+	binary_write(db, rs, hdr, sizeof hdr);
+}
+
+// Writes out the rows made so far, after the strings they need that are not written yet
+static void
+binary_flush(struct database_handle *db, struct binary *rs)
+{
+	if (rs->newtable || rs->nstrings != rs->nstrwritten)
+	{
+		binary_write_block(db, rs, BINARY_BLOCK_STRINGS, rs->newtable ? BINARY_FLAG_NEWTABLE : 0,
+		                   rs->nstrings - rs->nstrwritten, rs->strings.data + rs->strwritten,
+		                   rs->strings.len - rs->strwritten);
+
+		rs->newtable = false;
+		rs->strwritten = rs->strings.len;
+		rs->nstrwritten = rs->nstrings;
+	}
+
+	if (rs->nrows)
+	{
+		binary_write_block(db, rs, BINARY_BLOCK_ROWS, 0, rs->nrows, rs->rows.data, rs->rows.len);
+
+		rs->batchrows += rs->nrows;
+		rs->nrows = 0;
+		rs->rows.len = 0;
+	}
+
+	// no row refers to the table any more, so it need not be kept
+	if (rs->strings.len >= BINARY_TABLE_SIZE)
+	{
+		(void) memset(rs->slots, 0x00, rs->nslots * sizeof *rs->slots);
+
+		rs->strings.len = 0;
+		rs->strwritten = 0;
+		rs->nstrings = 0;
+		rs->nstrwritten = 0;
+		rs->newtable = true;
+	}
+}
+
+static bool
+binary_start_row(struct database_handle *db, const char *type)
+{
+	struct binary *rs;
+	uint8_t tmp[10];
+
+	return_val_if_fail(db != NULL, false);
+	return_val_if_fail(type != NULL, false);
+	rs = (struct binary *)db->priv;
+
+	binary_buf_put(&rs->rows, tmp, binary_put_varint(tmp, binary_intern(rs, type)));
+	return true;
+}
+
+static bool
+binary_write_cell(struct database_handle *db, const uint8_t tag, const uint64_t val)
+{
+	return_val_if_fail(db != NULL, false);
+
+	binary_buf_put_cell(&((struct binary *)db->priv)->rows, tag, val);
+	return true;
+}
+
+static bool
+binary_write_word(struct database_handle *db, const char *word)
+{
+	return_val_if_fail(db != NULL, false);
+
+	return binary_write_cell(db, BINARY_CELL_STR, binary_intern(db->priv, word != NULL ? word : "*"));
+}
+
+static bool
+binary_write_int(struct database_handle *db, int num)
+{
+	return binary_write_cell(db, BINARY_CELL_INT, binary_zigzag(num));
+}
+
+static bool
+binary_write_uint(struct database_handle *db, unsigned int num)
+{
+	return binary_write_cell(db, BINARY_CELL_UINT, num);
+}
+
+static bool
+binary_write_time(struct database_handle *db, time_t tm)
+{
+	return binary_write_cell(db, BINARY_CELL_TIME, binary_zigzag((int64_t) tm));
+}
+
+static bool
+binary_commit_row(struct database_handle *db)
+{
+	struct binary *rs;
+
+	return_val_if_fail(db != NULL, false);
+	rs = (struct binary *)db->priv;
+
+	binary_buf_put(&rs->rows, "", 1);
+	rs->nrows++;
+
+	if (rs->rows.len >= BINARY_BLOCK_SIZE)
+		binary_flush(db, rs);
+
+	return true;
+}
+
+static const struct database_vtable binary_vt = {
+	.name = "binary",
+	.read_next_row = binary_read_next_row,
+	.read_word = binary_read_word,
+	.read_str = binary_read_str,
+	.read_int = binary_read_int,
+	.read_uint = binary_read_uint,
+	.read_time = binary_read_time,
+	.start_row = binary_start_row,
+	.write_word = binary_write_word,
+	.write_str = binary_write_word,
+	.write_int = binary_write_int,
+	.write_uint = binary_write_uint,
+	.write_time = binary_write_time,
+	.commit_row = binary_commit_row
+};
+
+static struct database_handle *
+binary_db_new(struct binary *rs, const char *path, enum database_transaction txn)
+{
+	struct database_handle *const db = smalloc(sizeof *db);
+
+	db->priv = rs;
+	db->vt = &binary_vt;
+	db->txn = txn;
+	db->file = sstrdup(path);
+
+	if (txn != DB_READ)
+	{
+		rs->newtable = true;
+
+		if (rs->newfile)
+			binary_write_header(db, rs);
+	}
+
+	return db;
+}
+
+static bool
+binary_read_file(struct binary *const restrict rs, const int fd, const char *const restrict path)
+{
+	struct stat sb;
+	size_t done = 0;
+
+	if (fstat(fd, &sb) < 0)
+	{
+		slog(LG_ERROR, "db-open-read: cannot stat '%s': %s", path, strerror(errno));
+		return false;
+	}
+
+	if ((uintmax_t) sb.st_size >= SIZE_MAX)
+	{
+		slog(LG_ERROR, "db-open-read: '%s' is too large", path);
+		return false;
+	}
+
+	rs->filesize = (size_t) sb.st_size;
+
+#ifdef BINARY_USE_MMAP
+	if (rs->filesize >= BINARY_FILE_HDRLEN)
+	{
+		void *const map = mmap(NULL, rs->filesize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (map != MAP_FAILED && ! memcmp(map, BINARY_MAGIC, 8))
+		{
+			rs->file = map;
+			rs->mapped = true;
+			return true;
+		}
+
+		if (map != MAP_FAILED)
+			(void) munmap(map, rs->filesize);
+		else
+			slog(LG_DEBUG, "db-open-read: cannot map '%s' (%s); reading it instead", path, strerror(errno));
+	}
+#endif
+
+	// one byte more, so that a text database always ends with a NUL
+	rs->file = smalloc(rs->filesize + 1);
+
+	while (done < rs->filesize)
+	{
+		const ssize_t ret = read(fd, rs->file + done, rs->filesize - done);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+		{
+			slog(LG_ERROR, "db-open-read: cannot read '%s': %s", path, ret < 0 ? strerror(errno) : "short read");
+			return false;
+		}
+
+		done += (size_t) ret;
+	}
+
+	return true;
+}
+
+static struct database_handle * ATHEME_FATTR_MALLOC
+binary_db_open_read(const char *filename)
+{
+	struct database_handle *db;
+	struct binary *rs;
+	int fd;
+	int errno1;
+	char path[BUFSIZE];
+
+	snprintf(path, BUFSIZE, "%s/%s", datadir, filename != NULL ? filename : "services.db");
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		errno1 = errno;
+
+		// ENOENT can happen if the database does not exist yet.
+		if (errno == ENOENT)
+		{
+			if (database_create)
+			{
+				slog(LG_INFO, "db-open-read: database '%s' does not yet exist; a new one will be created.", path);
+				return NULL;
+			}
+			else
+			{
+				slog(LG_ERROR, "db-open-read: database '%s' does not yet exist; please specify the -b option to create a new one.", path);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		slog(LG_ERROR, "db-open-read: cannot open '%s' for reading: %s", path, strerror(errno1));
+		wallops("\2DATABASE ERROR\2: db-open-read: cannot open '%s' for reading: %s", path, strerror(errno1));
+		exit(EXIT_FAILURE);
+	}
+	else if (database_create)
+	{
+		slog(LG_ERROR, "db-open-read: database '%s' already exists, but you specified the -b option to create a new one; please remove the old database first", path);
+		exit(EXIT_FAILURE);
+	}
+
+	rs = smalloc(sizeof *rs);
+	rs->fd = -1;
+	rs->rowdone = true;
+	db = binary_db_new(rs, path, DB_READ);
+
+	if (! binary_read_file(rs, fd, path))
+	{
+		slog(LG_ERROR, "db-open-read: exiting to avoid data loss");
+		exit(EXIT_FAILURE);
+	}
+
+	(void) close(fd);
+
+	if (rs->filesize >= 8 && ! memcmp(rs->file, BINARY_MAGIC, 8))
+	{
+		if (! binary_index(db, rs))
+		{
+			slog(LG_ERROR, "db-open-read: exiting to avoid data loss");
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if (rs->filesize != 0)
+	{
+		slog(LG_INFO, "db-open-read: '%s' is not a binary database; reading it as an OpenSEX one", path);
+
+		rs->text = (char *) rs->file;
+		rs->textpos = rs->text;
+		rs->textend = rs->text + rs->filesize;
+		*rs->textend = '\0';
+	}
+
+	return db;
+}
+
+static struct database_handle * ATHEME_FATTR_MALLOC
+binary_db_open_write(const char *filename)
+{
+	struct binary *rs;
+	int fd;
+	int errno1;
+	char bpath[BUFSIZE], path[BUFSIZE];
+#ifdef HAVE_FLOCK
+	char lpath[BUFSIZE];
+#endif
+
+	snprintf(bpath, BUFSIZE, "%s/%s", datadir, filename != NULL ? filename : "services.db");
+
+	mowgli_strlcpy(path, bpath, sizeof path);
+	mowgli_strlcat(path, ".new", sizeof path);
+
+#ifdef HAVE_FLOCK
+	mowgli_strlcpy(lpath, bpath, sizeof lpath);
+	mowgli_strlcat(lpath, ".lock", sizeof lpath);
+
+	lockfd = open(lpath, O_RDONLY | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+
+	flock(lockfd, LOCK_EX);
+#endif
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if (fd < 0)
+	{
+		errno1 = errno;
+		slog(LG_ERROR, "db-open-write: cannot open '%s' for writing: %s", path, strerror(errno1));
+		wallops("\2DATABASE ERROR\2: db-open-write: cannot open '%s' for writing: %s", path, strerror(errno1));
+#ifdef HAVE_FLOCK
+		close(lockfd);
+#endif
+		return NULL;
+	}
+
+	rs = smalloc(sizeof *rs);
+	rs->fd = fd;
+	rs->newfile = true;
+
+	return binary_db_new(rs, bpath, DB_WRITE);
+}
+
+static struct database_handle * ATHEME_FATTR_MALLOC
+binary_db_open_append(const char *filename)
+{
+	struct binary *rs;
+	struct stat sb;
+	int fd;
+	int errno1;
+	char path[BUFSIZE];
+
+	return_val_if_fail(filename != NULL, NULL);
+
+	snprintf(path, BUFSIZE, "%s/%s", datadir, filename);
+
+	fd = open(path, O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if (fd < 0 || fstat(fd, &sb) < 0)
+	{
+		errno1 = errno;
+		slog(LG_ERROR, "db-open-append: cannot open '%s' for appending: %s", path, strerror(errno1));
+		wallops("\2DATABASE ERROR\2: db-open-append: cannot open '%s' for appending: %s", path, strerror(errno1));
+		if (fd >= 0)
+			close(fd);
+		return NULL;
+	}
+
+	rs = smalloc(sizeof *rs);
+	rs->fd = fd;
+	rs->newfile = (sb.st_size == 0);
+
+	return binary_db_new(rs, path, DB_APPEND);
+}
+
+static struct database_handle *
+binary_db_open(const char *filename, enum database_transaction txn)
+{
+	if (txn == DB_WRITE)
+		return binary_db_open_write(filename);
+	if (txn == DB_APPEND)
+		return binary_db_open_append(filename);
+	return binary_db_open_read(filename);
+}
+
+static void
+binary_db_parse(struct database_handle *db)
+{
+	struct binary *rs = (struct binary *)db->priv;
+	const char *cmd;
+
+	while (db_read_next_row(db))
+	{
+		if (rs->text == NULL)
+		{
+			db_process(db, rs->type);
+			continue;
+		}
+
+		cmd = db_read_word(db);
+		if (!cmd || !*cmd || strchr("#\n\t \r", *cmd)) continue;
+		db_process(db, cmd);
+	}
+}
+
+static void
+binary_db_close(struct database_handle *db)
+{
+	struct binary *rs;
+	int errno1;
+	char oldpath[BUFSIZE], newpath[BUFSIZE];
+
+	return_if_fail(db != NULL);
+	rs = db->priv;
+
+	mowgli_strlcpy(oldpath, db->file, sizeof oldpath);
+	mowgli_strlcat(oldpath, ".new", sizeof oldpath);
+
+	mowgli_strlcpy(newpath, db->file, sizeof newpath);
+
+	// the rest of the batch, and the end of it
+	if (db->txn != DB_READ)
+	{
+		binary_flush(db, rs);
+		binary_write_block(db, rs, BINARY_BLOCK_END, 0, rs->batchrows, NULL, 0);
+	}
+
+#if defined(_POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0)
+	if (db->txn != DB_READ && !rs->werror && config_options.db_save_sync && fdatasync(rs->fd) < 0)
+#else
+	if (db->txn != DB_READ && !rs->werror && config_options.db_save_sync && fsync(rs->fd) < 0)
+#endif
+	{
+		slog(LG_ERROR, "db-write: cannot flush '%s' to disk: %s", db->file, strerror(errno));
+		rs->werror = true;
+	}
+
+	if (db->txn != DB_READ && close(rs->fd) < 0 && !rs->werror)
+	{
+		slog(LG_ERROR, "db-write: cannot close '%s': %s", db->file, strerror(errno));
+		rs->werror = true;
+	}
+
+	if (db->txn == DB_WRITE)
+	{
+		// a partial database must never replace a complete one
+		if (rs->werror)
+		{
+			slog(LG_ERROR, "db_save(): keeping the previous database; the new one is incomplete");
+			wallops("\2DATABASE ERROR\2: db_save(): could not write %s; keeping the previous database", oldpath);
+		}
+		// now, replace the old database with the new one, using an atomic rename
+		else if (srename(oldpath, newpath) < 0)
+		{
+			errno1 = errno;
+			slog(LG_ERROR, "db_save(): cannot rename services.db.new to services.db: %s", strerror(errno1));
+			wallops("\2DATABASE ERROR\2: db_save(): cannot rename services.db.new to services.db: %s", strerror(errno1));
+		}
+		else
+			hook_call_db_saved();
+#ifdef HAVE_FLOCK
+		close(lockfd);
+#endif
+	}
+
+#ifdef BINARY_USE_MMAP
+	if (rs->mapped)
+		(void) munmap(rs->file, rs->filesize);
+	else
+#endif
+		sfree(rs->file);
+
+	for (size_t i = 0; i < rs->ntables; i++)
+		sfree(rs->tables[i].strs);
+
+	binary_scratch_reset(rs);
+	binary_buf_free(&rs->rows);
+	binary_buf_free(&rs->strings);
+	sfree(rs->spill);
+	sfree(rs->blocks);
+	sfree(rs->tables);
+	sfree(rs->slots);
+	sfree(rs->stroffs);
+	sfree(rs->strlens);
+	sfree(rs->strhashes);
+	sfree(rs);
+	sfree(db->file);
+	sfree(db);
+}
+
+// Only seen when an OpenSEX database is read
+static void
+binary_h_grver(struct database_handle *db, const char *type)
+{
+	const unsigned int grver = db_sread_uint(db);
+
+	if (grver != 1)
+		slog(LG_ERROR, "binary: OpenSEX grammar version %u is unsupported.  dazed and confused, but trying to continue.", grver);
+}
+
+static const struct database_module binary_mod = {
+	.db_open = binary_db_open,
+	.db_close = binary_db_close,
+	.db_parse = binary_db_parse,
+};
+
+static void
+mod_init(struct module *const restrict m)
+{
+	MODULE_TRY_REQUEST_DEPENDENCY(m, "backend/corestorage")
+
+	binary_crc32_init();
+
+	db_mod = &binary_mod;
+
+	db_register_type_handler("GRVER", binary_h_grver);
+
+	backend_loaded = true;
+
+	m->mflags |= MODFLAG_DBHANDLER;
+}
+
+static void
+mod_deinit(const enum module_unload_intent ATHEME_VATTR_UNUSED intent)
+{
+
+}
+
+SIMPLE_DECLARE_MODULE_V1("backend/binary", MODULE_UNLOAD_CAPABILITY_NEVER)
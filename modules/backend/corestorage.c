@@ -32,26 +32,371 @@ static bool mdep_load_mdeps = true;
 
 #ifdef HAVE_FORK
 static pid_t child_pid;
+static bool child_follows;      // whether the child is saving the journalled database
 #endif
 
-// write atheme.db (core fields)
+// set once a save has replaced the previous database
+static bool save_written;
+
+/* Changes made since the last full save are appended to <database>.journal.N,
+ * where N is the journal_seq that was current when they were made.  Every save
+ * made while journalling starts a new journal and records its number in the
+ * snapshot (JSEQ), so on startup the journals numbered from the snapshot's JSEQ
+ * onwards are replayed on top of it, and once a save is complete the older ones
+ * are deleted.  A snapshot without JSEQ was saved without a journal.
+ */
+struct journal_entry
+{
+	mowgli_node_t           node;
+	struct journal_entry *  hnext;          // next in its journal_index bucket
+	enum db_record_type     type;
+	void *                  object;         // written out as it is at flush time
+	char *                  key;            // metadata name
+	const char *            row;            // or a row built when it was queued
+	char *                  words[3];
+};
+
+static unsigned int journal_seq = 1;
+static bool journal_seq_loaded;
+static bool journal_active;
+static bool journal_save_active;        // whether the save being written has a journal
+static char *journal_db;                // the database the journals belong to
+static bool journal_compact_pending;
+static unsigned int journal_records;
+static mowgli_list_t journal_queue;
+static mowgli_eventloop_timer_t *journal_timer;
+
+/* Queued changes to an object (those with je->object set) are also chained
+ * into a bucket chosen by their (type, object) pair, so that every change
+ * can check for a queued entry to merge with, and every deletion can purge
+ * the object's entries, without walking the whole queue. A mass deletion
+ * would otherwise be quadratic in the number of changes made in that tick.
+ * Entries for the metadata of one object share a bucket; their keys are
+ * compared there.
+ */
+#define JOURNAL_INDEX_MINSIZE   256U
+
+static struct journal_entry **journal_index;
+static size_t journal_index_size;
+static size_t journal_index_count;
+
+/* With general::db_save_slice set, background saves are written a few
+ * accounts and channels at a time from the event loop instead of from a
+ * forked child.  Which accounts and channels go in is decided when the save
+ * begins, and everything else (K/X/Q-lines, module data, ...) is copied into
+ * memory then; accounts and channels are written as they are when their turn
+ * comes, under the names they had when it began, and those dropped before
+ * their turn are left out.  Such a save is not a snapshot of any one moment
+ * on its own: accounts and channels registered while it is written are
+ * missing from it, and it is only made whole by replaying the journal that
+ * was started with it.  It is therefore only used when that journal exists.
+ */
+struct corestorage_ptrset
+{
+	uintptr_t *             slots;          // 0: free, 1: removed, ptr|1: written
+	size_t                  nslots;
+	size_t                  used;
+	size_t                  cursor;
+};
+
+struct corestorage_rename
+{
+	mowgli_node_t           node;
+	struct myuser *         mu;
+	char *                  name;           // as it was when the save began
+};
+
+enum corestorage_slice_phase
+{
+	SLICE_ACCOUNTS,
+	SLICE_CHANNELS,
+	SLICE_DONE,
+};
+
+static struct database_handle *slice_db;
+static enum corestorage_slice_phase slice_phase;
+static struct corestorage_ptrset slice_accounts;
+static struct corestorage_ptrset slice_channels;
+static struct database_handle *slice_pre_ca;    // rows taken when the save began
+static struct database_handle *slice_tail;
+static mowgli_list_t slice_renames;
+static mowgli_eventloop_timer_t *slice_timer;
+static bool slice_again;
+static bool slice_follows;              // whether the save is of the journalled database
+
+// a sliced save may refer to accounts made after it began (see corestorage_h_ca)
+static bool db_fuzzy;
+
+static inline size_t
+corestorage_ptrset_hash(const struct corestorage_ptrset *const set, const void *const ptr)
+{
+	uint64_t key = (uint64_t) ((uintptr_t) ptr & ~(uintptr_t) 1);
+
+	key ^= key >> 33;
+	key *= UINT64_C(0xFF51AFD7ED558CCD);
+	key ^= key >> 33;
+
+	return (size_t) key & (set->nslots - 1);
+}
+
+static uintptr_t *
+corestorage_ptrset_find(const struct corestorage_ptrset *const set, const void *const ptr)
+{
+	if (! set->nslots)
+		return NULL;
+
+	for (size_t i = corestorage_ptrset_hash(set, ptr); set->slots[i]; i = (i + 1) & (set->nslots - 1))
+		if (set->slots[i] != 1 && (set->slots[i] & ~(uintptr_t) 1) == (uintptr_t) ptr)
+			return &set->slots[i];
+
+	return NULL;
+}
+
 static void
-corestorage_db_save(struct database_handle *db)
+corestorage_ptrset_add(struct corestorage_ptrset *const set, void *const ptr)
+{
+	size_t i;
+
+	if (set->used >= set->nslots / 2)
+	{
+		const struct corestorage_ptrset old = *set;
+
+		set->nslots = old.nslots ? old.nslots * 2 : 1024;
+		set->slots = scalloc(set->nslots, sizeof *set->slots);
+		set->used = 0;
+
+		for (size_t j = 0; j < old.nslots; j++)
+			if (old.slots[j] > 1)
+				corestorage_ptrset_add(set, (void *) old.slots[j]);
+
+		sfree(old.slots);
+	}
+
+	for (i = corestorage_ptrset_hash(set, ptr); set->slots[i]; i = (i + 1) & (set->nslots - 1))
+		;
+
+	set->slots[i] = (uintptr_t) ptr;
+	set->used++;
+}
+
+static void
+corestorage_ptrset_remove(struct corestorage_ptrset *const set, const void *const ptr)
+{
+	uintptr_t *const slot = corestorage_ptrset_find(set, ptr);
+
+	if (slot != NULL)
+		*slot = 1;
+}
+
+// Returns an entry that has not been written yet, and marks it written
+static void *
+corestorage_ptrset_next(struct corestorage_ptrset *const set)
+{
+	while (set->cursor < set->nslots)
+	{
+		uintptr_t *const slot = &set->slots[set->cursor++];
+
+		if (*slot > 1 && ! (*slot & 1))
+		{
+			*slot |= 1;
+			return (void *) (*slot & ~(uintptr_t) 1);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+corestorage_ptrset_free(struct corestorage_ptrset *const set)
+{
+	sfree(set->slots);
+	(void) memset(set, 0x00, sizeof *set);
+}
+
+static struct corestorage_rename *
+corestorage_rename_find(const struct myuser *const mu)
+{
+	mowgli_node_t *n;
+
+	MOWGLI_ITER_FOREACH(n, slice_renames.head)
+	{
+		struct corestorage_rename *const r = n->data;
+
+		if (r->mu == mu)
+			return r;
+	}
+
+	return NULL;
+}
+
+// The name to save an entity under in db
+static const char *
+corestorage_entity_name(const struct database_handle *const db, struct myentity *const mt)
+{
+	const struct corestorage_rename *r;
+
+	if (db == slice_db && MOWGLI_LIST_LENGTH(&slice_renames) && (r = corestorage_rename_find(user(mt))) != NULL)
+		return r->name;
+
+	return mt->name;
+}
+
+static void
+corestorage_write_metadata(struct database_handle *db, const char *type, void *obj, const char *name, const char *mask)
 {
 	struct metadata *md;
-	struct myuser *mu;
-	struct myentity *ment;
-	struct myuser_name *mun;
-	struct mychan *mc;
-	struct chanacs *ca;
-	struct kline *k;
-	struct xline *x;
-	struct qline *q;
-	struct svsignore *svsignore;
-	struct soper *soper;
-	mowgli_node_t *n, *tn;
 	mowgli_patricia_iteration_state_t state;
-	struct myentity_iteration_state mestate;
+
+	if (! atheme_object(obj)->metadata)
+		return;
+
+	MOWGLI_PATRICIA_FOREACH(md, &state, atheme_object(obj)->metadata)
+	{
+		db_start_row(db, type);
+		db_write_word(db, name);
+
+		if (mask != NULL)
+			db_write_word(db, mask);
+
+		db_write_word(db, md->name);
+		db_write_str(db, md->value);
+		db_commit_row(db);
+	}
+}
+
+/* MU <name> <pass> <email> <registered> <lastlogin> <failnum*> <lastfail*>
+ * <lastfailon*> <flags> <language>
+ *
+ *  * failnum, lastfail, and lastfailon are deprecated (moved to metadata)
+ */
+static void
+corestorage_write_mu(struct database_handle *db, const char *type, struct myuser *mu)
+{
+	char *flags = gflags_tostr(mu_flags, MOWGLI_LIST_LENGTH(&mu->logins) ? mu->flags & ~MU_NOBURSTLOGIN : mu->flags);
+	const char *name = corestorage_entity_name(db, entity(mu));
+	db_start_row(db, type);
+	db_write_word(db, entity(mu)->id);
+	db_write_word(db, name);
+	db_write_word(db, mu->pass);
+	db_write_word(db, mu->email);
+	db_write_time(db, mu->registered);
+
+	if (MOWGLI_LIST_LENGTH(&mu->logins))
+		db_write_time(db, 0);
+	else
+		db_write_time(db, mu->lastlogin);
+
+	db_write_word(db, flags);
+	db_write_word(db, language_get_name(mu->language));
+	db_commit_row(db);
+
+	corestorage_write_metadata(db, "MDU", mu, name, NULL);
+}
+
+static void
+corestorage_write_mn(struct database_handle *db, struct mynick *mn)
+{
+	db_start_row(db, "MN");
+	db_write_word(db, corestorage_entity_name(db, entity(mn->owner)));
+	db_write_word(db, mn->nick);
+	db_write_time(db, mn->registered);
+
+	struct user *u = user_find_named(mn->nick);
+	if (u != NULL && u->myuser == mn->owner)
+		db_write_time(db, 0);
+	else
+		db_write_time(db, mn->lastseen);
+
+	db_commit_row(db);
+}
+
+// MC <name> <registered> <used> <flags> <mlock_on> <mlock_off> <mlock_limit> [mlock_key]
+static void
+corestorage_write_mc(struct database_handle *db, const char *type, struct mychan *mc)
+{
+	char *flags = gflags_tostr(mc_flags, mc->flags);
+
+	db_start_row(db, type);
+	db_write_word(db, mc->name);
+	db_write_time(db, mc->registered);
+	db_write_time(db, mc->used);
+	db_write_word(db, flags);
+	db_write_uint(db, mc->mlock_on);
+	db_write_uint(db, mc->mlock_off);
+	db_write_uint(db, mc->mlock_limit);
+	db_write_word(db, mc->mlock_key ? mc->mlock_key : "");
+	db_commit_row(db);
+}
+
+static void
+corestorage_write_ca(struct database_handle *db, const char *type, struct chanacs *ca)
+{
+	struct myentity *setter = NULL;
+	const char *target = ca->entity ? corestorage_entity_name(db, ca->entity) : ca->host;
+
+	db_start_row(db, type);
+	db_write_word(db, ca->mychan->name);
+	db_write_word(db, target);
+	db_write_word(db, bitmask_to_flags(ca->level));
+	db_write_time(db, ca->tmodified);
+
+	if (*ca->setter_uid != '\0' && (setter = myentity_find_uid(ca->setter_uid)))
+		db_write_word(db, corestorage_entity_name(db, setter));
+	else
+		db_write_word(db, "*");
+
+	db_commit_row(db);
+
+	corestorage_write_metadata(db, "MDA", ca, ca->mychan->name, target);
+}
+
+// KL <user> <host> <duration> <settime> <setby> <reason>
+static void
+corestorage_write_kl(struct database_handle *db, struct kline *k)
+{
+	db_start_row(db, "KL");
+	db_write_uint(db, k->number);
+	db_write_word(db, k->user);
+	db_write_word(db, k->host);
+	db_write_uint(db, k->duration);
+	db_write_time(db, k->settime);
+	db_write_word(db, k->setby);
+	db_write_str(db, k->reason);
+	db_commit_row(db);
+}
+
+// XL <gecos> <duration> <settime> <setby> <reason>
+static void
+corestorage_write_xl(struct database_handle *db, struct xline *x)
+{
+	db_start_row(db, "XL");
+	db_write_uint(db, x->number);
+	db_write_word(db, x->realname);
+	db_write_uint(db, x->duration);
+	db_write_time(db, x->settime);
+	db_write_word(db, x->setby);
+	db_write_str(db, x->reason);
+	db_commit_row(db);
+}
+
+// QL <mask> <duration> <settime> <setby> <reason>
+static void
+corestorage_write_ql(struct database_handle *db, struct qline *q)
+{
+	db_start_row(db, "QL");
+	db_write_uint(db, q->number);
+	db_write_word(db, q->mask);
+	db_write_uint(db, q->duration);
+	db_write_time(db, q->settime);
+	db_write_word(db, q->setby);
+	db_write_str(db, q->reason);
+	db_commit_row(db);
+}
+
+static void
+corestorage_write_header(struct database_handle *db, const bool sliced)
+{
+	mowgli_node_t *n;
 
 	errno = 0;
 
@@ -84,203 +429,126 @@ corestorage_db_save(struct database_handle *db)
 	db_write_time(db, CURRTIME);
 	db_commit_row(db);
 
-	slog(LG_DEBUG, "db_save(): saving myusers");
-
-	MYENTITY_FOREACH_T(ment, &mestate, ENT_USER)
+	// older versions cannot load a database with JSEQ, so only write it when it is needed
+	if (journal_save_active)
 	{
-		mu = user(ment);
-		/* MU <name> <pass> <email> <registered> <lastlogin> <failnum*> <lastfail*>
-		 * <lastfailon*> <flags> <language>
-		 *
-		 *  * failnum, lastfail, and lastfailon are deprecated (moved to metadata)
-		 */
-		char *flags = gflags_tostr(mu_flags, MOWGLI_LIST_LENGTH(&mu->logins) ? mu->flags & ~MU_NOBURSTLOGIN : mu->flags);
-		db_start_row(db, "MU");
-		db_write_word(db, entity(mu)->id);
-		db_write_word(db, entity(mu)->name);
-		db_write_word(db, mu->pass);
-		db_write_word(db, mu->email);
-		db_write_time(db, mu->registered);
-
-		if (MOWGLI_LIST_LENGTH(&mu->logins))
-			db_write_time(db, 0);
-		else
-			db_write_time(db, mu->lastlogin);
-
-		db_write_word(db, flags);
-		db_write_word(db, language_get_name(mu->language));
+		db_start_row(db, "JSEQ");
+		db_write_uint(db, journal_seq);
 		db_commit_row(db);
+	}
 
-		if (atheme_object(mu)->metadata)
-		{
-			MOWGLI_PATRICIA_FOREACH(md, &state, atheme_object(mu)->metadata)
-			{
-				db_start_row(db, "MDU");
-				db_write_word(db, entity(mu)->name);
-				db_write_word(db, md->name);
-				db_write_str(db, md->value);
-				db_commit_row(db);
-			}
-		}
-
-		MOWGLI_ITER_FOREACH(tn, mu->memos.head)
-		{
-			struct mymemo *mz = (struct mymemo *)tn->data;
-
-			db_start_row(db, "ME");
-			db_write_word(db, entity(mu)->name);
-			db_write_word(db, mz->sender);
-			db_write_time(db, mz->sent);
-			db_write_uint(db, mz->status);
-			db_write_str(db, mz->text);
-			db_commit_row(db);
-		}
+	if (sliced)
+	{
+		db_start_row(db, "FUZZY");
+		db_commit_row(db);
+	}
+}
 
-		MOWGLI_ITER_FOREACH(tn, mu->memo_ignores.head)
-		{
-			db_start_row(db, "MI");
-			db_write_word(db, entity(mu)->name);
-			db_write_word(db, (char *)tn->data);
-			db_commit_row(db);
-		}
+static void
+corestorage_write_memos(struct database_handle *db, struct myuser *mu, const char *name)
+{
+	mowgli_node_t *tn;
+	char buf[MEMOLEN + 1];
 
-		MOWGLI_ITER_FOREACH(tn, mu->access_list.head)
-		{
-			db_start_row(db, "AC");
-			db_write_word(db, entity(mu)->name);
-			db_write_word(db, (char *)tn->data);
-			db_commit_row(db);
-		}
+	MOWGLI_ITER_FOREACH(tn, mu->memos.head)
+	{
+		struct mymemo *mz = (struct mymemo *)tn->data;
+		const char *const text = mymemo_text(mz, buf);
 
-		MOWGLI_ITER_FOREACH(tn, mu->nicks.head)
+		if (text == NULL)
 		{
-			struct mynick *mn = tn->data;
-
-			db_start_row(db, "MN");
-			db_write_word(db, entity(mu)->name);
-			db_write_word(db, mn->nick);
-			db_write_time(db, mn->registered);
-
-			struct user *u = user_find_named(mn->nick);
-			if (u != NULL && u->myuser == mn->owner)
-				db_write_time(db, 0);
-			else
-				db_write_time(db, mn->lastseen);
-
-			db_commit_row(db);
+			slog(LG_ERROR, "db_save(): cannot write a memo to %s; its text could not be read", name);
+			continue;
 		}
 
-		MOWGLI_ITER_FOREACH(tn, mu->cert_fingerprints.head)
-		{
-			struct mycertfp *mcfp = tn->data;
+		db_start_row(db, "ME");
+		db_write_word(db, name);
+		db_write_word(db, mz->sender);
+		db_write_time(db, mz->sent);
+		db_write_uint(db, mz->status);
+		db_write_str(db, text);
+		db_commit_row(db);
+	}
 
-			db_start_row(db, "MCFP");
-			db_write_word(db, entity(mu)->name);
-			db_write_word(db, mcfp->certfp);
-			db_commit_row(db);
-		}
+	MOWGLI_ITER_FOREACH(tn, myuser_ext_peek(mu)->memo_ignores.head)
+	{
+		db_start_row(db, "MI");
+		db_write_word(db, name);
+		db_write_word(db, (char *)tn->data);
+		db_commit_row(db);
 	}
+}
 
-	// XXX: groupserv hack.  remove when we have proper dependency resolution. --nenolod
-	hook_call_db_write_pre_ca(db);
+static void
+corestorage_write_account(struct database_handle *db, struct myuser *mu)
+{
+	const char *const name = corestorage_entity_name(db, entity(mu));
+	mowgli_node_t *tn;
 
-	slog(LG_DEBUG, "db_save(): saving mychans");
+	corestorage_write_mu(db, "MU", mu);
+	corestorage_write_memos(db, mu, name);
 
-	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
+	MOWGLI_ITER_FOREACH(tn, myuser_ext_peek(mu)->access_list.head)
 	{
-		mowgli_patricia_iteration_state_t state2;
+		db_start_row(db, "AC");
+		db_write_word(db, name);
+		db_write_word(db, (char *)tn->data);
+		db_commit_row(db);
+	}
 
-		char *flags = gflags_tostr(mc_flags, mc->flags);
+	MOWGLI_ITER_FOREACH(tn, mu->nicks.head)
+		corestorage_write_mn(db, tn->data);
 
-		// find a founder
-		mu = NULL;
-		MOWGLI_ITER_FOREACH(tn, mc->chanacs.head)
-		{
-			ca = (struct chanacs *)tn->data;
-			if (ca->entity != NULL && ca->level & CA_FOUNDER)
-			{
-				mu = user(ca->entity);
-				break;
-			}
-		}
+	MOWGLI_ITER_FOREACH(tn, myuser_ext_peek(mu)->cert_fingerprints.head)
+	{
+		struct mycertfp *mcfp = tn->data;
 
-		// MC <name> <registered> <used> <flags> <mlock_on> <mlock_off> <mlock_limit> [mlock_key]
-		db_start_row(db, "MC");
-		db_write_word(db, mc->name);
-		db_write_time(db, mc->registered);
-		db_write_time(db, mc->used);
-		db_write_word(db, flags);
-		db_write_uint(db, mc->mlock_on);
-		db_write_uint(db, mc->mlock_off);
-		db_write_uint(db, mc->mlock_limit);
-		db_write_word(db, mc->mlock_key ? mc->mlock_key : "");
+		db_start_row(db, "MCFP");
+		db_write_word(db, name);
+		db_write_word(db, mcfp->certfp);
 		db_commit_row(db);
+	}
+}
 
-		MOWGLI_ITER_FOREACH(tn, mc->chanacs.head)
-		{
-			struct myentity *setter = NULL;
-			ca = (struct chanacs *)tn->data;
-
-			db_start_row(db, "CA");
-			db_write_word(db, ca->mychan->name);
-			db_write_word(db, ca->entity ? ca->entity->name : ca->host);
-			db_write_word(db, bitmask_to_flags(ca->level));
-			db_write_time(db, ca->tmodified);
+static void
+corestorage_write_channel(struct database_handle *db, struct mychan *mc)
+{
+	mowgli_node_t *tn;
 
-			if (*ca->setter_uid != '\0' && (setter = myentity_find_uid(ca->setter_uid)))
-				db_write_word(db, setter->name);
-			else
-				db_write_word(db, "*");
+	corestorage_write_mc(db, "MC", mc);
 
-			db_commit_row(db);
+	MOWGLI_ITER_FOREACH(tn, mc->chanacs.head)
+	{
+		struct chanacs *const ca = tn->data;
 
-			if (atheme_object(ca)->metadata)
-			{
-				MOWGLI_PATRICIA_FOREACH(md, &state2, atheme_object(ca)->metadata)
-				{
-					db_start_row(db, "MDA");
-					db_write_word(db, ca->mychan->name);
-					db_write_word(db, (ca->entity) ? ca->entity->name : ca->host);
-					db_write_word(db, md->name);
-					db_write_str(db, md->value);
-					db_commit_row(db);
-				}
-			}
-		}
+		// accounts registered since a sliced save began are not in it
+		if (db == slice_db && isuser(ca->entity) && ! corestorage_ptrset_find(&slice_accounts, ca->entity))
+			continue;
 
-		if (atheme_object(mc)->metadata)
-		{
-			MOWGLI_PATRICIA_FOREACH(md, &state2, atheme_object(mc)->metadata)
-			{
-				db_start_row(db, "MDC");
-				db_write_word(db, mc->name);
-				db_write_word(db, md->name);
-				db_write_str(db, md->value);
-				db_commit_row(db);
-			}
-		}
+		corestorage_write_ca(db, "CA", ca);
 	}
 
+	corestorage_write_metadata(db, "MDC", mc, mc->name, NULL);
+}
+
+// everything after the channels
+static void
+corestorage_write_tail(struct database_handle *db)
+{
+	struct myuser_name *mun;
+	struct svsignore *svsignore;
+	struct soper *soper;
+	mowgli_node_t *n;
+	mowgli_patricia_iteration_state_t state;
+
 	// Old names
 	MOWGLI_PATRICIA_FOREACH(mun, &state, oldnameslist)
 	{
-		mowgli_patricia_iteration_state_t state2;
-
 		db_start_row(db, "NAM");
 		db_write_word(db, mun->name);
 		db_commit_row(db);
 
-		if (atheme_object(mun)->metadata)
-		{
-			MOWGLI_PATRICIA_FOREACH(md, &state2, atheme_object(mun)->metadata)
-			{
-				db_start_row(db, "MDN");
-				db_write_word(db, mun->name);
-				db_write_word(db, md->name);
-				db_write_str(db, md->value);
-				db_commit_row(db);
-			}
-		}
+		corestorage_write_metadata(db, "MDN", mun, mun->name, NULL);
 	}
 
 	// Services ignores
@@ -299,90 +567,986 @@ corestorage_db_save(struct database_handle *db)
 		db_commit_row(db);
 	}
 
-	// Services operators
-	slog(LG_DEBUG, "db_save(): saving sopers");
+	// Services operators
+	slog(LG_DEBUG, "db_save(): saving sopers");
+
+	MOWGLI_ITER_FOREACH(n, soperlist.head)
+	{
+		const char *flags;
+		soper = n->data;
+		flags = gflags_tostr(soper_flags, soper->flags);
+
+		if (soper->flags & SOPER_CONF || soper->myuser == NULL)
+			continue;
+
+		// SO <account> <operclass> <flags> [password]
+		db_start_row(db, "SO");
+		db_write_word(db, entity(soper->myuser)->name);
+		db_write_word(db, soper->classname);
+		db_write_word(db, flags);
+
+		if (soper->password != NULL)
+			db_write_word(db, soper->password);
+
+		db_commit_row(db);
+	}
+
+	slog(LG_DEBUG, "db_save(): saving klines");
+
+	db_start_row(db, "KID");
+	db_write_uint(db, me.kline_id);
+	db_commit_row(db);
+
+	MOWGLI_ITER_FOREACH(n, klnlist.head)
+		corestorage_write_kl(db, n->data);
+
+	slog(LG_DEBUG, "db_save(): saving xlines");
+
+	db_start_row(db, "XID");
+	db_write_uint(db, me.xline_id);
+	db_commit_row(db);
+
+	MOWGLI_ITER_FOREACH(n, xlnlist.head)
+		corestorage_write_xl(db, n->data);
+
+	db_start_row(db, "QID");
+	db_write_uint(db, me.qline_id);
+	db_commit_row(db);
+
+	MOWGLI_ITER_FOREACH(n, qlnlist.head)
+		corestorage_write_ql(db, n->data);
+}
+
+// write atheme.db (core fields)
+static void
+corestorage_db_save(struct database_handle *db)
+{
+	struct myentity *ment;
+	struct mychan *mc;
+	mowgli_patricia_iteration_state_t state;
+	struct myentity_iteration_state mestate;
+
+	corestorage_write_header(db, false);
+
+	slog(LG_DEBUG, "db_save(): saving myusers");
+
+	MYENTITY_FOREACH_T(ment, &mestate, ENT_USER)
+		corestorage_write_account(db, user(ment));
+
+	// XXX: groupserv hack.  remove when we have proper dependency resolution. --nenolod
+	hook_call_db_write_pre_ca(db);
+
+	slog(LG_DEBUG, "db_save(): saving mychans");
+
+	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
+		corestorage_write_channel(db, mc);
+
+	corestorage_write_tail(db);
+}
+
+/* A write-only handle that keeps the rows written to it, to be written to
+ * a real database later by corestorage_recorder_replay().
+ */
+struct corestorage_recording
+{
+	char *                  buf;
+	size_t                  len;
+	size_t                  size;
+};
+
+static void
+corestorage_recorder_put(struct database_handle *const db, const char op, const void *const data, const size_t len)
+{
+	struct corestorage_recording *const rec = db->priv;
+
+	if (rec->len + len + 1 > rec->size)
+	{
+		while (rec->len + len + 1 > rec->size)
+			rec->size = rec->size ? rec->size * 2 : 4096;
+
+		rec->buf = srealloc(rec->buf, rec->size);
+	}
+
+	rec->buf[rec->len++] = op;
+
+	if (len)
+		(void) memcpy(rec->buf + rec->len, data, len);
+
+	rec->len += len;
+}
+
+static bool
+corestorage_recorder_put_str(struct database_handle *const db, const char op, const char *const str)
+{
+	if (str == NULL)
+		corestorage_recorder_put(db, 'N', NULL, 0);
+	else
+		corestorage_recorder_put(db, op, str, strlen(str) + 1);
+
+	return true;
+}
+
+static bool
+corestorage_recorder_start_row(struct database_handle *db, const char *type)
+{
+	return corestorage_recorder_put_str(db, 'R', type);
+}
+
+static bool
+corestorage_recorder_write_word(struct database_handle *db, const char *word)
+{
+	return corestorage_recorder_put_str(db, 'W', word);
+}
+
+static bool
+corestorage_recorder_write_str(struct database_handle *db, const char *str)
+{
+	return corestorage_recorder_put_str(db, 'S', str);
+}
+
+static bool
+corestorage_recorder_write_int(struct database_handle *db, int num)
+{
+	corestorage_recorder_put(db, 'I', &num, sizeof num);
+	return true;
+}
+
+static bool
+corestorage_recorder_write_uint(struct database_handle *db, unsigned int num)
+{
+	corestorage_recorder_put(db, 'U', &num, sizeof num);
+	return true;
+}
+
+static bool
+corestorage_recorder_write_time(struct database_handle *db, time_t time)
+{
+	corestorage_recorder_put(db, 'T', &time, sizeof time);
+	return true;
+}
+
+static bool
+corestorage_recorder_commit_row(struct database_handle *db)
+{
+	corestorage_recorder_put(db, 'C', NULL, 0);
+	return true;
+}
+
+static const struct database_vtable corestorage_recorder_vt = {
+	.name           = "recorder",
+
+	.start_row      = &corestorage_recorder_start_row,
+	.write_word     = &corestorage_recorder_write_word,
+	.write_str      = &corestorage_recorder_write_str,
+	.write_int      = &corestorage_recorder_write_int,
+	.write_uint     = &corestorage_recorder_write_uint,
+	.write_time     = &corestorage_recorder_write_time,
+	.commit_row     = &corestorage_recorder_commit_row,
+};
+
+static struct database_handle *
+corestorage_recorder_create(void)
+{
+	struct database_handle *const rec = smalloc(sizeof *rec);
+
+	rec->priv = smalloc(sizeof(struct corestorage_recording));
+	rec->vt = &corestorage_recorder_vt;
+	rec->txn = DB_WRITE;
+
+	return rec;
+}
+
+static void
+corestorage_recorder_replay(const struct database_handle *const rec, struct database_handle *const db)
+{
+	const struct corestorage_recording *const data = rec->priv;
+	const char *pos = data->buf;
+	const char *const end = data->buf + data->len;
+
+	while (pos < end)
+	{
+		const char op = *pos++;
+		const char *const arg = pos;
+		int num;
+		unsigned int unum;
+		time_t ts;
+
+		switch (op)
+		{
+			case 'R':
+			case 'W':
+			case 'S':
+				pos += strlen(arg) + 1;
+
+				if (op == 'R')
+					(void) db_start_row(db, arg);
+				else if (op == 'W')
+					(void) db_write_word(db, arg);
+				else
+					(void) db_write_str(db, arg);
+
+				break;
+
+			case 'N':
+				(void) db_write_word(db, NULL);
+				break;
+
+			case 'I':
+				(void) memcpy(&num, arg, sizeof num);
+				pos += sizeof num;
+				(void) db_write_int(db, num);
+				break;
+
+			case 'U':
+				(void) memcpy(&unum, arg, sizeof unum);
+				pos += sizeof unum;
+				(void) db_write_uint(db, unum);
+				break;
+
+			case 'T':
+				(void) memcpy(&ts, arg, sizeof ts);
+				pos += sizeof ts;
+				(void) db_write_time(db, ts);
+				break;
+
+			case 'C':
+				(void) db_commit_row(db);
+				break;
+		}
+	}
+}
+
+static void
+corestorage_recorder_destroy(struct database_handle *const rec)
+{
+	struct corestorage_recording *const data = rec->priv;
+
+	sfree(data->buf);
+	sfree(data);
+	sfree(rec);
+}
+
+// Writes some of a sliced save; with bounded, stops once db_save_slice milliseconds have passed
+static void
+corestorage_slice_run(const bool bounded)
+{
+	struct timespec begin, now;
+	void *obj;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	while (slice_phase != SLICE_DONE)
+	{
+		if (slice_phase == SLICE_ACCOUNTS)
+		{
+			if ((obj = corestorage_ptrset_next(&slice_accounts)) != NULL)
+				corestorage_write_account(slice_db, obj);
+			else
+			{
+				corestorage_recorder_replay(slice_pre_ca, slice_db);
+				slice_phase = SLICE_CHANNELS;
+				continue;
+			}
+		}
+		else if ((obj = corestorage_ptrset_next(&slice_channels)) != NULL)
+			corestorage_write_channel(slice_db, obj);
+		else
+		{
+			corestorage_recorder_replay(slice_tail, slice_db);
+			slice_phase = SLICE_DONE;
+			break;
+		}
+
+		if (! bounded)
+			continue;
+
+		(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+		if ((now.tv_sec - begin.tv_sec) * 1000 + (now.tv_nsec - begin.tv_nsec) / 1000000 >=
+		    (long) config_options.db_save_slice)
+			break;
+	}
+}
+
+static void
+corestorage_slice_finish(void)
+{
+	struct database_handle *const db = slice_db;
+	mowgli_node_t *n, *tn;
+
+	if (slice_timer != NULL)
+	{
+		mowgli_timer_destroy(base_eventloop, slice_timer);
+		slice_timer = NULL;
+	}
+
+	corestorage_slice_run(false);
+
+	corestorage_ptrset_free(&slice_accounts);
+	corestorage_ptrset_free(&slice_channels);
+	corestorage_recorder_destroy(slice_pre_ca);
+	corestorage_recorder_destroy(slice_tail);
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, slice_renames.head)
+	{
+		struct corestorage_rename *const r = n->data;
+
+		mowgli_node_delete(&r->node, &slice_renames);
+		sfree(r->name);
+		sfree(r);
+	}
+
+	slice_db = NULL;
+	save_written = false;
+	db_close(db);
+
+	slog(LG_DEBUG, "db_save(): finished sliced DB write");
+
+	if (save_written && slice_follows)
+		db_mark_saved();
+}
+
+static void
+corestorage_slice_cb(void ATHEME_VATTR_UNUSED *const restrict unused)
+{
+	slice_timer = NULL;
+
+	corestorage_slice_run(true);
+
+	if (slice_phase != SLICE_DONE)
+	{
+		slice_timer = mowgli_timer_add_once(base_eventloop, "corestorage_slice", &corestorage_slice_cb, NULL, 0);
+		return;
+	}
+
+	corestorage_slice_finish();
+
+	// a save was asked for while this one was being written
+	if (slice_again)
+	{
+		slice_again = false;
+		db_save(NULL, DB_SAVE_BG_IMPORTANT);
+	}
+}
+
+// whether the save about to be written can be sliced
+static bool
+corestorage_slice_usable(void)
+{
+	static bool warned = false;
+
+	if (journal_save_active)
+		return true;
+
+	if (! warned)
+	{
+		slog(LG_ERROR, "db_save(): general::db_save_slice needs general::db_journal and can only write the "
+		               "database services loaded; writing this save in one piece instead");
+		warned = true;
+	}
+
+	return false;
+}
+
+static void
+corestorage_slice_begin(const char *const filename, const bool follows)
+{
+	struct myentity *ment;
+	struct mychan *mc;
+	mowgli_patricia_iteration_state_t state;
+	struct myentity_iteration_state mestate;
+
+	if (! (slice_db = db_open(filename, DB_WRITE)))
+	{
+		slog(LG_ERROR, "db_save(): db_open() failed, aborting save");
+		return;
+	}
+
+	corestorage_write_header(slice_db, true);
+
+	MYENTITY_FOREACH_T(ment, &mestate, ENT_USER)
+		corestorage_ptrset_add(&slice_accounts, ment);
+
+	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
+		corestorage_ptrset_add(&slice_channels, mc);
+
+	// XXX: groupserv hack.  remove when we have proper dependency resolution. --nenolod
+	slice_pre_ca = corestorage_recorder_create();
+	hook_call_db_write_pre_ca(slice_pre_ca);
+
+	slice_tail = corestorage_recorder_create();
+	corestorage_write_tail(slice_tail);
+	hook_call_db_write(slice_tail);
+
+	slice_follows = follows;
+	slice_phase = SLICE_ACCOUNTS;
+	slice_timer = mowgli_timer_add_once(base_eventloop, "corestorage_slice", &corestorage_slice_cb, NULL, 0);
+
+	slog(LG_DEBUG, "db_save(): started sliced DB write of %zu accounts and %zu channels",
+	     slice_accounts.used, slice_channels.used);
+}
+
+// keep a sliced save in step with accounts and channels that change under it
+static void
+corestorage_slice_h_db_change(struct hook_db_change *const restrict hdata)
+{
+	struct corestorage_rename *r;
+	struct myuser *mu;
+
+	if (slice_db == NULL)
+		return;
+
+	switch (hdata->type)
+	{
+		case DB_RECORD_MYUSER:
+			mu = hdata->object;
+
+			if (hdata->deleted)
+			{
+				corestorage_ptrset_remove(&slice_accounts, mu);
+
+				if ((r = corestorage_rename_find(mu)) != NULL)
+				{
+					mowgli_node_delete(&r->node, &slice_renames);
+					sfree(r->name);
+					sfree(r);
+				}
+			}
+			else if (hdata->key != NULL && corestorage_ptrset_find(&slice_accounts, mu) &&
+			         ! corestorage_rename_find(mu))
+			{
+				// a rename; the key is the old name
+				r = smalloc(sizeof *r);
+				r->mu = mu;
+				r->name = sstrdup(hdata->key);
+				mowgli_node_add(r, &r->node, &slice_renames);
+			}
+
+			break;
+
+		case DB_RECORD_MYCHAN:
+			if (hdata->deleted)
+				corestorage_ptrset_remove(&slice_channels, hdata->object);
+
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+corestorage_journal_name(char *const restrict buf, const size_t len, const unsigned int seq)
+{
+	(void) snprintf(buf, len, "%s.journal.%u", journal_db, seq);
+}
+
+// whether a save to filename (NULL for the default database) is one the journals belong to
+static bool
+corestorage_journal_follows(const char *const filename)
+{
+	return journal_db != NULL && strcmp(filename != NULL ? filename : "services.db", journal_db) == 0;
+}
+
+static void
+corestorage_journal_path(char *const restrict buf, const size_t len, const unsigned int seq)
+{
+	char name[BUFSIZE];
+
+	corestorage_journal_name(name, sizeof name, seq);
+	(void) snprintf(buf, len, "%s/%s", datadir, name);
+}
+
+// start an empty journal, replacing any stale one of the same number
+static bool
+corestorage_journal_create(const unsigned int seq)
+{
+	struct database_handle *db;
+	char name[BUFSIZE], path[BUFSIZE];
+
+	corestorage_journal_name(name, sizeof name, seq);
+	corestorage_journal_path(path, sizeof path, seq);
+
+	if (unlink(path) < 0 && errno != ENOENT)
+		slog(LG_ERROR, "corestorage: cannot remove stale journal '%s': %s", path, strerror(errno));
+
+	if (! (db = db_open(name, DB_APPEND)))
+		return false;
+
+	db_start_row(db, "DBV");
+	db_write_uint(db, 12);
+	db_commit_row(db);
+
+	db_close(db);
+	return true;
+}
+
+static inline size_t
+corestorage_journal_index_slot(const enum db_record_type type, const void *const object, const size_t size)
+{
+	uint64_t h = (uint64_t) (uintptr_t) object * UINT64_C(0x9E3779B97F4A7C15);
+
+	h ^= (uint64_t) type + UINT64_C(0x7F4A7C159E3779B9) + (h << 6) + (h >> 2);
+	h ^= h >> 29;
+	h *= UINT64_C(0xBF58476D1CE4E5B9);
+	h ^= h >> 32;
+
+	return (size_t) h & (size - 1U);
+}
+
+static void
+corestorage_journal_index_resize(const size_t size)
+{
+	struct journal_entry **const table = smalloc(size * sizeof *table);
+
+	for (size_t i = 0; i < journal_index_size; i++)
+	{
+		struct journal_entry *je = journal_index[i];
+
+		while (je != NULL)
+		{
+			struct journal_entry *const next = je->hnext;
+			const size_t slot = corestorage_journal_index_slot(je->type, je->object, size);
+
+			je->hnext = table[slot];
+			table[slot] = je;
+			je = next;
+		}
+	}
+
+	sfree(journal_index);
+	journal_index = table;
+	journal_index_size = size;
+}
+
+static void
+corestorage_journal_index_add(struct journal_entry *const je)
+{
+	if (journal_index_count >= journal_index_size)
+		corestorage_journal_index_resize(journal_index_size ? (journal_index_size * 2U) : JOURNAL_INDEX_MINSIZE);
+
+	const size_t slot = corestorage_journal_index_slot(je->type, je->object, journal_index_size);
+
+	je->hnext = journal_index[slot];
+	journal_index[slot] = je;
+	journal_index_count++;
+}
+
+static void
+corestorage_journal_index_delete(struct journal_entry *const je)
+{
+	struct journal_entry **pje = &journal_index[corestorage_journal_index_slot(je->type, je->object,
+	                                                                           journal_index_size)];
+
+	for (; *pje != NULL; pje = &(*pje)->hnext)
+	{
+		if (*pje != je)
+			continue;
+
+		*pje = je->hnext;
+		je->hnext = NULL;
+		journal_index_count--;
+		return;
+	}
+
+	slog(LG_DEBUG, "corestorage_journal_index_delete(): entry of type %d for %p was not indexed",
+	     (int) je->type, je->object);
+}
+
+static void
+corestorage_journal_free(struct journal_entry *const je)
+{
+	mowgli_node_delete(&je->node, &journal_queue);
+
+	if (je->object != NULL)
+		corestorage_journal_index_delete(je);
+
+	sfree(je->key);
+	sfree(je->words[0]);
+	sfree(je->words[1]);
+	sfree(je->words[2]);
+	sfree(je);
+}
+
+static struct journal_entry *
+corestorage_journal_find(const enum db_record_type type, const void *const object, const char *const key)
+{
+	if (! journal_index_count)
+		return NULL;
+
+	struct journal_entry *je = journal_index[corestorage_journal_index_slot(type, object, journal_index_size)];
+
+	for (; je != NULL; je = je->hnext)
+	{
+		if (je->object != object || je->type != type)
+			continue;
+
+		if (key == NULL || (je->key != NULL && strcasecmp(je->key, key) == 0))
+			return je;
+	}
+
+	return NULL;
+}
+
+// an object about to be destroyed must not be looked at when the queue is flushed
+static void
+corestorage_journal_purge(const void *const object)
+{
+	if (! journal_index_count)
+		return;
+
+	// DB_RECORD_MEMOS is the last record type
+	for (unsigned int type = DB_RECORD_MYUSER; type <= DB_RECORD_MEMOS; type++)
+	{
+		const size_t slot = corestorage_journal_index_slot(type, object, journal_index_size);
+		struct journal_entry *je = journal_index[slot];
+
+		while (je != NULL)
+		{
+			struct journal_entry *const next = je->hnext;
+
+			if (je->object == object && je->type == (enum db_record_type) type)
+				corestorage_journal_free(je);
+
+			je = next;
+		}
+	}
+}
+
+// queue a change to an object, written out as the object is at flush time
+static void
+corestorage_journal_queue_object(const enum db_record_type type, void *const object, const char *const key)
+{
+	struct journal_entry *const je = smalloc(sizeof *je);
+
+	je->type = type;
+	je->object = object;
+	je->key = key ? sstrdup(key) : NULL;
+
+	mowgli_node_add(je, &je->node, &journal_queue);
+	corestorage_journal_index_add(je);
+}
+
+static void
+corestorage_journal_queue_row(const char *const row, const char *const w0, const char *const w1, const char *const w2)
+{
+	struct journal_entry *const je = smalloc(sizeof *je);
+
+	je->row = row;
+	je->words[0] = w0 ? sstrdup(w0) : NULL;
+	je->words[1] = w1 ? sstrdup(w1) : NULL;
+	je->words[2] = w2 ? sstrdup(w2) : NULL;
+
+	mowgli_node_add(je, &je->node, &journal_queue);
+}
+
+static void
+corestorage_journal_write_metadata(struct database_handle *db, const struct journal_entry *const je)
+{
+	const struct atheme_object *const obj = je->object;
+	const struct metadata *const md = metadata_find(je->object, je->key);
+	const char *name, *mask = NULL;
+	const char *type, *deltype;
+
+	enum db_record_type owner;
+
+	switch (obj->type)
+	{
+		case ATHEME_OBJECT_MYUSER:
+			owner = DB_RECORD_MYUSER;
+			name = entity((struct myuser *) je->object)->name;
+			type = "MDU";
+			deltype = "JDMDU";
+			break;
+
+		case ATHEME_OBJECT_MYCHAN:
+			owner = DB_RECORD_MYCHAN;
+			name = ((struct mychan *) je->object)->name;
+			type = "MDC";
+			deltype = "JDMDC";
+			break;
+
+		case ATHEME_OBJECT_CHANACS:
+		{
+			const struct chanacs *const ca = je->object;
+
+			owner = DB_RECORD_CHANACS;
+			name = ca->mychan->name;
+			mask = ca->entity ? ca->entity->name : ca->host;
+			type = "MDA";
+			deltype = "JDMDA";
+			break;
+		}
+
+		default:
+			return;
+	}
+
+	// a queued change to the owner writes out all of its metadata
+	if (md != NULL && corestorage_journal_find(owner, je->object, NULL))
+		return;
+
+	db_start_row(db, md ? type : deltype);
+	db_write_word(db, name);
+
+	if (mask != NULL)
+		db_write_word(db, mask);
+
+	db_write_word(db, je->key);
+
+	if (md != NULL)
+		db_write_str(db, md->value);
+
+	db_commit_row(db);
+}
+
+static void
+corestorage_journal_write(struct database_handle *db, const struct journal_entry *const je)
+{
+	if (je->row != NULL)
+	{
+		db_start_row(db, je->row);
+
+		for (size_t i = 0; i < ARRAY_SIZE(je->words) && je->words[i] != NULL; i++)
+			db_write_word(db, je->words[i]);
+
+		db_commit_row(db);
+		return;
+	}
+
+	switch (je->type)
+	{
+		case DB_RECORD_MYUSER:
+			corestorage_write_mu(db, "JMU", je->object);
+			break;
+
+		case DB_RECORD_MYNICK:
+			corestorage_write_mn(db, je->object);
+			break;
+
+		case DB_RECORD_MYCHAN:
+			corestorage_write_mc(db, "MC", je->object);
+			corestorage_write_metadata(db, "MDC", je->object, ((struct mychan *) je->object)->name, NULL);
+			break;
+
+		case DB_RECORD_CHANACS:
+			corestorage_write_ca(db, "JCA", je->object);
+			break;
+
+		case DB_RECORD_METADATA:
+			corestorage_journal_write_metadata(db, je);
+			break;
+
+		case DB_RECORD_KLINE:
+			db_start_row(db, "KID");
+			db_write_uint(db, me.kline_id);
+			db_commit_row(db);
+
+			corestorage_write_kl(db, je->object);
+			break;
+
+		case DB_RECORD_XLINE:
+			corestorage_write_xl(db, je->object);
+			break;
+
+		case DB_RECORD_QLINE:
+			corestorage_write_ql(db, je->object);
+			break;
+
+		case DB_RECORD_MEMOS:
+			db_start_row(db, "JDME");
+			db_write_word(db, entity((struct myuser *) je->object)->name);
+			db_commit_row(db);
+
+			corestorage_write_memos(db, je->object, entity((struct myuser *) je->object)->name);
+			break;
+	}
+}
+
+static void
+corestorage_journal_flush(void)
+{
+	struct database_handle *db;
+	mowgli_node_t *n, *tn;
+	char name[BUFSIZE];
+
+	if (! MOWGLI_LIST_LENGTH(&journal_queue))
+		return;
+
+	corestorage_journal_name(name, sizeof name, journal_seq);
+
+	if ((db = db_open(name, DB_APPEND)) != NULL)
+	{
+		MOWGLI_ITER_FOREACH(n, journal_queue.head)
+			corestorage_journal_write(db, n->data);
+
+		// replayed accounts keep their UIDs, so new ones must not reuse them
+		db_start_row(db, "LUID");
+		db_write_word(db, myentity_get_last_uid());
+		db_commit_row(db);
+
+		db_close(db);
+	}
+	else
+		slog(LG_ERROR, "corestorage: %zu changes are not journalled and will be lost if services stop "
+		               "before the next database save", MOWGLI_LIST_LENGTH(&journal_queue));
+
+	journal_records += MOWGLI_LIST_LENGTH(&journal_queue);
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, journal_queue.head)
+		corestorage_journal_free(n->data);
+
+	// give back the memory a mass change took, now that the index is empty
+	if (journal_index_size > JOURNAL_INDEX_MINSIZE)
+	{
+		sfree(journal_index);
+		journal_index = NULL;
+		journal_index_size = 0;
+	}
+}
+
+static void
+corestorage_journal_flush_cb(void ATHEME_VATTR_UNUSED *const restrict unused)
+{
+	journal_timer = NULL;
+
+	corestorage_journal_flush();
+
+	// fold a long journal into a new snapshot
+	if (config_options.db_journal_compact && journal_records >= config_options.db_journal_compact)
+	{
+		slog(LG_DEBUG, "corestorage: journal has %u records, compacting it", journal_records);
+		db_save(NULL, DB_SAVE_BG_REGULAR);
+	}
+}
+
+static void
+corestorage_h_db_change(struct hook_db_change *const restrict hdata)
+{
+	char buf[BUFSIZE];
+
+	// those times are written by full saves only
+	if (! journal_active || hdata->touched)
+		return;
+
+	if (hdata->deleted)
+	{
+		corestorage_journal_purge(hdata->object);
+
+		switch (hdata->type)
+		{
+			case DB_RECORD_MYUSER:
+				corestorage_journal_queue_row("JDMU", entity((struct myuser *) hdata->object)->name, NULL, NULL);
+				break;
+
+			case DB_RECORD_MYNICK:
+				corestorage_journal_queue_row("JDMN", ((struct mynick *) hdata->object)->nick, NULL, NULL);
+				break;
+
+			case DB_RECORD_MYCHAN:
+				corestorage_journal_queue_row("JDMC", ((struct mychan *) hdata->object)->name, NULL, NULL);
+				break;
+
+			case DB_RECORD_CHANACS:
+			{
+				const struct chanacs *const ca = hdata->object;
+
+				corestorage_journal_queue_row("JDCA", ca->mychan->name, ca->entity ? ca->entity->name : ca->host, NULL);
+				break;
+			}
+
+			case DB_RECORD_KLINE:
+				(void) snprintf(buf, sizeof buf, "%lu", ((struct kline *) hdata->object)->number);
+				corestorage_journal_queue_row("JDKL", buf, NULL, NULL);
+				break;
+
+			case DB_RECORD_XLINE:
+				corestorage_journal_queue_row("JDXL", ((struct xline *) hdata->object)->realname, NULL, NULL);
+				break;
 
-	MOWGLI_ITER_FOREACH(n, soperlist.head)
-	{
-		const char *flags;
-		soper = n->data;
-		flags = gflags_tostr(soper_flags, soper->flags);
+			case DB_RECORD_QLINE:
+				corestorage_journal_queue_row("JDQL", ((struct qline *) hdata->object)->mask, NULL, NULL);
+				break;
 
-		if (soper->flags & SOPER_CONF || soper->myuser == NULL)
-			continue;
+			case DB_RECORD_METADATA:
+			case DB_RECORD_MEMOS:
+				break;
+		}
+	}
+	else if (hdata->type == DB_RECORD_METADATA)
+	{
+		const enum atheme_object_type otype = atheme_object(hdata->object)->type;
 
-		// SO <account> <operclass> <flags> [password]
-		db_start_row(db, "SO");
-		db_write_word(db, entity(soper->myuser)->name);
-		db_write_word(db, soper->classname);
-		db_write_word(db, flags);
+		if (otype != ATHEME_OBJECT_MYUSER && otype != ATHEME_OBJECT_MYCHAN && otype != ATHEME_OBJECT_CHANACS)
+			return;
 
-		if (soper->password != NULL)
-			db_write_word(db, soper->password);
+		if (! corestorage_journal_find(DB_RECORD_METADATA, hdata->object, hdata->key))
+			corestorage_journal_queue_object(DB_RECORD_METADATA, hdata->object, hdata->key);
+	}
+	else
+	{
+		// renamed account: the queued change must come after the rename
+		if (hdata->type == DB_RECORD_MYUSER && hdata->key != NULL)
+		{
+			corestorage_journal_purge(hdata->object);
+			corestorage_journal_queue_row("JRMU", hdata->key, entity((struct myuser *) hdata->object)->name, NULL);
+		}
 
-		db_commit_row(db);
+		if (! corestorage_journal_find(hdata->type, hdata->object, NULL))
+			corestorage_journal_queue_object(hdata->type, hdata->object, NULL);
 	}
 
-	slog(LG_DEBUG, "db_save(): saving klines");
+	// everything changed by one event loop iteration goes out in one write
+	if (! journal_timer)
+		journal_timer = mowgli_timer_add_once(base_eventloop, "corestorage_journal_flush",
+		                                      &corestorage_journal_flush_cb, NULL, 0);
+}
 
-	db_start_row(db, "KID");
-	db_write_uint(db, me.kline_id);
-	db_commit_row(db);
+/* Called before every save of services.db: whatever is still queued goes
+ * into the old journal, which the snapshot about to be written supersedes.
+ */
+static void
+corestorage_journal_rotate(void)
+{
+	corestorage_journal_flush();
 
-	MOWGLI_ITER_FOREACH(n, klnlist.head)
+	journal_seq++;
+	journal_records = 0;
+	journal_compact_pending = true;
+	journal_active = config_options.db_journal && ! readonly && journal_db != NULL;
+
+	if (journal_active && ! corestorage_journal_create(journal_seq))
 	{
-		k = (struct kline *)n->data;
-
-		// KL <user> <host> <duration> <settime> <setby> <reason>
-		db_start_row(db, "KL");
-		db_write_uint(db, k->number);
-		db_write_word(db, k->user);
-		db_write_word(db, k->host);
-		db_write_uint(db, k->duration);
-		db_write_time(db, k->settime);
-		db_write_word(db, k->setby);
-		db_write_str(db, k->reason);
-		db_commit_row(db);
+		slog(LG_ERROR, "corestorage: cannot start journal %u; changes will only be saved by full database saves",
+		     journal_seq);
+		journal_active = false;
 	}
+}
 
-	slog(LG_DEBUG, "db_save(): saving xlines");
-
-	db_start_row(db, "XID");
-	db_write_uint(db, me.xline_id);
-	db_commit_row(db);
+// the snapshot is on disk; the journals it has absorbed can go
+static void
+corestorage_h_db_saved(void ATHEME_VATTR_UNUSED *const restrict unused)
+{
+	char path[BUFSIZE];
 
-	MOWGLI_ITER_FOREACH(n, xlnlist.head)
-	{
-		x = (struct xline *)n->data;
+	save_written = true;
 
-		// XL <gecos> <duration> <settime> <setby> <reason>
-		db_start_row(db, "XL");
-		db_write_uint(db, x->number);
-		db_write_word(db, x->realname);
-		db_write_uint(db, x->duration);
-		db_write_time(db, x->settime);
-		db_write_word(db, x->setby);
-		db_write_str(db, x->reason);
-		db_commit_row(db);
-	}
+	if (! journal_compact_pending)
+		return;
 
-	db_start_row(db, "QID");
-	db_write_uint(db, me.qline_id);
-	db_commit_row(db);
+	journal_compact_pending = false;
 
-	MOWGLI_ITER_FOREACH(n, qlnlist.head)
+	for (unsigned int seq = journal_seq - 1; seq != 0; seq--)
 	{
-		q = (struct qline *)n->data;
+		corestorage_journal_path(path, sizeof path, seq);
 
-		// QL <mask> <duration> <settime> <setby> <reason>
-		db_start_row(db, "QL");
-		db_write_uint(db, q->number);
-		db_write_word(db, q->mask);
-		db_write_uint(db, q->duration);
-		db_write_time(db, q->settime);
-		db_write_word(db, q->setby);
-		db_write_str(db, q->reason);
-		db_commit_row(db);
+		if (unlink(path) < 0)
+		{
+			if (errno != ENOENT)
+				slog(LG_ERROR, "corestorage: cannot remove journal '%s': %s", path, strerror(errno));
+
+			break;
+		}
 	}
 }
 
@@ -480,18 +1644,21 @@ corestorage_h_mu(struct database_handle *db, const char *type)
 	unsigned int flags = 0;
 	struct myuser *mu;
 
+	// the journal (JMU) also records changes to existing accounts
+	const bool update = (strcmp(type, "JMU") == 0);
+
 	if (dbv >= 10)
 		uid = db_sread_word(db);
 
 	name = db_sread_word(db);
 
-	if (myuser_find(name))
+	if ((mu = myuser_find(name)) != NULL && ! update)
 	{
 		slog(LG_INFO, "db-h-mu: line %u: skipping duplicate account %s", db->line, name);
 		return;
 	}
 
-	if (strict_mode && uid && myuser_find_uid(uid))
+	if (mu == NULL && strict_mode && uid && myuser_find_uid(uid))
 	{
 		slog(LG_INFO, "db-h-mu: line %u: skipping account %s with duplicate UID %s", db->line, name, uid);
 		return;
@@ -510,12 +1677,23 @@ corestorage_h_mu(struct database_handle *db, const char *type)
 	}
 	language = db_read_word(db);
 
+	if (mu == NULL)
+		mu = myuser_add_id(uid, name, pass, email, flags);
+	else
+	{
+		if (strcmp(mu->email, email) != 0)
+			myuser_set_email(mu, email);
+
+		(void) myuser_set_pass(mu, pass);
+		mu->flags = flags;
+	}
 
-	mu = myuser_add_id(uid, name, pass, email, flags);
 	mu->registered = reg;
 
 	if (login != 0)
 		mu->lastlogin = login;
+	else if (update)
+		mu->lastlogin = CURRTIME;
 	else if (db_time != 0)
 		mu->lastlogin = db_time;
 	else
@@ -533,7 +1711,6 @@ corestorage_h_me(struct database_handle *db, const char *type)
 	time_t sent;
 	unsigned int status;
 	struct myuser *mu;
-	struct mymemo *mz;
 
 	dest = db_sread_word(db);
 	src = db_sread_word(db);
@@ -547,16 +1724,7 @@ corestorage_h_me(struct database_handle *db, const char *type)
 		return;
 	}
 
-	mz = smalloc(sizeof *mz);
-	mowgli_strlcpy(mz->sender, src, sizeof mz->sender);
-	mowgli_strlcpy(mz->text, text, sizeof mz->text);
-	mz->sent = sent;
-	mz->status = status;
-
-	if (!(mz->status & MEMO_READ))
-		mu->memoct_new++;
-
-	mowgli_node_add(mz, mowgli_node_create(), &mu->memos);
+	(void) mymemo_add(mu, src, text, sent, status);
 }
 
 static void
@@ -575,7 +1743,7 @@ corestorage_h_mi(struct database_handle *db, const char *type)
 		return;
 	}
 
-	mowgli_node_add(sstrdup(target), mowgli_node_create(), &mu->memo_ignores);
+	mowgli_node_add(sstrdup(target), mowgli_node_create(), &myuser_ext(mu)->memo_ignores);
 }
 
 static void
@@ -714,7 +1882,12 @@ corestorage_h_mc(struct database_handle *db, const char *type)
 	unsigned int flags = 0;
 
 	mowgli_strlcpy(buf, name, sizeof buf);
-	struct mychan *mc = mychan_add(buf);
+
+	// a channel may appear again in the journal after it has been changed
+	struct mychan *mc = mychan_find(buf);
+
+	if (mc == NULL)
+		mc = mychan_add(buf);
 
 	mc->registered = db_sread_time(db);
 	mc->used = db_sread_time(db);
@@ -732,6 +1905,9 @@ corestorage_h_mc(struct database_handle *db, const char *type)
 	mc->mlock_off = db_sread_uint(db);
 	mc->mlock_limit = db_sread_uint(db);
 
+	sfree(mc->mlock_key);
+	mc->mlock_key = NULL;
+
 	if ((key = db_read_word(db)))
 	{
 		mowgli_strlcpy(buf, key, sizeof buf);
@@ -849,6 +2025,13 @@ corestorage_h_mda(struct database_handle *db, const char *type)
 	metadata_add(obj, prop, value);
 }
 
+static void
+corestorage_h_fuzzy(struct database_handle ATHEME_VATTR_UNUSED *const restrict db,
+                    const char ATHEME_VATTR_UNUSED *const restrict type)
+{
+	db_fuzzy = true;
+}
+
 static void
 corestorage_h_ca(struct database_handle *db, const char *type)
 {
@@ -858,6 +2041,10 @@ corestorage_h_ca(struct database_handle *db, const char *type)
 	struct mychan *mc;
 	struct myentity *mt;
 	struct myentity *setter;
+	struct chanacs *ca;
+
+	// the journal (JCA) also records changes to existing entries
+	const bool update = (strcmp(type, "JCA") == 0);
 
 	chan = db_sread_word(db);
 	target = db_sread_word(db);
@@ -876,6 +2063,26 @@ corestorage_h_ca(struct database_handle *db, const char *type)
 	if (dbv >= 9)
 		setter = myentity_find(db_sread_word(db));
 
+	if (update && (mc == NULL || (mt == NULL && !validhostmask(target))))
+	{
+		// e.g. a group made since the last save; those are not journalled
+		slog(LG_INFO, "db-h-ca: line %u: skipping journalled chanacs %s on %s", db->line, target, chan);
+		return;
+	}
+
+	if (update && (ca = chanacs_find_by_mask(mc, target, CA_NONE)) != NULL)
+	{
+		chanacs_set_level(ca, flags & ca_all);
+		ca->tmodified = tmod;
+
+		if (setter != NULL)
+			mowgli_strlcpy(ca->setter_uid, setter->id, sizeof ca->setter_uid);
+		else
+			ca->setter_uid[0] = '\0';
+
+		return;
+	}
+
 	if (mc == NULL)
 	{
 		slog(LG_INFO, "db-h-ca: line %u: chanacs for nonexistent channel %s - exiting to avoid data loss", db->line, chan);
@@ -884,6 +2091,13 @@ corestorage_h_ca(struct database_handle *db, const char *type)
 		exit(EXIT_FAILURE);
 	}
 
+	if (mt == NULL && !validhostmask(target) && db_fuzzy)
+	{
+		// e.g. a group made while a sliced save was being written
+		slog(LG_INFO, "db-h-ca: line %u: skipping chanacs for nonexistent target %s", db->line, target);
+		return;
+	}
+
 	if (mt == NULL && !validhostmask(target))
 	{
 		slog(LG_INFO, "db-h-ca: line %u: chanacs for nonexistent target %s - exiting to avoid data loss", db->line, target);
@@ -952,8 +2166,7 @@ corestorage_h_kl(struct database_handle *db, const char *type)
 	strip(buf);
 
 	k = kline_add_with_id(user, host, buf, duration, setby, id ? id : ++me.kline_id);
-	k->settime = settime;
-	k->expires = k->settime + k->duration;
+	kline_set_expiry(k, settime);
 }
 
 static void
@@ -985,8 +2198,7 @@ corestorage_h_xl(struct database_handle *db, const char *type)
 	strip(buf);
 
 	x = xline_add(realname, buf, duration, setby);
-	x->settime = settime;
-	x->expires = x->settime + x->duration;
+	xline_set_expiry(x, settime);
 
 	if (id)
 		x->number = id;
@@ -1021,24 +2233,230 @@ corestorage_h_ql(struct database_handle *db, const char *type)
 	strip(buf);
 
 	q = qline_add(mask, buf, duration, setby);
-	q->settime = settime;
-	q->expires = q->settime + q->duration;
+	qline_set_expiry(q, settime);
 
 	if (id)
 		q->number = id;
 }
 
+static void
+corestorage_h_jseq(struct database_handle *db, const char *type)
+{
+	journal_seq = db_sread_uint(db);
+	journal_seq_loaded = true;
+}
+
+// the memos and memo ignores of an account follow, replacing the ones it has
+static void
+corestorage_h_jdme(struct database_handle *db, const char *type)
+{
+	struct myuser *mu = myuser_find(db_sread_word(db));
+	mowgli_node_t *n, *tn;
+
+	if (mu == NULL)
+		return;
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->memos.head)
+		mymemo_delete(mu, n);
+
+	if (mu->ext == NULL)
+		return;
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, mu->ext->memo_ignores.head)
+	{
+		sfree(n->data);
+		mowgli_node_delete(n, &mu->ext->memo_ignores);
+		mowgli_node_free(n);
+	}
+}
+
+static void
+corestorage_h_jdmu(struct database_handle *db, const char *type)
+{
+	struct myuser *mu = myuser_find(db_sread_word(db));
+
+	if (mu == NULL)
+		return;
+
+	hook_call_user_drop(mu);
+	atheme_object_dispose(mu);
+}
+
+static void
+corestorage_h_jrmu(struct database_handle *db, const char *type)
+{
+	const char *oldname = db_sread_word(db);
+	const char *newname = db_sread_word(db);
+	struct myuser *mu = myuser_find(oldname);
+
+	if (mu == NULL || myuser_find(newname) != NULL)
+	{
+		slog(LG_DEBUG, "db-h-jrmu: line %u: cannot rename %s to %s", db->line, oldname, newname);
+		return;
+	}
+
+	myuser_rename(mu, newname);
+}
+
+static void
+corestorage_h_jdmn(struct database_handle *db, const char *type)
+{
+	struct mynick *mn = mynick_find(db_sread_word(db));
+
+	if (mn != NULL)
+		atheme_object_unref(mn);
+}
+
+static void
+corestorage_h_jdmc(struct database_handle *db, const char *type)
+{
+	struct mychan *mc = mychan_find(db_sread_word(db));
+
+	if (mc == NULL)
+		return;
+
+	hook_call_channel_drop(mc);
+	atheme_object_unref(mc);
+}
+
+static void
+corestorage_h_jdca(struct database_handle *db, const char *type)
+{
+	struct mychan *mc = mychan_find(db_sread_word(db));
+	const char *target = db_sread_word(db);
+	struct chanacs *ca;
+
+	if (mc != NULL && (ca = chanacs_find_by_mask(mc, target, CA_NONE)) != NULL)
+		atheme_object_unref(ca);
+}
+
+static void
+corestorage_h_jdmd(struct database_handle *db, const char *type)
+{
+	const char *name = db_sread_word(db);
+	void *obj = NULL;
+
+	if (!strcmp(type, "JDMDU"))
+		obj = myuser_find(name);
+	else if (!strcmp(type, "JDMDC"))
+		obj = mychan_find(name);
+	else if (!strcmp(type, "JDMDA"))
+	{
+		struct mychan *mc = mychan_find(name);
+		const char *mask = db_sread_word(db);
+
+		if (mc != NULL)
+			obj = chanacs_find_by_mask(mc, mask, CA_NONE);
+	}
+
+	const char *prop = db_sread_word(db);
+
+	if (obj != NULL)
+		metadata_delete(obj, prop);
+}
+
+static void
+corestorage_h_jdkl(struct database_handle *db, const char *type)
+{
+	struct kline *k = kline_find_num(db_sread_uint(db));
+
+	if (k != NULL)
+		kline_delete(k);
+}
+
+static void
+corestorage_h_jdxl(struct database_handle *db, const char *type)
+{
+	xline_delete(db_sread_word(db));
+}
+
+static void
+corestorage_h_jdql(struct database_handle *db, const char *type)
+{
+	qline_delete(db_sread_word(db));
+}
+
 static void
 corestorage_ignore_row(struct database_handle *db, const char *type)
 {
 	return;
 }
 
+// apply the journals written since the snapshot that has just been loaded
+static void
+corestorage_journal_replay(void)
+{
+	struct database_handle *db;
+	struct stat sb;
+	char name[BUFSIZE], path[BUFSIZE];
+
+	for (;; journal_seq++)
+	{
+		corestorage_journal_name(name, sizeof name, journal_seq);
+		corestorage_journal_path(path, sizeof path, journal_seq);
+
+		if (stat(path, &sb) < 0)
+		{
+			if (errno != ENOENT)
+			{
+				slog(LG_ERROR, "corestorage: cannot read journal '%s': %s", path, strerror(errno));
+				slog(LG_ERROR, "corestorage: exiting to avoid data loss");
+				exit(EXIT_FAILURE);
+			}
+
+			break;
+		}
+
+		if (! (db = db_open(name, DB_READ)))
+			break;
+
+		slog(LG_INFO, "corestorage: replaying journal %s", path);
+
+		db_parse(db);
+		db_close(db);
+	}
+}
+
+/* The database was saved without a journal, so any journals beside it are
+ * from before that save (e.g. made before a downgrade) and must not be
+ * replayed the next time it is loaded.
+ */
+static void
+corestorage_journal_remove_stale(void)
+{
+	DIR *dir;
+	struct dirent *ent;
+	char prefix[BUFSIZE], path[BUFSIZE];
+
+	if ((dir = opendir(datadir)) == NULL)
+		return;
+
+	(void) snprintf(prefix, sizeof prefix, "%s.journal.", journal_db);
+
+	while ((ent = readdir(dir)) != NULL)
+	{
+		if (strncmp(ent->d_name, prefix, strlen(prefix)) != 0)
+			continue;
+
+		(void) snprintf(path, sizeof path, "%s/%s", datadir, ent->d_name);
+
+		slog(LG_INFO, "corestorage: removing journal '%s', which the database does not use", path);
+
+		if (unlink(path) < 0)
+			slog(LG_ERROR, "corestorage: cannot remove journal '%s': %s", path, strerror(errno));
+	}
+
+	closedir(dir);
+}
+
 static void
 corestorage_db_load(const char *filename)
 {
 	struct database_handle *db;
 
+	sfree(journal_db);
+	journal_db = sstrdup(filename != NULL ? filename : "services.db");
+
 	db = db_open(filename, DB_READ);
 	if (db == NULL)
 		return;
@@ -1047,9 +2465,28 @@ corestorage_db_load(const char *filename)
 
 	db_parse(db);
 	db_close(db);
+
+	if (journal_seq_loaded)
+		corestorage_journal_replay();
+	else
+		corestorage_journal_remove_stale();
+
+	if (db_fuzzy && ! journal_seq_loaded)
+		slog(LG_ERROR, "corestorage: the database was written by a sliced save without a journal; accounts and "
+		               "channels registered while it was written are missing from it");
+
+	journal_active = config_options.db_journal && ! readonly;
+
+	if (journal_active && ! corestorage_journal_create(journal_seq))
+	{
+		slog(LG_ERROR, "corestorage: cannot start journal %u; changes will only be saved by full database saves",
+		     journal_seq);
+		journal_active = false;
+	}
 }
 
-static void
+// returns whether the database was written and has replaced the previous one
+static bool
 corestorage_db_write_blocking(void *filename)
 {
 	struct database_handle *db;
@@ -1059,13 +2496,24 @@ corestorage_db_write_blocking(void *filename)
 	if (! db)
 	{
 		slog(LG_ERROR, "db_write_blocking(): db_open() failed, aborting save");
-		return;
+		return false;
 	}
 
 	corestorage_db_save(db);
 	hook_call_db_write(db);
 
+	save_written = false;
 	db_close(db);
+
+	return save_written;
+}
+
+// the changes counted when the save began are only saved once it has succeeded
+static void
+corestorage_db_write_now(void *filename, const bool follows)
+{
+	if (corestorage_db_write_blocking(filename) && follows)
+		db_mark_saved();
 }
 
 #ifdef HAVE_FORK
@@ -1078,6 +2526,9 @@ corestorage_db_saved_cb(pid_t pid, int status, void *data)
 	{
 		child_pid = 0;
 		slog(LG_DEBUG, "db_save(): finished asynchronous DB write");
+
+		if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS && child_follows)
+			db_mark_saved();
 	}
 }
 #endif
@@ -1085,8 +2536,44 @@ corestorage_db_saved_cb(pid_t pid, int status, void *data)
 static void
 corestorage_db_write(void *filename, enum db_save_strategy strategy)
 {
+	const bool follows = corestorage_journal_follows(filename);
+
+	if (slice_db != NULL)
+	{
+		if (strategy == DB_SAVE_BG_REGULAR)
+		{
+			slog(LG_DEBUG, "db_save(): previous save unfinished, skipping save");
+			return;
+		}
+
+		if (strategy == DB_SAVE_BG_IMPORTANT && filename == NULL && ! config_options.db_save_blocking)
+		{
+			slog(LG_DEBUG, "db_save(): previous save unfinished, saving again when it is done");
+			slice_again = true;
+			return;
+		}
+
+		slog(LG_DEBUG, "db_save(): finishing unfinished previous save for forced save");
+		corestorage_slice_finish();
+	}
+
 #ifndef HAVE_FORK
-	corestorage_db_write_blocking(filename);
+	if (follows)
+	{
+		corestorage_journal_rotate();
+		db_mark_saving();
+	}
+
+	journal_save_active = journal_active && follows;
+
+	if (config_options.db_save_slice && ! config_options.db_save_blocking && strategy != DB_SAVE_BLOCKING &&
+	    corestorage_slice_usable())
+	{
+		corestorage_slice_begin(filename, follows);
+		return;
+	}
+
+	corestorage_db_write_now(filename, follows);
 #else
 	if (child_pid && strategy == DB_SAVE_BG_REGULAR)
 	{
@@ -1094,6 +2581,14 @@ corestorage_db_write(void *filename, enum db_save_strategy strategy)
 		return;
 	}
 
+	if (follows)
+	{
+		corestorage_journal_rotate();
+		db_mark_saving();
+	}
+
+	journal_save_active = journal_active && follows;
+
 	if (child_pid)
 	{
 		slog(LG_DEBUG, "db_save(): interrupting unfinished previous save for forced save");
@@ -1109,7 +2604,13 @@ corestorage_db_write(void *filename, enum db_save_strategy strategy)
 
 	if (strategy == DB_SAVE_BLOCKING)
 	{
-		corestorage_db_write_blocking(filename);
+		corestorage_db_write_now(filename, follows);
+		return;
+	}
+
+	if (config_options.db_save_slice && corestorage_slice_usable())
+	{
+		corestorage_slice_begin(filename, follows);
 		return;
 	}
 
@@ -1118,15 +2619,15 @@ corestorage_db_write(void *filename, enum db_save_strategy strategy)
 	{
 		case -1:
 			slog(LG_ERROR, "db_save(): fork() failed; writing database synchronously");
-			corestorage_db_write_blocking(filename);
+			corestorage_db_write_now(filename, follows);
 			return;
 
 		case 0:
-			corestorage_db_write_blocking(filename);
-			exit(EXIT_SUCCESS);
+			exit(corestorage_db_write_blocking(filename) ? EXIT_SUCCESS : EXIT_FAILURE);
 
 		default:
 			child_pid = pid;
+			child_follows = follows;
 			childproc_add(pid, "db_save", corestorage_db_saved_cb, NULL);
 			return;
 	}
@@ -1168,10 +2669,31 @@ mod_init(struct module *const restrict m)
 	db_register_type_handler("QID", corestorage_h_qid);
 	db_register_type_handler("QL", corestorage_h_ql);
 
+	db_register_type_handler("JSEQ", corestorage_h_jseq);
+	db_register_type_handler("FUZZY", corestorage_h_fuzzy);
+	db_register_type_handler("JMU", corestorage_h_mu);
+	db_register_type_handler("JRMU", corestorage_h_jrmu);
+	db_register_type_handler("JDMU", corestorage_h_jdmu);
+	db_register_type_handler("JDMN", corestorage_h_jdmn);
+	db_register_type_handler("JDMC", corestorage_h_jdmc);
+	db_register_type_handler("JCA", corestorage_h_ca);
+	db_register_type_handler("JDCA", corestorage_h_jdca);
+	db_register_type_handler("JDMDU", corestorage_h_jdmd);
+	db_register_type_handler("JDMDC", corestorage_h_jdmd);
+	db_register_type_handler("JDMDA", corestorage_h_jdmd);
+	db_register_type_handler("JDKL", corestorage_h_jdkl);
+	db_register_type_handler("JDXL", corestorage_h_jdxl);
+	db_register_type_handler("JDQL", corestorage_h_jdql);
+	db_register_type_handler("JDME", corestorage_h_jdme);
+
 	db_register_type_handler("DE", corestorage_ignore_row);
 
 	db_register_type_handler("???", corestorage_h_unknown);
 
+	hook_add_db_change(corestorage_h_db_change);
+	hook_add_db_change(corestorage_slice_h_db_change);
+	hook_add_db_saved(corestorage_h_db_saved);
+
 	backend_loaded = true;
 
 	m->mflags |= MODFLAG_DBHANDLER;
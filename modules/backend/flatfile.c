@@ -192,7 +192,6 @@ flatfile_db_load(const char *filename)
 			char *sender, *text;
 			time_t mtime;
 			unsigned int status;
-			struct mymemo *mz;
 
 			mu = myuser_find(strtok(NULL, " "));
 			sender = strtok(NULL, " ");
@@ -209,17 +208,7 @@ flatfile_db_load(const char *filename)
 			if (!sender || !mtime || !text)
 				continue;
 
-			mz = smalloc(sizeof *mz);
-
-			mowgli_strlcpy(mz->sender, sender, sizeof mz->sender);
-			mowgli_strlcpy(mz->text, text, sizeof mz->text);
-			mz->sent = mtime;
-			mz->status = status;
-
-			if (!(mz->status & MEMO_READ))
-				mu->memoct_new++;
-
-			mowgli_node_add(mz, mowgli_node_create(), &mu->memos);
+			(void) mymemo_add(mu, sender, text, mtime, status);
 		}
 		else if (!strcmp("MI", item))
 		{
@@ -239,7 +228,7 @@ flatfile_db_load(const char *filename)
 
 			strbuf = sstrdup(target);
 
-			mowgli_node_add(strbuf, mowgli_node_create(), &mu->memo_ignores);
+			mowgli_node_add(strbuf, mowgli_node_create(), &myuser_ext(mu)->memo_ignores);
 		}
 		else if (!strcmp("AC", item))
 		{
@@ -619,10 +608,7 @@ flatfile_db_load(const char *filename)
 			strip(reason);
 
 			k = kline_add(user, host, reason, duration, setby);
-			k->settime = settime;
-
-			// XXX this is not nice, oh well -- jilles
-			k->expires = k->settime + k->duration;
+			kline_set_expiry(k, settime);
 
 			kin++;
 		}
@@ -649,10 +635,7 @@ flatfile_db_load(const char *filename)
 			strip(reason);
 
 			x = xline_add(realname, reason, duration, setby);
-			x->settime = settime;
-
-			// XXX this is not nice, oh well -- jilles
-			x->expires = x->settime + x->duration;
+			xline_set_expiry(x, settime);
 
 			xin++;
 		}
@@ -679,10 +662,7 @@ flatfile_db_load(const char *filename)
 			strip(reason);
 
 			q = qline_add(mask, reason, duration, setby);
-			q->settime = settime;
-
-			// XXX this is not nice, oh well -- jilles
-			q->expires = q->settime + q->duration;
+			qline_set_expiry(q, settime);
 
 			qin++;
 		}
@@ -12,22 +12,130 @@
 
 #include <atheme.h>
 
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#  include <sys/mman.h>
+#  define OPENSEX_USE_MMAP 1
+#endif
+
 struct opensex
 {
 	// Lexing state
 	char *buf;
 	unsigned int bufsize;
 	char *token;
+	char *rowend;
 	FILE *f;
 
+	/* When reading from a private writable mapping of the database, rows
+	 * and words are split in place and the buffer above is not used.
+	 */
+	char *map;
+	size_t mapsize;
+	char *pos;
+
+	// Output state: rows are built in wbuf and written out with write(2)
+	int fd;
+	char *wbuf;
+	size_t wsize;
+	size_t wlen;
+	bool werror;
+
 	// Interpreting state
 	unsigned int grver;
 };
 
+#define OPENSEX_WBUF_SIZE       1048576U
+#define OPENSEX_ABUF_SIZE       16384U  // appends are a few rows at a time
+
+/* Every append (e.g. to a journal) is one batch of rows, between a BATCH and a
+ * BATCHEND row. A batch without its BATCHEND was cut short, by a crash during
+ * the append, and none of it is applied. Snapshots have no batches; they are
+ * renamed into place once they are complete.
+ */
+#define OPENSEX_BATCH           "BATCH"
+#define OPENSEX_BATCH_END       "BATCHEND"
+
 #ifdef HAVE_FLOCK
 static int lockfd;
 #endif
 
+// whether a line (not yet split into words) is a row of the given type
+static bool
+opensex_is_row(const char *line, size_t len, const char *type)
+{
+	const size_t typelen = strlen(type);
+
+	return len >= typelen && memcmp(line, type, typelen) == 0 && (len == typelen || line[typelen] == ' ');
+}
+
+/* Whether the batch whose BATCH row has just been read has its BATCHEND row
+ * before the next batch begins; the rows are looked at without being read.
+ */
+static bool
+opensex_batch_complete(struct database_handle *db)
+{
+	struct opensex *rs = (struct opensex *)db->priv;
+
+	if (rs->map != NULL)
+	{
+		const char *const end = rs->map + rs->mapsize;
+		const char *row = rs->pos;
+		const char *nl;
+
+		while (row < end && (nl = memchr(row, '\n', (size_t) (end - row))) != NULL)
+		{
+			if (opensex_is_row(row, (size_t) (nl - row), OPENSEX_BATCH_END))
+				return true;
+			if (opensex_is_row(row, (size_t) (nl - row), OPENSEX_BATCH))
+				return false;
+
+			row = nl + 1;
+		}
+
+		return false;
+	}
+
+	const long start = ftell(rs->f);
+	char line[sizeof OPENSEX_BATCH_END];
+	size_t len = 0;
+	bool complete = false;
+	int c;
+
+	if (start < 0)
+		return false;
+
+	while ((c = getc(rs->f)) != EOF)
+	{
+		if (c != '\n')
+		{
+			if (len < sizeof line)
+				line[len] = (char) c;
+
+			len++;
+			continue;
+		}
+
+		if (opensex_is_row(line, len, OPENSEX_BATCH_END))
+		{
+			complete = true;
+			break;
+		}
+		if (opensex_is_row(line, len, OPENSEX_BATCH))
+			break;
+
+		len = 0;
+	}
+
+	if (fseek(rs->f, start, SEEK_SET) < 0)
+	{
+		slog(LG_ERROR, "opensex-read-next-row: cannot seek in %s: %s", db->file, strerror(errno));
+		slog(LG_ERROR, "opensex-read-next-row: exiting to avoid data loss");
+		exit(EXIT_FAILURE);
+	}
+
+	return complete;
+}
+
 static void
 opensex_db_parse(struct database_handle *db)
 {
@@ -36,6 +144,20 @@ opensex_db_parse(struct database_handle *db)
 	{
 		cmd = db_read_word(db);
 		if (!cmd || !*cmd || strchr("#\n\t \r", *cmd)) continue;
+
+		if (!strcmp(cmd, OPENSEX_BATCH))
+		{
+			if (!opensex_batch_complete(db))
+			{
+				slog(LG_ERROR, "db-parse: %s has an incomplete batch of changes at line %u; ignoring it and "
+				               "everything after it", db->file, db->line);
+				return;
+			}
+			continue;
+		}
+		if (!strcmp(cmd, OPENSEX_BATCH_END))
+			continue;
+
 		db_process(db, cmd);
 	}
 }
@@ -51,6 +173,45 @@ opensex_h_grver(struct database_handle *db, const char *type)
 		slog(LG_ERROR, "opensex: grammar version %u is unsupported.  dazed and confused, but trying to continue.", rs->grver);
 }
 
+/* Every row is written with its newline, so a last row without one is what is
+ * left of a write that was interrupted; it is never applied.
+ */
+static void
+opensex_drop_partial_row(struct database_handle *hdl)
+{
+	slog(LG_ERROR, "opensex-read-next-row: %s ends in the middle of line %u; ignoring that line", hdl->file,
+	               hdl->line + 1);
+}
+
+static bool
+opensex_read_next_row_mapped(struct database_handle *hdl, struct opensex *rs)
+{
+	char *const end = rs->map + rs->mapsize;
+	char *row = rs->pos;
+	char *nl;
+
+	if (row >= end)
+		return false;
+
+	// memchr() is typically vectorised; this is where the time goes
+	if ((nl = memchr(row, '\n', (size_t) (end - row))) == NULL)
+	{
+		opensex_drop_partial_row(hdl);
+		rs->pos = end;
+		return false;
+	}
+
+	*nl = '\0';
+	rs->pos = nl + 1;
+
+	rs->token = row;
+	rs->rowend = nl;
+
+	hdl->line++;
+	hdl->token = 0;
+	return true;
+}
+
 static bool
 opensex_read_next_row(struct database_handle *hdl)
 {
@@ -58,6 +219,9 @@ opensex_read_next_row(struct database_handle *hdl)
 	unsigned int n = 0;
 	struct opensex *rs = (struct opensex *)hdl->priv;
 
+	if (rs->map != NULL)
+		return opensex_read_next_row_mapped(hdl, rs);
+
 	while ((c = getc(rs->f)) != EOF && c != '\n')
 	{
 		rs->buf[n++] = c;
@@ -69,6 +233,7 @@ opensex_read_next_row(struct database_handle *hdl)
 	}
 	rs->buf[n] = '\0';
 	rs->token = rs->buf;
+	rs->rowend = rs->buf + n;
 
 	if (c == EOF && ferror(rs->f))
 	{
@@ -77,8 +242,13 @@ opensex_read_next_row(struct database_handle *hdl)
 		exit(EXIT_FAILURE);
 	}
 
-	if (c == EOF && n == 0)
+	if (c == EOF)
+	{
+		if (n != 0)
+			opensex_drop_partial_row(hdl);
+
 		return false;
+	}
 
 	hdl->line++;
 	hdl->token = 0;
@@ -91,13 +261,12 @@ opensex_read_word(struct database_handle *db)
 	struct opensex *rs = (struct opensex *)db->priv;
 	char *ptr;
 	char *res;
-	static char buf[BUFSIZE];
 
 	res = rs->token;
 	if (res == NULL)
 		return NULL;
 
-	ptr = strchr(res, ' ');
+	ptr = memchr(res, ' ', (size_t) (rs->rowend - res));
 	if (ptr != NULL)
 	{
 		*ptr++ = '\0';
@@ -159,6 +328,84 @@ opensex_read_time(struct database_handle *db, time_t *res)
 	return *s && !*rp;
 }
 
+static void
+opensex_wbuf_flush(struct database_handle *db, struct opensex *rs)
+{
+	size_t done = 0;
+
+	while (done < rs->wlen && !rs->werror)
+	{
+		const ssize_t ret = write(rs->fd, rs->wbuf + done, rs->wlen - done);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+		{
+			slog(LG_ERROR, "db-write: cannot write to '%s%s': %s", db->file, (db->txn == DB_WRITE) ? ".new" : "",
+			               ret < 0 ? strerror(errno) : "short write");
+			rs->werror = true;
+			break;
+		}
+
+		done += (size_t) ret;
+	}
+
+	rs->wlen = 0;
+}
+
+static void
+opensex_wbuf_put(struct database_handle *db, struct opensex *rs, const char *data, size_t len)
+{
+	while (len != 0)
+	{
+		size_t chunk = rs->wsize - rs->wlen;
+
+		if (chunk > len)
+			chunk = len;
+
+		(void) memcpy(rs->wbuf + rs->wlen, data, chunk);
+		rs->wlen += chunk;
+		data += chunk;
+		len -= chunk;
+
+		if (rs->wlen == rs->wsize)
+			opensex_wbuf_flush(db, rs);
+	}
+}
+
+static inline void
+opensex_wbuf_putc(struct database_handle *db, struct opensex *rs, char c)
+{
+	if (rs->wlen == rs->wsize)
+		opensex_wbuf_flush(db, rs);
+
+	rs->wbuf[rs->wlen++] = c;
+}
+
+/* Writes the decimal form of num, followed by a space, as "%ju " would.
+ * neg prefixes a minus sign.
+ */
+static void
+opensex_wbuf_putnum(struct database_handle *db, struct opensex *rs, uintmax_t num, bool neg)
+{
+	char buf[sizeof(uintmax_t) * 3 + 2];
+	char *p = buf + sizeof buf;
+
+	*--p = ' ';
+
+	do
+	{
+		*--p = (char) ('0' + (num % 10U));
+		num /= 10U;
+	} while (num != 0);
+
+	if (neg)
+		*--p = '-';
+
+	opensex_wbuf_put(db, rs, p, (size_t) ((buf + sizeof buf) - p));
+}
+
 static bool
 opensex_start_row(struct database_handle *db, const char *type)
 {
@@ -168,7 +415,8 @@ opensex_start_row(struct database_handle *db, const char *type)
 	return_val_if_fail(type != NULL, false);
 	rs = (struct opensex *)db->priv;
 
-	fprintf(rs->f, "%s ", type);
+	opensex_wbuf_put(db, rs, type, strlen(type));
+	opensex_wbuf_putc(db, rs, ' ');
 
 	return true;
 }
@@ -177,13 +425,17 @@ static bool
 opensex_write_cell(struct database_handle *db, const char *data, bool multiword)
 {
 	struct opensex *rs;
-	char buf[BUFSIZE], *bi;
-	const char *i;
 
 	return_val_if_fail(db != NULL, false);
 	rs = (struct opensex *)db->priv;
 
-	fprintf(rs->f, "%s%s", data != NULL ? data : "*", !multiword ? " " : "");
+	if (data == NULL)
+		data = "*";
+
+	opensex_wbuf_put(db, rs, data, strlen(data));
+
+	if (!multiword)
+		opensex_wbuf_putc(db, rs, ' ');
 
 	return true;
 }
@@ -203,25 +455,30 @@ opensex_write_str(struct database_handle *db, const char *word)
 static bool
 opensex_write_int(struct database_handle *db, int num)
 {
-	char buf[32];
-	snprintf(buf, sizeof buf, "%d", num);
-	return opensex_write_cell(db, buf, false);
+	return_val_if_fail(db != NULL, false);
+
+	// negate as unsigned so that INT_MIN comes out right
+	opensex_wbuf_putnum(db, db->priv, (num < 0) ? (0U - (unsigned int) num) : (unsigned int) num, num < 0);
+	return true;
 }
 
 static bool
 opensex_write_uint(struct database_handle *db, unsigned int num)
 {
-	char buf[32];
-	snprintf(buf, sizeof buf, "%u", num);
-	return opensex_write_cell(db, buf, false);
+	return_val_if_fail(db != NULL, false);
+
+	opensex_wbuf_putnum(db, db->priv, num, false);
+	return true;
 }
 
 static bool
 opensex_write_time(struct database_handle *db, time_t tm)
 {
-	char buf[32];
-	snprintf(buf, sizeof buf, "%lu", (unsigned long) tm);
-	return opensex_write_cell(db, buf, false);
+	return_val_if_fail(db != NULL, false);
+
+	// same conversion as the "%lu" this used to be written with
+	opensex_wbuf_putnum(db, db->priv, (unsigned long) tm, false);
+	return true;
 }
 
 static bool
@@ -232,7 +489,7 @@ opensex_commit_row(struct database_handle *db)
 	return_val_if_fail(db != NULL, false);
 	rs = (struct opensex *)db->priv;
 
-	fprintf(rs->f, "\n");
+	opensex_wbuf_putc(db, rs, '\n');
 
 	return true;
 }
@@ -300,6 +557,26 @@ opensex_db_open_read(const char *filename)
 	rs->buf = smalloc(rs->bufsize);
 	rs->f = f;
 
+#ifdef OPENSEX_USE_MMAP
+	struct stat sb;
+
+	if (fstat(fileno(f), &sb) == 0 && sb.st_size > 0 && (uintmax_t) sb.st_size <= SIZE_MAX)
+	{
+		void *const map = mmap(NULL, (size_t) sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(f), 0);
+
+		if (map != MAP_FAILED)
+		{
+			(void) posix_madvise(map, (size_t) sb.st_size, POSIX_MADV_SEQUENTIAL);
+
+			rs->map = map;
+			rs->mapsize = (size_t) sb.st_size;
+			rs->pos = rs->map;
+		}
+		else
+			slog(LG_DEBUG, "db-open-read: cannot map '%s' (%s); reading it instead", path, strerror(errno));
+	}
+#endif
+
 	db = smalloc(sizeof *db);
 	db->priv = rs;
 	db->vt = &opensex_vt;
@@ -315,7 +592,6 @@ opensex_db_open_write(const char *filename)
 	struct database_handle *db;
 	struct opensex *rs;
 	int fd;
-	FILE *f;
 	int errno1;
 	char bpath[BUFSIZE], path[BUFSIZE];
 #ifdef HAVE_FLOCK
@@ -336,8 +612,8 @@ opensex_db_open_write(const char *filename)
 	flock(lockfd, LOCK_EX);
 #endif
 
-	fd = open(path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-	if (fd < 0 || ! (f = fdopen(fd, "w")))
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if (fd < 0)
 	{
 		errno1 = errno;
 		slog(LG_ERROR, "db-open-write: cannot open '%s' for writing: %s", path, strerror(errno1));
@@ -349,7 +625,9 @@ opensex_db_open_write(const char *filename)
 	}
 
 	rs = smalloc(sizeof *rs);
-	rs->f = f;
+	rs->fd = fd;
+	rs->wsize = OPENSEX_WBUF_SIZE;
+	rs->wbuf = smalloc(rs->wsize);
 	rs->grver = 1;
 
 	db = smalloc(sizeof *db);
@@ -365,11 +643,67 @@ opensex_db_open_write(const char *filename)
 	return db;
 }
 
+static struct database_handle * ATHEME_FATTR_MALLOC
+opensex_db_open_append(const char *filename)
+{
+	struct database_handle *db;
+	struct opensex *rs;
+	struct stat sb;
+	int fd;
+	int errno1;
+	char path[BUFSIZE];
+
+	return_val_if_fail(filename != NULL, NULL);
+
+	snprintf(path, BUFSIZE, "%s/%s", datadir, filename);
+
+	fd = open(path, O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if (fd < 0 || fstat(fd, &sb) < 0)
+	{
+		errno1 = errno;
+		slog(LG_ERROR, "db-open-append: cannot open '%s' for appending: %s", path, strerror(errno1));
+		wallops("\2DATABASE ERROR\2: db-open-append: cannot open '%s' for appending: %s", path, strerror(errno1));
+		if (fd >= 0)
+			close(fd);
+		return NULL;
+	}
+
+	rs = smalloc(sizeof *rs);
+	rs->fd = fd;
+	rs->wsize = OPENSEX_ABUF_SIZE;
+	rs->wbuf = smalloc(rs->wsize);
+	rs->grver = 1;
+
+	db = smalloc(sizeof *db);
+	db->priv = rs;
+	db->vt = &opensex_vt;
+	db->txn = DB_APPEND;
+	db->file = sstrdup(path);
+
+	// a row left unfinished by a failed append must not run into this batch
+	if (sb.st_size != 0)
+		opensex_wbuf_putc(db, rs, '\n');
+
+	db_start_row(db, OPENSEX_BATCH);
+	db_commit_row(db);
+
+	if (sb.st_size == 0)
+	{
+		db_start_row(db, "GRVER");
+		db_write_uint(db, rs->grver);
+		db_commit_row(db);
+	}
+
+	return db;
+}
+
 static struct database_handle *
 opensex_db_open(const char *filename, enum database_transaction txn)
 {
 	if (txn == DB_WRITE)
 		return opensex_db_open_write(filename);
+	if (txn == DB_APPEND)
+		return opensex_db_open_append(filename);
 	return opensex_db_open_read(filename);
 }
 
@@ -388,25 +722,74 @@ opensex_db_close(struct database_handle *db)
 
 	mowgli_strlcpy(newpath, db->file, sizeof newpath);
 
-	fclose(rs->f);
+#ifdef OPENSEX_USE_MMAP
+	if (rs->map != NULL)
+		(void) munmap(rs->map, rs->mapsize);
+#endif
+
+	if (db->txn == DB_READ)
+		fclose(rs->f);
+
+	if (db->txn == DB_APPEND)
+	{
+		db_start_row(db, OPENSEX_BATCH_END);
+		db_commit_row(db);
+
+		opensex_wbuf_flush(db, rs);
+
+#if defined(_POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0)
+		if (!rs->werror && config_options.db_save_sync && fdatasync(rs->fd) < 0)
+#else
+		if (!rs->werror && config_options.db_save_sync && fsync(rs->fd) < 0)
+#endif
+			slog(LG_ERROR, "db-append: cannot flush '%s' to disk: %s", newpath, strerror(errno));
+
+		if (close(rs->fd) < 0 && !rs->werror)
+			slog(LG_ERROR, "db-append: cannot close '%s': %s", newpath, strerror(errno));
+	}
 
 	if (db->txn == DB_WRITE)
 	{
+		opensex_wbuf_flush(db, rs);
+
+#if defined(_POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0)
+		if (!rs->werror && config_options.db_save_sync && fdatasync(rs->fd) < 0)
+#else
+		if (!rs->werror && config_options.db_save_sync && fsync(rs->fd) < 0)
+#endif
+		{
+			slog(LG_ERROR, "db-write: cannot flush '%s' to disk: %s", oldpath, strerror(errno));
+			rs->werror = true;
+		}
+
+		if (close(rs->fd) < 0 && !rs->werror)
+		{
+			slog(LG_ERROR, "db-write: cannot close '%s': %s", oldpath, strerror(errno));
+			rs->werror = true;
+		}
+
+		// a partial database must never replace a complete one
+		if (rs->werror)
+		{
+			slog(LG_ERROR, "db_save(): keeping the previous database; the new one is incomplete");
+			wallops("\2DATABASE ERROR\2: db_save(): could not write %s; keeping the previous database", oldpath);
+		}
 		// now, replace the old database with the new one, using an atomic rename
-		if (srename(oldpath, newpath) < 0)
+		else if (srename(oldpath, newpath) < 0)
 		{
 			errno1 = errno;
 			slog(LG_ERROR, "db_save(): cannot rename services.db.new to services.db: %s", strerror(errno1));
 			wallops("\2DATABASE ERROR\2: db_save(): cannot rename services.db.new to services.db: %s", strerror(errno1));
 		}
-
-		hook_call_db_saved();
+		else
+			hook_call_db_saved();
 #ifdef HAVE_FLOCK
 		close(lockfd);
 #endif
 	}
 
 	sfree(rs->buf);
+	sfree(rs->wbuf);
 	sfree(rs);
 	sfree(db->file);
 	sfree(db);
@@ -545,6 +545,7 @@ bs_cmd_add(struct sourceinfo *si, int parc, char *parv[])
 	bot->me = service_add_static(bot->nick, bot->user, bot->host, bot->real, botserv_channel_handler, chansvs.me);
 	service_set_chanmsg(bot->me, true);
 	mowgli_node_add(bot, &bot->bnode, &bs_bots);
+	db_mark_dirty();
 
 	logcommand(si, CMDLOG_ADMIN, "BOT:ADD: \2%s\2 (\2%s\2@\2%s\2) [\2%s\2]", bot->nick, bot->user, bot->host, bot->real);
 	command_success_nodata(si, _("Bot \2%s\2 (\2%s\2@\2%s\2) [\2%s\2] created."), bot->nick, bot->user, bot->host, bot->real);
@@ -641,6 +642,7 @@ bs_cmd_change(struct sourceinfo *si, int parc, char *parv[])
 	bot->registered = CURRTIME;
 	bot->me = service_add_static(bot->nick, bot->user, bot->host, bot->real, botserv_channel_handler, chansvs.me);
 	service_set_chanmsg(bot->me, true);
+	db_mark_dirty();
 
 	// join it back and also update the metadata
 	MOWGLI_PATRICIA_FOREACH(mc, &state, mclist)
@@ -708,6 +710,7 @@ bs_cmd_delete(struct sourceinfo *si, int parc, char *parv[])
 	sfree(bot->real);
 	sfree(bot->host);
 	sfree(bot);
+	db_mark_dirty();
 
 	logcommand(si, CMDLOG_ADMIN, "BOT:DEL: \2%s\2", parv[0]);
 	command_success_nodata(si, _("Bot \2%s\2 deleted."), parv[0]);
@@ -990,8 +993,13 @@ bs_part(struct hook_channel_joinpart *hdata)
 
 	bot = bs_mychan_find_bot(mc);
 	if ((CURRTIME - mc->used) >= SECONDS_PER_HOUR)
+	{
 		if (chanacs_user_flags(mc, cu->user) & CA_USEDUPDATE)
+		{
 			mc->used = CURRTIME;
+			db_record_touched(DB_RECORD_MYCHAN, mc);
+		}
+	}
 
 	/*
 	 * When channel_part is fired, we haven't yet removed the
@@ -1053,9 +1061,9 @@ static struct command bs_botlist = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 
 		m->mflags |= MODFLAG_FAIL;
 		return;
@@ -232,6 +232,9 @@ chanfix_gather(void *unused)
 		chans++;
 	}
 
+	if (chans != 0)
+		db_mark_dirty();
+
 	slog(LG_DEBUG, "chanfix_gather(): gathered %u channels and %u oprecords.", chans, oprecords);
 }
 
@@ -241,6 +244,9 @@ chanfix_expire(void *unused)
 	struct chanfix_channel *chan;
 	mowgli_patricia_iteration_state_t state;
 
+	if (mowgli_patricia_size(chanfix_channels) != 0)
+		db_mark_dirty();
+
 	MOWGLI_PATRICIA_FOREACH(chan, &state, chanfix_channels)
 	{
 		mowgli_node_t *n, *tn;
@@ -410,6 +410,7 @@ cs_set_cmd_antiflood(struct sourceinfo *si, int parc, char *parv[])
 	if (!strcasecmp(parv[1], "OFF"))
 	{
 		mc->flags &= ~MC_ANTIFLOOD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		metadata_delete(mc, METADATA_KEY_ENFORCE_METHOD);
 
 		logcommand(si, CMDLOG_SET, "ANTIFLOOD:NONE: \2%s\2",  mc->name);
@@ -424,6 +425,7 @@ cs_set_cmd_antiflood(struct sourceinfo *si, int parc, char *parv[])
 			return;
 		}
 		mc->flags |= MC_ANTIFLOOD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		metadata_delete(mc, METADATA_KEY_ENFORCE_METHOD);
 
 		logcommand(si, CMDLOG_SET, "ANTIFLOOD: %s (%s)",  mc->name, "DEFAULT");
@@ -433,6 +435,7 @@ cs_set_cmd_antiflood(struct sourceinfo *si, int parc, char *parv[])
 	else if (!strcasecmp(parv[1], "QUIET"))
 	{
 		mc->flags |= MC_ANTIFLOOD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		metadata_add(mc, METADATA_KEY_ENFORCE_METHOD, "QUIET");
 
 		logcommand(si, CMDLOG_SET, "ANTIFLOOD: %s (%s)",  mc->name, "QUIET");
@@ -442,6 +445,7 @@ cs_set_cmd_antiflood(struct sourceinfo *si, int parc, char *parv[])
 	else if (!strcasecmp(parv[1], "KICKBAN"))
 	{
 		mc->flags |= MC_ANTIFLOOD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		metadata_add(mc, METADATA_KEY_ENFORCE_METHOD, "KICKBAN");
 
 		logcommand(si, CMDLOG_SET, "ANTIFLOOD: %s (%s)",  mc->name, "KICKBAN");
@@ -453,6 +457,7 @@ cs_set_cmd_antiflood(struct sourceinfo *si, int parc, char *parv[])
 		if (has_priv(si, PRIV_AKILL))
 		{
 			mc->flags |= MC_ANTIFLOOD;
+			db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 			metadata_add(mc, METADATA_KEY_ENFORCE_METHOD, "AKILL");
 
 			logcommand(si, CMDLOG_SET, "ANTIFLOOD: %s (%s)",  mc->name, "AKILL");
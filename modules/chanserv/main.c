@@ -12,6 +12,9 @@
 
 static mowgli_eventloop_timer_t *cs_leave_empty_timer = NULL;
 
+// registered channels that users joined during the uplink's burst
+static mowgli_patricia_t *cs_burst_chans = NULL;
+
 static void
 join_registered(bool all)
 {
@@ -352,38 +355,44 @@ chanuser_sync(struct hook_chanuser_sync *hdata)
 	}
 }
 
+/* A second user joined and was not kicked; we do not need
+ * to stay on the channel artificially.
+ * If there is only one user, stay in the channel to avoid
+ * triggering autocycle-for-ops scripts and immediately
+ * destroying channels with kick on split riding.
+ */
 static void
-cs_join(struct hook_channel_joinpart *hdata)
+cs_leave_inhabited(struct mychan *mc, struct channel *chan)
 {
-	struct chanuser *cu = hdata->cu;
-	struct user *u;
-	struct channel *chan;
-	struct mychan *mc;
+	if (mc->flags & MC_INHABIT && chan->nummembers - chan->numsvcmembers >= 2)
+	{
+		mc->flags &= ~MC_INHABIT;
+		if (!(mc->flags & MC_GUARD) && !(chan->flags & CHAN_LOG) && chanuser_find(chan, chansvs.me->me))
+			part(chan->name, chansvs.nick);
+	}
+}
+
+/* Act on a user joining a registered channel.
+ * burst - the user was introduced by a server that is still bursting
+ * members, users - the number of members, and of members that are not
+ *     services, that the channel had once the user joined
+ * Returns false if the user was kicked.
+ */
+static bool
+cs_join_sync(struct chanuser *cu, struct mychan *mc, bool burst, unsigned int members, unsigned int users)
+{
+	struct user *u = cu->user;
+	struct channel *chan = cu->chan;
 	unsigned int flags;
-	bool noop;
 	bool secure;
-	struct metadata *md;
-	struct chanacs *ca2;
-
-	if (cu == NULL || is_internal_client(cu->user))
-		return;
-	u = cu->user;
-	chan = cu->chan;
-
-	// first check if this is a registered channel at all
-	mc = mychan_find(chan->name);
-	if (mc == NULL)
-		return;
 
 	flags = chanacs_user_flags(mc, u);
-	noop = mc->flags & MC_NOOP || (u->myuser != NULL &&
-			u->myuser->flags & MU_NOOP);
 	/* attempt to deop people recreating channels, if the more
 	 * sophisticated mechanism is disabled */
 	secure = mc->flags & MC_SECURE || (!chansvs.changets &&
-			chan->nummembers == 1 && chan->ts > CURRTIME - 300);
+			members == 1 && chan->ts > CURRTIME - 300);
 
-	if (chan->nummembers == 1 && mc->flags & MC_GUARD &&
+	if (members == 1 && mc->flags & MC_GUARD &&
 		metadata_find(mc, "private:botserv:bot-assigned") == NULL)
 		join(chan->name, chansvs.nick);
 
@@ -400,10 +409,10 @@ cs_join(struct hook_channel_joinpart *hdata)
 	 */
 	if (mc->mlock_on & CMODE_INVITE && !(flags & CA_INVITE) &&
 			(!me.bursting || mc->flags & MC_RECREATED) &&
-			(!(u->server->flags & SF_EOB) || (chan->nummembers - chan->numsvcmembers == 1)) &&
+			(burst || users == 1) &&
 			(!ircd->invex_mchar || !next_matching_ban(chan, u, ircd->invex_mchar, chan->bans.head)))
 	{
-		if (chan->nummembers - chan->numsvcmembers == 1)
+		if (users == 1)
 		{
 			mc->flags |= MC_INHABIT;
 			if (chan->numsvcmembers == 0)
@@ -413,10 +422,7 @@ cs_join(struct hook_channel_joinpart *hdata)
 			check_modes(mc, true);
 		modestack_flush_channel(chan);
 		if (try_kick(chansvs.me->me, chan, u, "Invite only channel"))
-		{
-			hdata->cu = NULL;
-			return;
-		}
+			return false;
 	}
 
 	struct hook_chanuser_sync sync_hdata = {
@@ -427,26 +433,139 @@ cs_join(struct hook_channel_joinpart *hdata)
 	hook_call_chanuser_sync(&sync_hdata);
 
 	if (!sync_hdata.cu)
+		return false;
+
+	if (flags & CA_USEDUPDATE)
+	{
+		mc->used = CURRTIME;
+		db_record_touched(DB_RECORD_MYCHAN, mc);
+	}
+
+	return true;
+}
+
+static void
+cs_join(struct hook_channel_joinpart *hdata)
+{
+	struct chanuser *cu = hdata->cu;
+	struct user *u;
+	struct channel *chan;
+	struct mychan *mc;
+
+	if (cu == NULL || is_internal_client(cu->user))
+		return;
+	u = cu->user;
+	chan = cu->chan;
+
+	// first check if this is a registered channel at all
+	mc = mychan_find(chan->name);
+	if (mc == NULL)
+		return;
+
+	/* While our uplink is bursting, leave the users it introduces
+	 * alone until it has finished, and then act on each channel
+	 * once (see cs_burst_end()).
+	 */
+	if (me.burst_defer && !(u->server->flags & SF_EOB))
+	{
+		cu->flags |= CU_SYNC_DEFERRED;
+		if (mowgli_patricia_retrieve(cs_burst_chans, chan->name) == NULL)
+			mowgli_patricia_add(cs_burst_chans, chan->name, chan);
+		return;
+	}
+
+	if (!cs_join_sync(cu, mc, !(u->server->flags & SF_EOB), chan->nummembers,
+				chan->nummembers - chan->numsvcmembers))
 	{
 		hdata->cu = NULL;
 		return;
 	}
 
-	/* A second user joined and was not kicked; we do not need
-	 * to stay on the channel artificially.
-	 * If there is only one user, stay in the channel to avoid
-	 * triggering autocycle-for-ops scripts and immediately
-	 * destroying channels with kick on split riding.
-	 */
-	if (mc->flags & MC_INHABIT && chan->nummembers - chan->numsvcmembers >= 2)
+	cs_leave_inhabited(mc, chan);
+}
+
+/* Act on the users that joined a channel during the burst, in the order
+ * they joined, then send the resulting modes all at once.
+ * Kicking users may destroy the channel, so it is looked up by name again
+ * whenever that may have happened.
+ */
+static void
+cs_burst_sync(const char *name)
+{
+	struct channel *chan;
+	struct mychan *mc;
+	mowgli_node_t *n, *tn;
+	unsigned int users = 0;
+
+	if ((chan = channel_find(name)) == NULL)
+		return;
+
+	mc = mychan_find(name);
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, chan->members.head)
 	{
-		mc->flags &= ~MC_INHABIT;
-		if (!(mc->flags & MC_GUARD) && !(chan->flags & CHAN_LOG) && chanuser_find(chan, chansvs.me->me))
-			part(chan->name, chansvs.nick);
+		struct chanuser *cu = n->data;
+
+		if (is_internal_client(cu->user))
+			continue;
+
+		if (cu->flags & CU_SYNC_DEFERRED)
+		{
+			cu->flags &= ~CU_SYNC_DEFERRED;
+
+			if (mc != NULL && !cs_join_sync(cu, mc, true, chan->numsvcmembers + users + 1, users + 1))
+			{
+				if (channel_find(name) == NULL)
+					return;
+				continue;
+			}
+		}
+
+		users++;
 	}
 
-	if (flags & CA_USEDUPDATE)
-		mc->used = CURRTIME;
+	if (channel_find(name) == NULL)
+		return;
+
+	if (mc != NULL)
+		cs_leave_inhabited(mc, chan);
+
+	modestack_flush_channel(chan);
+}
+
+static void
+cs_burst_end(void *unused)
+{
+	mowgli_patricia_iteration_state_t state;
+	struct channel *chan;
+	mowgli_list_t names = { NULL, NULL, 0 };
+	mowgli_node_t *n, *tn;
+
+	/* take the names of the channels rather than the channels, as syncing
+	 * one of them may destroy another (by killing a user, say) */
+	MOWGLI_PATRICIA_FOREACH(chan, &state, cs_burst_chans)
+		mowgli_node_add(sstrdup(chan->name), mowgli_node_create(), &names);
+
+	mowgli_patricia_destroy(cs_burst_chans, NULL, NULL);
+	cs_burst_chans = mowgli_patricia_create(irccasecanon);
+
+	slog(LG_DEBUG, "cs_burst_end(): synchronizing %zu channels joined during the burst",
+			MOWGLI_LIST_LENGTH(&names));
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, names.head)
+	{
+		cs_burst_sync(n->data);
+
+		sfree(n->data);
+		mowgli_node_delete(n, &names);
+		mowgli_node_free(n);
+	}
+}
+
+static void
+cs_burst_forget(struct channel *c)
+{
+	mowgli_patricia_delete(cs_burst_chans, c->name);
 }
 
 static void
@@ -465,8 +584,13 @@ cs_part(struct hook_channel_joinpart *hdata)
 		return;
 
 	if ((CURRTIME - mc->used) >= SECONDS_PER_HOUR)
+	{
 		if (chanacs_user_flags(mc, cu->user) & CA_USEDUPDATE)
+		{
 			mc->used = CURRTIME;
+			db_record_touched(DB_RECORD_MYCHAN, mc);
+		}
+	}
 
 	/*
 	 * When channel_part is fired, we haven't yet removed the
@@ -826,7 +950,11 @@ mod_init(struct module ATHEME_VATTR_UNUSED *const restrict m)
 
 	chansvs.me = service_add("chanserv", chanserv);
 
+	cs_burst_chans = mowgli_patricia_create(irccasecanon);
+
 	hook_add_channel_join(cs_join);
+	hook_add_channel_delete(cs_burst_forget);
+	hook_add_burst_end(cs_burst_end);
 	hook_add_channel_part(cs_part);
 	hook_add_channel_register(cs_register);
 	hook_add_channel_succession(cs_succession);
@@ -37,6 +37,7 @@ csreq_create(const char *name, struct myentity *mt)
 	cs->ts = CURRTIME;
 
 	mowgli_patricia_add(csreq_list, cs->name, cs);
+	db_mark_dirty();
 
 	return cs;
 }
@@ -57,6 +58,8 @@ csreq_destroy(struct reg_request *cs)
 	mowgli_patricia_delete(csreq_list, cs->name);
 	sfree(cs->name);
 	sfree(cs);
+
+	db_mark_dirty();
 }
 
 static void
@@ -83,6 +83,10 @@ send_entrymsg(struct hook_channel_joinpart *hdata)
 	if (!(u->server->flags & SF_EOB))
 		return;
 
+	// ChanServ has not decided yet whether they may stay (see cs_burst_end())
+	if (cu->flags & CU_SYNC_DEFERRED)
+		return;
+
 	struct metadata *md = metadata_find(mc, ENTRYMSG_MD);
 	if (md != NULL && metadata_find(mc, "private:botserv:bot-assigned") == NULL)
 	{
@@ -59,6 +59,7 @@ cs_cmd_set_guard(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 enabled the GUARD flag", get_source_name(si));
 
 		mc->flags |= MC_GUARD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		if (!(mc->flags & MC_INHABIT))
 			join(mc->name, chansvs.nick);
@@ -78,6 +79,7 @@ cs_cmd_set_guard(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 disabled the GUARD flag", get_source_name(si));
 
 		mc->flags &= ~MC_GUARD;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		if (mc->chan != NULL && !(mc->flags & MC_INHABIT) && !(mc->chan->flags & CHAN_LOG))
 			part(mc->name, chansvs.nick);
@@ -53,6 +53,7 @@ cs_cmd_set_keeptopic(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 enabled the KEEPTOPIC flag", get_source_name(si));
 
 		mc->flags |= MC_KEEPTOPIC;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "KEEPTOPIC", mc->name);
 		return;
@@ -69,6 +70,7 @@ cs_cmd_set_keeptopic(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 disabled the KEEPTOPIC flag", get_source_name(si));
 
 		mc->flags &= ~(MC_KEEPTOPIC | MC_TOPICLOCK);
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "KEEPTOPIC", mc->name);
 		return;
@@ -224,6 +224,8 @@ cs_cmd_set_mlock(struct sourceinfo *si, int parc, char *parv[])
 		mc->mlock_key = *newlock_key != '\0' ? sstrdup(newlock_key) : NULL;
 	}
 
+	db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
+
 	ext_plus[0] = '\0';
 	ext_minus[0] = '\0';
 	if (mask_ext)
@@ -99,6 +99,7 @@ cs_cmd_set_restricted(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 enabled the RESTRICTED flag", get_source_name(si));
 
 		mc->flags |= MC_RESTRICTED;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "RESTRICTED", mc->name);
 		return;
@@ -115,6 +116,7 @@ cs_cmd_set_restricted(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 disabled the RESTRICTED flag", get_source_name(si));
 
 		mc->flags &= ~MC_RESTRICTED;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "RESTRICTED", mc->name);
 		return;
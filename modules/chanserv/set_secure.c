@@ -53,6 +53,7 @@ cs_cmd_set_secure(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 enabled the SECURE flag", get_source_name(si));
 
 		mc->flags |= MC_SECURE;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "SECURE", mc->name);
 		return;
@@ -69,6 +70,7 @@ cs_cmd_set_secure(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 disabled the SECURE flag", get_source_name(si));
 
 		mc->flags &= ~MC_SECURE;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "SECURE", mc->name);
 		return;
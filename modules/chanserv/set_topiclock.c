@@ -53,6 +53,7 @@ cs_cmd_set_topiclock(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 enabled the TOPICLOCK flag", get_source_name(si));
 
 		mc->flags |= MC_KEEPTOPIC | MC_TOPICLOCK;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		topiclock_sts(mc->chan);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "TOPICLOCK", mc->name);
@@ -71,6 +72,7 @@ cs_cmd_set_topiclock(struct sourceinfo *si, int parc, char *parv[])
 		verbose(mc, "\2%s\2 disabled the TOPICLOCK flag", get_source_name(si));
 
 		mc->flags &= ~MC_TOPICLOCK;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		topiclock_sts(mc->chan);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "TOPICLOCK", mc->name);
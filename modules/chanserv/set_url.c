@@ -79,6 +79,10 @@ send_url(struct hook_channel_joinpart *hdata)
 	if (!(u->server->flags & SF_EOB))
 		return;
 
+	// ChanServ has not decided yet whether they may stay (see cs_burst_end())
+	if (cu->flags & CU_SYNC_DEFERRED)
+		return;
+
 	struct metadata *md = metadata_find(mc, "url");
 	if (md)
 		numeric_sts(me.me, 328, u, "%s :%s", mc->name, md->value);
@@ -53,6 +53,7 @@ cs_cmd_set_verbose(struct sourceinfo *si, int parc, char *parv[])
 
  		mc->flags &= ~MC_VERBOSE_OPS;
  		mc->flags |= MC_VERBOSE;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		verbose(mc, "\2%s\2 enabled the VERBOSE flag", get_source_name(si));
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "VERBOSE", mc->name);
@@ -74,10 +75,12 @@ cs_cmd_set_verbose(struct sourceinfo *si, int parc, char *parv[])
 			verbose(mc, "\2%s\2 restricted VERBOSE to chanops", get_source_name(si));
  			mc->flags &= ~MC_VERBOSE;
  			mc->flags |= MC_VERBOSE_OPS;
+			db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 		}
 		else
 		{
  			mc->flags |= MC_VERBOSE_OPS;
+			db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 			verbose(mc, "\2%s\2 enabled the VERBOSE_OPS flag", get_source_name(si));
 		}
 
@@ -99,6 +102,7 @@ cs_cmd_set_verbose(struct sourceinfo *si, int parc, char *parv[])
 		else
 			verbose(mc, "\2%s\2 disabled the VERBOSE_OPS flag", get_source_name(si));
 		mc->flags &= ~(MC_VERBOSE | MC_VERBOSE_OPS);
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "VERBOSE", mc->name);
 		return;
@@ -215,6 +215,7 @@ cs_cmd_set_nosync(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOSYNC:ON: \2%s\2", mc->name);
 
 		mc->flags |= MC_NOSYNC;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for channel \2%s\2."), "NOSYNC", mc->name);
 		return;
@@ -230,6 +231,7 @@ cs_cmd_set_nosync(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOSYNC:OFF: \2%s\2", mc->name);
 
 		mc->flags &= ~MC_NOSYNC;
+		db_record_changed(DB_RECORD_MYCHAN, mc, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for channel \2%s\2."), "NOSYNC", mc->name);
 		return;
@@ -111,7 +111,7 @@ cs_cmd_why(struct sourceinfo *si, int parc, char *parv[])
 			}
 		}
 	}
-	for (n = next_matching_host_chanacs(mc, u, mc->chanacs.head); n != NULL; n = next_matching_host_chanacs(mc, u, n->next))
+	for (n = next_matching_host_chanacs(mc, u, mc->chanacs_host.head); n != NULL; n = next_matching_host_chanacs(mc, u, n->next))
 	{
 		ca = n->data;
 		fl |= ca->level;
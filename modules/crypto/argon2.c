@@ -40,12 +40,25 @@ enum atheme_argon2_type
 
 static mowgli_list_t **crypto_conf_table = NULL;
 
-static enum atheme_argon2_type atheme_argon2_type = ATHEME_ARGON2_TYPE_DEFAULT;
-static unsigned int atheme_argon2_memcost = ATHEME_ARGON2_MEMCOST_DEF;
-static unsigned int atheme_argon2_timecost = ATHEME_ARGON2_TIMECOST_DEF;
-static unsigned int atheme_argon2_threads = ATHEME_ARGON2_THREADS_DEF;
-static unsigned int atheme_argon2_saltlen = ATHEME_ARGON2_SALTLEN_DEF;
-static unsigned int atheme_argon2_hashlen = ATHEME_ARGON2_HASHLEN_DEF;
+struct atheme_argon2_params
+{
+	enum atheme_argon2_type         type;
+	unsigned int                    memcost;
+	unsigned int                    timecost;
+	unsigned int                    threads;
+	unsigned int                    saltlen;
+	unsigned int                    hashlen;
+};
+
+// Copied for each request to a password verification thread; see crypt_verify_params()
+static struct atheme_argon2_params atheme_argon2_params = {
+	.type       = ATHEME_ARGON2_TYPE_DEFAULT,
+	.memcost    = ATHEME_ARGON2_MEMCOST_DEF,
+	.timecost   = ATHEME_ARGON2_TIMECOST_DEF,
+	.threads    = ATHEME_ARGON2_THREADS_DEF,
+	.saltlen    = ATHEME_ARGON2_SALTLEN_DEF,
+	.hashlen    = ATHEME_ARGON2_HASHLEN_DEF,
+};
 
 static int
 c_ci_argon2_type(mowgli_config_file_entry_t *const restrict ce)
@@ -54,34 +67,34 @@ c_ci_argon2_type(mowgli_config_file_entry_t *const restrict ce)
 	{
 		(void) conf_report_warning(ce, "no parameter for configuration option -- using default");
 
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_DEFAULT;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_DEFAULT;
 		return 0;
 	}
 
 	if (strcasecmp(ce->vardata, "argon2d") == 0)
 	{
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_D;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_D;
 	}
 	else if (strcasecmp(ce->vardata, "argon2i") == 0)
 	{
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_I;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_I;
 	}
 	else if (strcasecmp(ce->vardata, "argon2id") == 0)
 	{
 #ifdef HAVE_LIBARGON2_TYPE_ID
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_ID;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_ID;
 #else /* HAVE_LIBARGON2_TYPE_ID */
 		(void) conf_report_warning(ce, "your libargon2 does not support the argon2id type");
 		(void) conf_report_warning(ce, "invalid parameter for configuration option -- using default");
 
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_DEFAULT;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_DEFAULT;
 #endif /* !HAVE_LIBARGON2_TYPE_ID */
 	}
 	else
 	{
 		(void) conf_report_warning(ce, "invalid parameter for configuration option -- using default");
 
-		atheme_argon2_type = ATHEME_ARGON2_TYPE_DEFAULT;
+		atheme_argon2_params.type = ATHEME_ARGON2_TYPE_DEFAULT;
 	}
 
 	return 0;
@@ -132,46 +145,48 @@ static inline bool
 atheme_argon2_needs_rehash(const uint32_t ver, const enum atheme_argon2_type type, const uint32_t m_cost,
                            const uint32_t t_cost, const uint32_t threads, const size_t saltlen, const size_t hashlen)
 {
+	const struct atheme_argon2_params *const params = crypt_verify_params(&atheme_argon2_params);
+
 	if (ver != ARGON2_VERSION_NUMBER)
 	{
 		(void) slog(LG_DEBUG, "%s: version (0x%08" PRIX32 ") is not current (0x%08X)", MOWGLI_FUNC_NAME,
 		                      ver, (unsigned int) ARGON2_VERSION_NUMBER);
 		return true;
 	}
-	if (type != atheme_argon2_type)
+	if (type != params->type)
 	{
 		(void) slog(LG_DEBUG, "%s: type (%s) is not the configured type (%s)", MOWGLI_FUNC_NAME,
-		                      atheme_argon2_type2string(type), atheme_argon2_type2string(atheme_argon2_type));
+		                      atheme_argon2_type2string(type), atheme_argon2_type2string(params->type));
 		return true;
 	}
-	if (m_cost != (1U << atheme_argon2_memcost))
+	if (m_cost != (1U << params->memcost))
 	{
 		(void) slog(LG_DEBUG, "%s: m_cost (%" PRIu32 ") is not the configured value (%u)", MOWGLI_FUNC_NAME,
-		                      m_cost, (1U << atheme_argon2_memcost));
+		                      m_cost, (1U << params->memcost));
 		return true;
 	}
-	if (t_cost != atheme_argon2_timecost)
+	if (t_cost != params->timecost)
 	{
 		(void) slog(LG_DEBUG, "%s: t_cost (%" PRIu32 ") is not the configured value (%u)", MOWGLI_FUNC_NAME,
-		                      t_cost, atheme_argon2_timecost);
+		                      t_cost, params->timecost);
 		return true;
 	}
-	if (threads != atheme_argon2_threads)
+	if (threads != params->threads)
 	{
 		(void) slog(LG_DEBUG, "%s: threads (%" PRIu32 ") is not the configured value (%u)", MOWGLI_FUNC_NAME,
-		                      threads, atheme_argon2_threads);
+		                      threads, params->threads);
 		return true;
 	}
-	if (saltlen != atheme_argon2_saltlen)
+	if (saltlen != params->saltlen)
 	{
 		(void) slog(LG_DEBUG, "%s: saltlen (%zu) is not the configured value (%u)", MOWGLI_FUNC_NAME,
-		                      saltlen, atheme_argon2_saltlen);
+		                      saltlen, params->saltlen);
 		return true;
 	}
-	if (hashlen != atheme_argon2_hashlen)
+	if (hashlen != params->hashlen)
 	{
 		(void) slog(LG_DEBUG, "%s: hashlen (%zu) is not the configured value (%u)", MOWGLI_FUNC_NAME,
-		                      hashlen, atheme_argon2_hashlen);
+		                      hashlen, params->hashlen);
 		return true;
 	}
 
@@ -186,6 +201,7 @@ atheme_argon2_compute(argon2_context *const restrict ctx, const enum atheme_argo
 	argon2_type inttype;
 	sigset_t oldset;
 	sigset_t newset;
+	char errbuf[BUFSIZE];
 
 	if (! atheme_argon2_type2int(type, &inttype))
 	{
@@ -208,12 +224,14 @@ atheme_argon2_compute(argon2_context *const restrict ctx, const enum atheme_argo
 	 */
 	if (sigfillset(&newset) != 0)
 	{
-		(void) slog(LG_ERROR, "%s: sigfillset(3): %s", MOWGLI_FUNC_NAME, strerror(errno));
+		(void) slog(LG_ERROR, "%s: sigfillset(3): %s", MOWGLI_FUNC_NAME,
+		                      sstrerror(errno, errbuf, sizeof errbuf));
 		return false;
 	}
 	if (sigprocmask(SIG_BLOCK, &newset, &oldset) != 0)
 	{
-		(void) slog(LG_ERROR, "%s: sigprocmask(2): %s", MOWGLI_FUNC_NAME, strerror(errno));
+		(void) slog(LG_ERROR, "%s: sigprocmask(2): %s", MOWGLI_FUNC_NAME,
+		                      sstrerror(errno, errbuf, sizeof errbuf));
 		return false;
 	}
 
@@ -234,7 +252,8 @@ atheme_argon2_compute(argon2_context *const restrict ctx, const enum atheme_argo
 		result = true;
 
 	if (sigprocmask(SIG_SETMASK, &oldset, NULL) != 0)
-		(void) slog(LG_ERROR, "%s: sigprocmask(2): %s", MOWGLI_FUNC_NAME, strerror(errno));
+		(void) slog(LG_ERROR, "%s: sigprocmask(2): %s", MOWGLI_FUNC_NAME,
+		                      sstrerror(errno, errbuf, sizeof errbuf));
 
 	(void) smemzero(pass, sizeof pass);
 	return result;
@@ -251,39 +270,39 @@ atheme_argon2_crypt(const char *const restrict password,
 	char salt64[BASE64_SIZE_STR(sizeof salt)];
 	const char *result = NULL;
 
-	const char *const typestr = atheme_argon2_type2string(atheme_argon2_type);
+	const char *const typestr = atheme_argon2_type2string(atheme_argon2_params.type);
 
-	(void) atheme_random_buf(salt, atheme_argon2_saltlen);
+	(void) atheme_random_buf(salt, atheme_argon2_params.saltlen);
 
 	argon2_context ctx = {
 		.version    = ARGON2_VERSION_NUMBER,
-		.m_cost     = (1U << atheme_argon2_memcost),
-		.t_cost     = atheme_argon2_timecost,
-		.threads    = atheme_argon2_threads,
+		.m_cost     = (1U << atheme_argon2_params.memcost),
+		.t_cost     = atheme_argon2_params.timecost,
+		.threads    = atheme_argon2_params.threads,
 		.salt       = salt,
-		.saltlen    = (uint32_t) atheme_argon2_saltlen,
+		.saltlen    = (uint32_t) atheme_argon2_params.saltlen,
 		.out        = hash,
-		.outlen     = (uint32_t) atheme_argon2_hashlen,
+		.outlen     = (uint32_t) atheme_argon2_params.hashlen,
 	};
 
-	if (! atheme_argon2_compute(&ctx, atheme_argon2_type, password))
+	if (! atheme_argon2_compute(&ctx, atheme_argon2_params.type, password))
 		// This function logs messages on failure
 		goto cleanup;
 
-	if (argon2_base64_encode(salt, atheme_argon2_saltlen, salt64, sizeof salt64) == BASE64_FAIL)
+	if (argon2_base64_encode(salt, atheme_argon2_params.saltlen, salt64, sizeof salt64) == BASE64_FAIL)
 	{
 		(void) slog(LG_ERROR, "%s: base64_encode() for salt failed (BUG)", MOWGLI_FUNC_NAME);
 		goto cleanup;
 	}
-	if (argon2_base64_encode(hash, atheme_argon2_hashlen, hash64, sizeof hash64) == BASE64_FAIL)
+	if (argon2_base64_encode(hash, atheme_argon2_params.hashlen, hash64, sizeof hash64) == BASE64_FAIL)
 	{
 		(void) slog(LG_ERROR, "%s: base64_encode() for hash failed (BUG)", MOWGLI_FUNC_NAME);
 		goto cleanup;
 	}
 
 	if (snprintf(resultbuf, sizeof resultbuf, MODULE_SAVEHASH_FORMAT, typestr,
-                       (unsigned int) ARGON2_VERSION_NUMBER, (1U << atheme_argon2_memcost), atheme_argon2_timecost,
-	               atheme_argon2_threads, salt64, hash64) >= (int) PASSLEN)
+                       (unsigned int) ARGON2_VERSION_NUMBER, (1U << atheme_argon2_params.memcost),
+	               atheme_argon2_params.timecost, atheme_argon2_params.threads, salt64, hash64) >= (int) PASSLEN)
 	{
 		(void) slog(LG_ERROR, "%s: snprintf(3) would have overflowed result buffer (BUG)", MOWGLI_FUNC_NAME);
 		(void) smemzero(resultbuf, sizeof resultbuf);
@@ -388,11 +407,16 @@ cleanup:
 	return result;
 }
 
+static const char *const crypto_argon2_prefixes[] = { "$argon2d$", "$argon2i$", "$argon2id$", NULL };
+
 static const struct crypt_impl crypto_argon2_impl = {
 
-	.id         = CRYPTO_MODULE_NAME,
-	.crypt      = &atheme_argon2_crypt,
-	.verify     = &atheme_argon2_verify,
+	.id             = CRYPTO_MODULE_NAME,
+	.crypt          = &atheme_argon2_crypt,
+	.verify         = &atheme_argon2_verify,
+	.prefixes       = crypto_argon2_prefixes,
+	.params         = &atheme_argon2_params,
+	.params_size    = sizeof atheme_argon2_params,
 };
 
 static void
@@ -402,19 +426,19 @@ mod_init(struct module *const restrict m)
 
 	(void) add_conf_item("argon2_type", *crypto_conf_table, &c_ci_argon2_type);
 
-	(void) add_uint_conf_item("argon2_memcost", *crypto_conf_table, 0, &atheme_argon2_memcost,
+	(void) add_uint_conf_item("argon2_memcost", *crypto_conf_table, 0, &atheme_argon2_params.memcost,
 	                          ATHEME_ARGON2_MEMCOST_MIN, ATHEME_ARGON2_MEMCOST_MAX, ATHEME_ARGON2_MEMCOST_DEF);
 
-	(void) add_uint_conf_item("argon2_timecost", *crypto_conf_table, 0, &atheme_argon2_timecost,
+	(void) add_uint_conf_item("argon2_timecost", *crypto_conf_table, 0, &atheme_argon2_params.timecost,
 	                          ATHEME_ARGON2_TIMECOST_MIN, ATHEME_ARGON2_TIMECOST_MAX, ATHEME_ARGON2_TIMECOST_DEF);
 
-	(void) add_uint_conf_item("argon2_threads", *crypto_conf_table, 0, &atheme_argon2_threads,
+	(void) add_uint_conf_item("argon2_threads", *crypto_conf_table, 0, &atheme_argon2_params.threads,
 	                          ATHEME_ARGON2_THREADS_MIN, ATHEME_ARGON2_THREADS_MAX, ATHEME_ARGON2_THREADS_DEF);
 
-	(void) add_uint_conf_item("argon2_saltlen", *crypto_conf_table, 0, &atheme_argon2_saltlen,
+	(void) add_uint_conf_item("argon2_saltlen", *crypto_conf_table, 0, &atheme_argon2_params.saltlen,
 	                          ATHEME_ARGON2_SALTLEN_MIN, ATHEME_ARGON2_SALTLEN_MAX, ATHEME_ARGON2_SALTLEN_DEF);
 
-	(void) add_uint_conf_item("argon2_hashlen", *crypto_conf_table, 0, &atheme_argon2_hashlen,
+	(void) add_uint_conf_item("argon2_hashlen", *crypto_conf_table, 0, &atheme_argon2_params.hashlen,
 	                          ATHEME_ARGON2_HASHLEN_MIN, ATHEME_ARGON2_HASHLEN_MAX, ATHEME_ARGON2_HASHLEN_DEF);
 
 	(void) crypt_register(&crypto_argon2_impl);
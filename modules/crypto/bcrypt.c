@@ -22,6 +22,7 @@
 
 static mowgli_list_t **crypto_conf_table = NULL;
 
+// Copied for each request to a password verification thread; see crypt_verify_params()
 static unsigned int atheme_bcrypt_cost = ATHEME_BCRYPT_ROUNDS_DEF;
 
 static const char *
@@ -141,10 +142,11 @@ atheme_bcrypt_verify(const char *const restrict password, const char *const rest
 
 		*flags |= PWVERIFY_FLAG_RECRYPT;
 	}
-	if (cost != atheme_bcrypt_cost)
+	const unsigned int *const defcost = crypt_verify_params(&atheme_bcrypt_cost);
+
+	if (cost != *defcost)
 	{
-		(void) slog(LG_DEBUG, "%s: cost (%u) is not the default (%u)", MOWGLI_FUNC_NAME, cost,
-		                      atheme_bcrypt_cost);
+		(void) slog(LG_DEBUG, "%s: cost (%u) is not the default (%u)", MOWGLI_FUNC_NAME, cost, *defcost);
 
 		*flags |= PWVERIFY_FLAG_RECRYPT;
 	}
@@ -157,11 +159,16 @@ cleanup:
 	return retval;
 }
 
+static const char *const crypto_bcrypt_prefixes[] = { "$2a$", "$2b$", NULL };
+
 static const struct crypt_impl crypto_bcrypt_impl = {
 
-	.id        = CRYPTO_MODULE_NAME,
-	.crypt     = &atheme_bcrypt_crypt,
-	.verify    = &atheme_bcrypt_verify,
+	.id             = CRYPTO_MODULE_NAME,
+	.crypt          = &atheme_bcrypt_crypt,
+	.verify         = &atheme_bcrypt_verify,
+	.prefixes       = crypto_bcrypt_prefixes,
+	.params         = &atheme_bcrypt_cost,
+	.params_size    = sizeof atheme_bcrypt_cost,
 };
 
 static void
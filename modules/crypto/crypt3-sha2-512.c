@@ -105,11 +105,15 @@ atheme_crypt3_sha2_512_verify(const char *const restrict password, const char *c
 	return true;
 }
 
+static const char *const crypto_crypt3_prefixes[] = { "$6$", NULL };
+
 static const struct crypt_impl crypto_crypt3_impl = {
 
-	.id        = CRYPTO_MODULE_NAME,
-	.crypt     = &atheme_crypt3_sha2_512_crypt,
-	.verify    = &atheme_crypt3_sha2_512_verify,
+	.id                 = CRYPTO_MODULE_NAME,
+	.crypt              = &atheme_crypt3_sha2_512_crypt,
+	.verify             = &atheme_crypt3_sha2_512_verify,
+	.verify_main_thread = true,
+	.prefixes           = crypto_crypt3_prefixes,
 };
 
 static void
@@ -56,10 +56,13 @@ atheme_crypto_base64_verify(const char *const restrict password, const char *con
 	return (ret == 0);
 }
 
+static const char *const crypto_base64_prefixes[] = { MODULE_PREFIX_STR, NULL };
+
 static const struct crypt_impl crypto_base64_impl = {
 
 	.id         = CRYPTO_MODULE_NAME,
 	.verify     = &atheme_crypto_base64_verify,
+	.prefixes   = crypto_base64_prefixes,
 };
 
 static void
@@ -64,8 +64,9 @@ atheme_crypt3_des_verify(const char *const restrict password, const char *const
 
 static const struct crypt_impl crypto_crypt3_impl = {
 
-	.id        = CRYPTO_MODULE_NAME,
-	.verify    = &atheme_crypt3_des_verify,
+	.id                 = CRYPTO_MODULE_NAME,
+	.verify             = &atheme_crypt3_des_verify,
+	.verify_main_thread = true,
 };
 
 static void
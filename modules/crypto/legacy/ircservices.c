@@ -68,10 +68,13 @@ atheme_ircservices_verify(const char *const restrict password, const char *const
 	return true;
 }
 
+static const char *const crypto_ircservices_prefixes[] = { MODULE_PREFIX_STR, NULL };
+
 static const struct crypt_impl crypto_ircservices_impl = {
 
 	.id         = CRYPTO_MODULE_NAME,
 	.verify     = &atheme_ircservices_verify,
+	.prefixes   = crypto_ircservices_prefixes,
 };
 
 static void
@@ -19,22 +19,29 @@
 
 static mowgli_list_t **crypto_conf_table = NULL;
 
-static unsigned int pbkdf2v2_digest = 0;
-static unsigned int pbkdf2v2_rounds = 0;
-static unsigned int pbkdf2v2_saltsz = 0;
+struct pbkdf2v2_params
+{
+	unsigned int    digest;
+	unsigned int    rounds;
+	unsigned int    saltsz;
+};
+
+// Copied for each request to a password verification thread; see crypt_verify_params()
+static struct pbkdf2v2_params pbkdf2v2_params = { 0, 0, 0 };
 
 static pbkdf2v2_scram_confhook_fn pbkdf2v2_scram_confhook = NULL;
 
 static inline void
 atheme_pbkdf2v2_scram_confhook_dispatch(void)
 {
-	if (! pbkdf2v2_scram_confhook || ! pbkdf2v2_digest || ! pbkdf2v2_rounds || ! pbkdf2v2_saltsz)
+	if (! pbkdf2v2_scram_confhook || ! pbkdf2v2_params.digest || ! pbkdf2v2_params.rounds ||
+	    ! pbkdf2v2_params.saltsz)
 		return;
 
 	struct pbkdf2v2_scram_config pbkdf2v2_scram_config = {
-		.a      = pbkdf2v2_digest,
-		.c      = pbkdf2v2_rounds,
-		.sl     = pbkdf2v2_saltsz,
+		.a      = pbkdf2v2_params.digest,
+		.c      = pbkdf2v2_params.rounds,
+		.sl     = pbkdf2v2_params.saltsz,
 	};
 
 	(void) (*pbkdf2v2_scram_confhook)(&pbkdf2v2_scram_config);
@@ -43,14 +50,14 @@ atheme_pbkdf2v2_scram_confhook_dispatch(void)
 static void
 atheme_pbkdf2v2_config_ready(void ATHEME_VATTR_UNUSED *const restrict unused)
 {
-	if (! pbkdf2v2_digest)
-		pbkdf2v2_digest = PBKDF2_PRF_DEFAULT;
+	if (! pbkdf2v2_params.digest)
+		pbkdf2v2_params.digest = PBKDF2_PRF_DEFAULT;
 
-	if (! pbkdf2v2_rounds)
-		pbkdf2v2_rounds = PBKDF2_ITERCNT_DEF;
+	if (! pbkdf2v2_params.rounds)
+		pbkdf2v2_params.rounds = PBKDF2_ITERCNT_DEF;
 
-	if (! pbkdf2v2_saltsz)
-		pbkdf2v2_saltsz = PBKDF2_SALTLEN_DEF;
+	if (! pbkdf2v2_params.saltsz)
+		pbkdf2v2_params.saltsz = PBKDF2_SALTLEN_DEF;
 
 	(void) atheme_pbkdf2v2_scram_confhook_dispatch();
 }
@@ -280,24 +287,26 @@ end:
 static bool
 atheme_pbkdf2v2_recrypt(const struct pbkdf2v2_dbentry *const restrict dbe)
 {
-	if (dbe->a != pbkdf2v2_digest)
+	const struct pbkdf2v2_params *const params = crypt_verify_params(&pbkdf2v2_params);
+
+	if (dbe->a != params->digest)
 	{
-		(void) slog(LG_DEBUG, "%s: prf (%u) != default (%u)", MOWGLI_FUNC_NAME, dbe->a, pbkdf2v2_digest);
+		(void) slog(LG_DEBUG, "%s: prf (%u) != default (%u)", MOWGLI_FUNC_NAME, dbe->a, params->digest);
 		return true;
 	}
 
-	if (dbe->c != pbkdf2v2_rounds)
+	if (dbe->c != params->rounds)
 	{
-		(void) slog(LG_DEBUG, "%s: rounds (%u) != default (%u)", MOWGLI_FUNC_NAME, dbe->c, pbkdf2v2_rounds);
+		(void) slog(LG_DEBUG, "%s: rounds (%u) != default (%u)", MOWGLI_FUNC_NAME, dbe->c, params->rounds);
 		return true;
 	}
 
 	if (atheme_pbkdf2v2_salt_is_b64(dbe->a))
 	{
-		if (dbe->sl != pbkdf2v2_saltsz)
+		if (dbe->sl != params->saltsz)
 		{
 			(void) slog(LG_DEBUG, "%s: salt length (%zu) != default (%u)", MOWGLI_FUNC_NAME, dbe->sl,
-			                      pbkdf2v2_saltsz);
+			                      params->saltsz);
 			return true;
 		}
 	}
@@ -438,18 +447,19 @@ const struct pbkdf2v2_scram_functions pbkdf2v2_scram_functions = {
 
 #endif /* HAVE_LIBIDN */
 
-static bool ATHEME_FATTR_WUR
-atheme_pbkdf2v2_compute(const char *const restrict password, struct pbkdf2v2_dbentry *const restrict dbe)
+// Copies the password into key (PASSLEN + 1 bytes) as it is given to PBKDF2; returns its length, or 0 on failure
+static size_t ATHEME_FATTR_WUR
+atheme_pbkdf2v2_key(const char *const restrict password, const struct pbkdf2v2_dbentry *const restrict dbe,
+                    char *const restrict key)
 {
-	char key[PASSLEN + 1];
-	(void) mowgli_strlcpy(key, password, sizeof key);
+	(void) mowgli_strlcpy(key, password, PASSLEN + 1);
 
 #ifdef HAVE_LIBIDN
-	if (dbe->scram && ! atheme_pbkdf2v2_scram_normalize(key, sizeof key))
+	if (dbe->scram && ! atheme_pbkdf2v2_scram_normalize(key, PASSLEN + 1))
 	{
 		(void) slog(LG_DEBUG, "%s: SASLprep normalization of password failed", MOWGLI_FUNC_NAME);
-		(void) smemzero(key, sizeof key);
-		return false;
+		(void) smemzero(key, PASSLEN + 1);
+		return 0;
 	}
 #endif /* HAVE_LIBIDN */
 
@@ -458,10 +468,23 @@ atheme_pbkdf2v2_compute(const char *const restrict password, struct pbkdf2v2_dbe
 	if (! kl)
 	{
 		(void) slog(LG_DEBUG, "%s: password length == 0", MOWGLI_FUNC_NAME);
-		(void) smemzero(key, sizeof key);
-		return false;
+		(void) smemzero(key, PASSLEN + 1);
+		return 0;
 	}
 
+	return kl;
+}
+
+static bool ATHEME_FATTR_WUR
+atheme_pbkdf2v2_compute(const char *const restrict password, struct pbkdf2v2_dbentry *const restrict dbe)
+{
+	char key[PASSLEN + 1];
+	const size_t kl = atheme_pbkdf2v2_key(password, dbe, key);
+
+	if (! kl)
+		// This function logs messages on failure
+		return false;
+
 	if (! digest_oneshot_pbkdf2(dbe->md, key, kl, dbe->salt, dbe->sl, dbe->c, dbe->cdg, dbe->dl))
 	{
 		(void) slog(LG_ERROR, "%s: digest_oneshot_pbkdf2() for cdg failed (BUG)", MOWGLI_FUNC_NAME);
@@ -487,9 +510,9 @@ atheme_pbkdf2v2_crypt(const char *const restrict password,
 
 	(void) memset(&dbe, 0x00, sizeof dbe);
 
-	dbe.sl = (size_t) pbkdf2v2_saltsz;
-	dbe.a = pbkdf2v2_digest;
-	dbe.c = pbkdf2v2_rounds;
+	dbe.sl = (size_t) pbkdf2v2_params.saltsz;
+	dbe.a = pbkdf2v2_params.digest;
+	dbe.c = pbkdf2v2_params.rounds;
 
 	(void) atheme_random_buf(dbe.salt, dbe.sl);
 
@@ -559,54 +582,54 @@ done:
 	return retval;
 }
 
+// Parses a hash for verification; dbe is zeroed by the caller afterwards
 static bool ATHEME_FATTR_WUR
-atheme_pbkdf2v2_verify(const char *const restrict password, const char *const restrict parameters,
-                       unsigned int *const restrict flags)
+atheme_pbkdf2v2_verify_parse(struct pbkdf2v2_dbentry *const restrict dbe, const char *const restrict parameters)
 {
-	unsigned char csk[DIGEST_MDLEN_MAX];
-	struct pbkdf2v2_dbentry dbe;
-	bool retval = false;
-
-	if (! atheme_pbkdf2v2_parse_dbentry(&dbe, parameters))
+	if (! atheme_pbkdf2v2_parse_dbentry(dbe, parameters))
 		// This function logs messages on failure
-		goto end;
+		return false;
 
-	if (atheme_pbkdf2v2_salt_is_b64(dbe.a))
+	if (atheme_pbkdf2v2_salt_is_b64(dbe->a))
 	{
-		if ((dbe.sl = base64_decode(dbe.salt64, dbe.salt, sizeof dbe.salt)) == BASE64_FAIL)
+		if ((dbe->sl = base64_decode(dbe->salt64, dbe->salt, sizeof dbe->salt)) == BASE64_FAIL)
 		{
-			(void) slog(LG_ERROR, "%s: base64_decode('%s') for salt failed", MOWGLI_FUNC_NAME, dbe.salt64);
-			goto end;
+			(void) slog(LG_ERROR, "%s: base64_decode('%s') for salt failed", MOWGLI_FUNC_NAME, dbe->salt64);
+			return false;
 		}
 
-		if (! atheme_pbkdf2v2_parameters_sane(&dbe))
+		if (! atheme_pbkdf2v2_parameters_sane(dbe))
 			// This function logs messages on failure
-			goto end;
+			return false;
 	}
 	else
 	{
-		dbe.sl = strlen(dbe.salt64);
+		dbe->sl = strlen(dbe->salt64);
 
-		if (! atheme_pbkdf2v2_parameters_sane(&dbe))
+		if (! atheme_pbkdf2v2_parameters_sane(dbe))
 			// This function logs messages on failure
-			goto end;
+			return false;
 
-		(void) memcpy(dbe.salt, dbe.salt64, dbe.sl);
+		(void) memcpy(dbe->salt, dbe->salt64, dbe->sl);
 	}
 
-	*flags |= PWVERIFY_FLAG_MYMODULE;
+	return true;
+}
 
-	if (! atheme_pbkdf2v2_compute(password, &dbe))
-		// This function logs messages on failure
-		goto end;
+// Compares the computed digest (cdg) with the hash
+static bool ATHEME_FATTR_WUR
+atheme_pbkdf2v2_verify_check(const struct pbkdf2v2_dbentry *const restrict dbe, unsigned int *const restrict flags)
+{
+	unsigned char csk[DIGEST_MDLEN_MAX];
+	bool retval = false;
 
-	if (dbe.scram)
+	if (dbe->scram)
 	{
-		if (! atheme_pbkdf2v2_scram_derive(&dbe, dbe.cdg, csk, NULL))
+		if (! atheme_pbkdf2v2_scram_derive(dbe, dbe->cdg, csk, NULL))
 			// This function logs messages on failure
 			goto end;
 
-		if (smemcmp(dbe.ssk, csk, dbe.dl) != 0)
+		if (smemcmp(dbe->ssk, csk, dbe->dl) != 0)
 		{
 			(void) slog(LG_DEBUG, "%s: smemcmp() mismatch on ssk (invalid password?)", MOWGLI_FUNC_NAME);
 			goto end;
@@ -614,24 +637,140 @@ atheme_pbkdf2v2_verify(const char *const restrict password, const char *const re
 	}
 	else
 	{
-		if (smemcmp(dbe.sdg, dbe.cdg, dbe.dl) != 0)
+		if (smemcmp(dbe->sdg, dbe->cdg, dbe->dl) != 0)
 		{
 			(void) slog(LG_DEBUG, "%s: smemcmp() mismatch on sdg (invalid password?)", MOWGLI_FUNC_NAME);
 			goto end;
 		}
 	}
 
-	if (atheme_pbkdf2v2_recrypt(&dbe))
+	if (atheme_pbkdf2v2_recrypt(dbe))
 		*flags |= PWVERIFY_FLAG_RECRYPT;
 
 	retval = true;
 
 end:
 	(void) smemzero(csk, sizeof csk);
+	return retval;
+}
+
+static bool ATHEME_FATTR_WUR
+atheme_pbkdf2v2_verify(const char *const restrict password, const char *const restrict parameters,
+                       unsigned int *const restrict flags)
+{
+	struct pbkdf2v2_dbentry dbe;
+	bool retval = false;
+
+	if (! atheme_pbkdf2v2_verify_parse(&dbe, parameters))
+		// This function logs messages on failure
+		goto end;
+
+	*flags |= PWVERIFY_FLAG_MYMODULE;
+
+	if (! atheme_pbkdf2v2_compute(password, &dbe))
+		// This function logs messages on failure
+		goto end;
+
+	retval = atheme_pbkdf2v2_verify_check(&dbe, flags);
+
+end:
 	(void) smemzero(&dbe, sizeof dbe);
 	return retval;
 }
 
+// Hashes whose derivations can run together: those with the same SHA2 PRF digest and iteration count
+static bool ATHEME_FATTR_WUR
+atheme_pbkdf2v2_batch_key(const char *const restrict parameters, uint64_t *const restrict key)
+{
+	struct pbkdf2v2_dbentry dbe;
+
+	(void) memset(&dbe, 0x00, sizeof dbe);
+
+	if (sscanf(parameters, PBKDF2_FN_PREFIX, &dbe.a, &dbe.c) != 2 || ! atheme_pbkdf2v2_determine_params(&dbe))
+		return false;
+
+	if (dbe.md != DIGALG_SHA2_256 && dbe.md != DIGALG_SHA2_512)
+		return false;
+
+	*key = ((uint64_t) dbe.md << 32) | dbe.c;
+	return true;
+}
+
+struct pbkdf2v2_batch_entry
+{
+	struct pbkdf2v2_dbentry dbe;
+	char                    key[PASSLEN + 1];
+	bool                    queued;                 // in the batch given to digest_oneshot_pbkdf2_batch()
+};
+
+static void
+atheme_pbkdf2v2_verify_batch(struct crypt_verify_job *const restrict jobs, const size_t n)
+{
+	struct pbkdf2v2_batch_entry *const ents = scalloc(n, sizeof *ents);
+	struct digest_pbkdf2_job *const djobs = scalloc(n, sizeof *djobs);
+	const struct pbkdf2v2_dbentry *first = NULL;
+	size_t dn = 0;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		struct pbkdf2v2_batch_entry *const ent = &ents[i];
+		size_t kl;
+
+		(void) crypt_verify_job_enter(&jobs[i]);
+
+		if (! atheme_pbkdf2v2_verify_parse(&ent->dbe, jobs[i].parameters))
+			// This function logs messages on failure
+			continue;
+
+		jobs[i].flags |= PWVERIFY_FLAG_MYMODULE;
+
+		// The batch key should have kept these apart; verify such a hash on its own
+		if (first && (ent->dbe.md != first->md || ent->dbe.c != first->c))
+		{
+			if (atheme_pbkdf2v2_compute(jobs[i].password, &ent->dbe))
+				jobs[i].result = atheme_pbkdf2v2_verify_check(&ent->dbe, &jobs[i].flags);
+
+			continue;
+		}
+
+		if (! (kl = atheme_pbkdf2v2_key(jobs[i].password, &ent->dbe, ent->key)))
+			// This function logs messages on failure
+			continue;
+
+		djobs[dn].pass = ent->key;
+		djobs[dn].passLen = kl;
+		djobs[dn].salt = ent->dbe.salt;
+		djobs[dn].saltLen = ent->dbe.sl;
+		djobs[dn].dk = ent->dbe.cdg;
+		djobs[dn].dkLen = ent->dbe.dl;
+		dn++;
+
+		ent->queued = true;
+
+		if (! first)
+			first = &ent->dbe;
+	}
+
+	if (dn && ! digest_oneshot_pbkdf2_batch(first->md, djobs, dn, first->c))
+	{
+		(void) slog(LG_ERROR, "%s: digest_oneshot_pbkdf2_batch() for cdg failed (BUG)", MOWGLI_FUNC_NAME);
+		dn = 0;
+	}
+
+	for (size_t i = 0; dn && i < n; i++)
+	{
+		if (! ents[i].queued)
+			continue;
+
+		(void) crypt_verify_job_enter(&jobs[i]);
+
+		jobs[i].result = atheme_pbkdf2v2_verify_check(&ents[i].dbe, &jobs[i].flags);
+	}
+
+	(void) smemzerofree(ents, n * sizeof *ents);
+	(void) sfree(djobs);
+}
+
 static int
 c_ci_pbkdf2v2_digest(mowgli_config_file_entry_t *const restrict ce)
 {
@@ -639,7 +778,7 @@ c_ci_pbkdf2v2_digest(mowgli_config_file_entry_t *const restrict ce)
 	{
 		(void) conf_report_warning(ce, "no parameter for configuration option -- using default");
 
-		pbkdf2v2_digest = PBKDF2_PRF_DEFAULT;
+		pbkdf2v2_params.digest = PBKDF2_PRF_DEFAULT;
 		return 0;
 	}
 
@@ -648,7 +787,7 @@ c_ci_pbkdf2v2_digest(mowgli_config_file_entry_t *const restrict ce)
 	{
 		(void) conf_report_warning(ce, "SCRAM mode is unavailable (GNU libidn is missing) -- using default");
 
-		pbkdf2v2_digest = PBKDF2_PRF_DEFAULT;
+		pbkdf2v2_params.digest = PBKDF2_PRF_DEFAULT;
 		return 0;
 	}
 #endif
@@ -656,52 +795,59 @@ c_ci_pbkdf2v2_digest(mowgli_config_file_entry_t *const restrict ce)
 	// Most of these are aliases, for compatibility. Having them around is harmless.   -- amdj
 
 	if (! strcasecmp(ce->vardata, "SHA1"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA1_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA1_S64;
 	else if (! strcasecmp(ce->vardata, "SHA-1"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA1_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA1_S64;
 	else if (! strcasecmp(ce->vardata, "SHA2-256"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SHA-256"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SHA256"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SHA2-512"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
 	else if (! strcasecmp(ce->vardata, "SHA-512"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
 	else if (! strcasecmp(ce->vardata, "SHA512"))
-		pbkdf2v2_digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_HMAC_SHA2_512_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA1"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA1_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA1_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA-1"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA1_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA1_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA2-256"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA-256"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA256"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_256_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA2-512"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA-512"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
 	else if (! strcasecmp(ce->vardata, "SCRAM-SHA512"))
-		pbkdf2v2_digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
+		pbkdf2v2_params.digest = PBKDF2_PRF_SCRAM_SHA2_512_S64;
 	else
 	{
 		(void) conf_report_warning(ce, "invalid parameter for configuration option -- using default");
 
-		pbkdf2v2_digest = PBKDF2_PRF_DEFAULT;
+		pbkdf2v2_params.digest = PBKDF2_PRF_DEFAULT;
 	}
 
 	return 0;
 }
 
+static const char *const crypto_pbkdf2v2_prefixes[] = { "$z$", NULL };
+
 static const struct crypt_impl crypto_pbkdf2v2_impl = {
 
-	.id         = CRYPTO_MODULE_NAME,
-	.crypt      = &atheme_pbkdf2v2_crypt,
-	.verify     = &atheme_pbkdf2v2_verify,
+	.id             = CRYPTO_MODULE_NAME,
+	.crypt          = &atheme_pbkdf2v2_crypt,
+	.verify         = &atheme_pbkdf2v2_verify,
+	.prefixes       = crypto_pbkdf2v2_prefixes,
+	.params         = &pbkdf2v2_params,
+	.params_size    = sizeof pbkdf2v2_params,
+	.batch_key      = &atheme_pbkdf2v2_batch_key,
+	.verify_batch   = &atheme_pbkdf2v2_verify_batch,
 };
 
 static void
@@ -713,10 +859,10 @@ mod_init(struct module *const restrict m)
 
 	(void) add_conf_item("pbkdf2v2_digest", *crypto_conf_table, &c_ci_pbkdf2v2_digest);
 
-	(void) add_uint_conf_item("pbkdf2v2_rounds", *crypto_conf_table, 0, &pbkdf2v2_rounds,
+	(void) add_uint_conf_item("pbkdf2v2_rounds", *crypto_conf_table, 0, &pbkdf2v2_params.rounds,
 	                          PBKDF2_ITERCNT_MIN, PBKDF2_ITERCNT_MAX, PBKDF2_ITERCNT_DEF);
 
-	(void) add_uint_conf_item("pbkdf2v2_saltlen", *crypto_conf_table, 0, &pbkdf2v2_saltsz,
+	(void) add_uint_conf_item("pbkdf2v2_saltlen", *crypto_conf_table, 0, &pbkdf2v2_params.saltsz,
 	                          PBKDF2_SALTLEN_MIN, PBKDF2_SALTLEN_MAX, PBKDF2_SALTLEN_DEF);
 
 	(void) hook_add_config_ready(&atheme_pbkdf2v2_config_ready);
@@ -17,16 +17,25 @@
 
 static mowgli_list_t **crypto_conf_table = NULL;
 
-static unsigned int atheme_scrypt_memlimit = ATHEME_SCRYPT_MEMLIMIT_DEF;
-static unsigned int atheme_scrypt_opslimit = ATHEME_SCRYPT_OPSLIMIT_DEF;
+struct atheme_scrypt_params
+{
+	unsigned int    memlimit;
+	unsigned int    opslimit;
+};
+
+// Copied for each request to a password verification thread; see crypt_verify_params()
+static struct atheme_scrypt_params atheme_scrypt_params = {
+	.memlimit   = ATHEME_SCRYPT_MEMLIMIT_DEF,
+	.opslimit   = ATHEME_SCRYPT_OPSLIMIT_DEF,
+};
 
 static inline size_t
-atheme_scrypt_calc_real_memlimit(void)
+atheme_scrypt_calc_real_memlimit(const struct atheme_scrypt_params *const restrict params)
 {
 	/* libsodium's password hashing API takes memory limits in bytes, but we specify the memory limit
 	 * as a power of 2, in KiB. This matches the configuration interface of libargon2, for consistency.
 	 */
-	return ((1ULL << (size_t) atheme_scrypt_memlimit) * 1024ULL);
+	return ((1ULL << (size_t) params->memlimit) * 1024ULL);
 }
 
 static const char *
@@ -34,8 +43,8 @@ atheme_scrypt_crypt(const char *const restrict password, const char ATHEME_VATTR
 {
 	static char result[PASSLEN + 1];
 
-	const unsigned long long opslimit = atheme_scrypt_opslimit;
-	const size_t memlimit = atheme_scrypt_calc_real_memlimit();
+	const unsigned long long opslimit = atheme_scrypt_params.opslimit;
+	const size_t memlimit = atheme_scrypt_calc_real_memlimit(&atheme_scrypt_params);
 
 	(void) memset(result, 0x00, sizeof result);
 
@@ -45,8 +54,8 @@ atheme_scrypt_crypt(const char *const restrict password, const char ATHEME_VATTR
 
 		(void) slog(LG_ERROR, "%s: encrypting failed (BUG? Incorrect configuration?)", CRYPTO_MODULE_NAME);
 		(void) slog(LG_ERROR, "%s: possibly useful information: opslimit %u, memlimit %u (%zu bytes), "
-		                      "ptrsize %zu, errno %d (%s)", CRYPTO_MODULE_NAME, atheme_scrypt_opslimit,
-		                      atheme_scrypt_memlimit, memlimit, sizeof (void *), errsv, strerror(errsv));
+		                      "ptrsize %zu, errno %d (%s)", CRYPTO_MODULE_NAME, atheme_scrypt_params.opslimit,
+		                      atheme_scrypt_params.memlimit, memlimit, sizeof (void *), errsv, strerror(errsv));
 		return NULL;
 	}
 
@@ -57,8 +66,9 @@ static bool ATHEME_FATTR_WUR
 atheme_scrypt_verify(const char *const restrict password, const char *const restrict parameters,
                      unsigned int *const restrict flags)
 {
-	const unsigned long long opslimit = atheme_scrypt_opslimit;
-	const size_t memlimit = atheme_scrypt_calc_real_memlimit();
+	const struct atheme_scrypt_params *const params = crypt_verify_params(&atheme_scrypt_params);
+	const unsigned long long opslimit = params->opslimit;
+	const size_t memlimit = atheme_scrypt_calc_real_memlimit(params);
 
 	const int needs_rehash = crypto_pwhash_scryptsalsa208sha256_str_needs_rehash(parameters, opslimit, memlimit);
 
@@ -82,11 +92,16 @@ atheme_scrypt_verify(const char *const restrict password, const char *const rest
 	return true;
 }
 
+static const char *const crypto_scrypt_prefixes[] = { "$7$", NULL };
+
 static const struct crypt_impl crypto_scrypt_impl = {
 
-	.id        = CRYPTO_MODULE_NAME,
-	.crypt     = &atheme_scrypt_crypt,
-	.verify    = &atheme_scrypt_verify,
+	.id             = CRYPTO_MODULE_NAME,
+	.crypt          = &atheme_scrypt_crypt,
+	.verify         = &atheme_scrypt_verify,
+	.prefixes       = crypto_scrypt_prefixes,
+	.params         = &atheme_scrypt_params,
+	.params_size    = sizeof atheme_scrypt_params,
 };
 
 static void
@@ -94,10 +109,10 @@ mod_init(struct module *const restrict m)
 {
 	MODULE_TRY_REQUEST_SYMBOL(m, crypto_conf_table, "crypto/main", "crypto_conf_table")
 
-	(void) add_uint_conf_item("scrypt_memlimit", *crypto_conf_table, 0, &atheme_scrypt_memlimit,
+	(void) add_uint_conf_item("scrypt_memlimit", *crypto_conf_table, 0, &atheme_scrypt_params.memlimit,
 	                          ATHEME_SCRYPT_MEMLIMIT_MIN, ATHEME_SCRYPT_MEMLIMIT_MAX, ATHEME_SCRYPT_MEMLIMIT_DEF);
 
-	(void) add_uint_conf_item("scrypt_opslimit", *crypto_conf_table, 0, &atheme_scrypt_opslimit,
+	(void) add_uint_conf_item("scrypt_opslimit", *crypto_conf_table, 0, &atheme_scrypt_params.opslimit,
 	                          ATHEME_SCRYPT_OPSLIMIT_MIN, ATHEME_SCRYPT_OPSLIMIT_MAX, ATHEME_SCRYPT_OPSLIMIT_DEF);
 
 	(void) crypt_register(&crypto_scrypt_impl);
@@ -37,6 +37,7 @@ gs_cmd_acsnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags |= MG_ACSNOLIMIT;
+		db_mark_dirty();
 
 		wallops("\2%s\2 set the ACSNOLIMIT option on the group \2%s\2.", get_oper_name(si), entity(mg)->name);
 		logcommand(si, CMDLOG_ADMIN, "ACSNOLIMIT:ON: \2%s\2", entity(mg)->name);
@@ -51,6 +52,7 @@ gs_cmd_acsnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags &= ~MG_ACSNOLIMIT;
+		db_mark_dirty();
 
 		wallops("\2%s\2 removed the ACSNOLIMIT option from the group \2%s\2.", get_oper_name(si), entity(mg)->name);
 		logcommand(si, CMDLOG_ADMIN, "ACSNOLIMIT:OFF: \2%s\2", entity(mg)->name);
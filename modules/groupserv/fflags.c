@@ -66,7 +66,10 @@ gs_cmd_fflags(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	if (ga != NULL && flags != 0)
+	{
 		ga->flags = flags;
+		db_mark_dirty();
+	}
 	else if (ga != NULL)
 	{
 		groupacs_delete(mg, mt);
@@ -47,6 +47,8 @@ mygroup_delete(struct mygroup *mg)
 	metadata_delete_all(mg);
 	strshare_unref(entity(mg)->name);
 	mowgli_heap_free(mygroup_heap, mg);
+
+	db_mark_dirty();
 }
 
 struct mygroup *
@@ -82,6 +84,8 @@ mygroup_add_id(const char *id, const char *name)
 
 	mg->regtime = CURRTIME;
 
+	db_mark_dirty();
+
 	return mg;
 }
 
@@ -124,6 +128,8 @@ groupacs_add(struct mygroup *mg, struct myentity *mt, unsigned int flags)
 	mowgli_node_add(ga, &ga->gnode, &mg->acs);
 	mowgli_node_add(ga, &ga->unode, myentity_get_membership_list(mt));
 
+	db_mark_dirty();
+
 	return ga;
 }
 
@@ -182,6 +188,8 @@ groupacs_delete(struct mygroup *mg, struct myentity *mt)
 		mowgli_node_delete(&ga->gnode, &mg->acs);
 		mowgli_node_delete(&ga->unode, myentity_get_membership_list(mt));
 		atheme_object_unref(ga);
+
+		db_mark_dirty();
 	}
 }
 
@@ -422,4 +430,6 @@ mygroup_rename(struct mygroup *mg, const char *name)
 	entity(mg)->name = newname;
 
 	myentity_put(entity(mg));
+
+	db_mark_dirty();
 }
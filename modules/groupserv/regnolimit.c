@@ -37,6 +37,7 @@ gs_cmd_regnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags |= MG_REGNOLIMIT;
+		db_mark_dirty();
 
 		wallops("\2%s\2 set the REGNOLIMIT option on the group \2%s\2.", get_oper_name(si), entity(mg)->name);
 		logcommand(si, CMDLOG_ADMIN, "REGNOLIMIT:ON: \2%s\2", entity(mg)->name);
@@ -51,6 +52,7 @@ gs_cmd_regnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags &= ~MG_REGNOLIMIT;
+		db_mark_dirty();
 
 		wallops("\2%s\2 removed the REGNOLIMIT option from the group \2%s\2.", get_oper_name(si), entity(mg)->name);
 		logcommand(si, CMDLOG_ADMIN, "REGNOLIMIT:OFF: \2%s\2", entity(mg)->name);
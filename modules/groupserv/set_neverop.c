@@ -42,6 +42,7 @@ gs_cmd_set_neverop(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags |= MG_NEVEROP;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "NEVEROP:ON: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("The \2%s\2 flag has been set for group \2%s\2."), "NEVEROP", entity(mg)->name);
@@ -55,6 +56,7 @@ gs_cmd_set_neverop(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags &= ~MG_NEVEROP;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "NEVEROP:OFF: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for group \2%s\2."), "NEVEROP", entity(mg)->name);
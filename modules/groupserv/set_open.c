@@ -49,6 +49,7 @@ gs_cmd_set_open(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags |= MG_OPEN;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "OPEN:ON: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("\2%s\2 is now open to anyone joining."), entity(mg)->name);
@@ -62,6 +63,7 @@ gs_cmd_set_open(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags &= ~MG_OPEN;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "OPEN:OFF: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("\2%s\2 is no longer open to anyone joining."), entity(mg)->name);
@@ -43,6 +43,7 @@ gs_cmd_set_public(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags |= MG_PUBLIC;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "PUBLIC:ON: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("\2%s\2 is now public."), entity(mg)->name);
@@ -56,6 +57,7 @@ gs_cmd_set_public(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mg->flags &= ~MG_PUBLIC;
+		db_mark_dirty();
 
 		logcommand(si, CMDLOG_SET, "PUBLIC:OFF: \2%s\2", entity(mg)->name);
 		command_success_nodata(si, _("\2%s\2 is no longer public."), entity(mg)->name);
@@ -75,6 +75,7 @@ account_drop_request(struct myuser *mu)
                         sfree(l->creator);
                         sfree(l->topic);
                         sfree(l);
+                        db_mark_dirty();
 
                         return;
                 }
@@ -100,6 +101,7 @@ account_delete_request(struct myuser *mu)
                         sfree(l->creator);
                         sfree(l->topic);
                         sfree(l);
+                        db_mark_dirty();
 
                         return;
                 }
@@ -154,6 +156,7 @@ helpserv_cmd_request(struct sourceinfo *si, int parc, char *parv[])
 			sfree(l->topic);
 			l->topic = sstrdup(topic);
 			l->ticket_ts = CURRTIME;;
+			db_mark_dirty();
 
 			command_success_nodata(si, _("You have requested help about \2%s\2."), topic);
 			logcommand(si, CMDLOG_REQUEST, "REQUEST: \2%s\2", topic);
@@ -172,6 +175,7 @@ helpserv_cmd_request(struct sourceinfo *si, int parc, char *parv[])
 	l = smalloc(sizeof *l);
 	l->nick = strshare_ref(entity(si->smu)->name);
 	l->ticket_ts = CURRTIME;;
+	db_mark_dirty();
 	l->creator = sstrdup(get_source_name(si));
 	l->topic = sstrdup(topic);
 
@@ -240,6 +244,7 @@ helpserv_cmd_close(struct sourceinfo *si, int parc, char *parv[])
 			sfree(l->creator);
 			sfree(l->topic);
 			sfree(l);
+			db_mark_dirty();
 
 			return;
 		}
@@ -291,6 +296,7 @@ helpserv_cmd_cancel(struct sourceinfo *si, int parc, char *parv[])
                         sfree(l->creator);
                         sfree(l->topic);
                         sfree(l);
+                        db_mark_dirty();
 
                         command_success_nodata(si, _("Your help request has been cancelled."));
 
@@ -340,9 +346,9 @@ static struct command helpserv_cancel = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
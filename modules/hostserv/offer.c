@@ -111,6 +111,7 @@ remove_group_offered_hosts(struct mygroup *mg)
 			strshare_unref(l->creator);
 			sfree(l->vhost);
 			sfree(l);
+			db_mark_dirty();
 		}
 	}
 }
@@ -173,6 +174,7 @@ hs_cmd_offer(struct sourceinfo *si, int parc, char *parv[])
 	l->group = mt;
 	l->vhost = sstrdup(host);
 	l->vhost_ts = CURRTIME;;
+	db_mark_dirty();
 	l->creator = strshare_ref(entity(si->smu)->name);
 
 	mowgli_node_add(l, &l->node, &hs_offeredlist);
@@ -222,6 +224,7 @@ hs_cmd_unoffer(struct sourceinfo *si, int parc, char *parv[])
 		strshare_unref(l->creator);
 		sfree(l->vhost);
 		sfree(l);
+		db_mark_dirty();
 
 		l = hs_offer_find(host, NULL);
 	}
@@ -419,9 +422,9 @@ static struct command hs_take = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
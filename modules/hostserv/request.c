@@ -75,6 +75,7 @@ remove_request_from_list(mowgli_node_t *const restrict n)
 
 	mowgli_node_delete(n, &hs_reqlist);
 	mowgli_node_free(n);
+	db_mark_dirty();
 }
 
 static void
@@ -320,6 +321,7 @@ hs_cmd_request(struct sourceinfo *si, int parc, char *parv[])
 			sfree(l->vhost);
 			l->vhost = sstrdup(host);
 			l->vhost_ts = CURRTIME;
+			db_mark_dirty();
 
 			command_success_nodata(si, _("You have requested vhost \2%s\2."), host);
 
@@ -348,6 +350,7 @@ hs_cmd_request(struct sourceinfo *si, int parc, char *parv[])
 
 	n = mowgli_node_create();
 	mowgli_node_add(l, n, &hs_reqlist);
+	db_mark_dirty();
 
 	command_success_nodata(si, _("You have requested vhost \2%s\2."), host);
 
@@ -572,9 +575,9 @@ static struct command hs_activate = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
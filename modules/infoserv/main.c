@@ -267,6 +267,7 @@ is_cmd_post(struct sourceinfo *si, int parc, char *parv[])
 
 	mowgli_list_t *list = (imp == 0) ? &operlogon_info : &logon_info;
 	mowgli_node_add(l, &l->node, list);
+	db_mark_dirty();
 
 	command_success_nodata(si, _("Added entry to logon info"));
 	if (logoninfo_count != 0 && !logoninfo_reverse && list->count > logoninfo_count)
@@ -336,6 +337,7 @@ is_del_impl(struct sourceinfo *si, int parc, char *parv[], bool oper)
 			sfree(l->subject);
 			sfree(l->story);
 			sfree(l);
+			db_mark_dirty();
 
 			if (oper)
 				command_success_nodata(si, _("Deleted entry %u from oper logon info."), id);
@@ -456,6 +458,7 @@ is_move_impl(struct sourceinfo *si, int parc, char *parv[], bool oper)
 
 	mowgli_node_delete(from_node, list);
 	mowgli_node_add_before(entry, from_node, list, to_node);
+	db_mark_dirty();
 
 	if (oper)
 		command_success_nodata(si, _("Oper logon info entry \2%u\2 moved to position \2%u\2."), from_id, to_id);
@@ -612,9 +615,9 @@ static struct command is_olist = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
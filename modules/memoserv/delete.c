@@ -80,14 +80,7 @@ ms_cmd_delete(struct sourceinfo *si, int parc, char *parv[])
 		{
 			delcount++;
 
-			if (!(memo->status & MEMO_READ))
-				si->smu->memoct_new--;
-
-			// Free to node pool, remove from chain
-			mowgli_node_delete(n, &si->smu->memos);
-			mowgli_node_free(n);
-
-			sfree(memo);
+			mymemo_delete(si->smu, n);
 		}
 
 	}
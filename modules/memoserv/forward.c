@@ -15,8 +15,10 @@ ms_cmd_forward(struct sourceinfo *si, int parc, char *parv[])
 	// Misc structs etc
 	struct user *tu;
 	struct myuser *tmu;
-	struct mymemo *memo, *newmemo;
-	mowgli_node_t *n, *temp;
+	struct mymemo *memo;
+	mowgli_node_t *n;
+	char buf[MEMOLEN + 1];
+	const char *text;
 	unsigned int i = 1, memonum = 0;
 	struct service *const memoserv = service_find("memoserv");
 
@@ -90,18 +92,19 @@ ms_cmd_forward(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	// rate limit it -- jilles
-	if (CURRTIME - si->smu->memo_ratelimit_time > MEMO_MAX_TIME)
-		si->smu->memo_ratelimit_num = 0;
-	if (si->smu->memo_ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
+	const struct myuser_ext *const mue = myuser_ext_peek(si->smu);
+	const unsigned int ratelimit_num = (CURRTIME - mue->memo_ratelimit_time > MEMO_MAX_TIME) ? 0 : mue->memo_ratelimit_num;
+	if (ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
 	{
 		command_fail(si, fault_toomany, _("Too many memos; please wait a while and try again"));
 		return;
 	}
-	si->smu->memo_ratelimit_num++;
-	si->smu->memo_ratelimit_time = CURRTIME;
+	struct myuser_ext *const smue = myuser_ext(si->smu);
+	smue->memo_ratelimit_num = ratelimit_num + 1;
+	smue->memo_ratelimit_time = CURRTIME;
 
 	// Make sure we're not on ignore
-	MOWGLI_ITER_FOREACH(n, tmu->memo_ignores.head)
+	MOWGLI_ITER_FOREACH(n, myuser_ext_peek(tmu)->memo_ignores.head)
 	{
 		struct mynick *mn;
 		struct myuser *mu;
@@ -130,22 +133,19 @@ ms_cmd_forward(struct sourceinfo *si, int parc, char *parv[])
 		{
 			// should have some function for send here...  ask nenolod
 			memo = (struct mymemo *)n->data;
-			newmemo = smalloc(sizeof *newmemo);
 
-			// Create memo
-			newmemo->sent = CURRTIME;
-			mowgli_strlcpy(newmemo->sender, entity(si->smu)->name, sizeof newmemo->sender);
-			mowgli_strlcpy(newmemo->text, memo->text, sizeof newmemo->text);
+			if ((text = mymemo_text(memo, buf)) == NULL)
+			{
+				command_fail(si, fault_internalerror, _("That memo could not be read."));
+				return;
+			}
 
-			// Create node, add to their linked list of memos
-			temp = mowgli_node_create();
-			mowgli_node_add(newmemo, temp, &tmu->memos);
-			tmu->memoct_new++;
+			(void) mymemo_add(tmu, entity(si->smu)->name, text, CURRTIME, 0);
 
 			// Should we email this?
 			if (tmu->flags & MU_EMAILMEMOS)
 			{
-				sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, memo->text);
+				sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, text);
 			}
 		}
 		i++;
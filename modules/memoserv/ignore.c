@@ -58,14 +58,14 @@ ms_cmd_ignore_add(struct sourceinfo *si, int parc, char *parv[])
 	newnick = entity(tmu)->name;
 
 	// Ignore list is full
-	if (si->smu->memo_ignores.count >= MAXMSIGNORES)
+	if (myuser_ext_peek(si->smu)->memo_ignores.count >= MAXMSIGNORES)
 	{
 		command_fail(si, fault_toomany, _("Your ignore list is full, please DEL an account."));
 		return;
 	}
 
 	// Iterate through list, make sure target not in it, if last node append
-	MOWGLI_ITER_FOREACH(n, si->smu->memo_ignores.head)
+	MOWGLI_ITER_FOREACH(n, myuser_ext_peek(si->smu)->memo_ignores.head)
 	{
 		temp = (char *)n->data;
 
@@ -79,7 +79,8 @@ ms_cmd_ignore_add(struct sourceinfo *si, int parc, char *parv[])
 
 	// Add to ignore list
 	temp = sstrdup(newnick);
-	mowgli_node_add(temp, mowgli_node_create(), &si->smu->memo_ignores);
+	mowgli_node_add(temp, mowgli_node_create(), &myuser_ext(si->smu)->memo_ignores);
+	db_record_changed(DB_RECORD_MEMOS, si->smu, NULL);
 	logcommand(si, CMDLOG_SET, "IGNORE:ADD: \2%s\2", newnick);
 	command_success_nodata(si, _("Account \2%s\2 added to your ignore list."), newnick);
 	return;
@@ -100,7 +101,7 @@ ms_cmd_ignore_del(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	// Iterate through list, make sure they're not in it, if last node append
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, si->smu->memo_ignores.head)
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, myuser_ext_peek(si->smu)->memo_ignores.head)
 	{
 		temp = (char *)n->data;
 
@@ -109,9 +110,10 @@ ms_cmd_ignore_del(struct sourceinfo *si, int parc, char *parv[])
 		{
 			logcommand(si, CMDLOG_SET, "IGNORE:DEL: \2%s\2", temp);
 			command_success_nodata(si, _("Account \2%s\2 removed from ignore list."), temp);
-			mowgli_node_delete(n, &si->smu->memo_ignores);
+			mowgli_node_delete(n, &myuser_ext(si->smu)->memo_ignores);
 			mowgli_node_free(n);
 			sfree(temp);
+			db_record_changed(DB_RECORD_MEMOS, si->smu, NULL);
 
 			return;
 		}
@@ -126,19 +128,21 @@ ms_cmd_ignore_clear(struct sourceinfo *si, int parc, char *parv[])
 {
 	mowgli_node_t *n, *tn;
 
-	if (MOWGLI_LIST_LENGTH(&si->smu->memo_ignores) == 0)
+	if (MOWGLI_LIST_LENGTH(&myuser_ext_peek(si->smu)->memo_ignores) == 0)
 	{
 		command_fail(si, fault_nochange, _("Ignore list already empty."));
 		return;
 	}
 
-	MOWGLI_ITER_FOREACH_SAFE(n, tn, si->smu->memo_ignores.head)
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, myuser_ext_peek(si->smu)->memo_ignores.head)
 	{
 		sfree(n->data);
-		mowgli_node_delete(n,&si->smu->memo_ignores);
+		mowgli_node_delete(n,&myuser_ext(si->smu)->memo_ignores);
 		mowgli_node_free(n);
 	}
 
+	db_record_changed(DB_RECORD_MEMOS, si->smu, NULL);
+
 	// Let them know list is clear
 	command_success_nodata(si, _("Ignore list cleared."));
 	logcommand(si, CMDLOG_SET, "IGNORE:CLEAR");
@@ -156,7 +160,7 @@ ms_cmd_ignore_list(struct sourceinfo *si, int parc, char *parv[])
 	command_success_nodata(si, "--------------------------------");
 
 	// Iterate through list, make sure they're not in it, if last node append
-	MOWGLI_ITER_FOREACH(n, si->smu->memo_ignores.head)
+	MOWGLI_ITER_FOREACH(n, myuser_ext_peek(si->smu)->memo_ignores.head)
 	{
 		command_success_nodata(si, "%u - %s", i, (char *)n->data);
 		i++;
@@ -16,10 +16,13 @@ ms_cmd_read(struct sourceinfo *si, int parc, char *parv[])
 {
 	// Misc structs etc
 	struct myuser *tmu;
-	struct mymemo *memo, *receipt;
+	struct mymemo *memo;
 	mowgli_node_t *n;
 	unsigned int i = 1, memonum = 0, numread = 0;
 	char strfbuf[BUFSIZE];
+	char text[MEMOLEN + 1];
+	char body[MEMOLEN + 1];
+	const char *memotext;
 	struct tm *tm;
 	bool readnew;
 
@@ -69,6 +72,7 @@ ms_cmd_read(struct sourceinfo *si, int parc, char *parv[])
 			{
 				memo->status |= MEMO_READ;
 				si->smu->memoct_new--;
+				db_record_changed(DB_RECORD_MEMOS, si->smu, NULL);
 				tmu = myuser_find(memo->sender);
 
 				/* If the sender is logged in, tell them the memo's been read */
@@ -82,23 +86,16 @@ ms_cmd_read(struct sourceinfo *si, int parc, char *parv[])
 					// If they have an account, their inbox is not full and they aren't memoserv
 					if ( (tmu != NULL) && (tmu->memos.count < me.mdlimit) && strcasecmp(si->service->nick, memo->sender))
 					{
-						// Malloc and populate memo struct
-						receipt = smalloc(sizeof *receipt);
-						receipt->sent = CURRTIME;
-						mowgli_strlcpy(receipt->sender, si->service->nick, sizeof receipt->sender);
-						snprintf(receipt->text, sizeof receipt->text, "%s has read a memo from you sent at %s", entity(si->smu)->name, strfbuf);
-
-						// Attach to their linked list
-						n = mowgli_node_create();
-						mowgli_node_add(receipt, n, &tmu->memos);
-						tmu->memoct_new++;
+						snprintf(text, sizeof text, "%s has read a memo from you sent at %s", entity(si->smu)->name, strfbuf);
+						(void) mymemo_add(tmu, si->service->nick, text, CURRTIME, 0);
 					}
 				}
 			}
 
 			command_success_nodata(si, _("\2Memo %u - Sent by %s, %s\2"), i, memo->sender, strfbuf);
 			command_success_nodata(si, "----------------------------------------------------------------");
-			command_success_nodata(si, "%s", memo->text);
+			memotext = mymemo_text(memo, body);
+			command_success_nodata(si, "%s", memotext ? memotext : _("(This memo could not be read.)"));
 			command_success_nodata(si, "----------------------------------------------------------------");
 
 			if (!readnew)
@@ -18,7 +18,6 @@ ms_cmd_send(struct sourceinfo *si, int parc, char *parv[])
 	struct user *tu;
 	struct myuser *tmu;
 	mowgli_node_t *n;
-	struct mymemo *memo;
 	struct command *cmd;
 	struct service *memoserv;
 
@@ -41,9 +40,9 @@ ms_cmd_send(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	// rate limit it -- jilles
-	if (CURRTIME - si->smu->memo_ratelimit_time > MEMO_MAX_TIME)
-		si->smu->memo_ratelimit_num = 0;
-	if (si->smu->memo_ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
+	const struct myuser_ext *const mue = myuser_ext_peek(si->smu);
+	const unsigned int ratelimit_num = (CURRTIME - mue->memo_ratelimit_time > MEMO_MAX_TIME) ? 0 : mue->memo_ratelimit_num;
+	if (ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
 	{
 		command_fail(si, fault_toomany, _("You have used this command too many times; please wait a while and try again."));
 		return;
@@ -80,8 +79,9 @@ ms_cmd_send(struct sourceinfo *si, int parc, char *parv[])
 			return;
 		}
 
-		si->smu->memo_ratelimit_num++;
-		si->smu->memo_ratelimit_time = CURRTIME;
+		struct myuser_ext *const smue = myuser_ext(si->smu);
+		smue->memo_ratelimit_num = ratelimit_num + 1;
+		smue->memo_ratelimit_time = CURRTIME;
 
 		// Does the user allow memos? --pfish
 		if (tmu->flags & MU_NOMEMO)
@@ -99,7 +99,7 @@ ms_cmd_send(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		// Make sure we're not on ignore
-		MOWGLI_ITER_FOREACH(n, tmu->memo_ignores.head)
+		MOWGLI_ITER_FOREACH(n, myuser_ext_peek(tmu)->memo_ignores.head)
 		{
 			struct mynick *mn;
 			struct myuser *mu;
@@ -120,21 +120,12 @@ ms_cmd_send(struct sourceinfo *si, int parc, char *parv[])
 		}
 		logcommand(si, CMDLOG_SET, "SEND: to \2%s\2", entity(tmu)->name);
 
-		// Malloc and populate struct
-		memo = smalloc(sizeof *memo);
-		memo->sent = CURRTIME;
-		mowgli_strlcpy(memo->sender, entity(si->smu)->name, sizeof memo->sender);
-		mowgli_strlcpy(memo->text, m, sizeof memo->text);
-
-		// Create a linked list node and add to memos
-		n = mowgli_node_create();
-		mowgli_node_add(memo, n, &tmu->memos);
-		tmu->memoct_new++;
+		(void) mymemo_add(tmu, entity(si->smu)->name, m, CURRTIME, 0);
 
 		// Should we email this?
 	        if (tmu->flags & MU_EMAILMEMOS)
 		{
-			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, memo->text);
+			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, m);
 	        }
 
 		/* Note: do not disclose other nicks they're logged in with
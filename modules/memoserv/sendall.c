@@ -17,7 +17,6 @@ ms_cmd_sendall(struct sourceinfo *si, int parc, char *parv[])
 	// misc structs etc
 	struct myentity *mt;
 	mowgli_node_t *n;
-	struct mymemo *memo;
 	unsigned int sent = 0, tried = 0;
 	bool ignored;
 	struct service *memoserv;
@@ -45,9 +44,9 @@ ms_cmd_sendall(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	// rate limit it -- jilles
-	if (CURRTIME - si->smu->memo_ratelimit_time > MEMO_MAX_TIME)
-		si->smu->memo_ratelimit_num = 0;
-	if (si->smu->memo_ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
+	const struct myuser_ext *const mue = myuser_ext_peek(si->smu);
+	const unsigned int ratelimit_num = (CURRTIME - mue->memo_ratelimit_time > MEMO_MAX_TIME) ? 0 : mue->memo_ratelimit_num;
+	if (ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
 	{
 		command_fail(si, fault_toomany, _("You have used this command too many times; please wait a while and try again."));
 		return;
@@ -69,8 +68,9 @@ ms_cmd_sendall(struct sourceinfo *si, int parc, char *parv[])
 		return;
 	}
 
-	si->smu->memo_ratelimit_num++;
-	si->smu->memo_ratelimit_time = CURRTIME;
+	struct myuser_ext *const smue = myuser_ext(si->smu);
+	smue->memo_ratelimit_num = ratelimit_num + 1;
+	smue->memo_ratelimit_time = CURRTIME;
 
 	MYENTITY_FOREACH_T(mt, &state, ENT_USER)
 	{
@@ -94,7 +94,7 @@ ms_cmd_sendall(struct sourceinfo *si, int parc, char *parv[])
 
 		// Make sure we're not on ignore
 		ignored = false;
-		MOWGLI_ITER_FOREACH(n, tmu->memo_ignores.head)
+		MOWGLI_ITER_FOREACH(n, myuser_ext_peek(tmu)->memo_ignores.head)
 		{
 			struct mynick *mn;
 			struct myuser *mu;
@@ -112,22 +112,12 @@ ms_cmd_sendall(struct sourceinfo *si, int parc, char *parv[])
 		if (ignored)
 			continue;
 
-		// Malloc and populate struct
-		memo = smalloc(sizeof *memo);
-		memo->sent = CURRTIME;
-		memo->status = MEMO_CHANNEL;
-		mowgli_strlcpy(memo->sender, entity(si->smu)->name, sizeof memo->sender);
-		mowgli_strlcpy(memo->text, m, sizeof memo->text);
-
-		// Create a linked list node and add to memos
-		n = mowgli_node_create();
-		mowgli_node_add(memo, n, &tmu->memos);
-		tmu->memoct_new++;
+		(void) mymemo_add(tmu, entity(si->smu)->name, m, CURRTIME, MEMO_CHANNEL);
 
 		// Should we email this?
 		if (tmu->flags & MU_EMAILMEMOS)
 		{
-			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, memo->text);
+			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, m);
 		}
 
 		memoserv = service_find("memoserv");
@@ -17,8 +17,8 @@ ms_cmd_sendops(struct sourceinfo *si, int parc, char *parv[])
 	// misc structs etc
 	struct myuser *tmu;
 	mowgli_node_t *n, *tn;
-	struct mymemo *memo;
 	struct mychan *mc;
+	char text[MEMOLEN + 1];
 	unsigned int sent = 0, tried = 0;
 	bool ignored, operoverride = false;
 	struct service *memoserv;
@@ -42,9 +42,9 @@ ms_cmd_sendops(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	// rate limit it -- jilles
-	if (CURRTIME - si->smu->memo_ratelimit_time > MEMO_MAX_TIME)
-		si->smu->memo_ratelimit_num = 0;
-	if (si->smu->memo_ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
+	const struct myuser_ext *const mue = myuser_ext_peek(si->smu);
+	const unsigned int ratelimit_num = (CURRTIME - mue->memo_ratelimit_time > MEMO_MAX_TIME) ? 0 : mue->memo_ratelimit_num;
+	if (ratelimit_num > MEMO_MAX_NUM && !has_priv(si, PRIV_FLOOD))
 	{
 		command_fail(si, fault_toomany, _("You have used this command too many times; please wait a while and try again."));
 		return;
@@ -85,8 +85,9 @@ ms_cmd_sendops(struct sourceinfo *si, int parc, char *parv[])
 		}
 	}
 
-	si->smu->memo_ratelimit_num++;
-	si->smu->memo_ratelimit_time = CURRTIME;
+	struct myuser_ext *const smue = myuser_ext(si->smu);
+	smue->memo_ratelimit_num = ratelimit_num + 1;
+	smue->memo_ratelimit_time = CURRTIME;
 
 	MOWGLI_ITER_FOREACH(tn, mc->chanacs.head)
 	{
@@ -111,7 +112,7 @@ ms_cmd_sendops(struct sourceinfo *si, int parc, char *parv[])
 
 		// Make sure we're not on ignore
 		ignored = false;
-		MOWGLI_ITER_FOREACH(n, tmu->memo_ignores.head)
+		MOWGLI_ITER_FOREACH(n, myuser_ext_peek(tmu)->memo_ignores.head)
 		{
 			struct mynick *mn;
 			struct myuser *mu;
@@ -129,22 +130,13 @@ ms_cmd_sendops(struct sourceinfo *si, int parc, char *parv[])
 		if (ignored)
 			continue;
 
-		// Malloc and populate struct
-		memo = smalloc(sizeof *memo);
-		memo->sent = CURRTIME;
-		memo->status = MEMO_CHANNEL;
-		mowgli_strlcpy(memo->sender, entity(si->smu)->name, sizeof memo->sender);
-		snprintf(memo->text, sizeof memo->text, "%s %s", mc->name, m);
-
-		// Create a linked list node and add to memos
-		n = mowgli_node_create();
-		mowgli_node_add(memo, n, &tmu->memos);
-		tmu->memoct_new++;
+		snprintf(text, sizeof text, "%s %s", mc->name, m);
+		(void) mymemo_add(tmu, entity(si->smu)->name, text, CURRTIME, MEMO_CHANNEL);
 
 		// Should we email this?
 		if (tmu->flags & MU_EMAILMEMOS)
 		{
-			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, memo->text);
+			sendemail(si->su, tmu, EMAIL_MEMO, tmu->email, text);
 		}
 
 		memoserv = service_find("memoserv");
@@ -356,6 +356,8 @@ httpd_closehandler(struct connection *cptr)
 	hd = cptr->userdata;
 	if (hd != NULL)
 	{
+		if (hd->pending != NULL && hd->pending_cancel != NULL)
+			hd->pending_cancel(hd->pending);
 		sfree(hd->requestbuf);
 		sfree(hd);
 	}
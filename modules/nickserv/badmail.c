@@ -132,6 +132,7 @@ ns_cmd_badmail(struct sourceinfo *si, int parc, char *parv[])
 
 		n = mowgli_node_create();
 		mowgli_node_add(l, n, &ns_maillist);
+		db_mark_dirty();
 
 		command_success_nodata(si, _("You have banned email address \2%s\2."), email);
 		return;
@@ -159,6 +160,7 @@ ns_cmd_badmail(struct sourceinfo *si, int parc, char *parv[])
 				sfree(l->creator);
 				sfree(l->reason);
 				sfree(l);
+				db_mark_dirty();
 
 				command_success_nodata(si, _("You have unbanned email address \2%s\2."), email);
 				return;
@@ -252,9 +254,9 @@ static struct command ns_badmail = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
@@ -47,9 +47,13 @@ log_enforce_victim_out(struct user *u, struct myuser *mu)
 		return false;
 
 	u->myuser->lastlogin = CURRTIME;
+	db_record_touched(DB_RECORD_MYUSER, u->myuser);
 
 	if ((mn = mynick_find(u->nick)) != NULL)
+	{
 		mn->lastseen = CURRTIME;
+		db_record_touched(DB_RECORD_MYNICK, mn);
+	}
 
 	if (!ircd_logout_or_kill(u, entity(u->myuser)->name))
 	{
@@ -477,6 +481,7 @@ ns_cmd_regain(struct sourceinfo *si, int parc, char *parv[])
 					// logout killed the user...
 					return;
 				si->smu->lastlogin = CURRTIME;
+				db_record_touched(DB_RECORD_MYUSER, si->smu);
 				MOWGLI_ITER_FOREACH_SAFE(n, tn, si->smu->logins.head)
 				{
 					if (n->data == si->su)
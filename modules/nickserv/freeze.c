@@ -99,6 +99,7 @@ ns_cmd_freeze(struct sourceinfo *si, int parc, char *parv[])
 			}
 		}
 		mu->flags |= MU_NOBURSTLOGIN;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 		authcookie_destroy_all(mu);
 
 		wallops("\2%s\2 froze the account \2%s\2 (%s).", get_oper_name(si), target, reason);
@@ -92,9 +92,15 @@ ns_cmd_ghost(struct sourceinfo *si, int parc, char *parv[])
 		 * Perhaps the ghosted nick belonged to someone else, but we were identified to it?
 		 * Try this first. */
 		if (target_u->myuser && target_u->myuser == si->smu)
+		{
 			target_u->myuser->lastlogin = CURRTIME;
+			db_record_touched(DB_RECORD_MYUSER, target_u->myuser);
+		}
 		else
+		{
 			mu->lastlogin = CURRTIME;
+			db_record_touched(DB_RECORD_MYUSER, mu);
+		}
 
 		return;
 	}
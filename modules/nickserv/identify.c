@@ -20,15 +20,151 @@
 #define COMMAND_DESC	N_("Identifies to services for a nickname.")
 #endif
 
+// A login waiting for its password to be verified on another thread
+struct ns_login_pending
+{
+	mowgli_node_t                   node;
+	struct user *                   user;   // cleared by the user_delete hook
+	struct service *                service;
+	struct verify_password_req *    req;
+};
+
+static mowgli_list_t ns_login_pending_list;
+
+static struct ns_login_pending *
+ns_login_pending_find(const struct user *const restrict u)
+{
+	mowgli_node_t *n;
+
+	MOWGLI_ITER_FOREACH(n, ns_login_pending_list.head)
+	{
+		struct ns_login_pending *const pending = n->data;
+
+		if (pending->user == u)
+			return pending;
+	}
+
+	return NULL;
+}
+
+static void
+ns_login_pending_free(struct ns_login_pending *const restrict pending)
+{
+	sfree(pending);
+}
+
+/* A user who quits while their password is being checked may be replaced by
+ * another under the same nickname (or, with UIDs, a reused one); the result
+ * must not be given to them, so the request goes with the user.
+ */
+static void
+ns_login_user_delete(struct user *const u)
+{
+	struct ns_login_pending *const pending = ns_login_pending_find(u);
+
+	if (! pending)
+		return;
+
+	verify_password_cancel(pending->req);
+	mowgli_node_delete(&pending->node, &ns_login_pending_list);
+	ns_login_pending_free(pending);
+}
+
+static void
+ns_login_finish(struct sourceinfo *si, struct user *u, struct myuser *mu, bool verified)
+{
+	mowgli_node_t *n, *tn;
+	char lau[BUFSIZE];
+
+	if (verified)
+	{
+		if (user_loginmaxed(mu))
+		{
+			command_fail(si, fault_toomany, _("There are already \2%zu\2 sessions logged in to \2%s\2 (maximum allowed: %u)."), MOWGLI_LIST_LENGTH(&mu->logins), entity(mu)->name, me.maxlogins);
+			lau[0] = '\0';
+			MOWGLI_ITER_FOREACH(n, mu->logins.head)
+			{
+				if (lau[0] != '\0')
+					mowgli_strlcat(lau, ", ", sizeof lau);
+				mowgli_strlcat(lau, ((struct user *)n->data)->nick, sizeof lau);
+			}
+			command_fail(si, fault_toomany, _("Logged in nicks are: %s"), lau);
+			logcommand(si, CMDLOG_LOGIN, "failed " COMMAND_UC " to \2%s\2 (too many logins)", entity(mu)->name);
+			return;
+		}
+
+		// if they are identified to another account, nuke their session first
+		if (u->myuser)
+		{
+			command_success_nodata(si, _("You have been logged out of \2%s\2."), entity(u->myuser)->name);
+
+			if (ircd_on_logout(u, entity(u->myuser)->name))
+				// logout killed the user...
+				return;
+		        u->myuser->lastlogin = CURRTIME;
+		        db_record_touched(DB_RECORD_MYUSER, u->myuser);
+		        MOWGLI_ITER_FOREACH_SAFE(n, tn, u->myuser->logins.head)
+		        {
+			        if (n->data == u)
+		                {
+		                        mowgli_node_delete(n, &u->myuser->logins);
+		                        mowgli_node_free(n);
+		                        break;
+		                }
+		        }
+		        u->myuser = NULL;
+		}
+
+		command_success_nodata(si, nicksvs.no_nick_ownership ? _("You are now logged in as \2%s\2.") : _("You are now identified for \2%s\2."), entity(mu)->name);
+		myuser_login(si->service, u, mu, true);
+		logcommand(si, CMDLOG_LOGIN, COMMAND_UC);
+
+		return;
+	}
+
+	logcommand(si, CMDLOG_LOGIN, "failed " COMMAND_UC " to \2%s\2 (bad password)", entity(mu)->name);
+
+	command_fail(si, fault_authfail, _("Invalid password for \2%s\2."), entity(mu)->name);
+	bad_password(si, mu);
+}
+
+static void
+ns_login_verified(struct myuser *mu, enum verify_password_result result, void *priv)
+{
+	struct ns_login_pending *const pending = priv;
+	struct user *const u = pending->user;
+
+	mowgli_node_delete(&pending->node, &ns_login_pending_list);
+
+	// Nothing to do if the account was dropped in the meantime
+	if (mu != NULL && curr_uplink != NULL && curr_uplink->conn != NULL)
+	{
+		struct sourceinfo *const si = sourceinfo_create();
+
+		si->su = u;
+		si->smu = u->myuser;
+		si->service = pending->service;
+		si->connection = curr_uplink->conn;
+		si->output_limit = MAX_IRC_OUTPUT_LINES;
+
+		if (u->myuser == mu)
+			command_fail(si, fault_nochange, _("You are already logged in as \2%s\2."), entity(mu)->name);
+		else
+			ns_login_finish(si, u, mu, result == VERIFY_PASSWORD_OK);
+
+		atheme_object_unref(si);
+	}
+
+	ns_login_pending_free(pending);
+}
+
 static void
 ns_cmd_login(struct sourceinfo *si, int parc, char *parv[])
 {
 	struct user *u = si->su;
 	struct myuser *mu;
-	mowgli_node_t *n, *tn;
 	const char *target = parv[0];
 	const char *password = parv[1];
-	char lau[BUFSIZE];
 
 	if (si->su == NULL)
 	{
@@ -42,6 +178,12 @@ ns_cmd_login(struct sourceinfo *si, int parc, char *parv[])
 		return;
 	}
 
+	if (ns_login_pending_find(u) != NULL)
+	{
+		command_fail(si, fault_authfail, _("Your previous password is still being checked; please wait."));
+		return;
+	}
+
 #ifndef NICKSERV_LOGIN
 	if (!nicksvs.no_nick_ownership && target && !password)
 	{
@@ -118,55 +260,40 @@ ns_cmd_login(struct sourceinfo *si, int parc, char *parv[])
 		return;
 	}
 
-	if (verify_password(mu, password))
+	// Only IRC users can wait for the result; anything else is answered right away
+	if (si->v != NULL)
 	{
-		if (user_loginmaxed(mu))
-		{
-			command_fail(si, fault_toomany, _("There are already \2%zu\2 sessions logged in to \2%s\2 (maximum allowed: %u)."), MOWGLI_LIST_LENGTH(&mu->logins), entity(mu)->name, me.maxlogins);
-			lau[0] = '\0';
-			MOWGLI_ITER_FOREACH(n, mu->logins.head)
-			{
-				if (lau[0] != '\0')
-					mowgli_strlcat(lau, ", ", sizeof lau);
-				mowgli_strlcat(lau, ((struct user *)n->data)->nick, sizeof lau);
-			}
-			command_fail(si, fault_toomany, _("Logged in nicks are: %s"), lau);
-			logcommand(si, CMDLOG_LOGIN, "failed " COMMAND_UC " to \2%s\2 (too many logins)", entity(mu)->name);
-			return;
-		}
+		ns_login_finish(si, u, mu, verify_password(mu, password));
+		return;
+	}
 
-		// if they are identified to another account, nuke their session first
-		if (u->myuser)
-		{
-			command_success_nodata(si, _("You have been logged out of \2%s\2."), entity(u->myuser)->name);
+	struct ns_login_pending *const pending = smalloc(sizeof *pending);
 
-			if (ircd_on_logout(u, entity(u->myuser)->name))
-				// logout killed the user...
-				return;
-		        u->myuser->lastlogin = CURRTIME;
-		        MOWGLI_ITER_FOREACH_SAFE(n, tn, u->myuser->logins.head)
-		        {
-			        if (n->data == u)
-		                {
-		                        mowgli_node_delete(n, &u->myuser->logins);
-		                        mowgli_node_free(n);
-		                        break;
-		                }
-		        }
-		        u->myuser = NULL;
-		}
+	pending->user = u;
+	pending->service = si->service;
 
-		command_success_nodata(si, nicksvs.no_nick_ownership ? _("You are now logged in as \2%s\2.") : _("You are now identified for \2%s\2."), entity(mu)->name);
-		myuser_login(si->service, u, mu, true);
-		logcommand(si, CMDLOG_LOGIN, COMMAND_UC);
+	switch (verify_password_async(mu, password, u->ip, &ns_login_verified, pending, &pending->req))
+	{
+		case VERIFY_PASSWORD_OK:
+			ns_login_pending_free(pending);
+			ns_login_finish(si, u, mu, true);
+			return;
 
-		return;
-	}
+		case VERIFY_PASSWORD_FAILED:
+			ns_login_pending_free(pending);
+			ns_login_finish(si, u, mu, false);
+			return;
 
-	logcommand(si, CMDLOG_LOGIN, "failed " COMMAND_UC " to \2%s\2 (bad password)", entity(mu)->name);
+		case VERIFY_PASSWORD_BUSY:
+			ns_login_pending_free(pending);
+			command_fail(si, fault_toomany, _("Too many logins are being processed right now; please try again later."));
+			logcommand(si, CMDLOG_LOGIN, "failed " COMMAND_UC " to \2%s\2 (server busy)", entity(mu)->name);
+			return;
 
-	command_fail(si, fault_authfail, _("Invalid password for \2%s\2."), entity(mu)->name);
-	bad_password(si, mu);
+		case VERIFY_PASSWORD_PENDING:
+			mowgli_node_add(pending, &pending->node, &ns_login_pending_list);
+			return;
+	}
 }
 
 static struct command ns_login = {
@@ -184,12 +311,27 @@ mod_init(struct module *const restrict m)
 	MODULE_TRY_REQUEST_DEPENDENCY(m, "nickserv/main")
 
 	service_named_bind_command("nickserv", &ns_login);
+
+	hook_add_user_delete(&ns_login_user_delete);
 }
 
 static void
 mod_deinit(const enum module_unload_intent ATHEME_VATTR_UNUSED intent)
 {
+	mowgli_node_t *n, *tn;
+
 	service_named_unbind_command("nickserv", &ns_login);
+
+	hook_del_user_delete(&ns_login_user_delete);
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, ns_login_pending_list.head)
+	{
+		struct ns_login_pending *const pending = n->data;
+
+		verify_password_cancel(pending->req);
+		mowgli_node_delete(n, &ns_login_pending_list);
+		ns_login_pending_free(pending);
+	}
 }
 
 SIMPLE_DECLARE_MODULE_V1("nickserv/" COMMAND_LC, MODULE_UNLOAD_CAPABILITY_OK)
@@ -48,6 +48,7 @@ ns_cmd_loginnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mu->flags |= MU_LOGINNOLIMIT;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 
 		wallops("\2%s\2 set the LOGINNOLIMIT option for the account \2%s\2.", get_oper_name(si), entity(mu)->name);
 		logcommand(si, CMDLOG_ADMIN, "LOGINNOLIMIT:ON: \2%s\2", entity(mu)->name);
@@ -62,6 +63,7 @@ ns_cmd_loginnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mu->flags &= ~MU_LOGINNOLIMIT;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 
 		wallops("\2%s\2 removed the LOGINNOLIMIT option on the account \2%s\2.", get_oper_name(si), entity(mu)->name);
 		logcommand(si, CMDLOG_ADMIN, "LOGINNOLIMIT:OFF: \2%s\2", entity(mu)->name);
@@ -94,9 +94,13 @@ ns_cmd_logout(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	u->myuser->lastlogin = CURRTIME;
+	db_record_touched(DB_RECORD_MYUSER, u->myuser);
 	mn = mynick_find(u->nick);
 	if (mn != NULL && mn->owner == u->myuser)
+	{
 		mn->lastseen = CURRTIME;
+		db_record_touched(DB_RECORD_MYNICK, mn);
+	}
 
 	if (!ircd_on_logout(u, entity(u->myuser)->name))
 	{
@@ -66,6 +66,7 @@ nickserv_handle_nickchange(struct user *u)
 	if (u->myuser == mn->owner)
 	{
 		mn->lastseen = CURRTIME;
+		db_record_touched(DB_RECORD_MYNICK, mn);
 		return;
 	}
 
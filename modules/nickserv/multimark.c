@@ -799,6 +799,7 @@ ns_cmd_multimark(struct sourceinfo *si, int parc, char *parv[])
 		mm->number = get_multimark_max(mu);
 		mm->mark = sstrdup(info);
 		mowgli_node_add(mm, &mm->node, l);
+		db_mark_dirty();
 
 		command_success_nodata(si, _("\2%s\2 has been marked."), target);
 		logcommand(si, CMDLOG_ADMIN, "MARK:ADD: \2%s\2 \2%s\2", target, info);
@@ -1033,6 +1034,7 @@ ns_cmd_multimark(struct sourceinfo *si, int parc, char *parv[])
 			sfree(mm->restored_from_account);
 			sfree(mm->mark);
 			sfree(mm);
+			db_mark_dirty();
 
 			found++;
 
@@ -1097,9 +1099,9 @@ static struct command ns_multimark = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
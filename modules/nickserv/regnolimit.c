@@ -48,6 +48,7 @@ ns_cmd_regnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mu->flags |= MU_REGNOLIMIT;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 
 		wallops("\2%s\2 set the REGNOLIMIT option for the account \2%s\2.", get_oper_name(si), entity(mu)->name);
 		logcommand(si, CMDLOG_ADMIN, "REGNOLIMIT:ON: \2%s\2", entity(mu)->name);
@@ -62,6 +63,7 @@ ns_cmd_regnolimit(struct sourceinfo *si, int parc, char *parv[])
 		}
 
 		mu->flags &= ~MU_REGNOLIMIT;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 
 		wallops("\2%s\2 removed the REGNOLIMIT option on the account \2%s\2.", get_oper_name(si), entity(mu)->name);
 		logcommand(si, CMDLOG_ADMIN, "REGNOLIMIT:OFF: \2%s\2", entity(mu)->name);
@@ -80,6 +80,7 @@ ns_cmd_resetpass(struct sourceinfo *si, int parc, char *parv[])
 	if (mu->flags & MU_NOPASSWORD)
 	{
 		mu->flags &= ~MU_NOPASSWORD;
+		db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "NOPASSWORD", entity(mu)->name);
 	}
 }
@@ -55,6 +55,7 @@ ns_cmd_set_emailmemos(struct sourceinfo *si, int parc, char *parv[])
 
 		logcommand(si, CMDLOG_SET, "SET:EMAILMEMOS:ON");
 		si->smu->flags |= MU_EMAILMEMOS;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "EMAILMEMOS", entity(si->smu)->name);
 		return;
 	}
@@ -69,6 +70,7 @@ ns_cmd_set_emailmemos(struct sourceinfo *si, int parc, char *parv[])
 
 		logcommand(si, CMDLOG_SET, "SET:EMAILMEMOS:OFF");
 		si->smu->flags &= ~MU_EMAILMEMOS;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "EMAILMEMOS", entity(si->smu)->name);
 		return;
 	}
@@ -41,6 +41,7 @@ ns_cmd_set_language(struct sourceinfo *si, int parc, char *parv[])
 	logcommand(si, CMDLOG_SET, "SET:LANGUAGE: \2%s\2", language_get_name(lang));
 
 	si->smu->language = lang;
+	db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 	command_success_nodata(si, _("The language for \2%s\2 has been changed to \2%s\2."), entity(si->smu)->name, language_get_name(lang));
 
@@ -45,6 +45,7 @@ ns_cmd_set_nogreet(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOGREET:ON");
 
 		si->smu->flags |= MU_NOGREET;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "NOGREET" ,entity(si->smu)->name);
 
@@ -61,6 +62,7 @@ ns_cmd_set_nogreet(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOGREET:OFF");
 
 		si->smu->flags &= ~MU_NOGREET;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "NOGREET", entity(si->smu)->name);
 
@@ -43,6 +43,7 @@ ns_cmd_set_nomemo(struct sourceinfo *si, int parc, char *parv[])
 
 		logcommand(si, CMDLOG_SET, "SET:NOMEMO:ON");
 		si->smu->flags |= MU_NOMEMO;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "NOMEMO", entity(si->smu)->name);
 		return;
 	}
@@ -57,6 +58,7 @@ ns_cmd_set_nomemo(struct sourceinfo *si, int parc, char *parv[])
 
 		logcommand(si, CMDLOG_SET, "SET:NOMEMO:OFF");
 		si->smu->flags &= ~MU_NOMEMO;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "NOMEMO", entity(si->smu)->name);
 		return;
 	}
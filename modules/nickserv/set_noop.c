@@ -45,6 +45,7 @@ ns_cmd_set_noop(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOOP:ON");
 
 		si->smu->flags |= MU_NOOP;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "NOOP", entity(si->smu)->name);
 
@@ -61,6 +62,7 @@ ns_cmd_set_noop(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOOP:OFF");
 
 		si->smu->flags &= ~MU_NOOP;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "NOOP", entity(si->smu)->name);
 
@@ -41,7 +41,7 @@ ns_cmd_set_nopassword(struct sourceinfo *si, int parc, char *parv[])
 			return;
 		}
 
-		if (si->smu->cert_fingerprints.head == NULL && metadata_find(si->smu, "private:pubkey") == NULL && metadata_find(si->smu, "pubkey") == NULL && metadata_find(si->smu, "ecdsa-nist521p-pubkey") == NULL)
+		if (myuser_ext_peek(si->smu)->cert_fingerprints.head == NULL && metadata_find(si->smu, "private:pubkey") == NULL && metadata_find(si->smu, "pubkey") == NULL && metadata_find(si->smu, "ecdsa-nist521p-pubkey") == NULL)
 		{
 			command_fail(si, fault_nochange, _("You are trying to enable NOPASSWORD without any possibility to identify without a password."));
 			return;
@@ -50,6 +50,7 @@ ns_cmd_set_nopassword(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOPASSWORD:ON");
 
 		si->smu->flags |= MU_NOPASSWORD;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "NOPASSWORD" ,entity(si->smu)->name);
 
@@ -66,6 +67,7 @@ ns_cmd_set_nopassword(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:NOPASSWORD:OFF");
 
 		si->smu->flags &= ~MU_NOPASSWORD;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "NOPASSWORD", entity(si->smu)->name);
 
@@ -45,6 +45,7 @@ ns_cmd_set_private(struct sourceinfo *si, int parc, char *parv[])
 
 		si->smu->flags |= MU_PRIVATE;
 		si->smu->flags |= MU_HIDEMAIL;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for \2%s\2."), "PRIVATE" ,entity(si->smu)->name);
 
@@ -61,6 +62,7 @@ ns_cmd_set_private(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:PRIVATE:OFF");
 
 		si->smu->flags &= ~MU_PRIVATE;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for \2%s\2."), "PRIVATE", entity(si->smu)->name);
 
@@ -44,6 +44,7 @@ ns_cmd_set_privmsg(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:PRIVMSG:ON");
 
 		si->smu->flags |= MU_USE_PRIVMSG;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for \2%s\2."), "PRIVMSG" ,entity(si->smu)->name);
 
@@ -60,6 +61,7 @@ ns_cmd_set_privmsg(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:PRIVMSG:OFF");
 
 		si->smu->flags &= ~MU_USE_PRIVMSG;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for \2%s\2."), "PRIVMSG", entity(si->smu)->name);
 
@@ -46,6 +46,7 @@ ns_cmd_set_quietchg(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:QUIETCHG:ON");
 
 		si->smu->flags |= MU_QUIETCHG;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been set for account \2%s\2."), "QUIETCHG" ,entity(si->smu)->name);
 
@@ -62,6 +63,7 @@ ns_cmd_set_quietchg(struct sourceinfo *si, int parc, char *parv[])
 		logcommand(si, CMDLOG_SET, "SET:QUIETCHG:OFF");
 
 		si->smu->flags &= ~MU_QUIETCHG;
+		db_record_changed(DB_RECORD_MYUSER, si->smu, NULL);
 
 		command_success_nodata(si, _("The \2%s\2 flag has been removed for account \2%s\2."), "QUIETCHG", entity(si->smu)->name);
 
@@ -19,6 +19,7 @@ ns_verify_activate_account(struct sourceinfo *si, struct myuser *mu, bool force)
 	struct hook_user_req req;
 
 	mu->flags &= ~MU_WAITAUTH;
+	db_record_changed(DB_RECORD_MYUSER, mu, NULL);
 
 	metadata_delete(mu, "private:verify:register:key");
 	metadata_delete(mu, "private:verify:register:timestamp");
@@ -214,6 +214,7 @@ os_cmd_clones_kline(struct sourceinfo *si, int parc, char *parv[])
 		}
 		kline_enabled = true;
 		grace_count = 0;
+		db_mark_dirty();
 		command_success_nodata(si, _("Enabled CLONES klines."));
 		wallops("\2%s\2 enabled CLONES klines", get_oper_name(si));
 		logcommand(si, CMDLOG_ADMIN, "CLONES:KLINE:ON");
@@ -226,6 +227,7 @@ os_cmd_clones_kline(struct sourceinfo *si, int parc, char *parv[])
 			return;
 		}
 		kline_enabled = false;
+		db_mark_dirty();
 		command_success_nodata(si, _("Disabled CLONES klines."));
 		wallops("\2%s\2 disabled CLONES klines", get_oper_name(si));
 		logcommand(si, CMDLOG_ADMIN, "CLONES:KLINE:OFF");
@@ -239,6 +241,7 @@ os_cmd_clones_kline(struct sourceinfo *si, int parc, char *parv[])
 		}
 		kline_enabled = true;
 		grace_count = newgrace;
+		db_mark_dirty();
 		command_success_nodata(si, ngettext(N_("Enabled CLONES klines with a grace of \2%u\2 kill"),
 		                                    N_("Enabled CLONES klines with a grace of \2%u\2 kills"),
 		                                    grace_count), grace_count);
@@ -423,6 +426,7 @@ os_cmd_clones_addexempt(struct sourceinfo *si, int parc, char *parv[])
 	c->allowed = clones;
 	c->warn = clones;
 	c->expires = duration ? (CURRTIME + duration) : 0;
+	db_mark_dirty();
 
 	logcommand(si, CMDLOG_ADMIN, "CLONES:ADDEXEMPT: \2%s\2 \2%u\2 (reason: \2%s\2) (duration: \2%s\2)", ip, clones, c->reason, timediff(duration));
 }
@@ -451,6 +455,7 @@ os_cmd_clones_delexempt(struct sourceinfo *si, int parc, char *parv[])
 			sfree(c);
 			mowgli_node_delete(n, &clone_exempts);
 			mowgli_node_free(n);
+			db_mark_dirty();
 		}
 		else if (!strcmp(c->ip, arg))
 		{
@@ -459,6 +464,7 @@ os_cmd_clones_delexempt(struct sourceinfo *si, int parc, char *parv[])
 			sfree(c);
 			mowgli_node_delete(n, &clone_exempts);
 			mowgli_node_free(n);
+			db_mark_dirty();
 			command_success_nodata(si, _("Removed \2%s\2 from clone exempt list."), arg);
 			logcommand(si, CMDLOG_ADMIN, "CLONES:DELEXEMPT: \2%s\2", arg);
 			return;
@@ -532,6 +538,7 @@ os_cmd_clones_setexempt(struct sourceinfo *si, int parc, char *parv[])
 				sfree(c);
 				mowgli_node_delete(n, &clone_exempts);
 				mowgli_node_free(n);
+				db_mark_dirty();
 			}
 			else if (!strcmp(c->ip, ip))
 			{
@@ -552,6 +559,7 @@ os_cmd_clones_setexempt(struct sourceinfo *si, int parc, char *parv[])
 					{
 						command_success_nodata(si, _("Clone warning messages will be disabled for host \2%s\2"), ip);
 						c->warn = 0;
+						db_mark_dirty();
 						return;
 					}
 					else if (clones > c->allowed)
@@ -619,6 +627,8 @@ os_cmd_clones_setexempt(struct sourceinfo *si, int parc, char *parv[])
 					return;
 				}
 
+				db_mark_dirty();
+
 				logcommand(si, CMDLOG_ADMIN, "CLONES:SETEXEMPT: \2%s\2 \2%d\2 (reason: \2%s\2) (duration: \2%s\2)", ip, clones, c->reason, timediff((c->expires - CURRTIME)));
 
 				return;
@@ -662,6 +672,7 @@ os_cmd_clones_duration(struct sourceinfo *si, int parc, char *parv[])
 	}
 
 	kline_duration = duration;
+	db_mark_dirty();
 	command_success_nodata(si, _("Clone ban duration set to \2%s\2 (%ld seconds)"), parv[0], kline_duration);
 }
 
@@ -683,6 +694,7 @@ os_cmd_clones_listexempt(struct sourceinfo *si, int parc, char *parv[])
 			sfree(c);
 			mowgli_node_delete(n, &clone_exempts);
 			mowgli_node_free(n);
+			db_mark_dirty();
 		}
 		else if (c->expires)
 			command_success_nodata(si, _("%s - allowed limit %u, warn on %u - expires in %s - \2%s\2"), c->ip, c->allowed, c->warn, timediff(c->expires > CURRTIME ? c->expires - CURRTIME : 0), c->reason);
@@ -904,9 +916,9 @@ static struct command os_clones_duration = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (! module_find_published("backend/opensex"))
+	if (! module_find_published("backend/opensex") && ! module_find_published("backend/binary"))
 	{
-		(void) slog(LG_ERROR, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		(void) slog(LG_ERROR, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 
 		m->mflags |= MODFLAG_FAIL;
 		return;
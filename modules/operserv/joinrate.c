@@ -234,6 +234,8 @@ os_cmd_joinrate_func(struct sourceinfo *const restrict si, const int parc, char
 		else
 			(void) jr_instance_destroy(instance);
 
+		(void) db_mark_dirty();
+
 		(void) command_success_nodata(si, _("Reset \2%s\2 to default join rate warning threshold (%d joins "
 		                                    "in %ds)"), chname, default_instance->rate,
 		                                    default_instance->time);
@@ -281,6 +283,8 @@ os_cmd_joinrate_func(struct sourceinfo *const restrict si, const int parc, char
 			instance->tokens = -1;
 		}
 
+		(void) db_mark_dirty();
+
 		(void) command_success_nodata(si, _("Set \2%s\2 join rate warning threshold to %d joins in %ds"),
 		                                    chname, (int) rate, (int) time);
 	}
@@ -302,9 +306,9 @@ mod_init(struct module *const restrict m)
 {
 	MODULE_TRY_REQUEST_DEPENDENCY(m, "operserv/main")
 
-	if (! module_find_published("backend/opensex"))
+	if (! module_find_published("backend/opensex") && ! module_find_published("backend/binary"))
 	{
-		(void) slog(LG_INFO, "Module %s requires use of the OpenSEX database backend, refusing to load",
+		(void) slog(LG_INFO, "Module %s requires use of the OpenSEX or binary database backend, refusing to load",
 		                     m->name);
 
 		m->mflags |= MODFLAG_FAIL;
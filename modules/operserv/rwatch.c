@@ -25,9 +25,31 @@ struct rwatch
 static struct rwatch *rwread = NULL;
 static FILE *f;
 
+struct rwatch_match
+{
+	struct user *u;
+	char *usermask;
+	char *oldusermask;
+	const char *oldnick;
+};
+
 static mowgli_patricia_t *os_rwatch_cmds;
 static mowgli_list_t rwatch_list;
 
+/* every entry of rwatch_list with a valid regex, matched in one go */
+static struct atheme_regex_set *rwatch_set = NULL;
+
+static void
+rwatch_add(struct rwatch *rw)
+{
+	mowgli_node_add(rw, mowgli_node_create(), &rwatch_list);
+
+	if (rw->re != NULL)
+		regex_set_add(rwatch_set, rw->regex, rw->reflags, rw->re, rw);
+
+	db_mark_dirty();
+}
+
 static void
 write_rwatchdb(struct database_handle *db)
 {
@@ -92,7 +114,7 @@ load_rwatchdb(char *path)
 			{
 				rw->actions = atoi(actionstr);
 				rw->reason = sstrdup(reason);
-				mowgli_node_add(rw, mowgli_node_create(), &rwatch_list);
+				rwatch_add(rw);
 				rw = NULL;
 			}
 		}
@@ -140,7 +162,7 @@ db_h_rr(struct database_handle *db, const char *type)
 
 	rwread->actions = actions;
 	rwread->reason = sstrdup(reason);
-	mowgli_node_add(rwread, mowgli_node_create(), &rwatch_list);
+	rwatch_add(rwread);
 	rwread = NULL;
 }
 
@@ -217,7 +239,7 @@ os_cmd_rwatch_add(struct sourceinfo *si, int parc, char *parv[])
 	rw->actions = RWACT_SNOOP | ((flags & AREGEX_KLINE) == AREGEX_KLINE ? RWACT_KLINE : 0);
 	rw->re = regex;
 
-	mowgli_node_add(rw, mowgli_node_create(), &rwatch_list);
+	rwatch_add(rw);
 	command_success_nodata(si, _("Added \2%s\2 to regex watch list."), pattern);
 	logcommand(si, CMDLOG_ADMIN, "RWATCH:ADD: \2%s\2 (reason: \2%s\2)", pattern, reason);
 }
@@ -269,6 +291,7 @@ os_cmd_rwatch_del(struct sourceinfo *si, int parc, char *parv[])
 				}
 				wallops("\2%s\2 disabled quarantine on regex watch pattern \2%s\2", get_oper_name(si), pattern);
 			}
+			regex_set_delete(rwatch_set, rw);
 			sfree(rw->regex);
 			sfree(rw->reason);
 			if (rw->re != NULL)
@@ -276,6 +299,7 @@ os_cmd_rwatch_del(struct sourceinfo *si, int parc, char *parv[])
 			sfree(rw);
 			mowgli_node_delete(n, &rwatch_list);
 			mowgli_node_free(n);
+			db_mark_dirty();
 			command_success_nodata(si, _("Removed \2%s\2 from regex watch list."), pattern);
 			logcommand(si, CMDLOG_ADMIN, "RWATCH:DEL: \2%s\2", pattern);
 			return;
@@ -415,6 +439,7 @@ os_cmd_rwatch_set(struct sourceinfo *si, int parc, char *parv[])
 			}
 			rw->actions |= addflags;
 			rw->actions &= ~removeflags;
+			db_mark_dirty();
 			command_success_nodata(si, _("Set options \2%s\2 on \2%s\2."), opts, pattern);
 
 			if (addflags & RWACT_KLINE)
@@ -435,13 +460,58 @@ os_cmd_rwatch_set(struct sourceinfo *si, int parc, char *parv[])
 	command_fail(si, fault_nosuch_target, _("\2%s\2 not found in regex watch list."), pattern);
 }
 
+static void
+rwatch_newuser_match(void *data, void *priv)
+{
+	struct rwatch *rw = data;
+	struct rwatch_match *m = priv;
+	struct user *u = m->u;
+
+	if (rw->actions & RWACT_SNOOP)
+	{
+		slog(LG_INFO, "RWATCH:%s \2%s\2 matches \2%s\2 (reason: \2%s\2)",
+				rw->actions & RWACT_KLINE ? "KLINE:" : "",
+				m->usermask, rw->regex, rw->reason);
+	}
+	if (rw->actions & RWACT_KLINE)
+	{
+		if (is_autokline_exempt(u))
+			slog(LG_INFO, "rwatch_newuser(): not klining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+		else
+		{
+			slog(LG_VERBOSE, "rwatch_newuser(): klining *@%s (user %s!%s@%s matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+			if (! (u->flags & UF_KLINESENT)) {
+				kline_sts("*", "*", u->host, SECONDS_PER_DAY, rw->reason);
+				u->flags |= UF_KLINESENT;
+			}
+		}
+	}
+	else if (rw->actions & RWACT_QUARANTINE)
+	{
+		if (is_autokline_exempt(u))
+			slog(LG_INFO, "rwatch_newuser(): not qurantining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+		else
+		{
+			slog(LG_VERBOSE, "rwatch_newuser(): quaranting *@%s (user %s!%s@%s matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+			quarantine_sts(service_find("operserv")->me, u, SECONDS_PER_DAY, rw->reason);
+		}
+	}
+}
+
 static void
 rwatch_newuser(struct hook_user_nick *data)
 {
 	struct user *u = data->u;
 	char usermask[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1 + GECOSLEN + 1];
-	mowgli_node_t *n;
-	struct rwatch *rw;
+	struct rwatch_match m;
 
 	// If the user has been killed, don't do anything.
 	if (!u)
@@ -450,54 +520,66 @@ rwatch_newuser(struct hook_user_nick *data)
 	if (is_internal_client(u))
 		return;
 
+	if (!MOWGLI_LIST_LENGTH(&rwatch_set->entries))
+		return;
+
 	snprintf(usermask, sizeof usermask, "%s!%s@%s %s", u->nick, u->user, u->host, u->gecos);
 
-	MOWGLI_ITER_FOREACH(n, rwatch_list.head)
+	m.u = u;
+	m.usermask = usermask;
+	m.oldusermask = NULL;
+	m.oldnick = NULL;
+
+	regex_set_match(rwatch_set, usermask, &rwatch_newuser_match, &m);
+}
+
+static void
+rwatch_nickchange_match(void *data, void *priv)
+{
+	struct rwatch *rw = data;
+	struct rwatch_match *m = priv;
+	struct user *u = m->u;
+
+	// Only process if they did not match before.
+	if (regex_match(rw->re, m->oldusermask))
+		return;
+	if (rw->actions & RWACT_SNOOP)
 	{
-		rw = n->data;
-		if (!rw->re)
-			continue;
-		if (regex_match(rw->re, usermask))
+		slog(LG_INFO, "RWATCH:NICKCHANGE:%s \2%s\2 -> \2%s\2 matches \2%s\2 (reason: \2%s\2)",
+				rw->actions & RWACT_KLINE ? "KLINE:" : "",
+				m->oldnick, m->usermask, rw->regex, rw->reason);
+	}
+	if (rw->actions & RWACT_KLINE)
+	{
+		if (is_autokline_exempt(u))
+			slog(LG_INFO, "rwatch_nickchange(): not klining *@%s (user %s -> %s!%s@%s is autokline exempt but matches %s %s)",
+					u->host, m->oldnick, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+		else
 		{
-			if (rw->actions & RWACT_SNOOP)
-			{
-				slog(LG_INFO, "RWATCH:%s \2%s\2 matches \2%s\2 (reason: \2%s\2)",
-						rw->actions & RWACT_KLINE ? "KLINE:" : "",
-						usermask, rw->regex, rw->reason);
-			}
-			if (rw->actions & RWACT_KLINE)
-			{
-				if (is_autokline_exempt(u))
-					slog(LG_INFO, "rwatch_newuser(): not klining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-				else
-				{
-					slog(LG_VERBOSE, "rwatch_newuser(): klining *@%s (user %s!%s@%s matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-					if (! (u->flags & UF_KLINESENT)) {
-						kline_sts("*", "*", u->host, SECONDS_PER_DAY, rw->reason);
-						u->flags |= UF_KLINESENT;
-					}
-				}
-			}
-			else if (rw->actions & RWACT_QUARANTINE)
-			{
-				if (is_autokline_exempt(u))
-					slog(LG_INFO, "rwatch_newuser(): not qurantining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-				else
-				{
-					slog(LG_VERBOSE, "rwatch_newuser(): quaranting *@%s (user %s!%s@%s matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-					quarantine_sts(service_find("operserv")->me, u, SECONDS_PER_DAY, rw->reason);
-				}
+			slog(LG_VERBOSE, "rwatch_nickchange(): klining *@%s (user %s -> %s!%s@%s matches %s %s)",
+					u->host, m->oldnick, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+			if (! (u->flags & UF_KLINESENT)) {
+				kline_sts("*", "*", u->host, SECONDS_PER_DAY, rw->reason);
+				u->flags |= UF_KLINESENT;
 			}
 		}
 	}
+	else if (rw->actions & RWACT_QUARANTINE)
+	{
+		if (is_autokline_exempt(u))
+			slog(LG_INFO, "rwatch_newuser(): not qurantining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+		else
+		{
+			slog(LG_VERBOSE, "rwatch_newuser(): quaranting *@%s (user %s!%s@%s matches %s %s)",
+					u->host, u->nick, u->user, u->host,
+					rw->regex, rw->reason);
+			quarantine_sts(service_find("operserv")->me, u, SECONDS_PER_DAY, rw->reason);
+		}
+	}
 }
 
 static void
@@ -506,8 +588,7 @@ rwatch_nickchange(struct hook_user_nick *data)
 	struct user *u = data->u;
 	char usermask[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1 + GECOSLEN + 1];
 	char oldusermask[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1 + GECOSLEN + 1];
-	mowgli_node_t *n;
-	struct rwatch *rw;
+	struct rwatch_match m;
 
 	// If the user has been killed, don't do anything.
 	if (!u)
@@ -516,58 +597,18 @@ rwatch_nickchange(struct hook_user_nick *data)
 	if (is_internal_client(u))
 		return;
 
+	if (!MOWGLI_LIST_LENGTH(&rwatch_set->entries))
+		return;
+
 	snprintf(usermask, sizeof usermask, "%s!%s@%s %s", u->nick, u->user, u->host, u->gecos);
 	snprintf(oldusermask, sizeof oldusermask, "%s!%s@%s %s", data->oldnick, u->user, u->host, u->gecos);
 
-	MOWGLI_ITER_FOREACH(n, rwatch_list.head)
-	{
-		rw = n->data;
-		if (!rw->re)
-			continue;
-		if (regex_match(rw->re, usermask))
-		{
-			// Only process if they did not match before.
-			if (regex_match(rw->re, oldusermask))
-				continue;
-			if (rw->actions & RWACT_SNOOP)
-			{
-				slog(LG_INFO, "RWATCH:NICKCHANGE:%s \2%s\2 -> \2%s\2 matches \2%s\2 (reason: \2%s\2)",
-						rw->actions & RWACT_KLINE ? "KLINE:" : "",
-						data->oldnick, usermask, rw->regex, rw->reason);
-			}
-			if (rw->actions & RWACT_KLINE)
-			{
-				if (is_autokline_exempt(u))
-					slog(LG_INFO, "rwatch_nickchange(): not klining *@%s (user %s -> %s!%s@%s is autokline exempt but matches %s %s)",
-							u->host, data->oldnick, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-				else
-				{
-					slog(LG_VERBOSE, "rwatch_nickchange(): klining *@%s (user %s -> %s!%s@%s matches %s %s)",
-							u->host, data->oldnick, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-					if (! (u->flags & UF_KLINESENT)) {
-						kline_sts("*", "*", u->host, SECONDS_PER_DAY, rw->reason);
-						u->flags |= UF_KLINESENT;
-					}
-				}
-			}
-			else if (rw->actions & RWACT_QUARANTINE)
-			{
-				if (is_autokline_exempt(u))
-					slog(LG_INFO, "rwatch_newuser(): not qurantining *@%s (user %s!%s@%s is autokline exempt but matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-				else
-				{
-					slog(LG_VERBOSE, "rwatch_newuser(): quaranting *@%s (user %s!%s@%s matches %s %s)",
-							u->host, u->nick, u->user, u->host,
-							rw->regex, rw->reason);
-					quarantine_sts(service_find("operserv")->me, u, SECONDS_PER_DAY, rw->reason);
-				}
-			}
-		}
-	}
+	m.u = u;
+	m.usermask = usermask;
+	m.oldusermask = oldusermask;
+	m.oldnick = data->oldnick;
+
+	regex_set_match(rwatch_set, usermask, &rwatch_nickchange_match, &m);
 }
 
 static struct command os_rwatch = {
@@ -628,6 +669,8 @@ mod_init(struct module *const restrict m)
 		return;
 	}
 
+	rwatch_set = regex_set_create();
+
 	(void) command_add(&os_rwatch_add, os_rwatch_cmds);
 	(void) command_add(&os_rwatch_del, os_rwatch_cmds);
 	(void) command_add(&os_rwatch_list, os_rwatch_cmds);
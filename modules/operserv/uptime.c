@@ -26,6 +26,7 @@ os_cmd_uptime_func(struct sourceinfo *const restrict si, const int ATHEME_VATTR_
 
 	(void) command_success_nodata(si, _("Registered channels: %u"), cnt.mychan);
 	(void) command_success_nodata(si, _("Users currently online: %u"), (cnt.user - me.me->users));
+	(void) command_success_nodata(si, _("Records changed since the last database save: %u"), db_changes);
 }
 
 static struct command os_cmd_uptime = {
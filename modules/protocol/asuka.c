@@ -177,6 +177,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(parv[5 + i]);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				else
 				{
@@ -184,6 +185,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(p + 1);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 					mowgli_strlcpy(userbuf, parv[5+i], sizeof userbuf);
 					p = strchr(userbuf, '@');
@@ -192,6 +194,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->user);
 					u->user = strshare_get(userbuf);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				i++;
 			}
@@ -264,6 +267,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(parv[2]);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				else
 				{
@@ -271,6 +275,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(p + 1);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 					mowgli_strlcpy(userbuf, parv[2], sizeof userbuf);
 
@@ -280,6 +285,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->user);
 					u->user = strshare_get(userbuf);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				slog(LG_DEBUG, "m_mode(): user %s setting vhost %s@%s", u->nick, u->user, u->vhost);
 			}
@@ -291,6 +297,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 				strshare_unref(u->vhost);
 				u->vhost = strshare_get(u->host);
+				CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 				// revert to +x vhost if applicable
 				check_hidehost(u);
@@ -328,6 +335,7 @@ check_hidehost(struct user *u)
 
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(buf);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	slog(LG_DEBUG, "check_hidehost(): %s -> %s", u->nick, u->vhost);
 }
@@ -248,6 +248,12 @@ bahamut_notice_user_sts(struct user *from, struct user *target, const char *text
 	sts(":%s NOTICE %s :%s", from ? from->nick : me.name, target->nick, text);
 }
 
+static size_t
+bahamut_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? from->nick : me.name, target->nick);
+}
+
 static void
 bahamut_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -951,6 +957,7 @@ mod_init(struct module *const restrict m)
 	msg = &bahamut_msg;
 	msg_global_sts = &bahamut_msg_global_sts;
 	notice_user_sts = &bahamut_notice_user_sts;
+	notice_user_prefix = &bahamut_notice_user_prefix;
 	notice_global_sts = &bahamut_notice_global_sts;
 	notice_channel_sts = &bahamut_notice_channel_sts;
 	wallchops = &bahamut_wallchops;
@@ -186,6 +186,40 @@ extgecos_match(const char *mask, struct user *u)
 	return !match(mask, hostgbuf) || (check_realhost && !match(mask, realgbuf));
 }
 
+static void
+charybdis_chanban_compile(struct chanban *cb)
+{
+	char *p;
+
+	/*
+	 * strip any banforwards from the mask. (SRV-73)
+	 * charybdis itself doesn't support banforward but i don't feel like copying
+	 * this stuff into ircd-seven and it is possible that charybdis may support them
+	 * one day.
+	 *   --nenolod
+	 */
+	p = strrchr(cb->mask, '$');
+	if (p != NULL && p != cb->mask)
+		cb->match_mask = sstrndup(cb->mask, (size_t) (p - cb->mask));
+	else
+		cb->match_mask = cb->mask;
+
+	cb->match_type = chanban_match_type(cb->match_mask);
+
+	if (cb->match_mask[0] == '$')
+	{
+		p = cb->match_mask + 1;
+		cb->ext_negate = *p == '~';
+		if (cb->ext_negate)
+			p++;
+		cb->ext_type = *p++;
+
+		// check parameter
+		if (cb->ext_type != '\0' && *p == ':')
+			cb->ext_param = p + 1;
+	}
+}
+
 static mowgli_node_t *
 charybdis_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_node_t *first)
 {
@@ -194,18 +228,11 @@ charybdis_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_
 	char hostbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char realbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char ipbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char strippedmask[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1 + CHANNELLEN + 3];
-	char *p;
-	bool negate, matched;
-	int exttype;
+	const char *p;
+	bool matched;
+	bool havebufs = false;
 	struct channel *target_c;
 
-	snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
-	snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
-
-	// will be nick!user@ if ip unknown, doesn't matter
-	snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
-
 	bool check_realhost = (config_options.masks_through_vhost || u->host == u->vhost);
 
 	MOWGLI_ITER_FOREACH(n, first)
@@ -215,38 +242,28 @@ charybdis_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_
 		if (cb->type != type)
 			continue;
 
-		/*
-		 * strip any banforwards from the mask. (SRV-73)
-		 * charybdis itself doesn't support banforward but i don't feel like copying
-		 * this stuff into ircd-seven and it is possible that charybdis may support them
-		 * one day.
-		 *   --nenolod
-		 */
-		mowgli_strlcpy(strippedmask, cb->mask, sizeof strippedmask);
-		p = strrchr(strippedmask, '$');
-		if (p != NULL && p != strippedmask)
-			*p = 0;
-
-		if (!match(strippedmask, hostbuf))
+		if (!havebufs)
+		{
+			snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
+			snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
+
+			// will be nick!user@ if ip unknown, doesn't matter
+			snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
+
+			havebufs = true;
+		}
+
+		if (chanban_match_mask(cb, hostbuf))
 			return n;
-		if (check_realhost && (!match(strippedmask, realbuf) || !match(strippedmask, ipbuf) || !match_cidr(strippedmask, ipbuf)))
+		if (check_realhost && (chanban_match_mask(cb, realbuf) || chanban_match_mask(cb, ipbuf) ||
+				(cb->match_type == CBAN_MATCH_CIDR && !match_cidr(cb->match_mask, ipbuf))))
 			return n;
 
-		if (strippedmask[0] == '$')
+		if (cb->ext_type != '\0')
 		{
-			p = strippedmask + 1;
-			negate = *p == '~';
-			if (negate)
-				p++;
-			exttype = *p++;
-			if (exttype == '\0')
-				continue;
-
-			// check parameter
-			if (*p++ != ':')
-				p = NULL;
-
-			switch (exttype)
+			p = cb->ext_param;
+
+			switch (cb->ext_type)
 			{
 				case 'a':
 					matched = u->myuser != NULL && !(u->myuser->flags & MU_WAITAUTH) && (p == NULL || !match(p, entity(u->myuser)->name));
@@ -280,7 +297,7 @@ charybdis_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_
 				default:
 					continue;
 			}
-			if (negate ^ matched)
+			if (cb->ext_negate ^ matched)
 				return n;
 		}
 	}
@@ -341,6 +358,7 @@ mod_init(struct module *const restrict m)
 
 	notice_channel_sts = &charybdis_notice_channel_sts;
 
+	chanban_compile = &charybdis_chanban_compile;
 	next_matching_ban = &charybdis_next_matching_ban;
 	is_valid_host = &charybdis_is_valid_host;
 	is_extban = &charybdis_is_extban;
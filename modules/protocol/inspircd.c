@@ -108,6 +108,19 @@ static bool has_shun = false;
 static bool has_svstopic_topiclock = false;
 static int has_protocol = 0;
 
+static void
+inspircd_chanban_compile(struct chanban *cb)
+{
+	cb->match_mask = cb->mask;
+	cb->match_type = chanban_match_type(cb->mask);
+
+	if (cb->mask[0] != '\0' && cb->mask[1] == ':' && strchr("MRUjrm", cb->mask[0]))
+	{
+		cb->ext_type = cb->mask[0];
+		cb->ext_param = cb->mask + 2;
+	}
+}
+
 static mowgli_node_t *
 inspircd_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_node_t *first)
 {
@@ -116,13 +129,8 @@ inspircd_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_n
 	char hostbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char realbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char ipbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char *p;
-
-	snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
-	snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
-
-	// will be nick!user@ if ip unknown, doesn't matter
-	snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
+	const char *p;
+	bool havebufs = false;
 
 	bool check_realhost = (config_options.masks_through_vhost || u->host == u->vhost);
 
@@ -135,20 +143,30 @@ inspircd_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_n
 		if (cb->type != type)
 			continue;
 
-		if (!match(cb->mask, hostbuf))
+		if (!havebufs)
+		{
+			snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
+			snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
+
+			// will be nick!user@ if ip unknown, doesn't matter
+			snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
+
+			havebufs = true;
+		}
+
+		if (chanban_match_mask(cb, hostbuf))
 			return n;
-		if (check_realhost && (!match(cb->mask, realbuf) || !match(cb->mask, ipbuf) || !match_cidr(cb->mask, ipbuf)))
+		if (check_realhost && (chanban_match_mask(cb, realbuf) || chanban_match_mask(cb, ipbuf) ||
+				(cb->match_type == CBAN_MATCH_CIDR && !match_cidr(cb->match_mask, ipbuf))))
 			return n;
 
-		if (cb->mask[1] == ':' && strchr("MRUjrm", cb->mask[0]))
+		if (cb->ext_type != '\0')
 		{
 			bool matched = false;
 
-			p = cb->mask + 2;
-			if (*(p - 1) != ':')
-				p = NULL;
+			p = cb->ext_param;
 
-			switch (cb->mask[0])
+			switch (cb->ext_type)
 			{
 			case 'M':
 			case 'R':
@@ -447,6 +465,12 @@ inspircd_notice_user_sts(struct user *from, struct user *target, const char *tex
 	sts(":%s NOTICE %s :%s", from ? from->uid : me.numeric, target->uid, text);
 }
 
+static size_t
+inspircd_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? from->uid : me.numeric, target->uid);
+}
+
 static void
 inspircd_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -1172,6 +1196,7 @@ inspircd_user_mode(struct user *u, const char *modes)
 					{
 						strshare_unref(u->chost);
 						u->chost = strshare_get(u->vhost);
+						CHANBAN_EPOCH_BUMP(u->ban_epoch);
 					}
 				}
 				break;
@@ -1409,6 +1434,7 @@ m_fident(struct sourceinfo *si, int parc, char *parv[])
 {
 	strshare_unref(si->su->user);
 	si->su->user = strshare_get(parv[0]);
+	CHANBAN_EPOCH_BUMP(si->su->ban_epoch);
 }
 
 static void
@@ -1416,6 +1442,7 @@ m_fhost(struct sourceinfo *si, int parc, char *parv[])
 {
 	strshare_unref(si->su->vhost);
 	si->su->vhost = strshare_get(parv[0]);
+	CHANBAN_EPOCH_BUMP(si->su->ban_epoch);
 }
 
 static void
@@ -1748,6 +1775,7 @@ mod_init(struct module *const restrict m)
 	MODULE_TRY_REQUEST_DEPENDENCY(m, "transport/rfc1459")
 	MODULE_TRY_REQUEST_DEPENDENCY(m, "protocol/base36uid")
 
+	chanban_compile = &inspircd_chanban_compile;
 	next_matching_ban = &inspircd_next_matching_ban;
 	server_login = &inspircd_server_login;
 	introduce_nick = &inspircd_introduce_nick;
@@ -1759,6 +1787,7 @@ mod_init(struct module *const restrict m)
 	msg = &inspircd_msg;
 	msg_global_sts = &inspircd_msg_global_sts;
 	notice_user_sts = &inspircd_notice_user_sts;
+	notice_user_prefix = &inspircd_notice_user_prefix;
 	notice_global_sts = &inspircd_notice_global_sts;
 	notice_channel_sts = &inspircd_notice_channel_sts;
 	numeric_sts = &inspircd_numeric_sts;
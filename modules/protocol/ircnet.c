@@ -177,6 +177,12 @@ ircnet_notice_user_sts(struct user *from, struct user *target, const char *text)
 	sts(":%s NOTICE %s :%s", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target), text);
 }
 
+static size_t
+ircnet_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target));
+}
+
 static void
 ircnet_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -764,6 +770,7 @@ mod_init(struct module *const restrict m)
 	msg = &ircnet_msg;
 	msg_global_sts = &ircnet_msg_global_sts;
 	notice_user_sts = &ircnet_notice_user_sts;
+	notice_user_prefix = &ircnet_notice_user_prefix;
 	notice_global_sts = &ircnet_notice_global_sts;
 	notice_channel_sts = &ircnet_notice_channel_sts;
 	numeric_sts = &ircnet_numeric_sts;
@@ -169,6 +169,7 @@ check_hidehost(struct user *u)
 
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(buf);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	slog(LG_DEBUG, "check_hidehost(): %s -> %s", u->nick, u->vhost);
 }
@@ -202,6 +203,7 @@ nefarious_on_logout(struct user *u, const char *account)
 
 		strshare_unref(u->vhost);
 		u->vhost = strshare_get(u->host);
+		CHANBAN_EPOCH_BUMP(u->ban_epoch);
 	}
 
 	return false;
@@ -428,6 +430,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(parv[5 + i]);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				else
 				{
@@ -435,6 +438,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(p + 1);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 					mowgli_strlcpy(userbuf, parv[5+i], sizeof userbuf);
 
@@ -444,6 +448,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->user);
 					u->user = strshare_get(userbuf);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				i++;
 			}
@@ -451,6 +456,7 @@ m_nick(struct sourceinfo *si, int parc, char *parv[])
 			{
 				strshare_unref(u->vhost);
 				u->vhost = strshare_get(parv[5 + i]);
+				CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 				i++;
 			}
@@ -523,6 +529,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(parv[2]);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				else
 				{
@@ -530,6 +537,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(p + 1);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 					mowgli_strlcpy(userbuf, parv[2], sizeof userbuf);
 					p = strchr(userbuf, '@');
@@ -538,6 +546,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 					strshare_unref(u->user);
 					u->user = strshare_get(userbuf);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				slog(LG_DEBUG, "m_mode(): user %s setting vhost %s@%s", u->nick, u->user, u->vhost);
 			}
@@ -549,6 +558,7 @@ m_mode(struct sourceinfo *si, int parc, char *parv[])
 
 				strshare_unref(u->vhost);
 				u->vhost = strshare_get(u->host);
+				CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 				// revert to +x vhost if applicable
 				check_hidehost(u);
@@ -183,6 +183,12 @@ ngircd_notice_user_sts(struct user *from, struct user *target, const char *text)
 	sts(":%s NOTICE %s :%s", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target), text);
 }
 
+static size_t
+ngircd_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target));
+}
+
 static void
 ngircd_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -327,6 +333,7 @@ ngircd_sethost_sts(struct user *source, struct user *target, const char *host)
 		{
 			strshare_unref(target->chost);
 			target->chost = strshare_get(host);
+			CHANBAN_EPOCH_BUMP(target->ban_epoch);
 		}
 	}
 	else
@@ -336,6 +343,7 @@ ngircd_sethost_sts(struct user *source, struct user *target, const char *host)
 
 		strshare_unref(target->chost);
 		target->chost = strshare_get(target->host);
+		CHANBAN_EPOCH_BUMP(target->ban_epoch);
 	}
 }
 
@@ -598,12 +606,14 @@ ngircd_user_mode(struct user *u, const char *modes)
 					{
 						strshare_unref(u->vhost);
 						u->vhost = strshare_get(u->chost);
+						CHANBAN_EPOCH_BUMP(u->ban_epoch);
 					}
 				}
 				else if (dir == MTYPE_DEL)
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(u->host);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				slog(LG_DEBUG, "user got vhost='%s' chost='%s'", u->vhost, u->chost);
 				break;
@@ -852,6 +862,7 @@ m_metadata(struct sourceinfo *si, int parc, char *parv[])
 	{
 		strshare_unref(u->chost);
 		u->chost = strshare_get(parv[2]);
+		CHANBAN_EPOCH_BUMP(u->ban_epoch);
 	}
 }
 
@@ -888,6 +899,7 @@ mod_init(struct module *const restrict m)
 	msg = &ngircd_msg;
 	msg_global_sts = &ngircd_msg_global_sts;
 	notice_user_sts = &ngircd_notice_user_sts;
+	notice_user_prefix = &ngircd_notice_user_prefix;
 	notice_global_sts = &ngircd_notice_global_sts;
 	notice_channel_sts = &ngircd_notice_channel_sts;
 	numeric_sts = &ngircd_numeric_sts;
@@ -140,6 +140,12 @@ p10_notice_user_sts(struct user *from, struct user *target, const char *text)
 	sts("%s O %s :%s", from ? from->uid : me.numeric, target->uid, text);
 }
 
+static size_t
+p10_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, "%s O %s :", from ? from->uid : me.numeric, target->uid);
+}
+
 static void
 p10_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -1029,6 +1035,7 @@ check_hidehost(struct user *u)
 
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(buf);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	slog(LG_DEBUG, "check_hidehost(): %s -> %s", u->nick, u->vhost);
 }
@@ -1049,6 +1056,7 @@ mod_init(struct module *const restrict m)
 	msg = &p10_msg;
 	msg_global_sts = &p10_msg_global_sts;
 	notice_user_sts = &p10_notice_user_sts;
+	notice_user_prefix = &p10_notice_user_prefix;
 	notice_global_sts = &p10_notice_global_sts;
 	notice_channel_sts = &p10_notice_channel_sts;
 	wallchops = &p10_wallchops;
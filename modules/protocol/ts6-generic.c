@@ -88,7 +88,7 @@ ts6_server_login(void)
 	if (ret == 1)
 		return 1;
 
-	me.bursting = true;
+	handle_burst_begin();
 
 	sts("CAPAB :QS EX IE KLN UNKLN ENCAP TB SERVICES EUID EOPMOD MLOCK STAG");
 	sts("SERVER %s 1 :%s%s", me.name, me.hidden ? "(H) " : "", me.desc);
@@ -211,6 +211,12 @@ ts6_notice_user_sts(struct user *from, struct user *target, const char *text)
 	sts(":%s NOTICE %s :%s", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target), text);
 }
 
+static size_t
+ts6_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target));
+}
+
 static void
 ts6_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -682,21 +688,7 @@ m_pong(struct sourceinfo *si, int parc, char *parv[])
 	me.uplinkpong = CURRTIME;
 
 	// -> :test.projectxero.net PONG test.projectxero.net :shrike.malkier.net
-	if (me.bursting)
-	{
-#ifdef HAVE_GETTIMEOFDAY
-		e_time(burstime, &burstime);
-
-		slog(LG_INFO, "m_pong(): finished synching with uplink (%d %s)", (tv2ms(&burstime) > 1000) ? (tv2ms(&burstime) / 1000) : tv2ms(&burstime), (tv2ms(&burstime) > 1000) ? "s" : "ms");
-
-		wallops("Finished synchronizing with network in %d %s.", (tv2ms(&burstime) > 1000) ? (tv2ms(&burstime) / 1000) : tv2ms(&burstime), (tv2ms(&burstime) > 1000) ? "s" : "ms");
-#else
-		slog(LG_INFO, "m_pong(): finished synching with uplink");
-		wallops("Finished synchronizing with network.");
-#endif
-
-		me.bursting = false;
-	}
+	handle_burst_end();
 }
 
 static void
@@ -1334,6 +1326,7 @@ m_encap(struct sourceinfo *si, int parc, char *parv[])
 
 		strshare_unref(u->host);
 		u->host = strshare_get(parv[2]);
+		CHANBAN_EPOCH_BUMP(u->ban_epoch);
 	}
 	else if (!irccasecmp(parv[1], "CHGHOST"))
 	{
@@ -1345,6 +1338,7 @@ m_encap(struct sourceinfo *si, int parc, char *parv[])
 
 		strshare_unref(u->vhost);
 		u->vhost = strshare_get(parv[3]);
+		CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 		slog(LG_DEBUG, "m_encap(): chghost %s -> %s", u->nick,
 				u->vhost);
@@ -1424,10 +1418,12 @@ m_signon(struct sourceinfo *si, int parc, char *parv[])
 	// USER
 	strshare_unref(u->user);
 	u->user = strshare_get(parv[1]);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	// HOST
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(parv[2]);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 
 	// LOGIN
 	if(*parv[4] == '*') // explicitly unchanged
@@ -1500,6 +1496,7 @@ m_chghost(struct sourceinfo *si, int parc, char *parv[])
 
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(parv[1]);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 }
 
 static void
@@ -1548,6 +1545,7 @@ mod_init(struct module *const restrict m)
 	msg = &ts6_msg;
 	msg_global_sts = &ts6_msg_global_sts;
 	notice_user_sts = &ts6_notice_user_sts;
+	notice_user_prefix = &ts6_notice_user_prefix;
 	notice_global_sts = &ts6_notice_global_sts;
 	notice_channel_sts = &ts6_notice_channel_sts;
 	wallchops = &ts6_wallchops;
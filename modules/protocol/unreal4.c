@@ -214,6 +214,25 @@ static struct extmode unreal_ignore_mode_list[] = {
   { '\0', 0 }
 };
 
+static void
+unreal_chanban_compile(struct chanban *cb)
+{
+	const char *p;
+
+	cb->match_mask = cb->mask;
+	cb->match_type = chanban_match_type(cb->mask);
+
+	if (cb->mask[0] == '~')
+	{
+		p = cb->mask + 1;
+		cb->ext_type = *p++;
+
+		// check parameter
+		if (cb->ext_type != '\0' && *p == ':')
+			cb->ext_param = p + 1;
+	}
+}
+
 static mowgli_node_t *
 unreal_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_node_t *first)
 {
@@ -222,17 +241,11 @@ unreal_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_nod
 	char hostbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char realbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
 	char ipbuf[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1];
-	char *p;
+	const char *p;
 	bool matched;
-	int exttype;
+	bool havebufs = false;
 	struct channel *target_c;
 
-	snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
-	snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
-
-	// will be nick!user@ if ip unknown, doesn't matter
-	snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
-
 	bool check_realhost = (config_options.masks_through_vhost || u->host == u->vhost);
 
 	MOWGLI_ITER_FOREACH(n, first)
@@ -242,24 +255,27 @@ unreal_next_matching_ban(struct channel *c, struct user *u, int type, mowgli_nod
 		if (cb->type != type)
 			continue;
 
-		if (!match(cb->mask, hostbuf))
+		if (!havebufs)
+		{
+			snprintf(hostbuf, sizeof hostbuf, "%s!%s@%s", u->nick, u->user, u->vhost);
+			snprintf(realbuf, sizeof realbuf, "%s!%s@%s", u->nick, u->user, u->host);
+
+			// will be nick!user@ if ip unknown, doesn't matter
+			snprintf(ipbuf, sizeof ipbuf, "%s!%s@%s", u->nick, u->user, u->ip);
+
+			havebufs = true;
+		}
+
+		if (chanban_match_mask(cb, hostbuf))
 			return n;
-		if (check_realhost && (!match(cb->mask, realbuf) || !match(cb->mask, ipbuf)))
+		if (check_realhost && (chanban_match_mask(cb, realbuf) || chanban_match_mask(cb, ipbuf)))
 			return n;
 
-		if (cb->mask[0] == '~')
+		if (cb->ext_type != '\0')
 		{
-			p = cb->mask + 1;
-			exttype = *p++;
+			p = cb->ext_param;
 
-			if (exttype == '\0')
-				continue;
-
-			// check parameter
-			if (*p++ != ':')
-				p = NULL;
-
-			switch (exttype)
+			switch (cb->ext_type)
 			{
 				case 'a':
 					matched = u->myuser != NULL && !(u->myuser->flags & MU_WAITAUTH) && (p == NULL || !match(p, entity(u->myuser)->name));
@@ -411,6 +427,12 @@ unreal_notice_user_sts(struct user *from, struct user *target, const char *text)
 	sts(":%s NOTICE %s :%s", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target), text);
 }
 
+static size_t
+unreal_notice_user_prefix(struct user *from, struct user *target, char *buf, size_t len)
+{
+	return (size_t) snprintf(buf, len, ":%s NOTICE %s :", from ? CLIENT_NAME(from) : ME, CLIENT_NAME(target));
+}
+
 static void
 unreal_notice_global_sts(struct user *from, const char *mask, const char *text)
 {
@@ -1256,12 +1278,14 @@ unreal_user_mode(struct user *u, const char *changes)
 					{
 						strshare_unref(u->chost);
 						u->chost = strshare_get(u->vhost);
+						CHANBAN_EPOCH_BUMP(u->ban_epoch);
 					}
 				}
 				else if (dir == MTYPE_DEL)
 				{
 					strshare_unref(u->vhost);
 					u->vhost = strshare_get(u->host);
+					CHANBAN_EPOCH_BUMP(u->ban_epoch);
 				}
 				break;
 		}
@@ -1493,6 +1517,7 @@ m_sethost(struct sourceinfo *si, int parc, char *parv[])
 {
 	strshare_unref(si->su->vhost);
 	si->su->vhost = strshare_get(parv[0]);
+	CHANBAN_EPOCH_BUMP(si->su->ban_epoch);
 }
 
 static void
@@ -1505,6 +1530,7 @@ m_chghost(struct sourceinfo *si, int parc, char *parv[])
 
 	strshare_unref(u->vhost);
 	u->vhost = strshare_get(parv[1]);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 }
 
 static void m_setname(struct sourceinfo *si, int parc, char *parv[])
@@ -1529,6 +1555,7 @@ static void m_setident(struct sourceinfo *si, int parc, char *parv[])
 {
 	strshare_unref(si->su->user);
 	si->su->user = strshare_get(parv[0]);
+	CHANBAN_EPOCH_BUMP(si->su->ban_epoch);
 }
 
 static void m_chgident(struct sourceinfo *si, int parc, char *parv[])
@@ -1540,6 +1567,7 @@ static void m_chgident(struct sourceinfo *si, int parc, char *parv[])
 
 	strshare_unref(u->user);
 	u->user = strshare_get(parv[1]);
+	CHANBAN_EPOCH_BUMP(u->ban_epoch);
 }
 
 
@@ -1636,6 +1664,7 @@ mod_init(struct module *const restrict m)
 	msg = &unreal_msg;
 	msg_global_sts = &unreal_msg_global_sts;
 	notice_user_sts = &unreal_notice_user_sts;
+	notice_user_prefix = &unreal_notice_user_prefix;
 	notice_global_sts = &unreal_notice_global_sts;
 	notice_channel_sts = &unreal_notice_channel_sts;
 	numeric_sts = &unreal_numeric_sts;
@@ -1665,6 +1694,7 @@ mod_init(struct module *const restrict m)
 	mlock_sts = &unreal_mlock_sts;
 	is_extban = &unreal_is_extban;
 
+	chanban_compile = &unreal_chanban_compile;
 	next_matching_ban = &unreal_next_matching_ban;
 	mode_list = unreal_mode_list;
 	ignore_mode_list = unreal_ignore_mode_list;
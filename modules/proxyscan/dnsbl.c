@@ -194,6 +194,7 @@ ps_cmd_dnsblexempt(struct sourceinfo *si, int parc, char *parv[])
 		de->reason = sstrdup(reason);
 		de->ip = sstrdup(ip);
 		mowgli_node_add(de, &de->node, dnsbl_elist);
+		db_mark_dirty();
 
 		command_success_nodata(si, _("You have added \2%s\2 to the DNSBL exempts list."), ip);
 		logcommand(si, CMDLOG_ADMIN, "DNSBL:EXEMPT:ADD: \2%s\2 \2%s\2", ip, reason);
@@ -223,6 +224,7 @@ ps_cmd_dnsblexempt(struct sourceinfo *si, int parc, char *parv[])
 				sfree(de->reason);
 				sfree(de->ip);
 				sfree(de);
+				db_mark_dirty();
 
 				return;
 			}
@@ -648,9 +650,9 @@ static struct command ps_dnsblscan = {
 static void
 mod_init(struct module *const restrict m)
 {
-	if (!module_find_published("backend/opensex"))
+	if (!module_find_published("backend/opensex") && !module_find_published("backend/binary"))
 	{
-		(void) slog(LG_ERROR, "Module %s requires use of the OpenSEX database backend, refusing to load.", m->name);
+		(void) slog(LG_ERROR, "Module %s requires use of the OpenSEX or binary database backend, refusing to load.", m->name);
 		m->mflags |= MODFLAG_FAIL;
 		return;
 	}
@@ -319,6 +319,7 @@ sasl_session_reset(struct sasl_session *const restrict p)
 	if (p->mechptr && p->mechptr->mech_finish)
 		(void) p->mechptr->mech_finish(p);
 	p->mechptr = NULL;
+	p->flags &= ~ASASL_SFLAG_PENDING;
 
 	struct user *const u = user_find(p->uid);
 	if (u)
@@ -462,6 +463,7 @@ sasl_handle_login(struct sasl_session *const restrict p, struct user *const u, s
 		{
 			// Otherwise, just update login time ...
 			mu->lastlogin = CURRTIME;
+			db_record_touched(DB_RECORD_MYUSER, mu);
 			(void) logcommand_user(saslsvs, u, CMDLOG_LOGIN, "REAUTHENTICATE (%s)", p->mechptr->name);
 		}
 	}
@@ -577,55 +579,11 @@ sasl_process_output(struct sasl_session *const restrict p, struct sasl_output_bu
 	return true;
 }
 
-/* given an entire sasl message, advance session by passing data to mechanism
- * and feeding returned data back to client.
- */
+// act on the result of a mechanism, whether it came from sasl_process_packet() or sasl_mech_complete()
 static bool ATHEME_FATTR_WUR
-sasl_process_packet(struct sasl_session *const restrict p, char *const restrict buf, const size_t len)
+sasl_process_result(struct sasl_session *const restrict p, const enum sasl_mechanism_result rc,
+                    const bool have_responded)
 {
-	struct sasl_output_buf outbuf = {
-		.buf    = NULL,
-		.len    = 0,
-		.flags  = ASASL_OUTFLAG_NONE,
-	};
-
-	enum sasl_mechanism_result rc;
-	bool have_responded = false;
-
-	if (! p->mechptr && ! len)
-	{
-		// First piece of data in a session is the name of the SASL mechanism that will be used
-		if (! (p->mechptr = sasl_mechanism_find(buf)))
-		{
-			(void) sasl_sts(p->uid, 'M', sasl_mechlist_string);
-			return false;
-		}
-
-		(void) sasl_sourceinfo_recreate(p);
-
-		if (p->mechptr->mech_start)
-			rc = p->mechptr->mech_start(p, &outbuf);
-		else
-			rc = ASASL_MRESULT_CONTINUE;
-	}
-	else if (! p->mechptr)
-	{
-		(void) slog(LG_DEBUG, "%s: session has no mechanism?", MOWGLI_FUNC_NAME);
-		return false;
-	}
-	else
-	{
-		rc = sasl_process_input(p, buf, len, &outbuf);
-	}
-
-	if (outbuf.buf && outbuf.len)
-	{
-		if (! sasl_process_output(p, &outbuf))
-			return false;
-
-		have_responded = true;
-	}
-
 	// Some progress has been made, reset timeout.
 	p->flags &= ~ASASL_SFLAG_MARKED_FOR_DELETION;
 
@@ -693,6 +651,13 @@ sasl_process_packet(struct sasl_session *const restrict p, char *const restrict
 
 		case ASASL_MRESULT_ERROR:
 			return false;
+
+		case ASASL_MRESULT_ASYNC:
+		{
+			// The mechanism will call sasl_mech_complete() with the real result later
+			p->flags |= ASASL_SFLAG_PENDING;
+			return true;
+		}
 	}
 
 	/* This is only here to keep GCC happy -- Clang can see that the switch() handles all legal
@@ -702,6 +667,58 @@ sasl_process_packet(struct sasl_session *const restrict p, char *const restrict
 	return false;
 }
 
+/* given an entire sasl message, advance session by passing data to mechanism
+ * and feeding returned data back to client.
+ */
+static bool ATHEME_FATTR_WUR
+sasl_process_packet(struct sasl_session *const restrict p, char *const restrict buf, const size_t len)
+{
+	struct sasl_output_buf outbuf = {
+		.buf    = NULL,
+		.len    = 0,
+		.flags  = ASASL_OUTFLAG_NONE,
+	};
+
+	enum sasl_mechanism_result rc;
+	bool have_responded = false;
+
+	if (! p->mechptr && ! len)
+	{
+		// First piece of data in a session is the name of the SASL mechanism that will be used
+		if (! (p->mechptr = sasl_mechanism_find(buf)))
+		{
+			(void) sasl_sts(p->uid, 'M', sasl_mechlist_string);
+			return false;
+		}
+
+		(void) sasl_sourceinfo_recreate(p);
+
+		if (p->mechptr->mech_start)
+			rc = p->mechptr->mech_start(p, &outbuf);
+		else
+			rc = ASASL_MRESULT_CONTINUE;
+	}
+	else if (! p->mechptr)
+	{
+		(void) slog(LG_DEBUG, "%s: session has no mechanism?", MOWGLI_FUNC_NAME);
+		return false;
+	}
+	else
+	{
+		rc = sasl_process_input(p, buf, len, &outbuf);
+	}
+
+	if (outbuf.buf && outbuf.len)
+	{
+		if (! sasl_process_output(p, &outbuf))
+			return false;
+
+		have_responded = true;
+	}
+
+	return sasl_process_result(p, rc, have_responded);
+}
+
 static bool ATHEME_FATTR_WUR
 sasl_process_buffer(struct sasl_session *const restrict p)
 {
@@ -866,12 +883,12 @@ sasl_input(struct sasl_message *const restrict smsg)
 
 		case 'S':
 			// (S)tart authentication
-			ret = sasl_input_startauth(smsg, p);
+			ret = ! (p->flags & ASASL_SFLAG_PENDING) && sasl_input_startauth(smsg, p);
 			break;
 
 		case 'C':
-			// (C)lient data
-			ret = sasl_input_clientdata(smsg, p);
+			// (C)lient data -- none is expected while the mechanism is waiting for a result
+			ret = ! (p->flags & ASASL_SFLAG_PENDING) && sasl_input_clientdata(smsg, p);
 			break;
 
 		case 'D':
@@ -884,6 +901,19 @@ sasl_input(struct sasl_message *const restrict smsg)
 		(void) sasl_session_abort(p);
 }
 
+static void
+sasl_mech_complete(struct sasl_session *const restrict p, const enum sasl_mechanism_result rc)
+{
+	return_if_fail(p != NULL);
+	return_if_fail(p->flags & ASASL_SFLAG_PENDING);
+	return_if_fail(rc != ASASL_MRESULT_ASYNC);
+
+	p->flags &= ~ASASL_SFLAG_PENDING;
+
+	if (! sasl_process_result(p, rc, false))
+		(void) sasl_session_abort(p);
+}
+
 static void
 sasl_user_add(struct hook_user_nick *const restrict data)
 {
@@ -1061,6 +1091,7 @@ const struct sasl_core_functions sasl_core_functions = {
 	.authcid_can_login  = &sasl_authcid_can_login,
 	.authzid_can_login  = &sasl_authzid_can_login,
 	.recalc_mechlist    = &sasl_mechlist_string_build,
+	.mech_complete      = &sasl_mech_complete,
 };
 
 static void
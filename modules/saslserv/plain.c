@@ -12,6 +12,20 @@
 
 static const struct sasl_core_functions *sasl_core_functions = NULL;
 
+static void
+sasl_mech_plain_verified(struct myuser ATHEME_VATTR_UNUSED *const restrict mu,
+                         const enum verify_password_result result, void *const restrict priv)
+{
+	struct sasl_session *const p = priv;
+
+	p->mechdata = NULL;
+
+	if (result == VERIFY_PASSWORD_OK)
+		(void) sasl_core_functions->mech_complete(p, ASASL_MRESULT_SUCCESS);
+	else
+		(void) sasl_core_functions->mech_complete(p, ASASL_MRESULT_FAILURE);
+}
+
 static enum sasl_mechanism_result ATHEME_FATTR_WUR
 sasl_mech_plain_step(struct sasl_session *const restrict p, const struct sasl_input_buf *const restrict in,
                      struct sasl_output_buf ATHEME_VATTR_UNUSED *const restrict out)
@@ -56,10 +70,37 @@ sasl_mech_plain_step(struct sasl_session *const restrict p, const struct sasl_in
 	if (! sasl_core_functions->authcid_can_login(p, HULM_PASSWORD, authcid, &mu))
 		return ASASL_MRESULT_ERROR;
 
-	if (! verify_password(mu, secret))
-		return ASASL_MRESULT_FAILURE;
+	struct verify_password_req *req = NULL;
+
+	switch (verify_password_async(mu, secret, p->ip, &sasl_mech_plain_verified, p, &req))
+	{
+		case VERIFY_PASSWORD_OK:
+			return ASASL_MRESULT_SUCCESS;
+
+		case VERIFY_PASSWORD_FAILED:
+			return ASASL_MRESULT_FAILURE;
+
+		case VERIFY_PASSWORD_BUSY:
+			return ASASL_MRESULT_ERROR;
+
+		case VERIFY_PASSWORD_PENDING:
+			p->mechdata = req;
+			return ASASL_MRESULT_ASYNC;
+	}
+
+	return ASASL_MRESULT_ERROR;
+}
+
+static void
+sasl_mech_plain_finish(struct sasl_session *const restrict p)
+{
+	if (! (p && p->mechdata))
+		return;
+
+	// The session is going away before its password has been verified
+	(void) verify_password_cancel(p->mechdata);
 
-	return ASASL_MRESULT_SUCCESS;
+	p->mechdata = NULL;
 }
 
 static const struct sasl_mechanism sasl_mech_plain = {
@@ -67,7 +108,7 @@ static const struct sasl_mechanism sasl_mech_plain = {
 	.name           = "PLAIN",
 	.mech_start     = NULL,
 	.mech_step      = &sasl_mech_plain_step,
-	.mech_finish    = NULL,
+	.mech_finish    = &sasl_mech_plain_finish,
 };
 
 static void
@@ -710,8 +710,7 @@ scram_step_success(struct sasl_session *const restrict p)
 	}
 
 	(void) slog(LG_DEBUG, "%s: succeeded", MOWGLI_FUNC_NAME);
-	(void) smemzero(s->mu->pass, sizeof s->mu->pass);
-	(void) memcpy(s->mu->pass, buf, (size_t) ret);
+	(void) myuser_set_pass(s->mu, buf);
 	(void) smemzero(buf, sizeof buf);
 	(void) hook_call_myuser_changed_password_or_hash(s->mu);
 
@@ -17,9 +17,20 @@ static mowgli_list_t *httpd_path_handlers = NULL;
 static mowgli_list_t conf_jsonrpc_table;
 static bool jsonrpc_log_full_info = false;
 
+// A login waiting for its password to be verified on another thread
+struct jsonrpc_login
+{
+	mowgli_node_t                   node;
+	struct connection *             conn;
+	char *                          sourceip;
+	char *                          id;
+	struct verify_password_req *    req;
+};
+
 // Miscellaneous state for this module
 static mowgli_patricia_t *json_methods = NULL;
 static mowgli_node_t *jsonrpc_path_node = NULL;
+static mowgli_list_t jsonrpc_login_list;
 
 void
 jsonrpc_register_method(const char *method_name, jsonrpc_method_fn method)
@@ -145,6 +156,92 @@ static struct sourceinfo_vtable jsonrpc_vtable = {
 
 // These taken from modules/transport/xmlrpc/main.c
 
+static void
+jsonrpc_login_free(struct jsonrpc_login *const restrict login)
+{
+	sfree(login->sourceip);
+	sfree(login->id);
+	sfree(login);
+}
+
+// Answers an atheme.login request once the password has been verified
+static bool
+jsonrpc_login_finish(void *conn, struct myuser *mu, bool verified, char *sourceip, char *id)
+{
+	struct authcookie *ac;
+
+	if (!verified)
+	{
+		struct sourceinfo *si;
+
+		logcommand_external(nicksvs.me, "jsonrpc", conn, sourceip, NULL, CMDLOG_LOGIN, "failed LOGIN to \2%s\2 (bad password)", entity(mu)->name);
+		jsonrpc_failure_string(conn, fault_authfail, "The password is incorrect.", id);
+
+		si = sourceinfo_create();
+
+		struct jsonrpc_sourceinfo *jsi = (struct jsonrpc_sourceinfo *)si;
+
+		si->service = NULL;
+		si->sourcedesc = sourceip;
+		si->connection = conn;
+		si->v = &jsonrpc_vtable;
+		si->force_language = language_find("en");
+
+		jsi->base = si;
+		jsi->id = id;
+
+		bad_password(si, mu);
+
+		atheme_object_unref(si);
+
+		return false;
+	}
+
+	mu->lastlogin = CURRTIME;
+	db_record_touched(DB_RECORD_MYUSER, mu);
+
+	ac = authcookie_create(mu);
+
+	logcommand_external(nicksvs.me, "jsonrpc", conn, sourceip, mu, CMDLOG_LOGIN, "LOGIN");
+
+	jsonrpc_success_string(conn, ac->ticket, id);
+
+	return true;
+}
+
+static void
+jsonrpc_login_verified(struct myuser *mu, enum verify_password_result result, void *priv)
+{
+	struct jsonrpc_login *const login = priv;
+	struct connection *const conn = login->conn;
+	struct httpddata *const hd = conn->userdata;
+
+	mowgli_node_delete(&login->node, &jsonrpc_login_list);
+	hd->pending = NULL;
+	hd->pending_cancel = NULL;
+
+	if (mu == NULL)
+		jsonrpc_failure_string(conn, fault_nosuch_source, "The account is not registered.", login->id);
+	else
+		(void) jsonrpc_login_finish(conn, mu, result == VERIFY_PASSWORD_OK, login->sourceip, login->id);
+
+	// The reply has been sent; go on with the next request on this connection
+	recvq_hold(conn, false);
+
+	jsonrpc_login_free(login);
+}
+
+// The connection closed while the password was being verified
+static void
+jsonrpc_login_cancel(void *priv)
+{
+	struct jsonrpc_login *const login = priv;
+
+	verify_password_cancel(login->req);
+	mowgli_node_delete(&login->node, &jsonrpc_login_list);
+	jsonrpc_login_free(login);
+}
+
 /* atheme.login
  *
  * Parameters:
@@ -155,17 +252,21 @@ static struct sourceinfo_vtable jsonrpc_vtable = {
  *       fault 3 - account is not registered
  *       fault 5 - invalid username and password
  *       fault 6 - account is frozen
+ *       fault 9 - too many logins are being verified; try again later
  *       default - success (authcookie)
  *
  * Side Effects:
  *       an authcookie ticket is created for the struct myuser.
  *       the user's lastlogin is updated
+ *
+ * With general::auth_threads set, the password is verified on another
+ * thread and the reply is sent when that is done; the connection's next
+ * request is only read after that, so that replies keep their order.
  */
 static bool
 jsonrpcmethod_login(void *conn, mowgli_list_t *params, char *id)
 {
 	struct myuser *mu;
-	struct authcookie *ac;
 	char *sourceip, *accountname, *password;
 
 	size_t len = MOWGLI_LIST_LENGTH(params);
@@ -193,40 +294,40 @@ jsonrpcmethod_login(void *conn, mowgli_list_t *params, char *id)
 		return false;
 	}
 
-	if (!verify_password(mu, password))
-	{
-		struct sourceinfo *si;
-
-		logcommand_external(nicksvs.me, "jsonrpc", conn, sourceip, NULL, CMDLOG_LOGIN, "failed LOGIN to \2%s\2 (bad password)", entity(mu)->name);
-		jsonrpc_failure_string(conn, fault_authfail, "The password is incorrect.", id);
-
-		si = sourceinfo_create();
+	struct jsonrpc_login *const login = smalloc(sizeof *login);
 
-		struct jsonrpc_sourceinfo *jsi = (struct jsonrpc_sourceinfo *)si;
+	login->conn = conn;
+	login->sourceip = sstrdup(sourceip);
+	login->id = sstrdup(id);
 
-		si->service = NULL;
-		si->sourcedesc = sourceip;
-		si->connection = conn;
-		si->v = &jsonrpc_vtable;
-		si->force_language = language_find("en");
-
-		jsi->base = si;
-		jsi->id = id;
-
-		bad_password(si, mu);
-
-		atheme_object_unref(si);
-
-		return false;
+	switch (verify_password_async(mu, password, sourceip, &jsonrpc_login_verified, login, &login->req))
+	{
+		case VERIFY_PASSWORD_OK:
+			jsonrpc_login_free(login);
+			return jsonrpc_login_finish(conn, mu, true, sourceip, id);
+
+		case VERIFY_PASSWORD_FAILED:
+			jsonrpc_login_free(login);
+			return jsonrpc_login_finish(conn, mu, false, sourceip, id);
+
+		case VERIFY_PASSWORD_BUSY:
+			jsonrpc_login_free(login);
+			logcommand_external(nicksvs.me, "jsonrpc", conn, sourceip, NULL, CMDLOG_LOGIN, "failed LOGIN to \2%s\2 (server busy)", entity(mu)->name);
+			jsonrpc_failure_string(conn, fault_toomany, "Too many logins are being processed right now; please try again later.", id);
+			return false;
+
+		case VERIFY_PASSWORD_PENDING:
+			break;
 	}
 
-	mu->lastlogin = CURRTIME;
-
-	ac = authcookie_create(mu);
+	struct httpddata *const hd = ((struct connection *) conn)->userdata;
 
-	logcommand_external(nicksvs.me, "jsonrpc", conn, sourceip, mu, CMDLOG_LOGIN, "LOGIN");
+	hd->pending = login;
+	hd->pending_cancel = &jsonrpc_login_cancel;
+	mowgli_node_add(login, &login->node, &jsonrpc_login_list);
 
-	jsonrpc_success_string(conn, ac->ticket, id);
+	// Replies must go out in request order, so read nothing more until this one is sent
+	recvq_hold(conn, true);
 
 	return true;
 }
@@ -711,6 +812,24 @@ mod_init(struct module *const restrict m)
 static void
 mod_deinit(const enum module_unload_intent ATHEME_VATTR_UNUSED intent)
 {
+	mowgli_node_t *n, *tn;
+
+	MOWGLI_ITER_FOREACH_SAFE(n, tn, jsonrpc_login_list.head)
+	{
+		struct jsonrpc_login *const login = n->data;
+		struct httpddata *const hd = login->conn->userdata;
+
+		verify_password_cancel(login->req);
+		hd->pending = NULL;
+		hd->pending_cancel = NULL;
+
+		jsonrpc_failure_string(login->conn, fault_internalerror, "The JSON-RPC module is being unloaded.", login->id);
+		recvq_hold(login->conn, false);
+
+		mowgli_node_delete(n, &jsonrpc_login_list);
+		jsonrpc_login_free(login);
+	}
+
 	del_conf_item("LOG_FULL_INFO", &conf_jsonrpc_table);
 	del_top_conf("JSONRPC");
 
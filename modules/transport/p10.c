@@ -24,7 +24,6 @@ p10_parse(char *line)
 	char *command = NULL;
 	char *message = NULL;
 	char *parv[MAXPARC + 1];
-	static char coreLine[BUFSIZE];
 	int parc = 0;
 	unsigned int i;
 	struct proto_cmd *pcmd;
@@ -47,9 +46,8 @@ p10_parse(char *line)
 		if (*line == '\000')
 			goto cleanup;
 
-		// copy the original line so we know what we crashed on
-		memset((char *)&coreLine, '\0', BUFSIZE);
-		mowgli_strlcpy(coreLine, line, BUFSIZE);
+		// remember the original line so we know what we crashed on
+		parse_set_coreline(line, strlen(line));
 
 		slog(LG_RAWDATA, "-> %s", line);
 
@@ -104,12 +102,12 @@ p10_parse(char *line)
                 }
 		if (si->s == me.me)
 		{
-                        slog(LG_INFO, "p10_parse(): got message supposedly from myself %s: %s", si->s->name, coreLine);
+                        slog(LG_INFO, "p10_parse(): got message supposedly from myself %s: %s", si->s->name, parse_coreline());
                         goto cleanup;
 		}
 		if (si->su != NULL && si->su->server == me.me)
 		{
-                        slog(LG_INFO, "p10_parse(): got message supposedly from my own client %s: %s", si->su->nick, coreLine);
+                        slog(LG_INFO, "p10_parse(): got message supposedly from my own client %s: %s", si->su->nick, parse_coreline());
                         goto cleanup;
 		}
 		si->smu = si->su != NULL ? si->su->myuser : NULL;
@@ -137,7 +135,7 @@ p10_parse(char *line)
 		 */
 		if (!command)
 		{
-			slog(LG_DEBUG, "p10_parse(): command not found: %s", coreLine);
+			slog(LG_DEBUG, "p10_parse(): command not found: %s", parse_coreline());
 			goto cleanup;
 		}
 
@@ -172,6 +170,7 @@ p10_parse(char *line)
 	}
 
 cleanup:
+	parse_set_coreline(NULL, 0);
 	atheme_object_unref(si);
 }
 
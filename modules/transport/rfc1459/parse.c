@@ -77,7 +77,6 @@ irc_parse(char *line)
 	char *command = NULL;
 	char *message = NULL;
 	char *parv[MAXPARC + 1];
-	static char coreLine[BUFSIZE];
 	int parc = 0;
 	unsigned int i;
 	struct proto_cmd *pcmd;
@@ -100,9 +99,8 @@ irc_parse(char *line)
 		if (*line == '\000')
 			goto cleanup;
 
-		// copy the original line so we know what we crashed on
-		memset((char *)&coreLine, '\0', BUFSIZE);
-		mowgli_strlcpy(coreLine, line, BUFSIZE);
+		// remember the original line so we know what we crashed on
+		parse_set_coreline(line, strlen(line));
 
 		slog(LG_RAWDATA, "-> %s", line);
 
@@ -205,12 +203,12 @@ irc_parse(char *line)
                 }
 		if (si->s == me.me)
 		{
-                        slog(LG_INFO, "irc_parse(): got message supposedly from myself %s: %s", si->s->name, coreLine);
+                        slog(LG_INFO, "irc_parse(): got message supposedly from myself %s: %s", si->s->name, parse_coreline());
                         goto cleanup;
 		}
 		if (si->su != NULL && si->su->server == me.me)
 		{
-                        slog(LG_INFO, "irc_parse(): got message supposedly from my own client %s: %s", si->su->nick, coreLine);
+                        slog(LG_INFO, "irc_parse(): got message supposedly from my own client %s: %s", si->su->nick, parse_coreline());
                         goto cleanup;
 		}
 		si->smu = si->su != NULL ? si->su->myuser : NULL;
@@ -261,6 +259,7 @@ irc_parse(char *line)
 	}
 
 cleanup:
+	parse_set_coreline(NULL, 0);
 	if (si->tags != NULL)
 	{
 		mowgli_patricia_destroy(si->tags, message_tag_free_cb, NULL);
@@ -214,6 +214,7 @@ xmlrpcmethod_login(void *conn, int parc, char *parv[])
 	}
 
 	mu->lastlogin = CURRTIME;
+	db_record_touched(DB_RECORD_MYUSER, mu);
 
 	ac = authcookie_create(mu);
 
@@ -423,3 +423,86 @@ benchmark_pbkdf2(const enum digest_algorithm digest, const size_t itercount, con
 	(void) pbkdf2_print_rowstats(digest, itercount, with_sasl_scram, duration);
 	return true;
 }
+
+#if (ATHEME_API_DIGEST_FRONTEND == ATHEME_API_DIGEST_FRONTEND_INTERNAL)
+
+void
+pbkdf2_lanes_print_colheaders(void)
+{
+	(void) bench_print(_(""
+		"\n"
+		"Digest           Iterations     Kernel     Batch  Elapsed        Per Derivation\n"
+		"---------------- -------------- ---------- ------ -------------- --------------"
+	));
+}
+
+void
+pbkdf2_lanes_print_rowstats(const enum digest_algorithm digest, const size_t iterations,
+                            const enum digest_lanes_impl impl, const size_t batch, const long double elapsed)
+{
+	(void) bench_print(_("%16s %14zu %-10s %6zu %13LFs %13LFs"), md_digest_to_name(digest, false), iterations,
+	                   digest_direct_lanes_name(impl), batch, elapsed, elapsed / batch);
+}
+
+bool ATHEME_FATTR_WUR
+benchmark_pbkdf2_lanes(const enum digest_algorithm digest, const size_t itercount, const enum digest_lanes_impl impl,
+                       const size_t batch, long double *const restrict elapsed)
+{
+	static unsigned char dkbuf[DIGEST_LANES_MAX][DIGEST_MDLEN_MAX];
+
+	struct digest_pbkdf2_job jobs[DIGEST_LANES_MAX];
+	const size_t mdlen = digest_size_alg(digest);
+	struct timespec begin;
+	struct timespec end;
+
+	if (! batch || batch > DIGEST_LANES_MAX)
+		return false;
+
+	for (size_t i = 0; i < batch; i++)
+	{
+		jobs[i].pass = passbuf;
+		jobs[i].passLen = PASSLEN;
+		jobs[i].salt = saltbuf;
+		jobs[i].saltLen = PBKDF2_SALTLEN_DEF;
+		jobs[i].dk = dkbuf[i];
+		jobs[i].dkLen = mdlen;
+	}
+
+	(void) memset(&begin, 0x00, sizeof begin);
+	(void) memset(&end, 0x00, sizeof end);
+
+	if (! digest_direct_lanes_force(impl))
+	{
+		(void) bench_print(_("The %s kernel is not supported by this CPU"), digest_direct_lanes_name(impl));
+		return false;
+	}
+	if (clock_gettime(CLOCK_MONOTONIC, &begin) != 0)
+	{
+		(void) perror("clock_gettime(2)");
+		return false;
+	}
+	if (! digest_oneshot_pbkdf2_batch(digest, jobs, batch, itercount))
+	{
+		(void) bench_print("digest_oneshot_pbkdf2_batch() failed");
+		return false;
+	}
+	if (clock_gettime(CLOCK_MONOTONIC, &end) != 0)
+	{
+		(void) perror("clock_gettime(2)");
+		return false;
+	}
+
+	(void) digest_direct_lanes_force(DIGEST_LANES_IMPL_AUTO);
+
+	const long double begin_ld = ((long double) begin.tv_sec) + (((long double) begin.tv_nsec) / nsec_per_sec);
+	const long double end_ld = ((long double) end.tv_sec) + (((long double) end.tv_nsec) / nsec_per_sec);
+	const long double duration = (end_ld - begin_ld);
+
+	if (elapsed)
+		*elapsed = duration;
+
+	(void) pbkdf2_lanes_print_rowstats(digest, itercount, impl, batch, duration);
+	return true;
+}
+
+#endif /* (ATHEME_API_DIGEST_FRONTEND == ATHEME_API_DIGEST_FRONTEND_INTERNAL) */
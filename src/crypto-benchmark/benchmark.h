@@ -31,6 +31,7 @@
 #define BENCH_RUN_OPTIONS_SCRYPT    0x0008U
 #define BENCH_RUN_OPTIONS_BCRYPT    0x0010U
 #define BENCH_RUN_OPTIONS_PBKDF2    0x0020U
+#define BENCH_RUN_OPTIONS_VERIFY    0x0040U
 
 #if defined(HAVE_LIBARGON2) || defined(HAVE_LIBSODIUM_SCRYPT)
 #  define HAVE_ANY_MEMORY_HARD_ALGORITHM 1
@@ -66,4 +67,11 @@ void pbkdf2_print_colheaders(void);
 void pbkdf2_print_rowstats(enum digest_algorithm, size_t, bool, long double);
 bool benchmark_pbkdf2(enum digest_algorithm, size_t, bool, long double *) ATHEME_FATTR_WUR;
 
+#if (ATHEME_API_DIGEST_FRONTEND == ATHEME_API_DIGEST_FRONTEND_INTERNAL)
+void pbkdf2_lanes_print_colheaders(void);
+void pbkdf2_lanes_print_rowstats(enum digest_algorithm, size_t, enum digest_lanes_impl, size_t, long double);
+bool benchmark_pbkdf2_lanes(enum digest_algorithm, size_t, enum digest_lanes_impl, size_t, long double *)
+    ATHEME_FATTR_WUR;
+#endif
+
 #endif /* !ATHEME_SRC_CRYPTO_BENCHMARK_BENCHMARK_H */
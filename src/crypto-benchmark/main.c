@@ -25,6 +25,7 @@
 #include "benchmark.h"              // (everything else)
 #include "optimal.h"                // do_optimal_benchmarks()
 #include "selftests.h"              // do_crypto_selftests()
+#include "verify.h"                 // do_verify_dispatch_tests()
 
 #define BENCH_ARRAY_SIZE(x)         ((sizeof((x))) / (sizeof((x)[0])))
 
@@ -36,6 +37,10 @@
 #define BENCH_MEMLIMIT_DEF          BENCH_MAX(ATHEME_ARGON2_MEMCOST_DEF, ATHEME_SCRYPT_MEMLIMIT_DEF)
 #define BENCH_MEMLIMIT_MAX          BENCH_MIN(ATHEME_ARGON2_MEMCOST_MAX, ATHEME_SCRYPT_MEMLIMIT_MAX)
 
+#define BENCH_VERIFY_ACCOUNTS_MIN   1U
+#define BENCH_VERIFY_ACCOUNTS_DEF   120U
+#define BENCH_VERIFY_ACCOUNTS_MAX   100000U
+
 #ifdef HAVE_LIBARGON2
 
 static argon2_type b_argon2_types_default[] = { Argon2_id };
@@ -80,6 +85,8 @@ static enum digest_algorithm b_pbkdf2_digests_default[] = { DIGALG_SHA1, DIGALG_
 static enum digest_algorithm *b_pbkdf2_digests = NULL;
 static size_t b_pbkdf2_digests_count = 0;
 
+static unsigned int b_verify_accounts = BENCH_VERIFY_ACCOUNTS_DEF;
+
 static long double optimal_clocklimit = BENCH_CLOCKTIME_DEF;
 static unsigned int optimal_memlimit = BENCH_MEMLIMIT_DEF;
 static bool optimal_memlimit_given = false;
@@ -118,6 +125,8 @@ static const mowgli_getopt_option_t bench_long_opts[] = {
 	{    "run-pbkdf2-benchmarks",       no_argument, NULL, 'k', 0 },
 	{        "pbkdf2-iterations", required_argument, NULL, 'c', 0 },
 	{ "pbkdf2-digest-algorithms", required_argument, NULL, 'd', 0 },
+	{       "run-dispatch-tests",       no_argument, NULL, 'x', 0 },
+	{          "verify-accounts", required_argument, NULL, 'w', 0 },
 
 	{ NULL, 0, NULL, 0, 0 },
 };
@@ -164,11 +173,16 @@ print_usage(void)
 		"  -c/--pbkdf2-iterations         Comma-separated iteration counts\n"
 		"  -d/--pbkdf2-digests            Comma-separated digest algorithms\n"
 		"\n"
+		"  -x/--run-dispatch-tests      Check which providers are offered each hash\n"
+		"                                 in a corpus of mixed-algorithm accounts,\n"
+		"                                 and time verifying them:\n"
+		"  -w/--verify-accounts           Number of accounts\n"
+		"\n"
 		"  Valid Argon2 types are: Argon2d, Argon2i, Argon2id (case-insensitive)\n"
 		"  Valid PBKDF2 digests are: MD5, SHA1, SHA2-256, SHA2-512 (case-insensitive)\n"
 		"\n"
 		"  If one of the above customisable options are not given, defaults are used.\n"
-		"  One of -h/-v/-o/-a/-s/-k MUST be given. They are all mutually-exclusive.\n"
+		"  One of -h/-v/-o/-a/-s/-k/-x MUST be given. They are all mutually-exclusive.\n"
 	));
 }
 
@@ -450,6 +464,25 @@ process_options(int argc, char *argv[])
 				break;
 			}
 
+			case 'x':
+				run_options |= BENCH_RUN_OPTIONS_VERIFY;
+				break;
+
+			case 'w':
+			{
+				if (! string_to_uint(mowgli_optarg, &b_verify_accounts) ||
+				    b_verify_accounts < BENCH_VERIFY_ACCOUNTS_MIN || b_verify_accounts > BENCH_VERIFY_ACCOUNTS_MAX)
+				{
+					(void) bench_print(_(""
+						"'%s' is not a valid value for integer option '%c'\n"
+						"range of valid values: %u to %u (inclusive)\n"
+					), mowgli_optarg, c, BENCH_VERIFY_ACCOUNTS_MIN, BENCH_VERIFY_ACCOUNTS_MAX);
+
+					return false;
+				}
+				break;
+			}
+
 			default:
 				(void) print_usage();
 				return false;
@@ -614,6 +647,47 @@ do_pbkdf2_benchmarks(void)
 	      // This function logs error messages on failure
 	      return false;
 
+#if (ATHEME_API_DIGEST_FRONTEND == ATHEME_API_DIGEST_FRONTEND_INTERNAL)
+	static const enum digest_lanes_impl b_lanes_impls[] = {
+		DIGEST_LANES_IMPL_SCALAR, DIGEST_LANES_IMPL_SSE41, DIGEST_LANES_IMPL_AVX2,
+	};
+
+	(void) bench_print("");
+	(void) bench_print(_(""
+		"SHA2 multi-lane kernels (a batch of 1 is a single derivation; a batch of\n"
+		"%u runs that many derivations in parallel lanes):"
+	), DIGEST_LANES_MAX);
+
+	(void) pbkdf2_lanes_print_colheaders();
+
+	for (size_t b_pbkdf2_digest = 0; b_pbkdf2_digest < b_pbkdf2_digests_count; b_pbkdf2_digest++)
+	{
+		const enum digest_algorithm b_digest = b_pbkdf2_digests[b_pbkdf2_digest];
+
+		if (b_digest != DIGALG_SHA2_256 && b_digest != DIGALG_SHA2_512)
+			continue;
+
+		for (size_t b_pbkdf2_itercount = 0; b_pbkdf2_itercount < b_pbkdf2_itercounts_count; b_pbkdf2_itercount++)
+		  for (size_t b_lanes_impl = 0; b_lanes_impl < BENCH_ARRAY_SIZE(b_lanes_impls); b_lanes_impl++)
+		  {
+		    if (! digest_direct_lanes_supported(b_lanes_impls[b_lanes_impl]))
+		      continue;
+
+		    // A single derivation always uses the scalar kernel
+		    if (b_lanes_impls[b_lanes_impl] == DIGEST_LANES_IMPL_SCALAR &&
+		        ! benchmark_pbkdf2_lanes(b_digest, b_pbkdf2_itercounts[b_pbkdf2_itercount],
+		                                 b_lanes_impls[b_lanes_impl], 1, NULL))
+		      // This function logs error messages on failure
+		      return false;
+
+		    if (! benchmark_pbkdf2_lanes(b_digest, b_pbkdf2_itercounts[b_pbkdf2_itercount],
+		                                 b_lanes_impls[b_lanes_impl], DIGEST_LANES_MAX, NULL))
+		      // This function logs error messages on failure
+		      return false;
+		  }
+	}
+#endif
+
 	return true;
 }
 
@@ -668,5 +742,9 @@ main(int argc, char *argv[])
 		// This function logs error messages on failure
 		return EXIT_FAILURE;
 
+	if ((run_options & BENCH_RUN_OPTIONS_VERIFY) && ! do_verify_dispatch_tests(b_verify_accounts))
+		// This function logs error messages on failure
+		return EXIT_FAILURE;
+
 	return EXIT_SUCCESS;
 }
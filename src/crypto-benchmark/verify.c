@@ -0,0 +1,392 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * Checks which providers crypt_verify_password() hands each hash to, in a
+ * corpus of accounts whose passwords were hashed by several different
+ * providers: once with the providers declaring the prefixes of their hashes,
+ * and once without (so that the providers are tried in turn). It counts the
+ * calls made into providers other than the one that produced the hash, and
+ * how many of those computed a full hash, and times each verification.
+ *
+ * The providers are stand-ins registered by this program, since it does not
+ * load modules: each one computes PBKDF2 with its own digest algorithm. Like
+ * the real ones, those with a verify function reject foreign hashes by their
+ * prefix, and the legacy ones have no prefix and only a crypt function, so
+ * they must compute a hash before they can tell whether it matches. The times
+ * are those of these stand-ins, not of the real providers.
+ */
+
+#include <atheme/attributes.h>      // ATHEME_FATTR_WUR
+#include <atheme/constants.h>       // BUFSIZE
+#include <atheme/crypto.h>          // crypt_register(), crypt_unregister(), crypt_verify_password()
+#include <atheme/digest.h>          // DIGALG_*, digest_oneshot_pbkdf2()
+#include <atheme/i18n.h>            // _() (gettext)
+#include <atheme/random.h>          // atheme_random_*()
+#include <atheme/stdheaders.h>      // (everything else)
+
+#include "benchmark.h"              // (everything else)
+#include "verify.h"                 // self-declarations
+
+#define VERIFY_SALTLEN              8U
+#define VERIFY_PASSLEN              16U
+#define VERIFY_ITERCNT              1000U
+
+struct verify_alg
+{
+	const char *            name;
+	const char *            prefix[2];
+	enum digest_algorithm   digest;
+};
+
+struct verify_account
+{
+	size_t                  alg;
+	char                    pass[VERIFY_PASSLEN + 1];
+	char                    hash[BUFSIZE];
+};
+
+struct verify_counts
+{
+	size_t                  verifies;
+	size_t                  foreign_calls;
+	size_t                  foreign_runs;
+	long double             elapsed;            // seconds, over all verifications
+	long double             elapsed_max;        // seconds, of the slowest one
+};
+
+/* In the order they are registered (and so tried without prefixes); the default provider (the first one with a
+ * crypt function) comes first, as it would on a network that has been migrating its users' hashes to it. The
+ * ones without a prefix are legacy providers with only a crypt function.
+ */
+static const struct verify_alg verify_algs[] = {
+	{ "sha512",        { "$bench-sha512$", NULL },  DIGALG_SHA2_512 },
+	{ "sha256",        { "$bench-sha256$", NULL },  DIGALG_SHA2_256 },
+	{ "sha1",          { "$bench-sha1$", NULL },    DIGALG_SHA1     },
+	{ "legacy-sha256", { NULL },                    DIGALG_SHA2_256 },
+	{ "legacy-sha1",   { NULL },                    DIGALG_SHA1     },
+	{ "legacy-md5",    { NULL },                    DIGALG_MD5      },
+};
+
+#define VERIFY_ALG_COUNT            (sizeof verify_algs / sizeof verify_algs[0])
+
+// Calls into each provider, and full hashes computed by each, since they were last reset
+static size_t verify_calls[VERIFY_ALG_COUNT];
+static size_t verify_runs[VERIFY_ALG_COUNT];
+
+static const char *
+verify_alg_crypt(const size_t alg, const char *const restrict password, const char *const restrict parameters)
+{
+	static char result[BUFSIZE];
+
+	const struct verify_alg *const va = &verify_algs[alg];
+	const char *const prefix = (va->prefix[0] ? va->prefix[0] : "");
+	const size_t prefixlen = strlen(prefix);
+	const size_t mdlen = digest_size_alg(va->digest);
+	unsigned char salt[VERIFY_SALTLEN];
+	unsigned char digest[DIGEST_MDLEN_MAX];
+
+	(void) memset(salt, 0x00, sizeof salt);
+
+	if (! parameters)
+	{
+		(void) atheme_random_buf(salt, sizeof salt);
+	}
+	else if (strncmp(parameters, prefix, prefixlen) == 0)
+	{
+		// A foreign hash gets a garbage salt here; the result then simply won't match it
+		for (size_t i = 0; i < sizeof salt; i++)
+			if (sscanf(parameters + prefixlen + (2 * i), "%2hhx", &salt[i]) != 1)
+				break;
+	}
+
+	verify_runs[alg]++;
+
+	if (! digest_oneshot_pbkdf2(va->digest, password, strlen(password), salt, sizeof salt, VERIFY_ITERCNT,
+	                            digest, mdlen))
+		return NULL;
+
+	char *ptr = result + snprintf(result, sizeof result, "%s", prefix);
+
+	for (size_t i = 0; i < sizeof salt; i++)
+		ptr += snprintf(ptr, 3, "%02x", salt[i]);
+
+	*ptr++ = '$';
+
+	for (size_t i = 0; i < mdlen; i++)
+		ptr += snprintf(ptr, 3, "%02x", digest[i]);
+
+	return result;
+}
+
+static bool
+verify_alg_verify(const size_t alg, const char *const restrict password, const char *const restrict parameters,
+                  unsigned int *const restrict flags)
+{
+	const char *const prefix = verify_algs[alg].prefix[0];
+
+	if (strncmp(parameters, prefix, strlen(prefix)) != 0)
+		return false;
+
+	*flags |= PWVERIFY_FLAG_MYMODULE;
+
+	const char *const result = verify_alg_crypt(alg, password, parameters);
+
+	return (result && strcmp(result, parameters) == 0);
+}
+
+#define VERIFY_ALG_FUNCS(n)                                                                                     \
+    static const char *                                                                                         \
+    verify_alg_crypt_##n(const char *const restrict password, const char *const restrict parameters)           \
+    {                                                                                                           \
+        verify_calls[n]++;                                                                                      \
+        return verify_alg_crypt(n, password, parameters);                                                       \
+    }                                                                                                           \
+    static bool                                                                                                 \
+    verify_alg_verify_##n(const char *const restrict password, const char *const restrict parameters,          \
+                          unsigned int *const restrict flags)                                                   \
+    {                                                                                                           \
+        verify_calls[n]++;                                                                                      \
+        return verify_alg_verify(n, password, parameters, flags);                                               \
+    }
+
+VERIFY_ALG_FUNCS(0)
+VERIFY_ALG_FUNCS(1)
+VERIFY_ALG_FUNCS(2)
+VERIFY_ALG_FUNCS(3)
+VERIFY_ALG_FUNCS(4)
+VERIFY_ALG_FUNCS(5)
+
+#define VERIFY_ALG_IMPL(n, with_prefixes)                                                                       \
+    {                                                                                                           \
+        .id         = "bench/" #n,                                                                              \
+        .crypt      = &verify_alg_crypt_##n,                                                                    \
+        .verify     = verify_algs[n].prefix[0] ? &verify_alg_verify_##n : NULL,                                 \
+        .prefixes   = ((with_prefixes) && verify_algs[n].prefix[0]) ? verify_algs[n].prefix : NULL,             \
+    }
+
+static struct crypt_impl verify_impls_walk[VERIFY_ALG_COUNT];
+static struct crypt_impl verify_impls_index[VERIFY_ALG_COUNT];
+
+static void
+verify_impls_init(void)
+{
+	const struct crypt_impl walk[] = {
+		VERIFY_ALG_IMPL(0, false), VERIFY_ALG_IMPL(1, false), VERIFY_ALG_IMPL(2, false),
+		VERIFY_ALG_IMPL(3, false), VERIFY_ALG_IMPL(4, false), VERIFY_ALG_IMPL(5, false),
+	};
+	const struct crypt_impl index[] = {
+		VERIFY_ALG_IMPL(0, true), VERIFY_ALG_IMPL(1, true), VERIFY_ALG_IMPL(2, true),
+		VERIFY_ALG_IMPL(3, true), VERIFY_ALG_IMPL(4, true), VERIFY_ALG_IMPL(5, true),
+	};
+
+	(void) memcpy(verify_impls_walk, walk, sizeof walk);
+	(void) memcpy(verify_impls_index, index, sizeof index);
+}
+
+static void
+verify_print_colheaders(void)
+{
+	(void) bench_print(_(""
+		"\n"
+		"Algorithm        Dispatch   Verifies   Foreign calls  Foreign hashes  Mean (ms)  Max (ms)\n"
+		"---------------- ---------- ---------- -------------- -------------- ---------- ----------"
+	));
+}
+
+/* Verifies one password against one account's hash and adds the calls made into other providers, and the time
+ * taken, to 'counts'. With prefixes declared, a hash with a prefix must only reach its owner, and a hash without
+ * one must only reach the providers without prefixes.
+ */
+static bool ATHEME_FATTR_WUR
+verify_account_check(const struct verify_account *const restrict acc, const char *const restrict password,
+                     const struct crypt_impl *const restrict expect, const struct crypt_impl *const restrict impls,
+                     const bool with_prefixes, struct verify_counts *const restrict counts)
+{
+	const long double nsec_per_sec = 1000000000.0L;
+	struct timespec begin;
+	struct timespec end;
+	unsigned int flags;
+
+	(void) memset(verify_calls, 0x00, sizeof verify_calls);
+	(void) memset(verify_runs, 0x00, sizeof verify_runs);
+
+	if (clock_gettime(CLOCK_MONOTONIC, &begin) != 0)
+	{
+		(void) perror("clock_gettime(2)");
+		return false;
+	}
+
+	const struct crypt_impl *const ci = crypt_verify_password(password, acc->hash, &flags);
+
+	if (clock_gettime(CLOCK_MONOTONIC, &end) != 0)
+	{
+		(void) perror("clock_gettime(2)");
+		return false;
+	}
+
+	const long double duration = ((long double) (end.tv_sec - begin.tv_sec)) +
+	                             (((long double) (end.tv_nsec - begin.tv_nsec)) / nsec_per_sec);
+
+	if (ci != expect)
+	{
+		(void) bench_print(_("crypt_verify_password() gave a '%s' hash to the wrong provider (BUG!)"),
+		                   verify_algs[acc->alg].name);
+		return false;
+	}
+
+	for (size_t i = 0; i < VERIFY_ALG_COUNT; i++)
+	{
+		if (i == acc->alg)
+			continue;
+
+		if (with_prefixes && verify_calls[i] && (verify_algs[acc->alg].prefix[0] || impls[i].prefixes))
+		{
+			(void) bench_print(_("crypt_verify_password() offered a '%s' hash to the '%s' provider (BUG!)"),
+			                   verify_algs[acc->alg].name, verify_algs[i].name);
+			return false;
+		}
+
+		counts->foreign_calls += verify_calls[i];
+		counts->foreign_runs += verify_runs[i];
+	}
+
+	counts->verifies++;
+	counts->elapsed += duration;
+	counts->elapsed_max = BENCH_MAX(counts->elapsed_max, duration);
+	return true;
+}
+
+static bool ATHEME_FATTR_WUR
+verify_corpus_run(const struct verify_account *const restrict corpus, const size_t accounts,
+                  const struct crypt_impl *const restrict impls, const bool with_prefixes,
+                  struct verify_counts *const restrict total)
+{
+	const char *const dispatch = (with_prefixes ? "prefix" : "walk");
+	struct verify_counts alg_counts[VERIFY_ALG_COUNT];
+	bool result = true;
+
+	(void) memset(alg_counts, 0x00, sizeof alg_counts);
+
+	for (size_t i = 0; i < VERIFY_ALG_COUNT; i++)
+		(void) crypt_register(&impls[i]);
+
+	for (size_t i = 0; result && i < accounts; i++)
+	{
+		const struct verify_account *const acc = &corpus[i];
+		struct verify_counts *const counts = &alg_counts[acc->alg];
+
+		// Once with the right password, then with a wrong one, which nobody may accept
+		result = verify_account_check(acc, acc->pass, &impls[acc->alg], impls, with_prefixes, counts) &&
+		         verify_account_check(acc, "wrong password", NULL, impls, with_prefixes, counts);
+	}
+
+	for (size_t i = 0; i < VERIFY_ALG_COUNT; i++)
+		(void) crypt_unregister(&impls[i]);
+
+	if (! result)
+		// verify_account_check() logs error messages on failure
+		return false;
+
+	for (size_t i = 0; i < VERIFY_ALG_COUNT; i++)
+	{
+		const struct verify_counts *const counts = &alg_counts[i];
+
+		if (! counts->verifies)
+			continue;
+
+		(void) bench_print(_("%-16s %-10s %10zu %14.2Lf %14.2Lf %10.3Lf %10.3Lf"), verify_algs[i].name, dispatch,
+		                   counts->verifies, (long double) counts->foreign_calls / counts->verifies,
+		                   (long double) counts->foreign_runs / counts->verifies,
+		                   (counts->elapsed * 1000.0L) / counts->verifies, counts->elapsed_max * 1000.0L);
+
+		total->verifies += counts->verifies;
+		total->foreign_calls += counts->foreign_calls;
+		total->foreign_runs += counts->foreign_runs;
+		total->elapsed += counts->elapsed;
+		total->elapsed_max = BENCH_MAX(total->elapsed_max, counts->elapsed_max);
+	}
+
+	return true;
+}
+
+bool ATHEME_FATTR_WUR
+do_verify_dispatch_tests(const size_t accounts)
+{
+	struct verify_account *corpus;
+	struct verify_counts walk_total;
+	struct verify_counts index_total;
+
+	(void) bench_print("");
+	(void) bench_print("");
+	(void) bench_print(_("Beginning password verification dispatch tests ..."));
+	(void) bench_print("");
+	(void) bench_print(_(""
+		"NOTICE: The algorithms below are stand-ins (PBKDF2 using the given digest);\n"
+		"        the 'legacy' ones have no prefix and no verify function. 'walk'\n"
+		"        tries every provider in turn, 'prefix' goes straight to the\n"
+		"        provider that declared the prefix of the hash. Each account is\n"
+		"        verified with its password and with a wrong one. 'Foreign calls'\n"
+		"        and 'Foreign hashes' are the mean number of calls into other\n"
+		"        providers, and of hashes they computed, per verification. The\n"
+		"        times are of crypt_verify_password() with these stand-ins (%u\n"
+		"        PBKDF2 iterations each), not with the real providers."
+	), VERIFY_ITERCNT);
+
+	if (! (corpus = calloc(accounts, sizeof *corpus)))
+	{
+		(void) perror("calloc(3)");
+		return false;
+	}
+
+	(void) verify_impls_init();
+
+	for (size_t i = 0; i < accounts; i++)
+	{
+		struct verify_account *const acc = &corpus[i];
+		const char *hash;
+
+		acc->alg = i % VERIFY_ALG_COUNT;
+		(void) atheme_random_str(acc->pass, VERIFY_PASSLEN);
+
+		if (! (hash = verify_alg_crypt(acc->alg, acc->pass, NULL)))
+		{
+			(void) bench_print("digest_oneshot_pbkdf2() failed");
+			(void) free(corpus);
+			return false;
+		}
+
+		(void) snprintf(acc->hash, sizeof acc->hash, "%s", hash);
+	}
+
+	(void) memset(&walk_total, 0x00, sizeof walk_total);
+	(void) memset(&index_total, 0x00, sizeof index_total);
+	(void) verify_print_colheaders();
+
+	if (! verify_corpus_run(corpus, accounts, verify_impls_walk, false, &walk_total) ||
+	    ! verify_corpus_run(corpus, accounts, verify_impls_index, true, &index_total))
+	{
+		// This function logs error messages on failure
+		(void) free(corpus);
+		return false;
+	}
+
+	(void) bench_print("");
+	(void) bench_print(_("Calls into other providers over %zu verifications: %zu (walk), %zu (prefix)"),
+	                   walk_total.verifies, walk_total.foreign_calls, index_total.foreign_calls);
+	(void) bench_print(_("Hashes computed by other providers: %zu (walk), %zu (prefix)"),
+	                   walk_total.foreign_runs, index_total.foreign_runs);
+	(void) bench_print(_("Mean verification time: %.3Lf ms (walk), %.3Lf ms (prefix); slowest: %.3Lf ms (walk), "
+	                     "%.3Lf ms (prefix)"), (walk_total.elapsed * 1000.0L) / walk_total.verifies,
+	                   (index_total.elapsed * 1000.0L) / index_total.verifies, walk_total.elapsed_max * 1000.0L,
+	                   index_total.elapsed_max * 1000.0L);
+
+	(void) free(corpus);
+	return true;
+}
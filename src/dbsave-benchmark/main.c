@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Loads a database (e.g. one made by tools/createtestdb) with the opensex
+ * backend, or another one given on the command line, and times blocking saves
+ * of it.
+ */
+
+#include <atheme.h>
+#include <atheme/libathemecore.h>
+
+#define BENCH_SAVES_DEF         5U
+
+static long double
+elapsed(const struct timespec *begin, const struct timespec *end)
+{
+	return (long double) (end->tv_sec - begin->tv_sec) + ((long double) (end->tv_nsec - begin->tv_nsec) / 1000000000.0L);
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned int nsaves = BENCH_SAVES_DEF;
+	const char *backend = "backend/opensex";
+	struct timespec begin, end;
+	long double total = 0, best = 0;
+	char savename[BUFSIZE];
+	struct stat sb;
+
+	if (argc < 2)
+	{
+		(void) fprintf(stderr, "Usage: %s <database> [saves [backend]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 2 && (! string_to_uint(argv[2], &nsaves) || ! nsaves))
+		return EXIT_FAILURE;
+
+	if (argc > 3)
+		backend = argv[3];
+
+	if (! libathemecore_early_init())
+		return EXIT_FAILURE;
+
+	atheme_bootstrap();
+	atheme_init(argv[0], LOGDIR "/dbsave-benchmark.log");
+	atheme_setup();
+
+	runflags = RF_LIVE;
+	datadir = ".";
+	strict_mode = false;
+	offline_mode = true;
+
+	if (! module_load(backend))
+		return EXIT_FAILURE;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+	runflags &= ~RF_LIVE;
+	db_load(argv[1]);
+	runflags |= RF_LIVE;
+	(void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("loaded %s in %.3Lfs: %u accounts, %u channels, %u access entries\n", argv[1],
+	       elapsed(&begin, &end), cnt.myuser, cnt.mychan, cnt.chanacs);
+
+	(void) snprintf(savename, sizeof savename, "%s.saved", argv[1]);
+
+	for (unsigned int i = 0; i < nsaves; i++)
+	{
+		(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+		db_save(savename, DB_SAVE_BLOCKING);
+		(void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+		const long double t = elapsed(&begin, &end);
+
+		total += t;
+		if (i == 0 || t < best)
+			best = t;
+	}
+
+	if (stat(savename, &sb) != 0)
+	{
+		(void) perror(savename);
+		return EXIT_FAILURE;
+	}
+
+	printf("  %u saves of %jd bytes: best %.3Lfs, mean %.3Lfs, %.1LfMB/s\n", nsaves, (intmax_t) sb.st_size,
+	       best, total / nsaves, ((long double) sb.st_size / (1024.0L * 1024.0L)) / best);
+
+	return EXIT_SUCCESS;
+}
@@ -57,6 +57,8 @@ main(int argc, char *argv[])
 
 	printf("sizeof myentity_t: %zu B --> %zu KB\n", sizeof(struct myentity), (regusercount * sizeof(struct myentity)) / 1024);
 	printf("sizeof myuser_t: %zu B --> %zu KB\n", sizeof(struct myuser), (regusercount * sizeof(struct myuser)) / 1024);
+	printf("sizeof myuser_ext_t: %zu B (only for accounts with memo ignores, access masks, certfps or sent memos)\n", sizeof(struct myuser_ext));
+	printf("password hash: allocated to its length, at most %u B\n", PASSLEN + 1);
 	printf("sizeof mychan_t: %zu B --> %zu KB\n", sizeof(struct mychan), (regchannelcount * sizeof(struct mychan)) / 1024);
 	printf("sizeof mynick_t: %zu B --> %zu KB\n", sizeof(struct mynick), (regusercount * sizeof(struct mynick)) / 1024);
 
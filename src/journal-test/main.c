@@ -0,0 +1,217 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * Checks that a journal cut short during an append (as by a crash) can still
+ * be replayed: the rows of a batch are only applied once the whole batch is
+ * there, a row that was cut short is never applied, and reading the journal
+ * does not exit. A journal of a few batches is written through the database
+ * module's append path, then cut at every byte and read back each time.
+ *
+ * Like dbverify, this loads backend/opensex from the installed modules; the
+ * path of another build of the module may be given instead.
+ */
+
+#include <atheme.h>
+#include <atheme/libathemecore.h>
+
+#define TEST_JOURNAL            "services.db.journal.1"
+#define TEST_BATCHES            3U
+#define TEST_BATCH_ROWS         4U
+
+static unsigned int rows_applied;
+static unsigned int rows_cut;
+
+static void
+handle_trow(struct database_handle *db, const char *type)
+{
+	const unsigned int id = db_sread_uint(db);
+	const char *const text = db_sread_str(db);
+	char expect[BUFSIZE];
+
+	(void) snprintf(expect, sizeof expect, "row %u of the journal test", id);
+
+	if (strcmp(text, expect) != 0)
+		rows_cut++;
+
+	rows_applied++;
+}
+
+static bool
+write_batch(const unsigned int first)
+{
+	struct database_handle *db;
+	char text[BUFSIZE];
+
+	if (! (db = db_open(TEST_JOURNAL, DB_APPEND)))
+		return false;
+
+	for (unsigned int id = first; id < first + TEST_BATCH_ROWS; id++)
+	{
+		(void) snprintf(text, sizeof text, "row %u of the journal test", id);
+
+		db_start_row(db, "TROW");
+		db_write_uint(db, id);
+		db_write_str(db, text);
+		db_commit_row(db);
+	}
+
+	db_close(db);
+	return true;
+}
+
+static bool
+write_file(const char *const path, const char *const mode, const char *const buf, const size_t len)
+{
+	FILE *const f = fopen(path, mode);
+
+	if (! f)
+	{
+		(void) perror(path);
+		return false;
+	}
+
+	const bool ok = (fwrite(buf, 1, len, f) == len);
+
+	if (fclose(f) != 0 || ! ok)
+	{
+		(void) perror(path);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+replay(void)
+{
+	struct database_handle *db;
+
+	rows_applied = 0;
+	rows_cut = 0;
+
+	if (! (db = db_open(TEST_JOURNAL, DB_READ)))
+		return;
+
+	db_parse(db);
+	db_close(db);
+}
+
+static bool
+check(const char *const what, const unsigned int expect)
+{
+	if (rows_applied == expect && ! rows_cut)
+		return true;
+
+	(void) fprintf(stderr, "%s: %u rows applied (%u of them cut short); expected %u\n", what, rows_applied,
+	               rows_cut, expect);
+	return false;
+}
+
+int
+main(int argc, char *argv[])
+{
+	char dir[] = "/tmp/atheme-journal-test.XXXXXX";
+	char path[BUFSIZE], logpath[BUFSIZE], what[BUFSIZE];
+	size_t batch_end[TEST_BATCHES];
+	unsigned int failures = 0;
+	struct stat sb;
+	char *journal;
+	FILE *f;
+
+	if (! libathemecore_early_init())
+		return EXIT_FAILURE;
+
+	if (! mkdtemp(dir))
+	{
+		(void) perror("mkdtemp(3)");
+		return EXIT_FAILURE;
+	}
+
+	(void) snprintf(path, sizeof path, "%s/%s", dir, TEST_JOURNAL);
+	(void) snprintf(logpath, sizeof logpath, "%s/journal-test.log", dir);
+
+	atheme_bootstrap();
+	atheme_init(argv[0], logpath);
+	atheme_setup();
+
+	datadir = dir;
+	strict_mode = false;
+	offline_mode = true;
+
+	if (! module_load(argc > 1 ? argv[1] : "backend/opensex"))
+		return EXIT_FAILURE;
+
+	db_register_type_handler("TROW", handle_trow);
+
+	for (unsigned int i = 0; i < TEST_BATCHES; i++)
+	{
+		if (! write_batch(1 + (i * TEST_BATCH_ROWS)) || stat(path, &sb) < 0)
+		{
+			(void) fprintf(stderr, "cannot write batch %u of %s\n", i + 1, path);
+			return EXIT_FAILURE;
+		}
+
+		batch_end[i] = (size_t) sb.st_size;
+	}
+
+	journal = smalloc(batch_end[TEST_BATCHES - 1]);
+
+	if (! (f = fopen(path, "rb")) || fread(journal, 1, batch_end[TEST_BATCHES - 1], f) != batch_end[TEST_BATCHES - 1])
+	{
+		(void) perror(path);
+		return EXIT_FAILURE;
+	}
+
+	(void) fclose(f);
+
+	// every batch whose end made it to disk is applied, and nothing else
+	for (size_t cut = 0; cut <= batch_end[TEST_BATCHES - 1]; cut++)
+	{
+		unsigned int expect = 0;
+
+		for (unsigned int i = 0; i < TEST_BATCHES; i++)
+			if (batch_end[i] <= cut)
+				expect += TEST_BATCH_ROWS;
+
+		if (! write_file(path, "wb", journal, cut))
+			return EXIT_FAILURE;
+
+		replay();
+
+		(void) snprintf(what, sizeof what, "journal cut at byte %zu of %zu", cut, batch_end[TEST_BATCHES - 1]);
+
+		if (! check(what, expect))
+			failures++;
+	}
+
+	/* An append whose write failed halfway leaves a batch without its end, and
+	 * later appends follow it; nothing from that batch on may be applied.
+	 */
+	static const char partial[] = "\nBATCH \nTROW 99 row 99 of the jou";
+
+	if (! write_file(path, "wb", journal, batch_end[1]) || ! write_file(path, "ab", partial, sizeof partial - 1) ||
+	    ! write_batch(1 + (TEST_BATCHES * TEST_BATCH_ROWS)))
+		return EXIT_FAILURE;
+
+	replay();
+
+	if (! check("journal with a failed append", 2 * TEST_BATCH_ROWS))
+		failures++;
+
+	(void) printf("%zu truncated journals and one failed append checked; %u failure(s)\n",
+	              batch_end[TEST_BATCHES - 1] + 1, failures);
+
+	(void) unlink(path);
+	(void) unlink(logpath);
+	(void) rmdir(dir);
+	sfree(journal);
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
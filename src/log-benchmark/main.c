@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Measures what the debug log messages on the channel join path cost. Users
+ * logged in to accounts join registered channels through chanuser_add(),
+ * have their access looked up with chanacs_user_flags() as ChanServ does on
+ * join, and part again; this is timed with LG_DEBUG off for every log stream
+ * (so slog() skips those messages) and then with LG_DEBUG on for the main log
+ * file (so they are formatted and written out).
+ *
+ * No protocol module is loaded; the prefix modes are set here, and every
+ * channel keeps one member that never parts so that it is not destroyed.
+ */
+
+#include <atheme.h>
+#include <atheme/libathemecore.h>
+
+#define BENCH_ROUNDS_DEF        20U
+#define BENCH_USERS             500U
+#define BENCH_CHANNELS          100U
+#define BENCH_JOINS_PER_USER    20U     // channels each user joins per round
+#define BENCH_ACCESS_PER_USER   5U      // of which the user has access to this many
+
+static const struct cmode bench_prefix_mode_list[] = {
+  { '@', CSTATUS_OP    },
+  { '+', CSTATUS_VOICE },
+  { '\0', 0 }
+};
+
+static struct user *users[BENCH_USERS];
+static struct channel *channels[BENCH_CHANNELS];
+static struct mychan *mychans[BENCH_CHANNELS];
+
+static inline unsigned int
+bench_channel(const unsigned int user, const unsigned int join)
+{
+	return (user + (join * 7U)) % BENCH_CHANNELS;
+}
+
+static long double
+elapsed(const struct timespec *begin, const struct timespec *end)
+{
+	return (long double) (end->tv_sec - begin->tv_sec) + ((long double) (end->tv_nsec - begin->tv_nsec) / 1000000000.0L);
+}
+
+static bool
+setup(void)
+{
+	struct server *const s = server_add("bench.example.org", 1, NULL, NULL, "log benchmark");
+	struct user *idle;
+	char name[BUFSIZE];
+	char host[BUFSIZE];
+
+	if (! s || ! (idle = user_add("BenchIdle", "bench", "idle.example.org", NULL, NULL, NULL, "log benchmark", s, 0)))
+		return false;
+
+	for (unsigned int i = 0; i < BENCH_CHANNELS; i++)
+	{
+		(void) snprintf(name, sizeof name, "#bench%u", i);
+
+		if (! (mychans[i] = mychan_add(name)) || ! (channels[i] = channel_add(name, CURRTIME, s)))
+			return false;
+
+		// one hostmask entry per channel, matched against every joining user
+		(void) chanacs_add_host(mychans[i], "*!*@*.users.example.org", CA_VOICE, CURRTIME, NULL);
+
+		if (! chanuser_add(channels[i], idle->nick))
+			return false;
+	}
+
+	for (unsigned int i = 0; i < BENCH_USERS; i++)
+	{
+		struct myuser *mu;
+
+		(void) snprintf(name, sizeof name, "BenchUser%u", i);
+		(void) snprintf(host, sizeof host, "host%u.users.example.org", i);
+
+		if (! (mu = myuser_add(name, "*", "bench@example.org", 0)))
+			return false;
+
+		if (! (users[i] = user_add(name, "bench", host, NULL, NULL, NULL, "log benchmark", s, 0)))
+			return false;
+
+		users[i]->myuser = mu;
+		mowgli_node_add(users[i], mowgli_node_create(), &mu->logins);
+
+		for (unsigned int j = 0; j < BENCH_ACCESS_PER_USER; j++)
+			(void) chanacs_add(mychans[bench_channel(i, j)], entity(mu), CA_AUTOOP | CA_OP | CA_TOPIC,
+			                   CURRTIME, NULL);
+	}
+
+	return true;
+}
+
+/* Returns the time taken, and adds the access flags found to *sum so that the
+ * lookups cannot be optimised away.
+ */
+static long double
+run(const unsigned int rounds, unsigned long *const sum)
+{
+	struct timespec begin, end;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	for (unsigned int r = 0; r < rounds; r++)
+	{
+		for (unsigned int i = 0; i < BENCH_USERS; i++)
+		{
+			for (unsigned int j = 0; j < BENCH_JOINS_PER_USER; j++)
+			{
+				const unsigned int c = bench_channel(i, j);
+
+				if (chanuser_add(channels[c], users[i]->nick))
+					*sum += chanacs_user_flags(mychans[c], users[i]);
+			}
+		}
+
+		for (unsigned int i = 0; i < BENCH_USERS; i++)
+			for (unsigned int j = 0; j < BENCH_JOINS_PER_USER; j++)
+				chanuser_delete(channels[bench_channel(i, j)], users[i]);
+	}
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&begin, &end);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char dir[] = "/tmp/atheme-log-benchmark.XXXXXX";
+	char logpath[BUFSIZE];
+	unsigned int rounds = BENCH_ROUNDS_DEF;
+	unsigned long sum_quiet = 0, sum_debug = 0;
+	long double t_quiet, t_debug;
+
+	if (! libathemecore_early_init())
+		return EXIT_FAILURE;
+
+	if (argc > 1 && ! string_to_uint(argv[1], &rounds))
+	{
+		(void) fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (! mkdtemp(dir))
+	{
+		(void) perror("mkdtemp(3)");
+		return EXIT_FAILURE;
+	}
+
+	(void) snprintf(logpath, sizeof logpath, "%s/log-benchmark.log", dir);
+
+	atheme_bootstrap();
+	atheme_init(argv[0], logpath);
+	atheme_setup();
+
+	prefix_mode_list = bench_prefix_mode_list;
+
+	const unsigned int quiet = log_active_mask;
+
+	if (log_level_enabled(LG_DEBUG))
+	{
+		(void) fprintf(stderr, "LG_DEBUG is already enabled; nothing to compare against\n");
+		return EXIT_FAILURE;
+	}
+
+	if (! setup())
+	{
+		(void) fprintf(stderr, "cannot set up the users and channels to join\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned long joins = (unsigned long) rounds * BENCH_USERS * BENCH_JOINS_PER_USER;
+
+	(void) printf("%lu joins (and parts) of %u users to %u registered channels\n", joins, BENCH_USERS,
+	              BENCH_CHANNELS);
+
+	t_quiet = run(rounds, &sum_quiet);
+
+	log_master_set_mask(quiet | LG_DEBUG);
+	t_debug = run(rounds, &sum_debug);
+	log_master_set_mask(quiet);
+
+	if (sum_quiet != sum_debug)
+	{
+		(void) fprintf(stderr, "the two runs found different access (%lu, %lu)\n", sum_quiet, sum_debug);
+		return EXIT_FAILURE;
+	}
+
+	(void) printf("  LG_DEBUG off:  %10.3Lfs  %10.1Lfns/join\n", t_quiet, t_quiet * 1000000000.0L / joins);
+	(void) printf("  LG_DEBUG on:   %10.3Lfs  %10.1Lfns/join (written to the main log file)\n", t_debug,
+	              t_debug * 1000000000.0L / joins);
+
+	(void) unlink(logpath);
+	(void) rmdir(dir);
+
+	return EXIT_SUCCESS;
+}
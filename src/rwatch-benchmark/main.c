@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: ISC
+ * SPDX-URL: https://spdx.org/licenses/ISC.html
+ *
+ * Copyright (C) 2026 Atheme Development Group (https://atheme.github.io/)
+ *
+ * Compares matching a stream of connecting users against an RWATCH-style
+ * list one regex at a time with matching it against a regex set.
+ */
+
+#include <atheme.h>
+#include <atheme/libathemecore.h>
+
+#define BENCH_USERS_DEF         100000U
+#define BENCH_PATTERNS_DEF      250U
+
+static const char *const pattern_templates[] = {
+	"^evil%u[0-9]*!",
+	"!~?spam%u@",
+	"@.*\\.bad%u\\.example\\.net ",
+	"^[a-z]+%u_bot[0-9]{2,}!",
+	" .*free ?money %u$",
+	"^guest%u!.*@10\\.%u\\.",
+};
+
+static unsigned int set_hits = 0;
+
+static void
+count_hit(void *data, void *priv)
+{
+	set_hits++;
+}
+
+static long double
+elapsed(const struct timespec *begin, const struct timespec *end)
+{
+	return (long double) (end->tv_sec - begin->tv_sec) + ((long double) (end->tv_nsec - begin->tv_nsec) / 1000000000.0L);
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned int nusers = BENCH_USERS_DEF;
+	unsigned int npatterns = BENCH_PATTERNS_DEF;
+	struct atheme_regex **regexes;
+	struct atheme_regex_set *set;
+	char **masks;
+	struct timespec begin, end;
+	long double t_list, t_set;
+	unsigned int list_hits = 0;
+	const unsigned int ntemplates = ARRAY_SIZE(pattern_templates);
+	unsigned int i, j;
+
+	if (! libathemecore_early_init())
+		return EXIT_FAILURE;
+
+	if (argc > 1 && ! string_to_uint(argv[1], &nusers))
+		return EXIT_FAILURE;
+
+	if (argc > 2 && ! string_to_uint(argv[2], &npatterns))
+		return EXIT_FAILURE;
+
+	srand(1);
+
+	regexes = smalloc(npatterns * sizeof *regexes);
+	set = regex_set_create();
+
+	for (i = 0; i < npatterns; i++)
+	{
+		const char *const tmpl = pattern_templates[i % ntemplates];
+		char pattern[BUFSIZE];
+		const int flags = (i % 3) ? AREGEX_ICASE : 0;
+
+		snprintf(pattern, sizeof pattern, tmpl, i, i % 256);
+
+		if (! (regexes[i] = regex_create(pattern, flags)))
+			return EXIT_FAILURE;
+
+		regex_set_add(set, pattern, flags, regexes[i], regexes[i]);
+	}
+
+	// about one user in a thousand matches something
+	masks = smalloc(nusers * sizeof *masks);
+
+	for (i = 0; i < nusers; i++)
+	{
+		char mask[NICKLEN + 1 + USERLEN + 1 + HOSTLEN + 1 + GECOSLEN + 1];
+
+		if ((rand() % 1000) == 0)
+			snprintf(mask, sizeof mask, "evil%u!spam%u@host%u.bad%u.example.net free money %u",
+					(unsigned int) rand() % npatterns, (unsigned int) rand() % npatterns,
+					i, (unsigned int) rand() % npatterns, (unsigned int) rand() % npatterns);
+		else
+			snprintf(mask, sizeof mask, "User%u!~user%u@%u.dsl.example.com Some User %u",
+					i, (unsigned int) rand(), (unsigned int) rand(), i);
+
+		masks[i] = sstrdup(mask);
+	}
+
+	printf("%u users against %u patterns\n", nusers, npatterns);
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < nusers; i++)
+		for (j = 0; j < npatterns; j++)
+			if (regex_match(regexes[j], masks[i]))
+				list_hits++;
+	(void) clock_gettime(CLOCK_MONOTONIC, &end);
+	t_list = elapsed(&begin, &end);
+
+	// the first match compiles the combined regexes; keep that out of the timing
+	(void) regex_set_match(set, masks[0], &count_hit, NULL);
+	set_hits = 0;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < nusers; i++)
+		(void) regex_set_match(set, masks[i], &count_hit, NULL);
+	(void) clock_gettime(CLOCK_MONOTONIC, &end);
+	t_set = elapsed(&begin, &end);
+
+	printf("  one by one: %10.3Lfs  %10.3Lfus/user  %u hits\n", t_list, t_list * 1000000.0L / nusers, list_hits);
+	printf("  regex set:  %10.3Lfs  %10.3Lfus/user  %u hits\n", t_set, t_set * 1000000.0L / nusers, set_hits);
+
+	for (i = 0; i < nusers; i++)
+		sfree(masks[i]);
+	sfree(masks);
+
+	regex_set_destroy(set);
+	for (i = 0; i < npatterns; i++)
+		(void) regex_destroy(regexes[i]);
+	sfree(regexes);
+
+	return (list_hits == set_hits) ? EXIT_SUCCESS : EXIT_FAILURE;
+}